@@ -2,7 +2,11 @@
 #define CONFIG_H
 
 //#define DILITHIUM_MODE 2
+/* Signing is hedged with fresh randomness unless
+ * DILITHIUM_DETERMINISTIC_SIGNING is defined (make deterministic) */
+#ifndef DILITHIUM_DETERMINISTIC_SIGNING
 #define DILITHIUM_RANDOMIZED_SIGNING
+#endif
 //#define USE_RDPMC
 //#define DBENCH
 
@@ -24,4 +28,22 @@
 #define DILITHIUM_NAMESPACE(s) pqcrystals_dilithium5_avx2_##s
 #endif
 
+/* Challenge products by sparse multiplication (poly_sparse_mul*) instead
+ * of pointwise product and inverse NTT. Off unless SPARSE_CHALLENGE is
+ * defined to 1: the timing of the sparse products depends on the
+ * positions and signs of the nonzero coefficients of c, and c stays
+ * secret for rejected attempts, whereas the NTT path does not depend on
+ * it. With SPARSE_CHALLENGE, c*s1 and c*s2 (SPARSE_CS) and c*t0
+ * (SPARSE_CT0) take the sparse path for the parameter sets where that
+ * measured faster with test_speed. */
+#ifndef SPARSE_CHALLENGE
+#define SPARSE_CHALLENGE 0
+#endif
+#ifndef SPARSE_CS
+#define SPARSE_CS (SPARSE_CHALLENGE && DILITHIUM_MODE != 3)
+#endif
+#ifndef SPARSE_CT0
+#define SPARSE_CT0 (SPARSE_CHALLENGE && DILITHIUM_MODE == 2)
+#endif
+
 #endif
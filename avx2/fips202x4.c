@@ -53,6 +53,70 @@ static void keccakx4_absorb_once(__m256i s[25],
   s[r/8 - 1] = _mm256_xor_si256(s[r/8 - 1], t);
 }
 
+static unsigned int keccakx4_absorb(__m256i s[25],
+                                    unsigned int pos,
+                                    unsigned int r,
+                                    const uint8_t *in0,
+                                    const uint8_t *in1,
+                                    const uint8_t *in2,
+                                    const uint8_t *in3,
+                                    size_t inlen)
+{
+  unsigned int i;
+  uint64_t t0, t1, t2, t3;
+  __m256i t;
+
+  while(inlen > 0) {
+    if(pos % 8 == 0 && inlen >= 8) {
+      /* Whole lanes */
+      for(i = pos/8; i < r/8 && inlen >= 8; ++i) {
+        memcpy(&t0, in0, 8);
+        memcpy(&t1, in1, 8);
+        memcpy(&t2, in2, 8);
+        memcpy(&t3, in3, 8);
+        t = _mm256_set_epi64x((long long)t3, (long long)t2, (long long)t1, (long long)t0);
+        s[i] = _mm256_xor_si256(s[i], t);
+        in0 += 8;
+        in1 += 8;
+        in2 += 8;
+        in3 += 8;
+        inlen -= 8;
+        pos += 8;
+      }
+    }
+    else {
+      t = _mm256_set_epi64x((long long)((uint64_t)in3[0] << 8*(pos%8)),
+                            (long long)((uint64_t)in2[0] << 8*(pos%8)),
+                            (long long)((uint64_t)in1[0] << 8*(pos%8)),
+                            (long long)((uint64_t)in0[0] << 8*(pos%8)));
+      s[pos/8] = _mm256_xor_si256(s[pos/8], t);
+      in0 += 1;
+      in1 += 1;
+      in2 += 1;
+      in3 += 1;
+      inlen -= 1;
+      pos += 1;
+    }
+
+    if(pos == r) {
+      f1600x4(s, KeccakF_RoundConstants);
+      pos = 0;
+    }
+  }
+
+  return pos;
+}
+
+static void keccakx4_finalize(__m256i s[25], unsigned int pos, unsigned int r, uint8_t p)
+{
+  __m256i t;
+
+  t = _mm256_set1_epi64x((uint64_t)p << 8*(pos%8));
+  s[pos/8] = _mm256_xor_si256(s[pos/8], t);
+  t = _mm256_set1_epi64x(1ULL << 63);
+  s[r/8 - 1] = _mm256_xor_si256(s[r/8 - 1], t);
+}
+
 static void keccakx4_squeezeblocks(uint8_t *out0,
                                    uint8_t *out1,
                                    uint8_t *out2,
@@ -123,6 +187,31 @@ void shake256x4_squeezeblocks(uint8_t *out0,
   keccakx4_squeezeblocks(out0, out1, out2, out3, nblocks, SHAKE256_RATE, state->s);
 }
 
+void shake256x4_init(keccakx4_state *state)
+{
+  unsigned int i;
+
+  for(i = 0; i < 25; ++i)
+    state->s[i] = _mm256_setzero_si256();
+  state->pos = 0;
+}
+
+void shake256x4_absorb(keccakx4_state *state,
+                       const uint8_t *in0,
+                       const uint8_t *in1,
+                       const uint8_t *in2,
+                       const uint8_t *in3,
+                       size_t inlen)
+{
+  state->pos = keccakx4_absorb(state->s, state->pos, SHAKE256_RATE, in0, in1, in2, in3, inlen);
+}
+
+void shake256x4_finalize(keccakx4_state *state)
+{
+  keccakx4_finalize(state->s, state->pos, SHAKE256_RATE, 0x1F);
+  state->pos = SHAKE256_RATE;
+}
+
 void shake128x4(uint8_t *out0,
                 uint8_t *out1,
                 uint8_t *out2,
@@ -26,6 +26,7 @@
 
 typedef struct {
   __m256i s[25];
+  unsigned int pos;
 } keccakx4_state;
 
 #define f1600x4 FIPS202X4_NAMESPACE(f1600x4)
@@ -63,6 +64,20 @@ void shake256x4_squeezeblocks(uint8_t *out0,
                               size_t nblocks,
                               keccakx4_state *state);
 
+#define shake256x4_init FIPS202X4_NAMESPACE(shake256x4_init)
+void shake256x4_init(keccakx4_state *state);
+
+#define shake256x4_absorb FIPS202X4_NAMESPACE(shake256x4_absorb)
+void shake256x4_absorb(keccakx4_state *state,
+                       const uint8_t *in0,
+                       const uint8_t *in1,
+                       const uint8_t *in2,
+                       const uint8_t *in3,
+                       size_t inlen);
+
+#define shake256x4_finalize FIPS202X4_NAMESPACE(shake256x4_finalize)
+void shake256x4_finalize(keccakx4_state *state);
+
 #define shake128x4 FIPS202X4_NAMESPACE(shake128x4)
 void shake128x4(uint8_t *out0,
                 uint8_t *out1,
@@ -697,6 +697,264 @@ void poly_challenge(poly * restrict c, const uint8_t seed[CTILDEBYTES]) {
   }
 }
 
+/*************************************************
+* Name:        poly_challenge_4x
+*
+* Description: Four-way variant of poly_challenge. The four SHAKE256
+*              streams are squeezed in lockstep; a further block is only
+*              squeezed when at least one lane has consumed its current one.
+*
+* Arguments:   - poly *c0, ..., *c3: pointers to output polynomials
+*              - const uint8_t seed0[], ..., seed3[]: byte arrays containing
+*                seeds of length CTILDEBYTES
+**************************************************/
+void poly_challenge_4x(poly *c0,
+                       poly *c1,
+                       poly *c2,
+                       poly *c3,
+                       const uint8_t seed0[CTILDEBYTES],
+                       const uint8_t seed1[CTILDEBYTES],
+                       const uint8_t seed2[CTILDEBYTES],
+                       const uint8_t seed3[CTILDEBYTES])
+{
+  unsigned int j, b, done;
+  unsigned int i[4], pos[4];
+  uint64_t signs[4];
+  ALIGNED_UINT8(SHAKE256_RATE) buf[4];
+  keccakx4_state state;
+  poly *c[4];
+
+  c[0] = c0;
+  c[1] = c1;
+  c[2] = c2;
+  c[3] = c3;
+
+  shake256x4_absorb_once(&state, seed0, seed1, seed2, seed3, CTILDEBYTES);
+  shake256x4_squeezeblocks(buf[0].coeffs, buf[1].coeffs, buf[2].coeffs, buf[3].coeffs, 1, &state);
+
+  for(j = 0; j < 4; ++j) {
+    memcpy(&signs[j], buf[j].coeffs, 8);
+    pos[j] = 8;
+    i[j] = N-TAU;
+    memset(c[j]->vec, 0, sizeof(poly));
+  }
+
+  for(;;) {
+    done = 0;
+    for(j = 0; j < 4; ++j) {
+      while(i[j] < N && pos[j] < SHAKE256_RATE) {
+        b = buf[j].coeffs[pos[j]++];
+        if(b > i[j])
+          continue;
+
+        c[j]->coeffs[i[j]] = c[j]->coeffs[b];
+        c[j]->coeffs[b] = 1 - 2*(signs[j] & 1);
+        signs[j] >>= 1;
+        i[j]++;
+      }
+      done += (i[j] == N);
+    }
+
+    if(done == 4)
+      break;
+
+    shake256x4_squeezeblocks(buf[0].coeffs, buf[1].coeffs, buf[2].coeffs, buf[3].coeffs, 1, &state);
+    for(j = 0; j < 4; ++j)
+      pos[j] = 0;
+  }
+}
+
+/*************************************************
+* Name:        poly_challenge_sparse
+*
+* Description: Lists the TAU nonzero coefficients of a challenge
+*              polynomial for poly_sparse_mul and poly_sparse_mul_eta.
+*
+* Arguments:   - poly_sparse *cs: pointer to output sparse challenge
+*              - const poly *c: pointer to challenge from poly_challenge
+**************************************************/
+void poly_challenge_sparse(poly_sparse *cs, const poly *c) {
+  unsigned int i, j, k = 0, mask;
+  __m256i f;
+  const __m256i zero = _mm256_setzero_si256();
+
+  for(i = 0; i < N/8; i++) {
+    f = _mm256_load_si256(&c->vec[i]);
+    f = _mm256_cmpeq_epi32(f, zero);
+    mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(f)) & 0xFF;
+    while(mask) {
+      j = 8*i + __builtin_ctz(mask);
+      cs->pos[k] = j;
+      cs->neg[k] = c->coeffs[j] < 0;
+      k++;
+      mask &= mask - 1;
+    }
+  }
+}
+
+/* The sparse products sum TAU windows of E = (a, -a, a): x^pos*a is the
+ * window that starts at 2N - pos and -x^pos*a the one at N - pos, so the
+ * sign costs no branch. Eight accumulators stay in registers over all
+ * TAU windows. */
+#define SPARSE_OFFSET(c,k) (2*N - (c)->pos[k] - N*(c)->neg[k])
+
+#if BETA < 128
+/*************************************************
+* Name:        poly_sparse_mul_eta
+*
+* Description: Negacyclic product of a sparse challenge and a polynomial
+*              with coefficients in [-ETA,ETA], without NTT. The result is
+*              exact, with coefficients in [-BETA,BETA]; these fit in a
+*              byte here, so all N coefficients are summed in eight
+*              registers. Timing depends on the positions and signs of the
+*              nonzero coefficients of c, which are secret for rejected
+*              attempts (see SPARSE_CS in config.h).
+*
+* Arguments:   - poly *r: pointer to output polynomial
+*              - const poly_sparse *c: pointer to sparse challenge
+*              - const poly *a: pointer to input polynomial
+**************************************************/
+void poly_sparse_mul_eta(poly *r, const poly_sparse *c, const poly *a) {
+  unsigned int i, k;
+  const uint8_t *e;
+  __m128i g;
+  __m256i f0, f1, f2, f3, acc[8];
+  ALIGNED_UINT8(3*N) ext;
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i idx = _mm256_setr_epi32(0,4,1,5,2,6,3,7);
+  DBENCH_START();
+
+  for(i = 0; i < N/32; i++) {
+    f0 = _mm256_load_si256(&a->vec[4*i+0]);
+    f1 = _mm256_load_si256(&a->vec[4*i+1]);
+    f2 = _mm256_load_si256(&a->vec[4*i+2]);
+    f3 = _mm256_load_si256(&a->vec[4*i+3]);
+    f0 = _mm256_packs_epi32(f0, f1);
+    f2 = _mm256_packs_epi32(f2, f3);
+    f0 = _mm256_packs_epi16(f0, f2);
+    f0 = _mm256_permutevar8x32_epi32(f0, idx);
+    _mm256_store_si256(&ext.vec[i], f0);
+    _mm256_store_si256(&ext.vec[N/32+i], _mm256_sub_epi8(zero, f0));
+    _mm256_store_si256(&ext.vec[2*N/32+i], f0);
+  }
+
+  for(i = 0; i < 8; i++)
+    acc[i] = zero;
+  for(k = 0; k < TAU; k++) {
+    e = &ext.coeffs[SPARSE_OFFSET(c, k)];
+    for(i = 0; i < 8; i++)
+      acc[i] = _mm256_add_epi8(acc[i], _mm256_loadu_si256((const __m256i *)&e[32*i]));
+  }
+
+  for(i = 0; i < 8; i++) {
+    g = _mm256_castsi256_si128(acc[i]);
+    _mm256_store_si256(&r->vec[4*i+0], _mm256_cvtepi8_epi32(g));
+    _mm256_store_si256(&r->vec[4*i+1], _mm256_cvtepi8_epi32(_mm_srli_si128(g, 8)));
+    g = _mm256_extracti128_si256(acc[i], 1);
+    _mm256_store_si256(&r->vec[4*i+2], _mm256_cvtepi8_epi32(g));
+    _mm256_store_si256(&r->vec[4*i+3], _mm256_cvtepi8_epi32(_mm_srli_si128(g, 8)));
+  }
+
+  DBENCH_STOP(*tmul);
+}
+#else
+/*************************************************
+* Name:        poly_sparse_mul_eta
+*
+* Description: Negacyclic product of a sparse challenge and a polynomial
+*              with coefficients in [-ETA,ETA], without NTT. The result is
+*              exact, with coefficients in [-BETA,BETA]; these need 16 bits
+*              here, so the coefficients are summed in two halves of eight
+*              registers each. Timing depends on the positions and signs of
+*              the nonzero coefficients of c, which are secret for rejected
+*              attempts (see SPARSE_CS in config.h).
+*
+* Arguments:   - poly *r: pointer to output polynomial
+*              - const poly_sparse *c: pointer to sparse challenge
+*              - const poly *a: pointer to input polynomial
+**************************************************/
+void poly_sparse_mul_eta(poly *r, const poly_sparse *c, const poly *a) {
+  unsigned int i, j, k;
+  const int16_t *e;
+  __m256i f0, f1, acc[8];
+  union {
+    int16_t coeffs[3*N];
+    __m256i vec[3*N/16];
+  } ext;
+  const __m256i zero = _mm256_setzero_si256();
+  DBENCH_START();
+
+  for(i = 0; i < N/16; i++) {
+    f0 = _mm256_load_si256(&a->vec[2*i+0]);
+    f1 = _mm256_load_si256(&a->vec[2*i+1]);
+    f0 = _mm256_packs_epi32(f0, f1);
+    f0 = _mm256_permute4x64_epi64(f0, 0xD8);
+    _mm256_store_si256(&ext.vec[i], f0);
+    _mm256_store_si256(&ext.vec[N/16+i], _mm256_sub_epi16(zero, f0));
+    _mm256_store_si256(&ext.vec[2*N/16+i], f0);
+  }
+
+  for(j = 0; j < N; j += 128) {
+    for(i = 0; i < 8; i++)
+      acc[i] = zero;
+    for(k = 0; k < TAU; k++) {
+      e = &ext.coeffs[SPARSE_OFFSET(c, k) + j];
+      for(i = 0; i < 8; i++)
+        acc[i] = _mm256_add_epi16(acc[i], _mm256_loadu_si256((const __m256i *)&e[16*i]));
+    }
+
+    for(i = 0; i < 8; i++) {
+      _mm256_store_si256(&r->vec[j/8+2*i+0], _mm256_cvtepi16_epi32(_mm256_castsi256_si128(acc[i])));
+      _mm256_store_si256(&r->vec[j/8+2*i+1], _mm256_cvtepi16_epi32(_mm256_extracti128_si256(acc[i], 1)));
+    }
+  }
+
+  DBENCH_STOP(*tmul);
+}
+#endif
+
+/*************************************************
+* Name:        poly_sparse_mul
+*
+* Description: Like poly_sparse_mul_eta for a polynomial with coefficients
+*              of absolute value below 2^31/TAU, e.g. t0; the result is
+*              exact. Sums in four passes of 64 coefficients.
+*
+* Arguments:   - poly *r: pointer to output polynomial
+*              - const poly_sparse *c: pointer to sparse challenge
+*              - const poly *a: pointer to input polynomial
+**************************************************/
+void poly_sparse_mul(poly *r, const poly_sparse *c, const poly *a) {
+  unsigned int i, j, k;
+  const int32_t *e;
+  __m256i f, acc[8];
+  ALIGNED_INT32(3*N) ext;
+  const __m256i zero = _mm256_setzero_si256();
+  DBENCH_START();
+
+  for(i = 0; i < N/8; i++) {
+    f = _mm256_load_si256(&a->vec[i]);
+    _mm256_store_si256(&ext.vec[i], f);
+    _mm256_store_si256(&ext.vec[N/8+i], _mm256_sub_epi32(zero, f));
+    _mm256_store_si256(&ext.vec[2*N/8+i], f);
+  }
+
+  for(j = 0; j < N; j += 64) {
+    for(i = 0; i < 8; i++)
+      acc[i] = zero;
+    for(k = 0; k < TAU; k++) {
+      e = &ext.coeffs[SPARSE_OFFSET(c, k) + j];
+      for(i = 0; i < 8; i++)
+        acc[i] = _mm256_add_epi32(acc[i], _mm256_loadu_si256((const __m256i *)&e[8*i]));
+    }
+
+    for(i = 0; i < 8; i++)
+      _mm256_store_si256(&r->vec[j/8+i], acc[i]);
+  }
+
+  DBENCH_STOP(*tmul);
+}
+
 /*************************************************
 * Name:        polyeta_pack
 *
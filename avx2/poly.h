@@ -54,6 +54,28 @@ void poly_uniform_gamma1_preinit(poly *a, stream256_state *state);
 void poly_uniform_gamma1(poly *a, const uint8_t seed[CRHBYTES], uint16_t nonce);
 #define poly_challenge DILITHIUM_NAMESPACE(poly_challenge)
 void poly_challenge(poly *c, const uint8_t seed[CTILDEBYTES]);
+#define poly_challenge_4x DILITHIUM_NAMESPACE(poly_challenge_4x)
+void poly_challenge_4x(poly *c0,
+                       poly *c1,
+                       poly *c2,
+                       poly *c3,
+                       const uint8_t seed0[CTILDEBYTES],
+                       const uint8_t seed1[CTILDEBYTES],
+                       const uint8_t seed2[CTILDEBYTES],
+                       const uint8_t seed3[CTILDEBYTES]);
+
+/* Challenge by its TAU nonzero coefficients, for the sparse products */
+typedef struct {
+  uint8_t pos[TAU]; // positions
+  uint8_t neg[TAU]; // 1 where the coefficient is -1
+} poly_sparse;
+
+#define poly_challenge_sparse DILITHIUM_NAMESPACE(poly_challenge_sparse)
+void poly_challenge_sparse(poly_sparse *cs, const poly *c);
+#define poly_sparse_mul_eta DILITHIUM_NAMESPACE(poly_sparse_mul_eta)
+void poly_sparse_mul_eta(poly *r, const poly_sparse *c, const poly *a);
+#define poly_sparse_mul DILITHIUM_NAMESPACE(poly_sparse_mul)
+void poly_sparse_mul(poly *r, const poly_sparse *c, const poly *a);
 
 #define poly_uniform_4x DILITHIUM_NAMESPACE(poly_uniform_4x)
 void poly_uniform_4x(poly *a0,
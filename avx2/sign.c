@@ -1,5 +1,7 @@
+#define _POSIX_C_SOURCE 199309L // POSIX compliance
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
 #include "align.h"
 #include "params.h"
 #include "sign.h"
@@ -9,6 +11,12 @@
 #include "randombytes.h"
 #include "symmetric.h"
 #include "fips202.h"
+#include "fips202x4.h"
+
+// global timing struct now defined in sign.h
+__thread timing_info_t g_time = {0};
+
+#define PREHASH_OIDBYTES 11
 
 static inline void polyvec_matrix_expand_row(polyvecl **row, polyvecl buf[2], const uint8_t rho[SEEDBYTES], unsigned int i) {
   switch(i) {
@@ -51,6 +59,115 @@ static inline void polyvec_matrix_expand_row(polyvecl **row, polyvecl buf[2], co
   }
 }
 
+/* Team of the row-parallel mode, per calling thread (crypto_sign_set_team) */
+static __thread const sign_team *row_team;
+
+/*************************************************
+* Name:        crypto_sign_set_team
+*
+* Description: Sets the thread team that operations on the calling thread
+*              split the rows of matrix A over (NULL: none).
+*
+* Arguments:   - const sign_team *team: thread team, or NULL
+**************************************************/
+void crypto_sign_set_team(const sign_team *team) {
+  row_team = team;
+}
+
+static int rows_parallel(void) {
+  return row_team && row_team->width >= 2;
+}
+
+typedef struct {
+  polyvecl *mat;
+  const uint8_t *rho;
+} expand_job;
+
+/* Row i and the entries of row i+1 sampled along with it; each entry of A
+ * is written by exactly one row function */
+static void expand_row(void *arg, unsigned int i) {
+  static void (*const row_fn[K])(polyvecl *, polyvecl *, const uint8_t *) = {
+    polyvec_matrix_expand_row0, polyvec_matrix_expand_row1,
+    polyvec_matrix_expand_row2, polyvec_matrix_expand_row3,
+#if K > 4
+    polyvec_matrix_expand_row4, polyvec_matrix_expand_row5,
+#endif
+#if K > 6
+    polyvec_matrix_expand_row6, polyvec_matrix_expand_row7,
+#endif
+  };
+  expand_job *job = arg;
+  polyvecl spill;
+
+  row_fn[i](&job->mat[i], i + 1 < K ? &job->mat[i+1] : &spill, job->rho);
+}
+
+/* ExpandA, one row per team call if a team is set */
+static void matrix_expand(polyvecl mat[K], const uint8_t rho[SEEDBYTES]) {
+  expand_job job;
+
+  if(!rows_parallel()) {
+    polyvec_matrix_expand(mat, rho);
+    return;
+  }
+  job.mat = mat;
+  job.rho = rho;
+  row_team->run(row_team, expand_row, &job, K);
+}
+
+typedef struct {
+  polyveck *t;
+  const polyvecl *mat;
+  const polyvecl *v;
+  const poly *c;
+  const polyveck *u;
+} product_job;
+
+static void product_row(void *arg, unsigned int i) {
+  product_job *job = arg;
+  poly *t = &job->t->vec[i];
+  poly cu;
+
+  polyvecl_pointwise_acc_montgomery(t, &job->mat[i], job->v);
+  if(job->c) {
+    poly_pointwise_montgomery(&cu, job->c, &job->u->vec[i]);
+    poly_sub(t, t, &cu);
+    poly_reduce(t);
+  }
+  poly_invntt_tomont(t);
+}
+
+/*************************************************
+* Name:        matrix_product
+*
+* Description: Computes t = A*v - c*u row by row and transforms it out of
+*              NTT domain; one row per team call if a team is set. All
+*              inputs in NTT domain.
+*
+* Arguments:   - polyveck *t: pointer to output vector
+*              - const polyvecl mat[K]: matrix A
+*              - const polyvecl *v: pointer to input vector
+*              - const poly *c: pointer to challenge, or NULL for t = A*v
+*              - const polyveck *u: pointer to vector multiplied by c
+**************************************************/
+static void matrix_product(polyveck *t, const polyvecl mat[K], const polyvecl *v,
+                           const poly *c, const polyveck *u) {
+  unsigned int i;
+  product_job job;
+
+  job.t = t;
+  job.mat = mat;
+  job.v = v;
+  job.c = c;
+  job.u = u;
+  if(!rows_parallel()) {
+    for(i = 0; i < K; i++)
+      product_row(&job, i);
+    return;
+  }
+  row_team->run(row_team, product_row, &job, K);
+}
+
 /*************************************************
 * Name:        crypto_sign_keypair
 *
@@ -64,6 +181,9 @@ static inline void polyvec_matrix_expand_row(polyvecl **row, polyvecl buf[2], co
 * Returns 0 (success)
 **************************************************/
 int crypto_sign_keypair(uint8_t *pk, uint8_t *sk) {
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
   unsigned int i;
   uint8_t seedbuf[2*SEEDBYTES + CRHBYTES];
   const uint8_t *rho, *rhoprime, *key;
@@ -112,34 +232,83 @@ int crypto_sign_keypair(uint8_t *pk, uint8_t *sk) {
   /* Transform s1 */
   polyvecl_ntt(&s1);
 
-  for(i = 0; i < K; i++) {
-    /* Expand matrix row */
-    polyvec_matrix_expand_row(&row, rowbuf, rho, i);
+  /* With a team, expand the whole matrix and compute A*s1 row-parallel */
+  if(rows_parallel()) {
+    polyvecl mat[K];
+    polyveck t;
 
-    /* Compute inner-product */
-    polyvecl_pointwise_acc_montgomery(&t1, row, &s1);
-    poly_invntt_tomont(&t1);
+    matrix_expand(mat, rho);
+    matrix_product(&t, mat, &s1, NULL, NULL);
+    for(i = 0; i < K; i++) {
+      poly_add(&t1, &t.vec[i], &s2.vec[i]);
+      poly_caddq(&t1);
+      poly_power2round(&t1, &t0, &t1);
+      polyt1_pack(pk + SEEDBYTES + i*POLYT1_PACKEDBYTES, &t1);
+      polyt0_pack(sk + 2*SEEDBYTES + TRBYTES + (L+K)*POLYETA_PACKEDBYTES + i*POLYT0_PACKEDBYTES, &t0);
+    }
+  } else {
+    for(i = 0; i < K; i++) {
+      /* Expand matrix row */
+      polyvec_matrix_expand_row(&row, rowbuf, rho, i);
+
+      /* Compute inner-product */
+      polyvecl_pointwise_acc_montgomery(&t1, row, &s1);
+      poly_invntt_tomont(&t1);
 
-    /* Add error polynomial */
-    poly_add(&t1, &t1, &s2.vec[i]);
+      /* Add error polynomial */
+      poly_add(&t1, &t1, &s2.vec[i]);
 
-    /* Round t and pack t1, t0 */
-    poly_caddq(&t1);
-    poly_power2round(&t1, &t0, &t1);
-    polyt1_pack(pk + SEEDBYTES + i*POLYT1_PACKEDBYTES, &t1);
-    polyt0_pack(sk + 2*SEEDBYTES + TRBYTES + (L+K)*POLYETA_PACKEDBYTES + i*POLYT0_PACKEDBYTES, &t0);
+      /* Round t and pack t1, t0 */
+      poly_caddq(&t1);
+      poly_power2round(&t1, &t0, &t1);
+      polyt1_pack(pk + SEEDBYTES + i*POLYT1_PACKEDBYTES, &t1);
+      polyt0_pack(sk + 2*SEEDBYTES + TRBYTES + (L+K)*POLYETA_PACKEDBYTES + i*POLYT0_PACKEDBYTES, &t0);
+    }
   }
 
   /* Compute H(rho, t1) and store in secret key */
   shake256(sk + 2*SEEDBYTES, TRBYTES, pk, CRYPTO_PUBLICKEYBYTES);
 
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.keygen += t;
+  g_time.all += t;
+
   return 0;
 }
 
 /*************************************************
-* Name:        crypto_sign_signature_internal
+* Name:        crypto_sign_key_expand
 *
-* Description: Computes signature. Internal API.
+* Description: Unpacks secret key, expands matrix A and transforms the
+*              secret vectors that are multiplied by the challenge through
+*              the NTT (SPARSE_CS, SPARSE_CT0) to NTT domain, so that
+*              repeated signatures under the same key skip this work.
+*
+* Arguments:   - sign_ctx *sctx: pointer to output expanded key
+*              - uint8_t *sk: pointer to bit-packed secret key
+**************************************************/
+void crypto_sign_key_expand(sign_ctx *sctx, const uint8_t *sk)
+{
+  uint8_t rho[SEEDBYTES];
+
+  unpack_sk(rho, sctx->tr, sctx->key, &sctx->t0, &sctx->s1, &sctx->s2, sk);
+
+  /* Expand matrix and transform vectors */
+  matrix_expand(sctx->mat, rho);
+#if !SPARSE_CS
+  polyvecl_ntt(&sctx->s1);
+  polyveck_ntt(&sctx->s2);
+#endif
+#if !SPARSE_CT0
+  polyveck_ntt(&sctx->t0);
+#endif
+}
+
+/*************************************************
+* Name:        crypto_sign_signature_ctx_internal
+*
+* Description: Computes signature with expanded secret key. Internal API.
 *
 * Arguments:   - uint8_t *sig: pointer to output signature (of length CRYPTO_BYTES)
 *              - size_t *siglen: pointer to output length of signature
@@ -148,74 +317,130 @@ int crypto_sign_keypair(uint8_t *pk, uint8_t *sk) {
 *              - uint8_t *pre: pointer to prefix string
 *              - size_t prelen: length of prefix string
 *              - uint8_t *rnd: pointer to random seed
-*              - uint8_t *sk: pointer to bit-packed secret key
+*              - sign_ctx *sctx: pointer to expanded secret key
 *
 * Returns 0 (success)
 **************************************************/
-int crypto_sign_signature_internal(uint8_t *sig, size_t *siglen, const uint8_t *m, size_t mlen,
-                                   const uint8_t *pre, size_t prelen, const uint8_t rnd[RNDBYTES], const uint8_t *sk)
+int crypto_sign_signature_ctx_internal(uint8_t *sig, size_t *siglen, const uint8_t *m, size_t mlen,
+                                       const uint8_t *pre, size_t prelen, const uint8_t rnd[RNDBYTES],
+                                       const sign_ctx *sctx)
 {
-  unsigned int i, n, pos;
-  uint8_t seedbuf[2*SEEDBYTES + TRBYTES + 2*CRHBYTES];
-  uint8_t *rho, *tr, *key, *mu, *rhoprime;
-  uint8_t hintbuf[N];
-  uint8_t *hint = sig + CTILDEBYTES + L*POLYZ_PACKEDBYTES;
-  uint64_t nonce = 0;
-  polyvecl mat[K], s1, z;
-  polyveck t0, s2, w1;
-  poly c, tmp;
-  union {
-    polyvecl y;
-    polyveck w0;
-  } tmpv;
-  keccak_state state;
+  uint8_t mu[CRHBYTES];
 
-  rho = seedbuf;
-  tr = rho + SEEDBYTES;
-  key = tr + TRBYTES;
-  mu = key + SEEDBYTES;
-  rhoprime = mu + CRHBYTES;
-  unpack_sk(rho, tr, key, &t0, &s1, &s2, sk);
+  crypto_sign_mu_internal(mu, m, mlen, pre, prelen, sctx);
+  return crypto_sign_signature_mu_internal(sig, siglen, mu, rnd, sctx);
+}
+
+/*************************************************
+* Name:        crypto_sign_mu_internal
+*
+* Description: Computes the message representative mu = CRH(tr, pre, m)
+*              from an expanded secret key. Internal API.
+*
+* Arguments:   - uint8_t *mu: output mu (of length CRHBYTES)
+*              - uint8_t *m: pointer to message
+*              - size_t mlen: length of message
+*              - uint8_t *pre: pointer to prefix string
+*              - size_t prelen: length of prefix string
+*              - sign_ctx *sctx: pointer to expanded secret key
+**************************************************/
+void crypto_sign_mu_internal(uint8_t mu[CRHBYTES], const uint8_t *m, size_t mlen,
+                             const uint8_t *pre, size_t prelen, const sign_ctx *sctx)
+{
+  keccak_state state;
 
-  /* Compute mu = CRH(tr, pre, msg) */
   shake256_init(&state);
-  shake256_absorb(&state, tr, TRBYTES);
+  shake256_absorb(&state, sctx->tr, TRBYTES);
   shake256_absorb(&state, pre, prelen);
   shake256_absorb(&state, m, mlen);
   shake256_finalize(&state);
   shake256_squeeze(mu, CRHBYTES, &state);
+}
 
-  /* Compute rhoprime = CRH(key, rnd, mu) */
-  shake256_init(&state);
-  shake256_absorb(&state, key, SEEDBYTES);
-  shake256_absorb(&state, rnd, RNDBYTES);
-  shake256_absorb(&state, mu, CRHBYTES);
-  shake256_finalize(&state);
-  shake256_squeeze(rhoprime, CRHBYTES, &state);
+/* Challenge c in the forms its products with the secret polynomials take:
+ * sparse (SPARSE_CS, SPARSE_CT0 in config.h) or NTT domain */
+typedef struct {
+  poly ntt;
+  poly_sparse sparse;
+} challenge;
 
-  /* Expand matrix and transform vectors */
-  polyvec_matrix_expand(mat, rho);
-  polyvecl_ntt(&s1);
-  polyveck_ntt(&s2);
-  polyveck_ntt(&t0);
+static void challenge_expand(challenge *c, const uint8_t seed[CTILDEBYTES]) {
+  poly_challenge(&c->ntt, seed);
+#if SPARSE_CS || SPARSE_CT0
+  poly_challenge_sparse(&c->sparse, &c->ntt);
+#endif
+#if !SPARSE_CS || !SPARSE_CT0
+  poly_ntt(&c->ntt);
+#endif
+}
+
+/* r = c*s for a polynomial s of s1 or s2, normal domain, not reduced */
+static void challenge_mul_s(poly *r, const challenge *c, const poly *s) {
+#if SPARSE_CS
+  poly_sparse_mul_eta(r, &c->sparse, s);
+#else
+  poly_pointwise_montgomery(r, &c->ntt, s);
+  poly_invntt_tomont(r);
+#endif
+}
+
+/* r = c*t for a polynomial t of t0, normal domain, not reduced */
+static void challenge_mul_t0(poly *r, const challenge *c, const poly *t) {
+#if SPARSE_CT0
+  poly_sparse_mul(r, &c->sparse, t);
+#else
+  poly_pointwise_montgomery(r, &c->ntt, t);
+  poly_invntt_tomont(r);
+#endif
+}
+
+/*************************************************
+* Name:        sign_attempt
+*
+* Description: One pass of the rejection loop: samples y for the given
+*              attempt number, computes w, the challenge and the response
+*              and checks them. Attempts with different numbers are
+*              independent.
+*
+* Arguments:   - uint8_t *sig: pointer to output signature, complete only if
+*                              the attempt is accepted
+*              - uint8_t *mu: pointer to message representative
+*              - uint8_t *rhoprime: pointer to seed for y
+*              - uint16_t attempt: attempt number
+*              - sign_ctx *sctx: pointer to expanded secret key
+*
+* Returns 0 (accepted) or -1 (rejected)
+**************************************************/
+static int sign_attempt(uint8_t *sig, const uint8_t mu[CRHBYTES], const uint8_t rhoprime[CRHBYTES],
+                        uint16_t attempt, const sign_ctx *sctx)
+{
+  unsigned int i, n, pos;
+  uint8_t hintbuf[N];
+  uint8_t *hint = sig + CTILDEBYTES + L*POLYZ_PACKEDBYTES;
+  uint16_t nonce = L*attempt;
+  polyvecl z;
+  polyveck w1;
+  poly tmp;
+  challenge c;
+  union {
+    polyvecl y;
+    polyveck w0;
+  } tmpv;
+  keccak_state state;
 
-rej:
   /* Sample intermediate vector y */
 #if L == 4
   poly_uniform_gamma1_4x(&z.vec[0], &z.vec[1], &z.vec[2], &z.vec[3],
                          rhoprime, nonce, nonce + 1, nonce + 2, nonce + 3);
-  nonce += 4;
 #elif L == 5
   poly_uniform_gamma1_4x(&z.vec[0], &z.vec[1], &z.vec[2], &z.vec[3],
                          rhoprime, nonce, nonce + 1, nonce + 2, nonce + 3);
   poly_uniform_gamma1(&z.vec[4], rhoprime, nonce + 4);
-  nonce += 5;
 #elif L == 7
   poly_uniform_gamma1_4x(&z.vec[0], &z.vec[1], &z.vec[2], &z.vec[3],
                          rhoprime, nonce, nonce + 1, nonce + 2, nonce + 3);
   poly_uniform_gamma1_4x(&z.vec[4], &z.vec[5], &z.vec[6], &tmp,
                          rhoprime, nonce + 4, nonce + 5, nonce + 6, 0);
-  nonce += 7;
 #else
 #error
 #endif
@@ -223,8 +448,7 @@ rej:
   /* Matrix-vector product */
   tmpv.y = z;
   polyvecl_ntt(&tmpv.y);
-  polyvec_matrix_pointwise_montgomery(&w1, mat, &tmpv.y);
-  polyveck_invntt_tomont(&w1);
+  matrix_product(&w1, sctx->mat, &tmpv.y, NULL, NULL);
 
   /* Decompose w and call the random oracle */
   polyveck_caddq(&w1);
@@ -236,17 +460,15 @@ rej:
   shake256_absorb(&state, sig, K*POLYW1_PACKEDBYTES);
   shake256_finalize(&state);
   shake256_squeeze(sig, CTILDEBYTES, &state);
-  poly_challenge(&c, sig);
-  poly_ntt(&c);
+  challenge_expand(&c, sig);
 
   /* Compute z, reject if it reveals secret */
   for(i = 0; i < L; i++) {
-    poly_pointwise_montgomery(&tmp, &c, &s1.vec[i]);
-    poly_invntt_tomont(&tmp);
+    challenge_mul_s(&tmp, &c, &sctx->s1.vec[i]);
     poly_add(&z.vec[i], &z.vec[i], &tmp);
     poly_reduce(&z.vec[i]);
     if(poly_chknorm(&z.vec[i], GAMMA1 - BETA))
-      goto rej;
+      return -1;
   }
 
   /* Zero hint vector in signature */
@@ -256,24 +478,22 @@ rej:
   for(i = 0; i < K; i++) {
     /* Check that subtracting cs2 does not change high bits of w and low bits
      * do not reveal secret information */
-    poly_pointwise_montgomery(&tmp, &c, &s2.vec[i]);
-    poly_invntt_tomont(&tmp);
+    challenge_mul_s(&tmp, &c, &sctx->s2.vec[i]);
     poly_sub(&tmpv.w0.vec[i], &tmpv.w0.vec[i], &tmp);
     poly_reduce(&tmpv.w0.vec[i]);
     if(poly_chknorm(&tmpv.w0.vec[i], GAMMA2 - BETA))
-      goto rej;
+      return -1;
 
     /* Compute hints */
-    poly_pointwise_montgomery(&tmp, &c, &t0.vec[i]);
-    poly_invntt_tomont(&tmp);
+    challenge_mul_t0(&tmp, &c, &sctx->t0.vec[i]);
     poly_reduce(&tmp);
     if(poly_chknorm(&tmp, GAMMA2))
-      goto rej;
+      return -1;
 
     poly_add(&tmpv.w0.vec[i], &tmpv.w0.vec[i], &tmp);
     n = poly_make_hint(hintbuf, &tmpv.w0.vec[i], &w1.vec[i]);
     if(pos + n > OMEGA)
-      goto rej;
+      return -1;
 
     /* Store hints in signature */
     memcpy(&hint[pos], hintbuf, n);
@@ -284,133 +504,519 @@ rej:
   for(i = 0; i < L; i++)
     polyz_pack(sig + CTILDEBYTES + i*POLYZ_PACKEDBYTES, &z.vec[i]);
 
-  *siglen = CRYPTO_BYTES;
   return 0;
 }
 
+/* rhoprime = CRH(key, rnd, mu) */
+static void sign_rhoprime(uint8_t rhoprime[CRHBYTES], const uint8_t mu[CRHBYTES],
+                          const uint8_t rnd[RNDBYTES], const sign_ctx *sctx)
+{
+  keccak_state state;
+
+  shake256_init(&state);
+  shake256_absorb(&state, sctx->key, SEEDBYTES);
+  shake256_absorb(&state, rnd, RNDBYTES);
+  shake256_absorb(&state, mu, CRHBYTES);
+  shake256_finalize(&state);
+  shake256_squeeze(rhoprime, CRHBYTES, &state);
+}
+
 /*************************************************
-* Name:        crypto_sign_signature
+* Name:        crypto_sign_signature_mu_internal
 *
-* Description: Computes signature.
+* Description: Computes signature over a precomputed message
+*              representative mu = CRH(tr, pre, m). Internal API.
 *
 * Arguments:   - uint8_t *sig: pointer to output signature (of length CRYPTO_BYTES)
 *              - size_t *siglen: pointer to output length of signature
-*              - uint8_t *m: pointer to message to be signed
-*              - size_t mlen: length of message
-*              - uint8_t *ctx: pointer to context string
-*              - size_t ctxlen: length of context string
-*              - uint8_t *sk: pointer to bit-packed secret key
+*              - uint8_t *mu: pointer to message representative
+*              - uint8_t *rnd: pointer to random seed
+*              - sign_ctx *sctx: pointer to expanded secret key
 *
-* Returns 0 (success) or -1 (context string too long)
+* Returns 0 (success)
 **************************************************/
-int crypto_sign_signature(uint8_t *sig, size_t *siglen, const uint8_t *m, size_t mlen,
-                          const uint8_t *ctx, size_t ctxlen, const uint8_t *sk)
+int crypto_sign_signature_mu_internal(uint8_t *sig, size_t *siglen, const uint8_t mu[CRHBYTES],
+                                      const uint8_t rnd[RNDBYTES], const sign_ctx *sctx)
 {
-  uint8_t pre[257];
-  uint8_t rnd[RNDBYTES];
+  uint8_t rhoprime[CRHBYTES];
+  uint16_t attempt = 0;
 
-  if(ctxlen > 255)
-    return -1;
+  sign_rhoprime(rhoprime, mu, rnd, sctx);
+  while(sign_attempt(sig, mu, rhoprime, attempt++, sctx))
+    ;
 
-  /* Prepare pre = (0, ctxlen, ctx) */
-  pre[0] = 0;
-  pre[1] = ctxlen;
-  memcpy(&pre[2], ctx, ctxlen);
+  *siglen = CRYPTO_BYTES;
+  return 0;
+}
 
-#ifdef DILITHIUM_RANDOMIZED_SIGNING
-  randombytes(rnd, RNDBYTES);
-#else
-  memset(rnd, 0, RNDBYTES);
-#endif
+/* One round of speculative signing: attempts first .. first + width - 1 */
+typedef struct {
+  uint8_t sig[SIGN_SPEC_MAX_WIDTH][CRYPTO_BYTES];
+  unsigned int first; // lowest accepted candidate so far, width if none
+  uint16_t attempt;
+  const uint8_t *mu;
+  const uint8_t *rhoprime;
+  const sign_ctx *sctx;
+} spec_round;
 
-  crypto_sign_signature_internal(sig,siglen,m,mlen,pre,2+ctxlen,rnd,sk);
-  return 0;
+static void spec_candidate(void *arg, unsigned int i)
+{
+  spec_round *r = arg;
+  unsigned int first;
+
+  /* A candidate behind an accepted one can no longer be the result */
+  if(i > __atomic_load_n(&r->first, __ATOMIC_ACQUIRE))
+    return;
+  if(sign_attempt(r->sig[i], r->mu, r->rhoprime, r->attempt + i, r->sctx))
+    return;
+  first = __atomic_load_n(&r->first, __ATOMIC_RELAXED);
+  while(i < first && !__atomic_compare_exchange_n(&r->first, &first, i, 0,
+                                                  __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    ;
 }
 
 /*************************************************
-* Name:        crypto_sign
+* Name:        crypto_sign_signature_mu_spec
 *
-* Description: Compute signed message.
+* Description: Like crypto_sign_signature_mu_internal, but evaluates up to
+*              SIGN_SPEC_MAX_WIDTH attempts at once on a thread team and
+*              keeps the first accepted one in attempt order, so the
+*              signature is the same as the sequential one. Without a team
+*              (NULL or width 1) it signs sequentially.
 *
-* Arguments:   - uint8_t *sm: pointer to output signed message (allocated
-*                             array with CRYPTO_BYTES + mlen bytes),
-*                             can be equal to m
-*              - size_t *smlen: pointer to output length of signed
-*                               message
-*              - const uint8_t *m: pointer to message to be signed
-*              - size_t mlen: length of message
-*              - const uint8_t *ctx: pointer to context string
-*              - size_t ctxlen: length of context string
-*              - const uint8_t *sk: pointer to bit-packed secret key
+* Arguments:   - uint8_t *sig: pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen: pointer to output length of signature
+*              - uint8_t *mu: pointer to message representative
+*              - uint8_t *rnd: pointer to random seed
+*              - sign_ctx *sctx: pointer to expanded secret key
+*              - const sign_team *team: thread team to spread the attempts over
 *
 * Returns 0 (success)
 **************************************************/
-int crypto_sign(uint8_t *sm, size_t *smlen, const uint8_t *m, size_t mlen, const uint8_t *ctx, size_t ctxlen,
-                const uint8_t *sk)
+int crypto_sign_signature_mu_spec(uint8_t *sig, size_t *siglen, const uint8_t mu[CRHBYTES],
+                                  const uint8_t rnd[RNDBYTES], const sign_ctx *sctx,
+                                  const sign_team *team)
 {
-  size_t i;
-  int ret;
+  uint8_t rhoprime[CRHBYTES];
+  unsigned int width;
+  spec_round r;
+  const sign_team *rows;
 
-  for(i = 0; i < mlen; ++i)
-    sm[CRYPTO_BYTES + mlen - 1 - i] = m[mlen - 1 - i];
-  ret = crypto_sign_signature(sm, smlen, sm + CRYPTO_BYTES, mlen, ctx, ctxlen, sk);
-  *smlen += mlen;
-  return ret;
+  if(!team || team->width < 2)
+    return crypto_sign_signature_mu_internal(sig, siglen, mu, rnd, sctx);
+
+  /* The attempts run whole on the team members, not split by rows */
+  rows = row_team;
+  row_team = NULL;
+
+  width = team->width < SIGN_SPEC_MAX_WIDTH ? team->width : SIGN_SPEC_MAX_WIDTH;
+  sign_rhoprime(rhoprime, mu, rnd, sctx);
+  r.attempt = 0;
+  r.mu = mu;
+  r.rhoprime = rhoprime;
+  r.sctx = sctx;
+  for(;;) {
+    r.first = width;
+    team->run(team, spec_candidate, &r, width);
+    if(r.first < width)
+      break;
+    r.attempt += width;
+  }
+  row_team = rows;
+
+  memcpy(sig, r.sig[r.first], CRYPTO_BYTES);
+  *siglen = CRYPTO_BYTES;
+  return 0;
+}
+
+/* memset that the compiler may not drop as a dead store */
+static void wipe(void *p, size_t len) {
+  memset(p, 0, len);
+  __asm__ __volatile__("" : : "r"(p) : "memory");
 }
 
 /*************************************************
-* Name:        crypto_sign_verify_internal
+* Name:        crypto_sign_commit
 *
-* Description: Verifies signature. Internal API.
-*
-* Arguments:   - uint8_t *m: pointer to input signature
-*              - size_t siglen: length of signature
-*              - const uint8_t *m: pointer to message
-*              - size_t mlen: length of message
-*              - const uint8_t *pre: pointer to prefix string
-*              - size_t prelen: length of prefix string
-*              - const uint8_t *pk: pointer to bit-packed public key
+* Description: Offline half of offline/online signing (not FIPS 204, see
+*              sign.h): samples a mask y from fresh randomness and the key
+*              and computes the decomposed commitment w = A*y.
 *
-* Returns 0 if signature could be verified correctly and -1 otherwise
+* Arguments:   - sign_commitment *cm: pointer to output commitment
+*              - sign_ctx *sctx: pointer to expanded secret key
 **************************************************/
-int crypto_sign_verify_internal(const uint8_t *sig, size_t siglen, const uint8_t *m, size_t mlen,
-                                const uint8_t *pre, size_t prelen, const uint8_t *pk) {
-  unsigned int i, j, pos = 0;
-  /* polyw1_pack writes additional 14 bytes */
+void crypto_sign_commit(sign_commitment *cm, const sign_ctx *sctx)
+{
+  uint8_t rnd[RNDBYTES];
+  uint8_t rhoprime[CRHBYTES];
   ALIGNED_UINT8(K*POLYW1_PACKEDBYTES+14) buf;
-  uint8_t mu[CRHBYTES];
-  const uint8_t *hint = sig + CTILDEBYTES + L*POLYZ_PACKEDBYTES;
-  polyvecl rowbuf[2];
-  polyvecl *row = rowbuf;
-  polyvecl z;
-  poly c, w1, h;
+  polyvecl yhat;
+  poly tmp;
   keccak_state state;
 
-  if(siglen != CRYPTO_BYTES)
-    return -1;
-
-  /* Compute CRH(H(rho, t1), pre, msg) */
-  shake256(mu, TRBYTES, pk, CRYPTO_PUBLICKEYBYTES);
+  /* rhoprime = CRH(key, rnd): mu is not known yet */
+  randombytes(rnd, RNDBYTES);
   shake256_init(&state);
-  shake256_absorb(&state, mu, CRHBYTES);
-  shake256_absorb(&state, pre, prelen);
-  shake256_absorb(&state, m, mlen);
+  shake256_absorb(&state, sctx->key, SEEDBYTES);
+  shake256_absorb(&state, rnd, RNDBYTES);
   shake256_finalize(&state);
-  shake256_squeeze(mu, CRHBYTES, &state);
-
-  /* Expand challenge */
-  poly_challenge(&c, sig);
-  poly_ntt(&c);
+  shake256_squeeze(rhoprime, CRHBYTES, &state);
 
-  /* Unpack z; shortness follows from unpacking */
-  for(i = 0; i < L; i++) {
-    polyz_unpack(&z.vec[i], sig + CTILDEBYTES + i*POLYZ_PACKEDBYTES);
-    poly_ntt(&z.vec[i]);
-  }
+#if L == 4
+  poly_uniform_gamma1_4x(&cm->y.vec[0], &cm->y.vec[1], &cm->y.vec[2], &cm->y.vec[3],
+                         rhoprime, 0, 1, 2, 3);
+#elif L == 5
+  poly_uniform_gamma1_4x(&cm->y.vec[0], &cm->y.vec[1], &cm->y.vec[2], &cm->y.vec[3],
+                         rhoprime, 0, 1, 2, 3);
+  poly_uniform_gamma1(&cm->y.vec[4], rhoprime, 4);
+#elif L == 7
+  poly_uniform_gamma1_4x(&cm->y.vec[0], &cm->y.vec[1], &cm->y.vec[2], &cm->y.vec[3],
+                         rhoprime, 0, 1, 2, 3);
+  poly_uniform_gamma1_4x(&cm->y.vec[4], &cm->y.vec[5], &cm->y.vec[6], &tmp,
+                         rhoprime, 4, 5, 6, 0);
+#else
+#error
+#endif
+  wipe(rnd, sizeof(rnd));
+  wipe(rhoprime, sizeof(rhoprime));
 
-  for(i = 0; i < K; i++) {
-    /* Expand matrix row */
-    polyvec_matrix_expand_row(&row, rowbuf, pk, i);
+  yhat = cm->y;
+  polyvecl_ntt(&yhat);
+  matrix_product(&cm->w1, sctx->mat, &yhat, NULL, NULL);
+
+  polyveck_caddq(&cm->w1);
+  polyveck_decompose(&cm->w1, &cm->w0, &cm->w1);
+  /* polyw1_pack writes additional 14 bytes */
+  polyveck_pack_w1(buf.coeffs, &cm->w1);
+  memcpy(cm->w1_packed, buf.coeffs, K*POLYW1_PACKEDBYTES);
+  wipe(&yhat, sizeof(yhat));
+  wipe(&tmp, sizeof(tmp));
+  wipe(&buf, sizeof(buf));
+  cm->ready = 1;
+}
+
+/*************************************************
+* Name:        crypto_sign_signature_commit
+*
+* Description: Online half of offline/online signing: one signing attempt
+*              over mu with a commitment from crypto_sign_commit. The
+*              commitment is wiped in any case; one that is not ready is
+*              refused without writing a signature.
+*
+* Arguments:   - uint8_t *sig: pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen: pointer to output length of signature
+*              - uint8_t *mu: pointer to message representative
+*              - sign_commitment *cm: pointer to commitment, used up
+*              - sign_ctx *sctx: pointer to expanded secret key
+*
+* Returns 0 (success) or -1 (attempt rejected or commitment not ready;
+* retry with a new commitment)
+**************************************************/
+int crypto_sign_signature_commit(uint8_t *sig, size_t *siglen, const uint8_t mu[CRHBYTES],
+                                 sign_commitment *cm, const sign_ctx *sctx)
+{
+  unsigned int i, n, pos;
+  uint8_t hintbuf[N];
+  uint8_t *hint = sig + CTILDEBYTES + L*POLYZ_PACKEDBYTES;
+  polyvecl z;
+  poly tmp, w0;
+  challenge c;
+  keccak_state state;
+
+  /* Never sign twice with the same y */
+  if(!cm->ready)
+    return -1;
+  cm->ready = 0;
+
+  /* Call the random oracle on the precomputed w1 */
+  shake256_init(&state);
+  shake256_absorb(&state, mu, CRHBYTES);
+  shake256_absorb(&state, cm->w1_packed, K*POLYW1_PACKEDBYTES);
+  shake256_finalize(&state);
+  shake256_squeeze(sig, CTILDEBYTES, &state);
+  challenge_expand(&c, sig);
+
+  /* Compute z, reject if it reveals secret */
+  for(i = 0; i < L; i++) {
+    challenge_mul_s(&tmp, &c, &sctx->s1.vec[i]);
+    poly_add(&z.vec[i], &cm->y.vec[i], &tmp);
+    poly_reduce(&z.vec[i]);
+    if(poly_chknorm(&z.vec[i], GAMMA1 - BETA))
+      goto rej;
+  }
+
+  pos = 0;
+  memset(hint, 0, OMEGA);
+
+  for(i = 0; i < K; i++) {
+    challenge_mul_s(&tmp, &c, &sctx->s2.vec[i]);
+    poly_sub(&w0, &cm->w0.vec[i], &tmp);
+    poly_reduce(&w0);
+    if(poly_chknorm(&w0, GAMMA2 - BETA))
+      goto rej;
+
+    challenge_mul_t0(&tmp, &c, &sctx->t0.vec[i]);
+    poly_reduce(&tmp);
+    if(poly_chknorm(&tmp, GAMMA2))
+      goto rej;
+
+    poly_add(&w0, &w0, &tmp);
+    n = poly_make_hint(hintbuf, &w0, &cm->w1.vec[i]);
+    if(pos + n > OMEGA)
+      goto rej;
+
+    memcpy(&hint[pos], hintbuf, n);
+    hint[OMEGA + i] = pos = pos + n;
+  }
+
+  for(i = 0; i < L; i++)
+    polyz_pack(sig + CTILDEBYTES + i*POLYZ_PACKEDBYTES, &z.vec[i]);
+
+  *siglen = CRYPTO_BYTES;
+  wipe(cm, sizeof(*cm));
+  return 0;
+
+rej:
+  wipe(sig, CTILDEBYTES);
+  wipe(cm, sizeof(*cm));
+  return -1;
+}
+
+/*************************************************
+* Name:        crypto_sign_signature_internal
+*
+* Description: Computes signature. Internal API.
+*
+* Arguments:   - uint8_t *sig: pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen: pointer to output length of signature
+*              - uint8_t *m: pointer to message to be signed
+*              - size_t mlen: length of message
+*              - uint8_t *pre: pointer to prefix string
+*              - size_t prelen: length of prefix string
+*              - uint8_t *rnd: pointer to random seed
+*              - uint8_t *sk: pointer to bit-packed secret key
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_sign_signature_internal(uint8_t *sig, size_t *siglen, const uint8_t *m, size_t mlen,
+                                   const uint8_t *pre, size_t prelen, const uint8_t rnd[RNDBYTES], const uint8_t *sk)
+{
+  sign_ctx sctx;
+
+  crypto_sign_key_expand(&sctx, sk);
+  return crypto_sign_signature_ctx_internal(sig, siglen, m, mlen, pre, prelen, rnd, &sctx);
+}
+
+/*************************************************
+* Name:        build_prefix
+*
+* Description: Writes pre = (domain, ctxlen, ctx). ctx may be NULL when
+*              ctxlen is 0.
+*
+* Arguments:   - uint8_t *pre: pointer to output prefix (of length 2 + ctxlen)
+*              - uint8_t domain: 0 for ML-DSA, 1 for HashML-DSA
+*              - uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string, at most 255
+*
+* Returns length of the prefix
+**************************************************/
+static size_t build_prefix(uint8_t *pre, uint8_t domain, const uint8_t *ctx, size_t ctxlen) {
+  pre[0] = domain;
+  pre[1] = ctxlen;
+  if(ctxlen)
+    memcpy(&pre[2], ctx, ctxlen);
+  return 2 + ctxlen;
+}
+
+/*************************************************
+* Name:        crypto_sign_signature
+*
+* Description: Computes signature.
+*
+* Arguments:   - uint8_t *sig: pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen: pointer to output length of signature
+*              - uint8_t *m: pointer to message to be signed
+*              - size_t mlen: length of message
+*              - uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - uint8_t *sk: pointer to bit-packed secret key
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_signature(uint8_t *sig, size_t *siglen, const uint8_t *m, size_t mlen,
+                          const uint8_t *ctx, size_t ctxlen, const uint8_t *sk)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint8_t pre[257];
+  uint8_t rnd[RNDBYTES];
+
+  if(ctxlen > 255)
+    return -1;
+
+  /* Prepare pre = (0, ctxlen, ctx) */
+  build_prefix(pre, 0, ctx, ctxlen);
+
+#ifdef DILITHIUM_RANDOMIZED_SIGNING
+  randombytes(rnd, RNDBYTES);
+#else
+  memset(rnd, 0, RNDBYTES);
+#endif
+
+  crypto_sign_signature_internal(sig,siglen,m,mlen,pre,2+ctxlen,rnd,sk);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.sign += t;
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_signature_ctx
+*
+* Description: Computes signature with expanded secret key.
+*
+* Arguments:   - uint8_t *sig: pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen: pointer to output length of signature
+*              - uint8_t *m: pointer to message to be signed
+*              - size_t mlen: length of message
+*              - uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - sign_ctx *sctx: pointer to expanded secret key
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_signature_ctx(uint8_t *sig, size_t *siglen, const uint8_t *m, size_t mlen,
+                              const uint8_t *ctx, size_t ctxlen, const sign_ctx *sctx)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint8_t pre[257];
+  uint8_t rnd[RNDBYTES];
+
+  if(ctxlen > 255)
+    return -1;
+
+  /* Prepare pre = (0, ctxlen, ctx) */
+  build_prefix(pre, 0, ctx, ctxlen);
+
+#ifdef DILITHIUM_RANDOMIZED_SIGNING
+  randombytes(rnd, RNDBYTES);
+#else
+  memset(rnd, 0, RNDBYTES);
+#endif
+
+  crypto_sign_signature_ctx_internal(sig,siglen,m,mlen,pre,2+ctxlen,rnd,sctx);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.sign += t;
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign
+*
+* Description: Compute signed message.
+*
+* Arguments:   - uint8_t *sm: pointer to output signed message (allocated
+*                             array with CRYPTO_BYTES + mlen bytes),
+*                             can be equal to m
+*              - size_t *smlen: pointer to output length of signed
+*                               message
+*              - const uint8_t *m: pointer to message to be signed
+*              - size_t mlen: length of message
+*              - const uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - const uint8_t *sk: pointer to bit-packed secret key
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_sign(uint8_t *sm, size_t *smlen, const uint8_t *m, size_t mlen, const uint8_t *ctx, size_t ctxlen,
+                const uint8_t *sk)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  size_t i;
+  int ret;
+
+  for(i = 0; i < mlen; ++i)
+    sm[CRYPTO_BYTES + mlen - 1 - i] = m[mlen - 1 - i];
+  ret = crypto_sign_signature(sm, smlen, sm + CRYPTO_BYTES, mlen, ctx, ctxlen, sk);
+  *smlen += mlen;
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.all += t;
+
+  return ret;
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_internal
+*
+* Description: Verifies signature. Internal API.
+*
+* Arguments:   - uint8_t *m: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *m: pointer to message
+*              - size_t mlen: length of message
+*              - const uint8_t *pre: pointer to prefix string
+*              - size_t prelen: length of prefix string
+*              - const uint8_t *pk: pointer to bit-packed public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_internal(const uint8_t *sig, size_t siglen, const uint8_t *m, size_t mlen,
+                                const uint8_t *pre, size_t prelen, const uint8_t *pk) {
+  unsigned int i, j, pos = 0;
+  /* polyw1_pack writes additional 14 bytes */
+  ALIGNED_UINT8(K*POLYW1_PACKEDBYTES+14) buf;
+  uint8_t mu[CRHBYTES];
+  const uint8_t *hint = sig + CTILDEBYTES + L*POLYZ_PACKEDBYTES;
+  polyvecl rowbuf[2];
+  polyvecl *row = rowbuf;
+  polyvecl z;
+  poly c, w1, h;
+  keccak_state state;
+
+  if(siglen != CRYPTO_BYTES)
+    return -1;
+
+  /* With a team, expand A whole so that its rows can be split */
+  if(rows_parallel()) {
+    verify_ctx vctx;
+    crypto_sign_pk_expand(&vctx, pk);
+    return crypto_sign_verify_ctx_internal(sig, siglen, m, mlen, pre, prelen, &vctx);
+  }
+
+  /* Compute CRH(H(rho, t1), pre, msg) */
+  shake256(mu, TRBYTES, pk, CRYPTO_PUBLICKEYBYTES);
+  shake256_init(&state);
+  shake256_absorb(&state, mu, CRHBYTES);
+  shake256_absorb(&state, pre, prelen);
+  shake256_absorb(&state, m, mlen);
+  shake256_finalize(&state);
+  shake256_squeeze(mu, CRHBYTES, &state);
+
+  /* Expand challenge */
+  poly_challenge(&c, sig);
+  poly_ntt(&c);
+
+  /* Unpack z; shortness follows from unpacking */
+  for(i = 0; i < L; i++) {
+    polyz_unpack(&z.vec[i], sig + CTILDEBYTES + i*POLYZ_PACKEDBYTES);
+    poly_ntt(&z.vec[i]);
+  }
+
+  for(i = 0; i < K; i++) {
+    /* Expand matrix row */
+    polyvec_matrix_expand_row(&row, rowbuf, pk, i);
 
     /* Compute i-th row of Az - c2^Dt1 */
     polyvecl_pointwise_acc_montgomery(&w1, row, &z);
@@ -436,14 +1042,450 @@ int crypto_sign_verify_internal(const uint8_t *sig, size_t siglen, const uint8_t
     }
     pos = hint[OMEGA + i];
 
-    poly_caddq(&w1);
-    poly_use_hint(&w1, &w1, &h);
-    polyw1_pack(buf.coeffs + i*POLYW1_PACKEDBYTES, &w1);
-  }
+    poly_caddq(&w1);
+    poly_use_hint(&w1, &w1, &h);
+    polyw1_pack(buf.coeffs + i*POLYW1_PACKEDBYTES, &w1);
+  }
+
+  /* Extra indices are zero for strong unforgeability */
+  for(j = pos; j < OMEGA; ++j)
+    if(hint[j]) return -1;
+
+  /* Call random oracle and verify challenge */
+  shake256_init(&state);
+  shake256_absorb(&state, mu, CRHBYTES);
+  shake256_absorb(&state, buf.coeffs, K*POLYW1_PACKEDBYTES);
+  shake256_finalize(&state);
+  shake256_squeeze(buf.coeffs, CTILDEBYTES, &state);
+  for(i = 0; i < CTILDEBYTES; ++i)
+    if(buf.coeffs[i] != sig[i])
+      return -1;
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_init
+*
+* Description: Starts a streaming signature. The message is absorbed
+*              incrementally with crypto_sign_update, so memory use does
+*              not depend on the message length.
+*
+* Arguments:   - sign_stream *st: pointer to stream state
+*              - uint8_t *ctx:    pointer to contex string
+*              - size_t ctxlen:   length of contex string
+*              - uint8_t *sk:     pointer to bit-packed secret key
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_init(sign_stream *st, const uint8_t *ctx, size_t ctxlen, const uint8_t *sk)
+{
+  uint8_t pre[257];
+
+  if(ctxlen > 255)
+    return -1;
+
+  build_prefix(pre, 0, ctx, ctxlen);
+
+  /* tr follows rho and key in the packed secret key */
+  shake256_init(&st->state);
+  shake256_absorb(&st->state, sk + 2*SEEDBYTES, TRBYTES);
+  shake256_absorb(&st->state, pre, 2+ctxlen);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_update
+*
+* Description: Absorbs the next part of the message to be signed.
+*
+* Arguments:   - sign_stream *st: pointer to stream state
+*              - uint8_t *m:      pointer to message part
+*              - size_t mlen:     length of message part
+**************************************************/
+void crypto_sign_update(sign_stream *st, const uint8_t *m, size_t mlen)
+{
+  shake256_absorb(&st->state, m, mlen);
+}
+
+/*************************************************
+* Name:        crypto_sign_final
+*
+* Description: Computes signature over all absorbed message parts.
+*
+* Arguments:   - sign_stream *st: pointer to stream state
+*              - uint8_t *sig:    pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen:  pointer to output length of signature
+*              - uint8_t *sk:     pointer to bit-packed secret key
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_sign_final(sign_stream *st, uint8_t *sig, size_t *siglen, const uint8_t *sk)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint8_t mu[CRHBYTES];
+  uint8_t rnd[RNDBYTES];
+  sign_ctx sctx;
+
+  shake256_finalize(&st->state);
+  shake256_squeeze(mu, CRHBYTES, &st->state);
+
+#ifdef DILITHIUM_RANDOMIZED_SIGNING
+  randombytes(rnd, RNDBYTES);
+#else
+  memset(rnd, 0, RNDBYTES);
+#endif
+
+  crypto_sign_key_expand(&sctx, sk);
+  crypto_sign_signature_mu_internal(sig, siglen, mu, rnd, &sctx);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.sign += t;
+
+  return 0;
+}
+
+/* DER-encoded OIDs of the HashML-DSA pre-hash functions, indexed by
+ * DILITHIUM_PH_* (FIPS 204, Section 5.4) */
+static const uint8_t prehash_oid[4][PREHASH_OIDBYTES] = {
+  {0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x08},
+  {0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x0A},
+  {0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x0B},
+  {0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x0C}
+};
+static const size_t prehash_bytes[4] = {32, 64, 32, 64};
+
+/*************************************************
+* Name:        prehash_pre
+*
+* Description: Prepares the HashML-DSA prefix pre = (1, ctxlen, ctx, OID).
+*              The digest itself is passed as message to the internal API.
+*
+* Arguments:   - uint8_t *pre:   output prefix of at least 257+PREHASH_OIDBYTES bytes
+*              - uint8_t *ctx:   pointer to contex string
+*              - size_t ctxlen:  length of contex string
+*              - int phalg:      pre-hash function (DILITHIUM_PH_*)
+*              - size_t phlen:   length of digest
+*
+* Returns length of prefix or -1 (bad context, pre-hash or digest length)
+**************************************************/
+static int prehash_pre(uint8_t *pre, const uint8_t *ctx, size_t ctxlen, int phalg, size_t phlen)
+{
+  if(ctxlen > 255 || phalg < 0 || phalg > 3 || phlen != prehash_bytes[phalg])
+    return -1;
+
+  build_prefix(pre, 1, ctx, ctxlen);
+  memcpy(&pre[2 + ctxlen], prehash_oid[phalg], PREHASH_OIDBYTES);
+
+  return 2 + ctxlen + PREHASH_OIDBYTES;
+}
+
+/*************************************************
+* Name:        crypto_sign_prehash
+*
+* Description: Computes the HashML-DSA message digest PH(m).
+*
+* Arguments:   - uint8_t *ph:    output digest (of length DILITHIUM_PH_MAXBYTES)
+*              - uint8_t *m:     pointer to message
+*              - size_t mlen:    length of message
+*              - int phalg:      pre-hash function (DILITHIUM_PH_*)
+*
+* Returns length of digest or -1 (unknown pre-hash function)
+**************************************************/
+int crypto_sign_prehash(uint8_t ph[DILITHIUM_PH_MAXBYTES], const uint8_t *m, size_t mlen, int phalg)
+{
+  switch(phalg) {
+    case DILITHIUM_PH_SHA3_256:
+      sha3_256(ph, m, mlen);
+      break;
+    case DILITHIUM_PH_SHA3_512:
+      sha3_512(ph, m, mlen);
+      break;
+    case DILITHIUM_PH_SHAKE128:
+      shake128(ph, 32, m, mlen);
+      break;
+    case DILITHIUM_PH_SHAKE256:
+      shake256(ph, 64, m, mlen);
+      break;
+    default:
+      return -1;
+  }
+
+  return prehash_bytes[phalg];
+}
+
+/*************************************************
+* Name:        crypto_sign_mu
+*
+* Description: Computes the message representative mu = CRH(tr, pre, m)
+*              for the external-mu API, e.g. on a node that only holds pk.
+*
+* Arguments:   - uint8_t *mu:    output mu (of length CRHBYTES)
+*              - uint8_t *m:     pointer to message
+*              - size_t mlen:    length of message
+*              - uint8_t *ctx:   pointer to contex string
+*              - size_t ctxlen:  length of contex string
+*              - uint8_t *pk:    pointer to bit-packed public key
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_mu(uint8_t mu[CRHBYTES], const uint8_t *m, size_t mlen, const uint8_t *ctx,
+                   size_t ctxlen, const uint8_t *pk)
+{
+  verify_stream st;
+
+  if(crypto_verify_init(&st, ctx, ctxlen, pk))
+    return -1;
+  crypto_verify_update(&st, m, mlen);
+  shake256_finalize(&st.state);
+  shake256_squeeze(mu, CRHBYTES, &st.state);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_signature_prehash
+*
+* Description: Computes HashML-DSA signature over a message digest.
+*
+* Arguments:   - uint8_t *sig:   pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen: pointer to output length of signature
+*              - uint8_t *ph:    pointer to digest PH(m)
+*              - size_t phlen:   length of digest
+*              - uint8_t *ctx:   pointer to contex string
+*              - size_t ctxlen:  length of contex string
+*              - int phalg:      pre-hash function (DILITHIUM_PH_*)
+*              - uint8_t *sk:    pointer to bit-packed secret key
+*
+* Returns 0 (success) or -1 (bad context, pre-hash or digest length)
+**************************************************/
+int crypto_sign_signature_prehash(uint8_t *sig, size_t *siglen, const uint8_t *ph, size_t phlen,
+                                  const uint8_t *ctx, size_t ctxlen, int phalg, const uint8_t *sk)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  int prelen;
+  uint8_t pre[257 + PREHASH_OIDBYTES];
+  uint8_t rnd[RNDBYTES];
+
+  prelen = prehash_pre(pre, ctx, ctxlen, phalg, phlen);
+  if(prelen < 0)
+    return -1;
+
+#ifdef DILITHIUM_RANDOMIZED_SIGNING
+  randombytes(rnd, RNDBYTES);
+#else
+  memset(rnd, 0, RNDBYTES);
+#endif
+
+  crypto_sign_signature_internal(sig, siglen, ph, phlen, pre, prelen, rnd, sk);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.sign += t;
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_signature_extmu
+*
+* Description: Computes signature over an externally supplied message
+*              representative mu (see crypto_sign_mu).
+*
+* Arguments:   - uint8_t *sig:   pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen: pointer to output length of signature
+*              - uint8_t *mu:    pointer to message representative
+*              - uint8_t *sk:    pointer to bit-packed secret key
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_sign_signature_extmu(uint8_t *sig, size_t *siglen, const uint8_t mu[CRHBYTES],
+                                const uint8_t *sk)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint8_t rnd[RNDBYTES];
+  sign_ctx sctx;
+
+#ifdef DILITHIUM_RANDOMIZED_SIGNING
+  randombytes(rnd, RNDBYTES);
+#else
+  memset(rnd, 0, RNDBYTES);
+#endif
+
+  crypto_sign_key_expand(&sctx, sk);
+  crypto_sign_signature_mu_internal(sig, siglen, mu, rnd, &sctx);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.sign += t;
+
+  return 0;
+}
+
+/*************************************************
+* Name:        pk_expand_mat
+*
+* Description: Expands matrix A and NTT(t1*2^D) of a verify_ctx, leaving
+*              tr to the caller.
+*
+* Arguments:   - verify_ctx *vctx: pointer to output expanded public key
+*              - const uint8_t *pk: pointer to bit-packed public key
+**************************************************/
+static void pk_expand_mat(verify_ctx *vctx, const uint8_t *pk)
+{
+  unsigned int i;
+
+  matrix_expand(vctx->mat, pk);
+
+  for(i = 0; i < K; i++) {
+    polyt1_unpack(&vctx->t1.vec[i], pk + SEEDBYTES + i*POLYT1_PACKEDBYTES);
+    poly_shiftl(&vctx->t1.vec[i]);
+    poly_ntt(&vctx->t1.vec[i]);
+  }
+}
+
+/*************************************************
+* Name:        crypto_sign_pk_expand
+*
+* Description: Computes tr = H(pk), expands matrix A and transforms
+*              t1*2^D to NTT domain, so that repeated verifications
+*              under the same key skip this work.
+*
+* Arguments:   - verify_ctx *vctx: pointer to output expanded key
+*              - const uint8_t *pk: pointer to bit-packed public key
+**************************************************/
+void crypto_sign_pk_expand(verify_ctx *vctx, const uint8_t *pk)
+{
+  shake256(vctx->tr, TRBYTES, pk, CRYPTO_PUBLICKEYBYTES);
+  pk_expand_mat(vctx, pk);
+}
+
+/*************************************************
+* Name:        verify_recover_w1
+*
+* Description: Computes w1' = UseHint(h, Az - c*t1*2^D) from a signature
+*              and an expanded public key and packs it.
+*
+* Arguments:   - uint8_t *w1buf: output byte array with at least
+*                                K*POLYW1_PACKEDBYTES+14 bytes
+*              - const uint8_t *sig: pointer to signature of CRYPTO_BYTES
+*              - const poly *c: pointer to challenge in NTT domain
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 on success and -1 if the hint is malformed
+**************************************************/
+static int verify_recover_w1(uint8_t *w1buf, const uint8_t *sig, const poly *c, const verify_ctx *vctx) {
+  unsigned int i, j, pos = 0;
+  const uint8_t *hint = sig + CTILDEBYTES + L*POLYZ_PACKEDBYTES;
+  polyvecl z;
+  polyveck w1;
+  poly h;
+
+  /* Unpack z; shortness follows from unpacking */
+  for(i = 0; i < L; i++) {
+    polyz_unpack(&z.vec[i], sig + CTILDEBYTES + i*POLYZ_PACKEDBYTES);
+    poly_ntt(&z.vec[i]);
+  }
+
+  /* Compute Az - c2^Dt1 */
+  matrix_product(&w1, vctx->mat, &z, c, &vctx->t1);
+
+  for(i = 0; i < K; i++) {
+    /* Get hint polynomial and reconstruct w1 */
+    memset(h.vec, 0, sizeof(poly));
+    if(hint[OMEGA + i] < pos || hint[OMEGA + i] > OMEGA)
+      return -1;
+
+    for(j = pos; j < hint[OMEGA + i]; ++j) {
+      /* Coefficients are ordered for strong unforgeability */
+      if(j > pos && hint[j] <= hint[j-1]) return -1;
+      h.coeffs[hint[j]] = 1;
+    }
+    pos = hint[OMEGA + i];
+
+    poly_caddq(&w1.vec[i]);
+    poly_use_hint(&w1.vec[i], &w1.vec[i], &h);
+    polyw1_pack(w1buf + i*POLYW1_PACKEDBYTES, &w1.vec[i]);
+  }
+
+  /* Extra indices are zero for strong unforgeability */
+  for(j = pos; j < OMEGA; ++j)
+    if(hint[j]) return -1;
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_ctx_internal
+*
+* Description: Verifies signature with expanded public key. Internal API.
+*
+* Arguments:   - uint8_t *m: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *m: pointer to message
+*              - size_t mlen: length of message
+*              - const uint8_t *pre: pointer to prefix string
+*              - size_t prelen: length of prefix string
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_ctx_internal(const uint8_t *sig, size_t siglen, const uint8_t *m, size_t mlen,
+                                    const uint8_t *pre, size_t prelen, const verify_ctx *vctx) {
+  uint8_t mu[CRHBYTES];
+  keccak_state state;
+
+  if(siglen != CRYPTO_BYTES)
+    return -1;
+
+  /* Compute CRH(tr, pre, msg) */
+  shake256_init(&state);
+  shake256_absorb(&state, vctx->tr, TRBYTES);
+  shake256_absorb(&state, pre, prelen);
+  shake256_absorb(&state, m, mlen);
+  shake256_finalize(&state);
+  shake256_squeeze(mu, CRHBYTES, &state);
+
+  return crypto_sign_verify_mu_internal(sig, siglen, mu, vctx);
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_mu_internal
+*
+* Description: Verifies signature over a precomputed message
+*              representative mu = CRH(tr, pre, m). Internal API.
+*
+* Arguments:   - uint8_t *m: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *mu: pointer to message representative
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_mu_internal(const uint8_t *sig, size_t siglen, const uint8_t mu[CRHBYTES],
+                                   const verify_ctx *vctx) {
+  unsigned int i;
+  /* polyw1_pack writes additional 14 bytes */
+  ALIGNED_UINT8(K*POLYW1_PACKEDBYTES+14) buf;
+  poly c;
+  keccak_state state;
+
+  if(siglen != CRYPTO_BYTES)
+    return -1;
+
+  /* Expand challenge */
+  poly_challenge(&c, sig);
+  poly_ntt(&c);
 
-  /* Extra indices are zero for strong unforgeability */
-  for(j = pos; j < OMEGA; ++j)
-    if(hint[j]) return -1;
+  /* Reconstruct w1 */
+  if(verify_recover_w1(buf.coeffs, sig, &c, vctx))
+    return -1;
 
   /* Call random oracle and verify challenge */
   shake256_init(&state);
@@ -476,15 +1518,575 @@ int crypto_sign_verify_internal(const uint8_t *sig, size_t siglen, const uint8_t
 int crypto_sign_verify(const uint8_t *sig, size_t siglen, const uint8_t *m, size_t mlen,
                        const uint8_t *ctx, size_t ctxlen, const uint8_t *pk)
 {
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
   uint8_t pre[257];
 
   if(ctxlen > 255)
     return -1;
 
-  pre[0] = 0;
-  pre[1] = ctxlen;
-  memcpy(&pre[2], ctx, ctxlen);
-  return crypto_sign_verify_internal(sig,siglen,m,mlen,pre,2+ctxlen,pk);
+  build_prefix(pre, 0, ctx, ctxlen);
+  int valid = crypto_sign_verify_internal(sig,siglen,m,mlen,pre,2+ctxlen,pk);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return valid;
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_ctx
+*
+* Description: Verifies signature with expanded public key.
+*
+* Arguments:   - uint8_t *m: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *m: pointer to message
+*              - size_t mlen: length of message
+*              - const uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_ctx(const uint8_t *sig, size_t siglen, const uint8_t *m, size_t mlen,
+                           const uint8_t *ctx, size_t ctxlen, const verify_ctx *vctx)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint8_t pre[257];
+
+  if(ctxlen > 255)
+    return -1;
+
+  build_prefix(pre, 0, ctx, ctxlen);
+  int valid = crypto_sign_verify_ctx_internal(sig,siglen,m,mlen,pre,2+ctxlen,vctx);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return valid;
+}
+
+/*************************************************
+* Name:        crypto_sign_mu_ctx
+*
+* Description: Computes mu = CRH(tr, pre, m) from an expanded public key,
+*              without hashing pk again. With a fixed message the result
+*              can be reused by crypto_sign_verify_ctx_mu.
+*
+* Arguments:   - uint8_t *mu:    output mu (of length CRHBYTES)
+*              - uint8_t *m:     pointer to message
+*              - size_t mlen:    length of message
+*              - uint8_t *ctx:   pointer to contex string
+*              - size_t ctxlen:  length of contex string
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_mu_ctx(uint8_t mu[CRHBYTES], const uint8_t *m, size_t mlen, const uint8_t *ctx,
+                       size_t ctxlen, const verify_ctx *vctx)
+{
+  uint8_t pre[257];
+  keccak_state state;
+
+  if(ctxlen > 255)
+    return -1;
+
+  build_prefix(pre, 0, ctx, ctxlen);
+  shake256_init(&state);
+  shake256_absorb(&state, vctx->tr, TRBYTES);
+  shake256_absorb(&state, pre, 2+ctxlen);
+  shake256_absorb(&state, m, mlen);
+  shake256_finalize(&state);
+  shake256_squeeze(mu, CRHBYTES, &state);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_ctx_mu
+*
+* Description: Verifies signature over a precomputed mu (see
+*              crypto_sign_mu_ctx) with expanded public key.
+*
+* Arguments:   - const uint8_t *sig: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *mu: pointer to message representative
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_ctx_mu(const uint8_t *sig, size_t siglen, const uint8_t mu[CRHBYTES],
+                              const verify_ctx *vctx)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  int valid = crypto_sign_verify_mu_internal(sig, siglen, mu, vctx);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return valid;
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_batch_mu
+*
+* Description: Verifies n signatures over one precomputed mu (see
+*              crypto_sign_mu_ctx) with one expanded public key. Challenges
+*              are expanded and H(mu, w1') computed four signatures at a
+*              time on 4-way Keccak.
+*
+* Arguments:   - int *results: pointer to output array of n verification
+*                              results (0 or -1)
+*              - const uint8_t *const *sigs: array of n pointers to signatures
+*              - const size_t *siglens: array of n signature lengths
+*              - const uint8_t *mu: pointer to message representative
+*              - const verify_ctx *vctx: pointer to expanded public key
+*              - size_t n: number of signatures
+*
+* Returns 0 if all signatures could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_batch_mu(int *results, const uint8_t *const *sigs, const size_t *siglens,
+                                const uint8_t mu[CRHBYTES], const verify_ctx *vctx, size_t n)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  static const uint8_t dummy[CTILDEBYTES];
+  unsigned int j;
+  size_t b;
+  int valid[4], ret = 0;
+  uint8_t c2[4][CTILDEBYTES];
+  /* mu followed by packed w1; polyw1_pack writes additional 14 bytes */
+  ALIGNED_UINT8(CRHBYTES+K*POLYW1_PACKEDBYTES+14) buf[4];
+  const uint8_t *sig[4];
+  poly c[4];
+
+  memset(buf, 0, sizeof(buf));
+  for(j = 0; j < 4; ++j)
+    memcpy(buf[j].coeffs, mu, CRHBYTES);
+
+  for(b = 0; b < n; b += 4) {
+    /* Missing lanes of the last group and malformed signatures expand a
+     * dummy challenge and are discarded */
+    for(j = 0; j < 4; ++j) {
+      valid[j] = (b + j < n && siglens[b + j] == CRYPTO_BYTES) ? 0 : -1;
+      sig[j] = valid[j] ? dummy : sigs[b + j];
+    }
+
+    /* Expand challenges */
+    poly_challenge_4x(&c[0], &c[1], &c[2], &c[3], sig[0], sig[1], sig[2], sig[3]);
+
+    /* Reconstruct w1 behind mu */
+    for(j = 0; j < 4; ++j) {
+      if(valid[j])
+        continue;
+      poly_ntt(&c[j]);
+      valid[j] = verify_recover_w1(buf[j].coeffs + CRHBYTES, sig[j], &c[j], vctx);
+    }
+
+    /* Call random oracle and verify challenges */
+    shake256x4(c2[0], c2[1], c2[2], c2[3], CTILDEBYTES,
+               buf[0].coeffs, buf[1].coeffs, buf[2].coeffs, buf[3].coeffs, CRHBYTES + K*POLYW1_PACKEDBYTES);
+
+    for(j = 0; j < 4 && b + j < n; ++j) {
+      if(!valid[j] && memcmp(c2[j], sig[j], CTILDEBYTES))
+        valid[j] = -1;
+      results[b + j] = valid[j];
+      ret |= valid[j];
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return ret;
+}
+
+/* Signatures of a batch are ordered by public key in chunks of this many,
+ * so that each key is expanded once per chunk however they are mixed */
+#define VERIFY_BATCH_CHUNK 64
+
+static int pk_cmp(const uint8_t *a, const uint8_t *b) {
+  return (a == b) ? 0 : memcmp(a, b, CRYPTO_PUBLICKEYBYTES);
+}
+
+/*************************************************
+* Name:        sort_by_pk
+*
+* Description: Stable insertion sort of signature indices by public key.
+*
+* Arguments:   - size_t *idx: array of len indices into pks, sorted in place
+*              - size_t len: number of indices
+*              - const uint8_t *const *pks: array of pointers to public keys
+**************************************************/
+static void sort_by_pk(size_t *idx, size_t len, const uint8_t *const *pks) {
+  size_t i, j, t;
+
+  for(i = 1; i < len; ++i) {
+    t = idx[i];
+    for(j = i; j > 0 && pk_cmp(pks[idx[j-1]], pks[t]) > 0; --j)
+      idx[j] = idx[j-1];
+    idx[j] = t;
+  }
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_batch
+*
+* Description: Verifies n independent signatures. Signatures are processed
+*              in groups of four so that the SHAKE256 calls for tr, mu, the
+*              challenge and the final challenge hash run on 4-way Keccak.
+*              Within chunks of VERIFY_BATCH_CHUNK signatures the groups are
+*              formed in public key order, so signatures under the same key
+*              share one matrix expansion wherever they are in the chunk.
+*
+* Arguments:   - int *results: pointer to output array of n verification
+*                              results (0 or -1)
+*              - const uint8_t *const *sigs: array of n pointers to signatures
+*              - const size_t *siglens: array of n signature lengths
+*              - const uint8_t *const *msgs: array of n pointers to messages
+*              - const size_t *mlens: array of n message lengths
+*              - const uint8_t *ctx: pointer to context string shared by
+*                                    all signatures
+*              - size_t ctxlen: length of context string
+*              - const uint8_t *const *pks: array of n pointers to
+*                                           bit-packed public keys
+*              - size_t n: number of signatures
+*
+* Returns 0 if all signatures could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_batch(int *results,
+                             const uint8_t *const *sigs, const size_t *siglens,
+                             const uint8_t *const *msgs, const size_t *mlens,
+                             const uint8_t *ctx, size_t ctxlen,
+                             const uint8_t *const *pks, size_t n)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  static const uint8_t dummy[CTILDEBYTES];
+  unsigned int j, samepk;
+  size_t b, g, len, order[VERIFY_BATCH_CHUNK], idx[4];
+  int valid[4], ret = 0;
+  uint8_t pre[257];
+  uint8_t tr[4][TRBYTES];
+  uint8_t c2[4][CTILDEBYTES];
+  /* mu followed by packed w1; polyw1_pack writes additional 14 bytes */
+  ALIGNED_UINT8(CRHBYTES+K*POLYW1_PACKEDBYTES+14) buf[4];
+  const uint8_t *sig[4], *pk[4], *vpk = NULL;
+  poly c[4];
+  keccakx4_state statex4;
+  keccak_state state;
+  verify_ctx vctx;
+
+  if(ctxlen > 255) {
+    for(b = 0; b < n; ++b)
+      results[b] = -1;
+    return -1;
+  }
+
+  build_prefix(pre, 0, ctx, ctxlen);
+  memset(buf, 0, sizeof(buf));
+
+  for(b = 0; b < n; b += len) {
+    len = (n - b < VERIFY_BATCH_CHUNK) ? n - b : VERIFY_BATCH_CHUNK;
+    for(g = 0; g < len; ++g)
+      order[g] = b + g;
+    sort_by_pk(order, len, pks);
+
+    for(g = 0; g < len; g += 4) {
+      /* Missing lanes of the last group duplicate its first signature */
+      for(j = 0; j < 4; ++j) {
+        idx[j] = (g + j < len) ? order[g + j] : order[g];
+        valid[j] = (siglens[idx[j]] == CRYPTO_BYTES) ? 0 : -1;
+        sig[j] = valid[j] ? dummy : sigs[idx[j]];
+        pk[j] = pks[idx[j]];
+      }
+
+      /* Compute tr = H(pk) unless all lanes are under the expanded key */
+      samepk = (vpk != NULL);
+      for(j = 0; j < 4 && samepk; ++j)
+        samepk = !pk_cmp(pk[j], vpk);
+
+      if(samepk) {
+        for(j = 0; j < 4; ++j)
+          memcpy(tr[j], vctx.tr, TRBYTES);
+      }
+      else
+        shake256x4(tr[0], tr[1], tr[2], tr[3], TRBYTES, pk[0], pk[1], pk[2], pk[3], CRYPTO_PUBLICKEYBYTES);
+
+      /* Compute CRH(tr, pre, msg) */
+      if(mlens[idx[0]] == mlens[idx[1]] && mlens[idx[0]] == mlens[idx[2]] && mlens[idx[0]] == mlens[idx[3]]) {
+        shake256x4_init(&statex4);
+        shake256x4_absorb(&statex4, tr[0], tr[1], tr[2], tr[3], TRBYTES);
+        shake256x4_absorb(&statex4, pre, pre, pre, pre, 2+ctxlen);
+        shake256x4_absorb(&statex4, msgs[idx[0]], msgs[idx[1]], msgs[idx[2]], msgs[idx[3]], mlens[idx[0]]);
+        shake256x4_finalize(&statex4);
+        shake256x4_squeezeblocks(buf[0].coeffs, buf[1].coeffs, buf[2].coeffs, buf[3].coeffs, 1, &statex4);
+      }
+      else {
+        for(j = 0; j < 4; ++j) {
+          shake256_init(&state);
+          shake256_absorb(&state, tr[j], TRBYTES);
+          shake256_absorb(&state, pre, 2+ctxlen);
+          shake256_absorb(&state, msgs[idx[j]], mlens[idx[j]]);
+          shake256_finalize(&state);
+          shake256_squeeze(buf[j].coeffs, CRHBYTES, &state);
+        }
+      }
+
+      /* Expand challenges */
+      poly_challenge_4x(&c[0], &c[1], &c[2], &c[3], sig[0], sig[1], sig[2], sig[3]);
+
+      /* Reconstruct w1 behind mu; a new key reuses its tr from above */
+      for(j = 0; j < 4; ++j) {
+        if(g + j >= len || valid[j])
+          continue;
+
+        if(vpk == NULL || pk_cmp(vpk, pk[j])) {
+          memcpy(vctx.tr, tr[j], TRBYTES);
+          pk_expand_mat(&vctx, pk[j]);
+        }
+        vpk = pk[j];
+
+        poly_ntt(&c[j]);
+        valid[j] = verify_recover_w1(buf[j].coeffs + CRHBYTES, sig[j], &c[j], &vctx);
+      }
+
+      /* Call random oracle and verify challenges */
+      shake256x4(c2[0], c2[1], c2[2], c2[3], CTILDEBYTES,
+                 buf[0].coeffs, buf[1].coeffs, buf[2].coeffs, buf[3].coeffs, CRHBYTES + K*POLYW1_PACKEDBYTES);
+
+      for(j = 0; j < 4 && g + j < len; ++j) {
+        if(!valid[j] && memcmp(c2[j], sig[j], CTILDEBYTES))
+          valid[j] = -1;
+        results[idx[j]] = valid[j];
+        ret |= valid[j];
+      }
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return ret;
+}
+
+/*************************************************
+* Name:        crypto_verify_init
+*
+* Description: Starts a streaming verification. The message is absorbed
+*              incrementally with crypto_verify_update.
+*
+* Arguments:   - verify_stream *st: pointer to stream state
+*              - const uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - const uint8_t *pk: pointer to bit-packed public key
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_verify_init(verify_stream *st, const uint8_t *ctx, size_t ctxlen, const uint8_t *pk)
+{
+  uint8_t pre[257];
+  uint8_t tr[TRBYTES];
+
+  if(ctxlen > 255)
+    return -1;
+
+  build_prefix(pre, 0, ctx, ctxlen);
+
+  shake256(tr, TRBYTES, pk, CRYPTO_PUBLICKEYBYTES);
+  shake256_init(&st->state);
+  shake256_absorb(&st->state, tr, TRBYTES);
+  shake256_absorb(&st->state, pre, 2+ctxlen);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_verify_update
+*
+* Description: Absorbs the next part of the signed message.
+*
+* Arguments:   - verify_stream *st: pointer to stream state
+*              - const uint8_t *m: pointer to message part
+*              - size_t mlen: length of message part
+**************************************************/
+void crypto_verify_update(verify_stream *st, const uint8_t *m, size_t mlen)
+{
+  shake256_absorb(&st->state, m, mlen);
+}
+
+/*************************************************
+* Name:        crypto_verify_final
+*
+* Description: Verifies signature over all absorbed message parts.
+*
+* Arguments:   - verify_stream *st: pointer to stream state
+*              - const uint8_t *sig: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *pk: pointer to bit-packed public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_verify_final(verify_stream *st, const uint8_t *sig, size_t siglen, const uint8_t *pk)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint8_t mu[CRHBYTES];
+  verify_ctx vctx;
+
+  shake256_finalize(&st->state);
+  shake256_squeeze(mu, CRHBYTES, &st->state);
+
+  crypto_sign_pk_expand(&vctx, pk);
+  int valid = crypto_sign_verify_mu_internal(sig, siglen, mu, &vctx);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return valid;
+}
+
+/*************************************************
+* Name:        crypto_verify_init_ctx
+*
+* Description: Starts a streaming verification under an expanded public
+*              key; continue with crypto_verify_update and end with
+*              crypto_verify_final_ctx.
+*
+* Arguments:   - verify_stream *st: pointer to stream state
+*              - const uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_verify_init_ctx(verify_stream *st, const uint8_t *ctx, size_t ctxlen, const verify_ctx *vctx)
+{
+  uint8_t pre[257];
+
+  if(ctxlen > 255)
+    return -1;
+
+  build_prefix(pre, 0, ctx, ctxlen);
+
+  shake256_init(&st->state);
+  shake256_absorb(&st->state, vctx->tr, TRBYTES);
+  shake256_absorb(&st->state, pre, 2+ctxlen);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_verify_final_ctx
+*
+* Description: Verifies signature over all absorbed message parts with
+*              expanded public key.
+*
+* Arguments:   - verify_stream *st: pointer to stream state
+*              - const uint8_t *sig: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_verify_final_ctx(verify_stream *st, const uint8_t *sig, size_t siglen, const verify_ctx *vctx)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint8_t mu[CRHBYTES];
+
+  shake256_finalize(&st->state);
+  shake256_squeeze(mu, CRHBYTES, &st->state);
+
+  int valid = crypto_sign_verify_mu_internal(sig, siglen, mu, vctx);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return valid;
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_prehash
+*
+* Description: Verifies HashML-DSA signature over a message digest.
+*
+* Arguments:   - const uint8_t *sig: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *ph: pointer to digest PH(m)
+*              - size_t phlen: length of digest
+*              - const uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - int phalg: pre-hash function (DILITHIUM_PH_*)
+*              - const uint8_t *pk: pointer to bit-packed public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_prehash(const uint8_t *sig, size_t siglen, const uint8_t *ph, size_t phlen,
+                               const uint8_t *ctx, size_t ctxlen, int phalg, const uint8_t *pk)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  int prelen;
+  uint8_t pre[257 + PREHASH_OIDBYTES];
+
+  prelen = prehash_pre(pre, ctx, ctxlen, phalg, phlen);
+  if(prelen < 0)
+    return -1;
+
+  int valid = crypto_sign_verify_internal(sig, siglen, ph, phlen, pre, prelen, pk);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return valid;
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_extmu
+*
+* Description: Verifies signature over an externally supplied message
+*              representative mu (see crypto_sign_mu).
+*
+* Arguments:   - const uint8_t *sig: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *mu: pointer to message representative
+*              - const uint8_t *pk: pointer to bit-packed public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_extmu(const uint8_t *sig, size_t siglen, const uint8_t mu[CRHBYTES],
+                             const uint8_t *pk)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  verify_ctx vctx;
+
+  crypto_sign_pk_expand(&vctx, pk);
+  int valid = crypto_sign_verify_mu_internal(sig, siglen, mu, &vctx);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return valid;
 }
 
 /*************************************************
@@ -505,6 +2107,9 @@ int crypto_sign_verify(const uint8_t *sig, size_t siglen, const uint8_t *m, size
 **************************************************/
 int crypto_sign_open(uint8_t *m, size_t *mlen, const uint8_t *sm, size_t smlen,
                      const uint8_t *ctx, size_t ctxlen, const uint8_t *pk) {
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
   size_t i;
 
   if(smlen < CRYPTO_BYTES)
@@ -517,6 +2122,11 @@ int crypto_sign_open(uint8_t *m, size_t *mlen, const uint8_t *sm, size_t smlen,
     /* All good, copy msg, return 0 */
     for(i = 0; i < *mlen; ++i)
       m[i] = sm[CRYPTO_BYTES + i];
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    g_time.all += t;
+
     return 0;
   }
 
@@ -526,5 +2136,16 @@ badsig:
   for(i = 0; i < smlen; ++i)
     m[i] = 0;
 
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.all += t;
+
   return -1;
 }
+
+// For testing: print timing information and return timing struct
+timing_info_t print_timing_info(void)
+{
+  g_time.temp = g_time.keygen + g_time.sign + g_time.verify;
+  return g_time;
+}
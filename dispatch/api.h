@@ -0,0 +1,89 @@
+#ifndef API_H
+#define API_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define pqcrystals_dilithium2_PUBLICKEYBYTES 1312
+#define pqcrystals_dilithium2_SECRETKEYBYTES 2560
+#define pqcrystals_dilithium2_BYTES 2420
+
+int pqcrystals_dilithium2_keypair(uint8_t *pk, uint8_t *sk);
+
+int pqcrystals_dilithium2_signature(uint8_t *sig, size_t *siglen,
+                                    const uint8_t *m, size_t mlen,
+                                    const uint8_t *ctx, size_t ctxlen,
+                                    const uint8_t *sk);
+
+int pqcrystals_dilithium2(uint8_t *sm, size_t *smlen,
+                          const uint8_t *m, size_t mlen,
+                          const uint8_t *ctx, size_t ctxlen,
+                          const uint8_t *sk);
+
+int pqcrystals_dilithium2_verify(const uint8_t *sig, size_t siglen,
+                                 const uint8_t *m, size_t mlen,
+                                 const uint8_t *ctx, size_t ctxlen,
+                                 const uint8_t *pk);
+
+int pqcrystals_dilithium2_open(uint8_t *m, size_t *mlen,
+                               const uint8_t *sm, size_t smlen,
+                               const uint8_t *ctx, size_t ctxlen,
+                               const uint8_t *pk);
+
+#define pqcrystals_dilithium3_PUBLICKEYBYTES 1952
+#define pqcrystals_dilithium3_SECRETKEYBYTES 4032
+#define pqcrystals_dilithium3_BYTES 3309
+
+int pqcrystals_dilithium3_keypair(uint8_t *pk, uint8_t *sk);
+
+int pqcrystals_dilithium3_signature(uint8_t *sig, size_t *siglen,
+                                    const uint8_t *m, size_t mlen,
+                                    const uint8_t *ctx, size_t ctxlen,
+                                    const uint8_t *sk);
+
+int pqcrystals_dilithium3(uint8_t *sm, size_t *smlen,
+                          const uint8_t *m, size_t mlen,
+                          const uint8_t *ctx, size_t ctxlen,
+                          const uint8_t *sk);
+
+int pqcrystals_dilithium3_verify(const uint8_t *sig, size_t siglen,
+                                 const uint8_t *m, size_t mlen,
+                                 const uint8_t *ctx, size_t ctxlen,
+                                 const uint8_t *pk);
+
+int pqcrystals_dilithium3_open(uint8_t *m, size_t *mlen,
+                               const uint8_t *sm, size_t smlen,
+                               const uint8_t *ctx, size_t ctxlen,
+                               const uint8_t *pk);
+
+#define pqcrystals_dilithium5_PUBLICKEYBYTES 2592
+#define pqcrystals_dilithium5_SECRETKEYBYTES 4896
+#define pqcrystals_dilithium5_BYTES 4627
+
+int pqcrystals_dilithium5_keypair(uint8_t *pk, uint8_t *sk);
+
+int pqcrystals_dilithium5_signature(uint8_t *sig, size_t *siglen,
+                                    const uint8_t *m, size_t mlen,
+                                    const uint8_t *ctx, size_t ctxlen,
+                                    const uint8_t *sk);
+
+int pqcrystals_dilithium5(uint8_t *sm, size_t *smlen,
+                          const uint8_t *m, size_t mlen,
+                          const uint8_t *ctx, size_t ctxlen,
+                          const uint8_t *sk);
+
+int pqcrystals_dilithium5_verify(const uint8_t *sig, size_t siglen,
+                                 const uint8_t *m, size_t mlen,
+                                 const uint8_t *ctx, size_t ctxlen,
+                                 const uint8_t *pk);
+
+int pqcrystals_dilithium5_open(uint8_t *m, size_t *mlen,
+                               const uint8_t *sm, size_t smlen,
+                               const uint8_t *ctx, size_t ctxlen,
+                               const uint8_t *pk);
+
+/* Backend picked from CPUID when the library was loaded: "ref", "sse41"
+ * or "avx2" */
+const char *pqcrystals_dilithium_implementation(void);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#ifndef DILITHIUM_MODE
+#define DILITHIUM_MODE 2
+#endif
+
+/* The combined library exports the unsuffixed names and forwards to the
+ * ref, sse41 or avx2 build of the same mode. */
+#if DILITHIUM_MODE == 2
+#define CRYPTO_ALGNAME "Dilithium2"
+#define DILITHIUM_NAMESPACETOP pqcrystals_dilithium2
+#define DILITHIUM_NAMESPACE(s) pqcrystals_dilithium2_##s
+#define DILITHIUM_IMPLTOP(impl) pqcrystals_dilithium2_##impl
+#define DILITHIUM_IMPL(impl, s) pqcrystals_dilithium2_##impl##_##s
+#elif DILITHIUM_MODE == 3
+#define CRYPTO_ALGNAME "Dilithium3"
+#define DILITHIUM_NAMESPACETOP pqcrystals_dilithium3
+#define DILITHIUM_NAMESPACE(s) pqcrystals_dilithium3_##s
+#define DILITHIUM_IMPLTOP(impl) pqcrystals_dilithium3_##impl
+#define DILITHIUM_IMPL(impl, s) pqcrystals_dilithium3_##impl##_##s
+#elif DILITHIUM_MODE == 5
+#define CRYPTO_ALGNAME "Dilithium5"
+#define DILITHIUM_NAMESPACETOP pqcrystals_dilithium5
+#define DILITHIUM_NAMESPACE(s) pqcrystals_dilithium5_##s
+#define DILITHIUM_IMPLTOP(impl) pqcrystals_dilithium5_##impl
+#define DILITHIUM_IMPL(impl, s) pqcrystals_dilithium5_##impl##_##s
+#endif
+
+#endif
@@ -0,0 +1,83 @@
+#include <stdint.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#include "api.h"
+#include "cpu.h"
+
+unsigned int dilithium_backend = DILITHIUM_BACKEND_REF;
+
+static const char *const backend_names[DILITHIUM_NBACKENDS] = {
+  "ref", "sse41", "avx2"
+};
+
+/*************************************************
+* Name:        dilithium_cpu_features
+*
+* Description: Query CPUID for the instruction set extensions the backends
+*              need. AVX2 is only reported if the OS has enabled saving of
+*              the XMM and YMM state (OSXSAVE and XCR0 bits 1 and 2).
+*
+* Returns bit mask of DILITHIUM_CPU_* flags; 0 on non-x86 targets.
+**************************************************/
+unsigned int dilithium_cpu_features(void) {
+  unsigned int f = 0;
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned int eax, ebx, ecx, edx, xcr0_lo, xcr0_hi;
+  int ymm = 0;
+
+  if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    return 0;
+
+  if(ecx & bit_SSE4_1)
+    f |= DILITHIUM_CPU_SSE41;
+  if(ecx & bit_POPCNT)
+    f |= DILITHIUM_CPU_POPCNT;
+  if((ecx & bit_OSXSAVE) && (ecx & bit_AVX)) {
+    __asm__ volatile ("xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+    ymm = (xcr0_lo & 0x6) == 0x6;
+  }
+
+  if(__get_cpuid_max(0, 0) >= 7) {
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    if(ymm && (ebx & bit_AVX2))
+      f |= DILITHIUM_CPU_AVX2;
+    if(ebx & bit_BMI2)
+      f |= DILITHIUM_CPU_BMI2;
+  }
+#endif
+  return f;
+}
+
+/*************************************************
+* Name:        dilithium_select_backend
+*
+* Description: Pick the fastest backend for the given CPU features.
+*
+* Arguments:   - unsigned int f: bit mask from dilithium_cpu_features()
+*
+* Returns one of DILITHIUM_BACKEND_*.
+**************************************************/
+unsigned int dilithium_select_backend(unsigned int f) {
+  if((f & DILITHIUM_CPU_REQ_AVX2) == DILITHIUM_CPU_REQ_AVX2)
+    return DILITHIUM_BACKEND_AVX2;
+  if((f & DILITHIUM_CPU_REQ_SSE41) == DILITHIUM_CPU_REQ_SSE41)
+    return DILITHIUM_BACKEND_SSE41;
+  return DILITHIUM_BACKEND_REF;
+}
+
+/* Runs before the constructors of dependent code (priority 101), so the
+ * very first API call already goes to the selected backend. */
+static void __attribute__((constructor(101))) dilithium_cpu_init(void) {
+  dilithium_backend = dilithium_select_backend(dilithium_cpu_features());
+}
+
+const char *dilithium_backend_name(unsigned int backend) {
+  if(backend >= DILITHIUM_NBACKENDS)
+    return "unknown";
+  return backend_names[backend];
+}
+
+const char *pqcrystals_dilithium_implementation(void) {
+  return backend_names[dilithium_backend];
+}
@@ -0,0 +1,32 @@
+#ifndef CPU_H
+#define CPU_H
+
+#define DILITHIUM_CPU_SSE41  0x1
+#define DILITHIUM_CPU_POPCNT 0x2
+#define DILITHIUM_CPU_AVX2   0x4 // only set if the OS saves the YMM registers
+#define DILITHIUM_CPU_BMI2   0x8
+
+/* Backends in order of preference, lowest first */
+#define DILITHIUM_BACKEND_REF   0
+#define DILITHIUM_BACKEND_SSE41 1
+#define DILITHIUM_BACKEND_AVX2  2
+#define DILITHIUM_NBACKENDS     3
+
+#define DILITHIUM_CPU_REQ_SSE41 (DILITHIUM_CPU_SSE41)
+#define DILITHIUM_CPU_REQ_AVX2 \
+  (DILITHIUM_CPU_AVX2 | DILITHIUM_CPU_BMI2 | DILITHIUM_CPU_POPCNT)
+
+#define dilithium_cpu_features pqcrystals_dilithium_cpu_features
+unsigned int dilithium_cpu_features(void);
+
+#define dilithium_select_backend pqcrystals_dilithium_select_backend
+unsigned int dilithium_select_backend(unsigned int features);
+
+/* Backend used by the public API, chosen once when the library is loaded */
+#define dilithium_backend pqcrystals_dilithium_backend
+extern unsigned int dilithium_backend;
+
+#define dilithium_backend_name pqcrystals_dilithium_backend_name
+const char *dilithium_backend_name(unsigned int backend);
+
+#endif
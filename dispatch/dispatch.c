@@ -0,0 +1,87 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "api.h"
+#include "cpu.h"
+#include "dispatch.h"
+
+#define crypto_sign_keypair DILITHIUM_NAMESPACE(keypair)
+#define crypto_sign_signature DILITHIUM_NAMESPACE(signature)
+#define crypto_sign DILITHIUM_NAMESPACETOP
+#define crypto_sign_verify DILITHIUM_NAMESPACE(verify)
+#define crypto_sign_open DILITHIUM_NAMESPACE(open)
+#define impl_table DILITHIUM_NAMESPACE(impl)
+
+/* Prototypes of the namespaced backend builds linked into the library */
+#define DECLARE_IMPL(impl)                                                    \
+  int DILITHIUM_IMPL(impl, keypair)(uint8_t *pk, uint8_t *sk);                \
+  int DILITHIUM_IMPL(impl, signature)(uint8_t *sig, size_t *siglen,          \
+                                      const uint8_t *m, size_t mlen,          \
+                                      const uint8_t *ctx, size_t ctxlen,      \
+                                      const uint8_t *sk);                     \
+  int DILITHIUM_IMPLTOP(impl)(uint8_t *sm, size_t *smlen,                     \
+                              const uint8_t *m, size_t mlen,                  \
+                              const uint8_t *ctx, size_t ctxlen,              \
+                              const uint8_t *sk);                             \
+  int DILITHIUM_IMPL(impl, verify)(const uint8_t *sig, size_t siglen,        \
+                                   const uint8_t *m, size_t mlen,             \
+                                   const uint8_t *ctx, size_t ctxlen,         \
+                                   const uint8_t *pk);                        \
+  int DILITHIUM_IMPL(impl, open)(uint8_t *m, size_t *mlen,                    \
+                                 const uint8_t *sm, size_t smlen,             \
+                                 const uint8_t *ctx, size_t ctxlen,           \
+                                 const uint8_t *pk);
+
+#define IMPL_ENTRY(impl) {                                                    \
+  DILITHIUM_IMPL(impl, keypair),                                              \
+  DILITHIUM_IMPL(impl, signature),                                            \
+  DILITHIUM_IMPLTOP(impl),                                                    \
+  DILITHIUM_IMPL(impl, verify),                                               \
+  DILITHIUM_IMPL(impl, open)                                                  \
+}
+
+DECLARE_IMPL(ref)
+DECLARE_IMPL(sse41)
+DECLARE_IMPL(avx2)
+
+const dilithium_impl impl_table[DILITHIUM_NBACKENDS] = {
+  [DILITHIUM_BACKEND_REF] = IMPL_ENTRY(ref),
+  [DILITHIUM_BACKEND_SSE41] = IMPL_ENTRY(sse41),
+  [DILITHIUM_BACKEND_AVX2] = IMPL_ENTRY(avx2),
+};
+
+int crypto_sign_keypair(uint8_t *pk, uint8_t *sk) {
+  return impl_table[dilithium_backend].keypair(pk, sk);
+}
+
+int crypto_sign_signature(uint8_t *sig, size_t *siglen,
+                          const uint8_t *m, size_t mlen,
+                          const uint8_t *ctx, size_t ctxlen,
+                          const uint8_t *sk)
+{
+  return impl_table[dilithium_backend].signature(sig, siglen, m, mlen, ctx, ctxlen, sk);
+}
+
+int crypto_sign(uint8_t *sm, size_t *smlen,
+                const uint8_t *m, size_t mlen,
+                const uint8_t *ctx, size_t ctxlen,
+                const uint8_t *sk)
+{
+  return impl_table[dilithium_backend].sign(sm, smlen, m, mlen, ctx, ctxlen, sk);
+}
+
+int crypto_sign_verify(const uint8_t *sig, size_t siglen,
+                       const uint8_t *m, size_t mlen,
+                       const uint8_t *ctx, size_t ctxlen,
+                       const uint8_t *pk)
+{
+  return impl_table[dilithium_backend].verify(sig, siglen, m, mlen, ctx, ctxlen, pk);
+}
+
+int crypto_sign_open(uint8_t *m, size_t *mlen,
+                     const uint8_t *sm, size_t smlen,
+                     const uint8_t *ctx, size_t ctxlen,
+                     const uint8_t *pk)
+{
+  return impl_table[dilithium_backend].open(m, mlen, sm, smlen, ctx, ctxlen, pk);
+}
@@ -0,0 +1,34 @@
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cpu.h"
+
+/* NIST API of one backend build of one mode */
+typedef struct {
+  int (*keypair)(uint8_t *pk, uint8_t *sk);
+  int (*signature)(uint8_t *sig, size_t *siglen,
+                   const uint8_t *m, size_t mlen,
+                   const uint8_t *ctx, size_t ctxlen,
+                   const uint8_t *sk);
+  int (*sign)(uint8_t *sm, size_t *smlen,
+              const uint8_t *m, size_t mlen,
+              const uint8_t *ctx, size_t ctxlen,
+              const uint8_t *sk);
+  int (*verify)(const uint8_t *sig, size_t siglen,
+                const uint8_t *m, size_t mlen,
+                const uint8_t *ctx, size_t ctxlen,
+                const uint8_t *pk);
+  int (*open)(uint8_t *m, size_t *mlen,
+              const uint8_t *sm, size_t smlen,
+              const uint8_t *ctx, size_t ctxlen,
+              const uint8_t *pk);
+} dilithium_impl;
+
+/* Per-mode tables indexed by DILITHIUM_BACKEND_* */
+extern const dilithium_impl pqcrystals_dilithium2_impl[DILITHIUM_NBACKENDS];
+extern const dilithium_impl pqcrystals_dilithium3_impl[DILITHIUM_NBACKENDS];
+extern const dilithium_impl pqcrystals_dilithium5_impl[DILITHIUM_NBACKENDS];
+
+#endif
@@ -0,0 +1,115 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "api.h"
+#include "cpu.h"
+#include "dispatch.h"
+#include "mldsa.h"
+
+typedef struct {
+  const char *name;
+  size_t pklen;
+  size_t sklen;
+  size_t siglen;
+  const dilithium_impl *impl;
+} mldsa_info;
+
+static const mldsa_info params[MLDSA_NPARAMS] = {
+  [MLDSA_44] = { "ML-DSA-44", pqcrystals_dilithium2_PUBLICKEYBYTES,
+                 pqcrystals_dilithium2_SECRETKEYBYTES, pqcrystals_dilithium2_BYTES,
+                 pqcrystals_dilithium2_impl },
+  [MLDSA_65] = { "ML-DSA-65", pqcrystals_dilithium3_PUBLICKEYBYTES,
+                 pqcrystals_dilithium3_SECRETKEYBYTES, pqcrystals_dilithium3_BYTES,
+                 pqcrystals_dilithium3_impl },
+  [MLDSA_87] = { "ML-DSA-87", pqcrystals_dilithium5_PUBLICKEYBYTES,
+                 pqcrystals_dilithium5_SECRETKEYBYTES, pqcrystals_dilithium5_BYTES,
+                 pqcrystals_dilithium5_impl },
+};
+
+#if MLDSA_MAX_PUBLICKEYBYTES != pqcrystals_dilithium5_PUBLICKEYBYTES \
+ || MLDSA_MAX_SECRETKEYBYTES != pqcrystals_dilithium5_SECRETKEYBYTES \
+ || MLDSA_MAX_BYTES != pqcrystals_dilithium5_BYTES
+#error "MLDSA_MAX_* out of sync with api.h"
+#endif
+
+/* Functions of parameter set p for the backend selected at load time */
+static const dilithium_impl *impl(mldsa_param p) {
+  if((unsigned int)p >= MLDSA_NPARAMS)
+    return NULL;
+  return &params[p].impl[dilithium_backend];
+}
+
+size_t mldsa_publickeybytes(mldsa_param p) {
+  return ((unsigned int)p < MLDSA_NPARAMS) ? params[p].pklen : 0;
+}
+
+size_t mldsa_secretkeybytes(mldsa_param p) {
+  return ((unsigned int)p < MLDSA_NPARAMS) ? params[p].sklen : 0;
+}
+
+size_t mldsa_bytes(mldsa_param p) {
+  return ((unsigned int)p < MLDSA_NPARAMS) ? params[p].siglen : 0;
+}
+
+const char *mldsa_name(mldsa_param p) {
+  return ((unsigned int)p < MLDSA_NPARAMS) ? params[p].name : "unknown";
+}
+
+int mldsa_keypair(mldsa_param p, uint8_t *pk, uint8_t *sk) {
+  const dilithium_impl *f = impl(p);
+
+  if(!f)
+    return -1;
+  return f->keypair(pk, sk);
+}
+
+int mldsa_signature(mldsa_param p,
+                    uint8_t *sig, size_t *siglen,
+                    const uint8_t *m, size_t mlen,
+                    const uint8_t *ctx, size_t ctxlen,
+                    const uint8_t *sk)
+{
+  const dilithium_impl *f = impl(p);
+
+  if(!f)
+    return -1;
+  return f->signature(sig, siglen, m, mlen, ctx, ctxlen, sk);
+}
+
+int mldsa_sign(mldsa_param p,
+               uint8_t *sm, size_t *smlen,
+               const uint8_t *m, size_t mlen,
+               const uint8_t *ctx, size_t ctxlen,
+               const uint8_t *sk)
+{
+  const dilithium_impl *f = impl(p);
+
+  if(!f)
+    return -1;
+  return f->sign(sm, smlen, m, mlen, ctx, ctxlen, sk);
+}
+
+int mldsa_verify(mldsa_param p,
+                 const uint8_t *sig, size_t siglen,
+                 const uint8_t *m, size_t mlen,
+                 const uint8_t *ctx, size_t ctxlen,
+                 const uint8_t *pk)
+{
+  const dilithium_impl *f = impl(p);
+
+  if(!f)
+    return -1;
+  return f->verify(sig, siglen, m, mlen, ctx, ctxlen, pk);
+}
+
+int mldsa_open(mldsa_param p,
+               uint8_t *m, size_t *mlen,
+               const uint8_t *sm, size_t smlen,
+               const uint8_t *ctx, size_t ctxlen,
+               const uint8_t *pk)
+{
+  const dilithium_impl *f = impl(p);
+
+  if(!f)
+    return -1;
+  return f->open(m, mlen, sm, smlen, ctx, ctxlen, pk);
+}
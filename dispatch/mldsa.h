@@ -0,0 +1,55 @@
+#ifndef MLDSA_H
+#define MLDSA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Parameter sets of FIPS 204; each one is a separately compiled,
+ * namespaced build (Dilithium2/3/5) behind the same runtime dispatch as
+ * the pqcrystals_dilithiumN_* API. */
+typedef enum {
+  MLDSA_44 = 0,
+  MLDSA_65 = 1,
+  MLDSA_87 = 2
+} mldsa_param;
+
+#define MLDSA_NPARAMS 3
+
+/* Largest sizes over all parameter sets, for static buffers */
+#define MLDSA_MAX_PUBLICKEYBYTES 2592
+#define MLDSA_MAX_SECRETKEYBYTES 4896
+#define MLDSA_MAX_BYTES 4627
+
+size_t mldsa_publickeybytes(mldsa_param p);
+size_t mldsa_secretkeybytes(mldsa_param p);
+size_t mldsa_bytes(mldsa_param p);
+const char *mldsa_name(mldsa_param p);
+
+/* All functions return -1 for an unknown parameter set */
+int mldsa_keypair(mldsa_param p, uint8_t *pk, uint8_t *sk);
+
+int mldsa_signature(mldsa_param p,
+                    uint8_t *sig, size_t *siglen,
+                    const uint8_t *m, size_t mlen,
+                    const uint8_t *ctx, size_t ctxlen,
+                    const uint8_t *sk);
+
+int mldsa_sign(mldsa_param p,
+               uint8_t *sm, size_t *smlen,
+               const uint8_t *m, size_t mlen,
+               const uint8_t *ctx, size_t ctxlen,
+               const uint8_t *sk);
+
+int mldsa_verify(mldsa_param p,
+                 const uint8_t *sig, size_t siglen,
+                 const uint8_t *m, size_t mlen,
+                 const uint8_t *ctx, size_t ctxlen,
+                 const uint8_t *pk);
+
+int mldsa_open(mldsa_param p,
+               uint8_t *m, size_t *mlen,
+               const uint8_t *sm, size_t smlen,
+               const uint8_t *ctx, size_t ctxlen,
+               const uint8_t *pk);
+
+#endif
@@ -0,0 +1,173 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "../api.h"
+#include "../cpu.h"
+#include "../dispatch.h"
+#include "../mldsa.h"
+#include "../../ref/randombytes.h"
+
+#define MLEN 59
+#define MAXPK pqcrystals_dilithium5_PUBLICKEYBYTES
+#define MAXSK pqcrystals_dilithium5_SECRETKEYBYTES
+#define MAXSIG pqcrystals_dilithium5_BYTES
+
+typedef struct {
+  const char *name;
+  size_t pklen, sklen, siglen;
+  const dilithium_impl *impl;
+  dilithium_impl api; // exported unsuffixed functions
+} mode_info;
+
+static const mode_info modes[] = {
+  { "Dilithium2", pqcrystals_dilithium2_PUBLICKEYBYTES,
+    pqcrystals_dilithium2_SECRETKEYBYTES, pqcrystals_dilithium2_BYTES,
+    pqcrystals_dilithium2_impl,
+    { pqcrystals_dilithium2_keypair, pqcrystals_dilithium2_signature,
+      pqcrystals_dilithium2, pqcrystals_dilithium2_verify,
+      pqcrystals_dilithium2_open } },
+  { "Dilithium3", pqcrystals_dilithium3_PUBLICKEYBYTES,
+    pqcrystals_dilithium3_SECRETKEYBYTES, pqcrystals_dilithium3_BYTES,
+    pqcrystals_dilithium3_impl,
+    { pqcrystals_dilithium3_keypair, pqcrystals_dilithium3_signature,
+      pqcrystals_dilithium3, pqcrystals_dilithium3_verify,
+      pqcrystals_dilithium3_open } },
+  { "Dilithium5", pqcrystals_dilithium5_PUBLICKEYBYTES,
+    pqcrystals_dilithium5_SECRETKEYBYTES, pqcrystals_dilithium5_BYTES,
+    pqcrystals_dilithium5_impl,
+    { pqcrystals_dilithium5_keypair, pqcrystals_dilithium5_signature,
+      pqcrystals_dilithium5, pqcrystals_dilithium5_verify,
+      pqcrystals_dilithium5_open } },
+};
+
+static int supported(unsigned int backend, unsigned int features) {
+  return dilithium_select_backend(features) >= backend;
+}
+
+// Keys and signatures of every backend must be accepted by every other one
+static int test_cross(const mode_info *mi, unsigned int features, const uint8_t *m)
+{
+  uint8_t pk[MAXPK], sk[MAXSK], sig[MAXSIG];
+  size_t siglen;
+  unsigned int i, j, k;
+
+  for (i = 0; i < DILITHIUM_NBACKENDS; ++i) {
+    if (!supported(i, features))
+      continue;
+    mi->impl[i].keypair(pk, sk);
+    for (j = 0; j < DILITHIUM_NBACKENDS; ++j) {
+      if (!supported(j, features))
+        continue;
+      mi->impl[j].signature(sig, &siglen, m, MLEN, NULL, 0, sk);
+      for (k = 0; k < DILITHIUM_NBACKENDS; ++k) {
+        if (!supported(k, features))
+          continue;
+        if (siglen != mi->siglen || mi->impl[k].verify(sig, siglen, m, MLEN, NULL, 0, pk)) {
+          printf("ERROR: %s keygen %s, sign %s, verify %s failed\n", mi->name,
+                 dilithium_backend_name(i), dilithium_backend_name(j),
+                 dilithium_backend_name(k));
+          return 1;
+        }
+      }
+    }
+  }
+
+  return 0;
+}
+
+static int test_api(const mode_info *mi, const uint8_t *m)
+{
+  uint8_t pk[MAXPK], sk[MAXSK];
+  uint8_t sm[MAXSIG + MLEN], m2[MAXSIG + MLEN];
+  size_t smlen, mlen2;
+
+  mi->api.keypair(pk, sk);
+  mi->api.sign(sm, &smlen, m, MLEN, NULL, 0, sk);
+  if (mi->api.open(m2, &mlen2, sm, smlen, NULL, 0, pk) || mlen2 != MLEN) {
+    printf("ERROR: %s dispatched open rejected valid signature\n", mi->name);
+    return 1;
+  }
+  if (mi->api.verify(sm, mi->siglen, m, MLEN, NULL, 0, pk)) {
+    printf("ERROR: %s dispatched verify rejected valid signature\n", mi->name);
+    return 1;
+  }
+
+  sm[0] ^= 1;
+  if (!mi->api.verify(sm, mi->siglen, m, MLEN, NULL, 0, pk)) {
+    printf("ERROR: %s dispatched verify accepted forged signature\n", mi->name);
+    return 1;
+  }
+
+  return 0;
+}
+
+// One process, all parameter sets through mldsa_*
+static int test_mldsa(const uint8_t *m)
+{
+  uint8_t pk[MLDSA_NPARAMS][MLDSA_MAX_PUBLICKEYBYTES];
+  uint8_t sk[MLDSA_NPARAMS][MLDSA_MAX_SECRETKEYBYTES];
+  uint8_t sig[MLDSA_NPARAMS][MLDSA_MAX_BYTES];
+  size_t siglen[MLDSA_NPARAMS];
+  int p, q;
+
+  for (p = 0; p < MLDSA_NPARAMS; ++p) {
+    mldsa_keypair((mldsa_param)p, pk[p], sk[p]);
+    mldsa_signature((mldsa_param)p, sig[p], &siglen[p], m, MLEN, NULL, 0, sk[p]);
+    if (siglen[p] != mldsa_bytes((mldsa_param)p)) {
+      printf("ERROR: %s signature has wrong length\n", mldsa_name((mldsa_param)p));
+      return 1;
+    }
+  }
+
+  for (p = 0; p < MLDSA_NPARAMS; ++p) {
+    for (q = 0; q < MLDSA_NPARAMS; ++q) {
+      int r = mldsa_verify((mldsa_param)q, sig[p], siglen[p], m, MLEN, NULL, 0, pk[q]);
+      if ((p == q) != (r == 0)) {
+        printf("ERROR: %s verify of %s signature returned %d\n",
+               mldsa_name((mldsa_param)q), mldsa_name((mldsa_param)p), r);
+        return 1;
+      }
+    }
+  }
+
+  if (mldsa_verify((mldsa_param)MLDSA_NPARAMS, sig[0], siglen[0], m, MLEN, NULL, 0, pk[0]) != -1
+      || mldsa_bytes((mldsa_param)-1) != 0) {
+    printf("ERROR: unknown parameter set accepted\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+int main(void)
+{
+  uint8_t m[MLEN];
+  unsigned int features = dilithium_cpu_features();
+  unsigned int i;
+
+  printf("CPU features:%s%s%s%s\n",
+         (features & DILITHIUM_CPU_SSE41) ? " sse4.1" : "",
+         (features & DILITHIUM_CPU_POPCNT) ? " popcnt" : "",
+         (features & DILITHIUM_CPU_AVX2) ? " avx2" : "",
+         (features & DILITHIUM_CPU_BMI2) ? " bmi2" : "");
+  printf("Selected implementation: %s\n", pqcrystals_dilithium_implementation());
+
+  if (dilithium_backend != dilithium_select_backend(features)) {
+    printf("ERROR: library did not select the fastest backend\n");
+    return 1;
+  }
+
+  randombytes(m, MLEN);
+  for (i = 0; i < sizeof(modes)/sizeof(modes[0]); ++i) {
+    if (test_cross(&modes[i], features, m))
+      return 1;
+    if (test_api(&modes[i], m))
+      return 1;
+  }
+
+  if (test_mldsa(m))
+    return 1;
+
+  printf("All backends agree\n");
+  return 0;
+}
@@ -357,6 +357,52 @@ static void keccak_init(uint64_t s[25])
     s[i] = 0;
 }
 
+/*************************************************
+* Name:        keccak_xorbytes
+*
+* Description: XOR bytes into the Keccak state, whole lanes at a time
+*              where the position is lane-aligned.
+*
+* Arguments:   - uint64_t *s: pointer to Keccak state
+*              - unsigned int pos: byte offset in state (pos+len <= 200)
+*              - const uint8_t *in: pointer to input
+*              - size_t len: number of bytes
+**************************************************/
+static void keccak_xorbytes(uint64_t s[25], unsigned int pos, const uint8_t *in, size_t len)
+{
+  for(;len > 0 && pos%8;len--,pos++)
+    s[pos/8] ^= (uint64_t)*in++ << 8*(pos%8);
+
+  for(;len >= 8;len-=8,pos+=8,in+=8)
+    s[pos/8] ^= load64(in);
+
+  for(;len > 0;len--,pos++)
+    s[pos/8] ^= (uint64_t)*in++ << 8*(pos%8);
+}
+
+/*************************************************
+* Name:        keccak_extractbytes
+*
+* Description: Copy bytes out of the Keccak state, whole lanes at a time
+*              where the position is lane-aligned.
+*
+* Arguments:   - uint8_t *out: pointer to output
+*              - const uint64_t *s: pointer to Keccak state
+*              - unsigned int pos: byte offset in state (pos+len <= 200)
+*              - size_t len: number of bytes
+**************************************************/
+static void keccak_extractbytes(uint8_t *out, const uint64_t s[25], unsigned int pos, size_t len)
+{
+  for(;len > 0 && pos%8;len--,pos++)
+    *out++ = s[pos/8] >> 8*(pos%8);
+
+  for(;len >= 8;len-=8,pos+=8,out+=8)
+    store64(out, s[pos/8]);
+
+  for(;len > 0;len--,pos++)
+    *out++ = s[pos/8] >> 8*(pos%8);
+}
+
 /*************************************************
 * Name:        keccak_absorb
 *
@@ -378,18 +424,29 @@ static unsigned int keccak_absorb(uint64_t s[25],
 {
   unsigned int i;
 
-  while(pos+inlen >= r) {
-    for(i=pos;i<r;i++)
-      s[i/8] ^= (uint64_t)*in++ << 8*(i%8);
+  if(pos+inlen < r) {
+    keccak_xorbytes(s, pos, in, inlen);
+    return pos+inlen;
+  }
+
+  if(pos > 0) {
+    keccak_xorbytes(s, pos, in, r-pos);
+    in += r-pos;
     inlen -= r-pos;
     KeccakF1600_StatePermute(s);
-    pos = 0;
   }
 
-  for(i=pos;i<pos+inlen;i++)
-    s[i/8] ^= (uint64_t)*in++ << 8*(i%8);
+  /* Full blocks go straight to the permutation */
+  while(inlen >= r) {
+    for(i=0;i<r/8;i++)
+      s[i] ^= load64(in+8*i);
+    in += r;
+    inlen -= r;
+    KeccakF1600_StatePermute(s);
+  }
 
-  return i;
+  keccak_xorbytes(s, 0, in, inlen);
+  return inlen;
 }
 
 /*************************************************
@@ -429,17 +486,18 @@ static unsigned int keccak_squeeze(uint8_t *out,
                                    unsigned int pos,
                                    unsigned int r)
 {
-  unsigned int i;
+  size_t n;
 
   while(outlen) {
     if(pos == r) {
       KeccakF1600_StatePermute(s);
       pos = 0;
     }
-    for(i=pos;i < r && i < pos+outlen; i++)
-      *out++ = s[i/8] >> 8*(i%8);
-    outlen -= i-pos;
-    pos = i;
+    n = (outlen < r-pos) ? outlen : r-pos;
+    keccak_extractbytes(out, s, pos, n);
+    out += n;
+    outlen -= n;
+    pos += n;
   }
 
   return pos;
@@ -0,0 +1,51 @@
+#ifndef FIPS202X4_H
+#define FIPS202X4_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fips202.h"
+
+#define FIPS202X4_NAMESPACE(s) pqcrystals_dilithium_fips202x4_ref_##s
+
+/* Four Keccak states, interleaved lane by lane in two pairs. Built on GCC
+ * vector extensions: every operation on a keccakx2_lane acts on two states
+ * and maps to a single SSE2 (or NEON) instruction. */
+typedef uint64_t keccakx2_lane __attribute__((vector_size(16)));
+
+typedef struct {
+  keccakx2_lane s[2][25];
+} keccakx4_state;
+
+#define shake128x4_absorb_once FIPS202X4_NAMESPACE(shake128x4_absorb_once)
+void shake128x4_absorb_once(keccakx4_state *state,
+                            const uint8_t *in0,
+                            const uint8_t *in1,
+                            const uint8_t *in2,
+                            const uint8_t *in3,
+                            size_t inlen);
+
+#define shake128x4_squeezeblocks FIPS202X4_NAMESPACE(shake128x4_squeezeblocks)
+void shake128x4_squeezeblocks(uint8_t *out0,
+                              uint8_t *out1,
+                              uint8_t *out2,
+                              uint8_t *out3,
+                              size_t nblocks,
+                              keccakx4_state *state);
+
+#define shake256x4_absorb_once FIPS202X4_NAMESPACE(shake256x4_absorb_once)
+void shake256x4_absorb_once(keccakx4_state *state,
+                            const uint8_t *in0,
+                            const uint8_t *in1,
+                            const uint8_t *in2,
+                            const uint8_t *in3,
+                            size_t inlen);
+
+#define shake256x4_squeezeblocks FIPS202X4_NAMESPACE(shake256x4_squeezeblocks)
+void shake256x4_squeezeblocks(uint8_t *out0,
+                              uint8_t *out1,
+                              uint8_t *out2,
+                              uint8_t *out3,
+                              size_t nblocks,
+                              keccakx4_state *state);
+
+#endif
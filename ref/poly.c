@@ -5,6 +5,7 @@
 #include "reduce.h"
 #include "rounding.h"
 #include "symmetric.h"
+#include "fips202x4.h"
 
 #ifdef DBENCH
 #include "test/cpucycles.h"
@@ -367,6 +368,62 @@ void poly_uniform(poly *a,
   }
 }
 
+/*************************************************
+* Name:        poly_uniform_4x
+*
+* Description: Sample four polynomials as in poly_uniform, running the four
+*              SHAKE128 streams on the interleaved Keccak from fips202x4.c.
+*
+* Arguments:   - poly *a0, ..., *a3: pointers to output polynomials
+*              - const uint8_t seed[]: byte array with seed of length SEEDBYTES
+*              - uint16_t nonce0, ..., nonce3: 2-byte nonces
+**************************************************/
+void poly_uniform_4x(poly *a0,
+                     poly *a1,
+                     poly *a2,
+                     poly *a3,
+                     const uint8_t seed[SEEDBYTES],
+                     uint16_t nonce0,
+                     uint16_t nonce1,
+                     uint16_t nonce2,
+                     uint16_t nonce3)
+{
+  unsigned int i, ctr0, ctr1, ctr2, ctr3;
+  unsigned int buflen = POLY_UNIFORM_NBLOCKS*STREAM128_BLOCKBYTES;
+  uint8_t buf[4][POLY_UNIFORM_NBLOCKS*STREAM128_BLOCKBYTES];
+  keccakx4_state state;
+
+  for(i = 0; i < SEEDBYTES; ++i)
+    buf[0][i] = buf[1][i] = buf[2][i] = buf[3][i] = seed[i];
+
+  buf[0][SEEDBYTES+0] = nonce0;
+  buf[0][SEEDBYTES+1] = nonce0 >> 8;
+  buf[1][SEEDBYTES+0] = nonce1;
+  buf[1][SEEDBYTES+1] = nonce1 >> 8;
+  buf[2][SEEDBYTES+0] = nonce2;
+  buf[2][SEEDBYTES+1] = nonce2 >> 8;
+  buf[3][SEEDBYTES+0] = nonce3;
+  buf[3][SEEDBYTES+1] = nonce3 >> 8;
+
+  shake128x4_absorb_once(&state, buf[0], buf[1], buf[2], buf[3], SEEDBYTES + 2);
+  shake128x4_squeezeblocks(buf[0], buf[1], buf[2], buf[3], POLY_UNIFORM_NBLOCKS, &state);
+
+  ctr0 = rej_uniform(a0->coeffs, N, buf[0], buflen);
+  ctr1 = rej_uniform(a1->coeffs, N, buf[1], buflen);
+  ctr2 = rej_uniform(a2->coeffs, N, buf[2], buflen);
+  ctr3 = rej_uniform(a3->coeffs, N, buf[3], buflen);
+
+  /* Block lengths are multiples of 3, so no bytes carry over */
+  while(ctr0 < N || ctr1 < N || ctr2 < N || ctr3 < N) {
+    shake128x4_squeezeblocks(buf[0], buf[1], buf[2], buf[3], 1, &state);
+
+    ctr0 += rej_uniform(a0->coeffs + ctr0, N - ctr0, buf[0], STREAM128_BLOCKBYTES);
+    ctr1 += rej_uniform(a1->coeffs + ctr1, N - ctr1, buf[1], STREAM128_BLOCKBYTES);
+    ctr2 += rej_uniform(a2->coeffs + ctr2, N - ctr2, buf[2], STREAM128_BLOCKBYTES);
+    ctr3 += rej_uniform(a3->coeffs + ctr3, N - ctr3, buf[3], STREAM128_BLOCKBYTES);
+  }
+}
+
 /*************************************************
 * Name:        rej_eta
 *
@@ -452,6 +509,61 @@ void poly_uniform_eta(poly *a,
   }
 }
 
+/*************************************************
+* Name:        poly_uniform_eta_4x
+*
+* Description: Sample four polynomials as in poly_uniform_eta, running the
+*              four SHAKE256 streams on the interleaved Keccak.
+*
+* Arguments:   - poly *a0, ..., *a3: pointers to output polynomials
+*              - const uint8_t seed[]: byte array with seed of length CRHBYTES
+*              - uint16_t nonce0, ..., nonce3: 2-byte nonces
+**************************************************/
+void poly_uniform_eta_4x(poly *a0,
+                         poly *a1,
+                         poly *a2,
+                         poly *a3,
+                         const uint8_t seed[CRHBYTES],
+                         uint16_t nonce0,
+                         uint16_t nonce1,
+                         uint16_t nonce2,
+                         uint16_t nonce3)
+{
+  unsigned int i, ctr0, ctr1, ctr2, ctr3;
+  unsigned int buflen = POLY_UNIFORM_ETA_NBLOCKS*STREAM256_BLOCKBYTES;
+  uint8_t buf[4][POLY_UNIFORM_ETA_NBLOCKS*STREAM256_BLOCKBYTES];
+  keccakx4_state state;
+
+  for(i = 0; i < CRHBYTES; ++i)
+    buf[0][i] = buf[1][i] = buf[2][i] = buf[3][i] = seed[i];
+
+  buf[0][CRHBYTES+0] = nonce0;
+  buf[0][CRHBYTES+1] = nonce0 >> 8;
+  buf[1][CRHBYTES+0] = nonce1;
+  buf[1][CRHBYTES+1] = nonce1 >> 8;
+  buf[2][CRHBYTES+0] = nonce2;
+  buf[2][CRHBYTES+1] = nonce2 >> 8;
+  buf[3][CRHBYTES+0] = nonce3;
+  buf[3][CRHBYTES+1] = nonce3 >> 8;
+
+  shake256x4_absorb_once(&state, buf[0], buf[1], buf[2], buf[3], CRHBYTES + 2);
+  shake256x4_squeezeblocks(buf[0], buf[1], buf[2], buf[3], POLY_UNIFORM_ETA_NBLOCKS, &state);
+
+  ctr0 = rej_eta(a0->coeffs, N, buf[0], buflen);
+  ctr1 = rej_eta(a1->coeffs, N, buf[1], buflen);
+  ctr2 = rej_eta(a2->coeffs, N, buf[2], buflen);
+  ctr3 = rej_eta(a3->coeffs, N, buf[3], buflen);
+
+  while(ctr0 < N || ctr1 < N || ctr2 < N || ctr3 < N) {
+    shake256x4_squeezeblocks(buf[0], buf[1], buf[2], buf[3], 1, &state);
+
+    ctr0 += rej_eta(a0->coeffs + ctr0, N - ctr0, buf[0], STREAM256_BLOCKBYTES);
+    ctr1 += rej_eta(a1->coeffs + ctr1, N - ctr1, buf[1], STREAM256_BLOCKBYTES);
+    ctr2 += rej_eta(a2->coeffs + ctr2, N - ctr2, buf[2], STREAM256_BLOCKBYTES);
+    ctr3 += rej_eta(a3->coeffs + ctr3, N - ctr3, buf[3], STREAM256_BLOCKBYTES);
+  }
+}
+
 /*************************************************
 * Name:        poly_uniform_gamma1m1
 *
@@ -476,6 +588,51 @@ void poly_uniform_gamma1(poly *a,
   polyz_unpack(a, buf);
 }
 
+/*************************************************
+* Name:        poly_uniform_gamma1_4x
+*
+* Description: Sample four polynomials as in poly_uniform_gamma1, running
+*              the four SHAKE256 streams on the interleaved Keccak.
+*
+* Arguments:   - poly *a0, ..., *a3: pointers to output polynomials
+*              - const uint8_t seed[]: byte array with seed of length CRHBYTES
+*              - uint16_t nonce0, ..., nonce3: 16-bit nonces
+**************************************************/
+void poly_uniform_gamma1_4x(poly *a0,
+                            poly *a1,
+                            poly *a2,
+                            poly *a3,
+                            const uint8_t seed[CRHBYTES],
+                            uint16_t nonce0,
+                            uint16_t nonce1,
+                            uint16_t nonce2,
+                            uint16_t nonce3)
+{
+  unsigned int i;
+  uint8_t buf[4][POLY_UNIFORM_GAMMA1_NBLOCKS*STREAM256_BLOCKBYTES];
+  keccakx4_state state;
+
+  for(i = 0; i < CRHBYTES; ++i)
+    buf[0][i] = buf[1][i] = buf[2][i] = buf[3][i] = seed[i];
+
+  buf[0][CRHBYTES+0] = nonce0;
+  buf[0][CRHBYTES+1] = nonce0 >> 8;
+  buf[1][CRHBYTES+0] = nonce1;
+  buf[1][CRHBYTES+1] = nonce1 >> 8;
+  buf[2][CRHBYTES+0] = nonce2;
+  buf[2][CRHBYTES+1] = nonce2 >> 8;
+  buf[3][CRHBYTES+0] = nonce3;
+  buf[3][CRHBYTES+1] = nonce3 >> 8;
+
+  shake256x4_absorb_once(&state, buf[0], buf[1], buf[2], buf[3], CRHBYTES + 2);
+  shake256x4_squeezeblocks(buf[0], buf[1], buf[2], buf[3], POLY_UNIFORM_GAMMA1_NBLOCKS, &state);
+
+  polyz_unpack(a0, buf[0]);
+  polyz_unpack(a1, buf[1]);
+  polyz_unpack(a2, buf[2]);
+  polyz_unpack(a3, buf[3]);
+}
+
 /*************************************************
 * Name:        challenge
 *
@@ -520,6 +677,108 @@ void poly_challenge(poly *c, const uint8_t seed[CTILDEBYTES]) {
   }
 }
 
+/*************************************************
+* Name:        poly_challenge_sparse
+*
+* Description: Lists the TAU nonzero coefficients of a challenge
+*              polynomial for poly_sparse_mul and poly_sparse_mul_eta.
+*
+* Arguments:   - poly_sparse *cs: pointer to output sparse challenge
+*              - const poly *c: pointer to challenge from poly_challenge
+**************************************************/
+void poly_challenge_sparse(poly_sparse *cs, const poly *c) {
+  unsigned int i, k = 0;
+
+  for(i = 0; i < N; ++i) {
+    if(c->coeffs[i]) {
+      cs->pos[k] = i;
+      cs->neg[k] = c->coeffs[i] < 0;
+      ++k;
+    }
+  }
+}
+
+/* Coefficients of c*a for a with coefficients in [-ETA,ETA] are bounded
+ * by TAU*ETA (BETA), so they are summed in the narrowest type that holds
+ * them: more of them fit in one vector register */
+#if BETA < 128
+typedef int8_t sparse_eta_t;
+#else
+typedef int16_t sparse_eta_t;
+#endif
+
+/*************************************************
+* Name:        poly_sparse_mul_eta
+*
+* Description: Negacyclic product of a sparse challenge and a polynomial
+*              with coefficients in [-ETA,ETA], without NTT: the sum of
+*              TAU signed rotations of a. The result is exact, with
+*              coefficients in [-BETA,BETA]. Timing depends on the
+*              positions and signs of the nonzero coefficients of c, which
+*              are secret for rejected attempts (see SPARSE_CS in config.h).
+*
+* Arguments:   - poly *r: pointer to output polynomial
+*              - const poly_sparse *c: pointer to sparse challenge
+*              - const poly *a: pointer to input polynomial
+**************************************************/
+void poly_sparse_mul_eta(poly *r, const poly_sparse *c, const poly *a) {
+  unsigned int i, k;
+  sparse_eta_t ext[2*N], acc[N];
+  const sparse_eta_t *e;
+
+  /* x^pos*a is the window of (-a, a) that starts at N - pos */
+  for(i = 0; i < N; ++i) {
+    ext[i] = -a->coeffs[i];
+    ext[N+i] = a->coeffs[i];
+    acc[i] = 0;
+  }
+  for(k = 0; k < TAU; ++k) {
+    e = ext + N - c->pos[k];
+    if(c->neg[k])
+      for(i = 0; i < N; ++i)
+        acc[i] -= e[i];
+    else
+      for(i = 0; i < N; ++i)
+        acc[i] += e[i];
+  }
+  for(i = 0; i < N; ++i)
+    r->coeffs[i] = acc[i];
+}
+
+/*************************************************
+* Name:        poly_sparse_mul
+*
+* Description: Like poly_sparse_mul_eta for a polynomial with coefficients
+*              of absolute value below 2^31/TAU, e.g. t0; the result is
+*              exact.
+*
+* Arguments:   - poly *r: pointer to output polynomial
+*              - const poly_sparse *c: pointer to sparse challenge
+*              - const poly *a: pointer to input polynomial
+**************************************************/
+void poly_sparse_mul(poly *r, const poly_sparse *c, const poly *a) {
+  unsigned int i, k;
+  int32_t ext[2*N], acc[N];
+  const int32_t *e;
+
+  for(i = 0; i < N; ++i) {
+    ext[i] = -a->coeffs[i];
+    ext[N+i] = a->coeffs[i];
+    acc[i] = 0;
+  }
+  for(k = 0; k < TAU; ++k) {
+    e = ext + N - c->pos[k];
+    if(c->neg[k])
+      for(i = 0; i < N; ++i)
+        acc[i] -= e[i];
+    else
+      for(i = 0; i < N; ++i)
+        acc[i] += e[i];
+  }
+  for(i = 0; i < N; ++i)
+    r->coeffs[i] = acc[i];
+}
+
 /*************************************************
 * Name:        polyeta_pack
 *
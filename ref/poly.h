@@ -50,9 +50,53 @@ void poly_uniform_eta(poly *a,
 void poly_uniform_gamma1(poly *a,
                          const uint8_t seed[CRHBYTES],
                          uint16_t nonce);
+
+#define poly_uniform_4x DILITHIUM_NAMESPACE(poly_uniform_4x)
+void poly_uniform_4x(poly *a0,
+                     poly *a1,
+                     poly *a2,
+                     poly *a3,
+                     const uint8_t seed[SEEDBYTES],
+                     uint16_t nonce0,
+                     uint16_t nonce1,
+                     uint16_t nonce2,
+                     uint16_t nonce3);
+#define poly_uniform_eta_4x DILITHIUM_NAMESPACE(poly_uniform_eta_4x)
+void poly_uniform_eta_4x(poly *a0,
+                         poly *a1,
+                         poly *a2,
+                         poly *a3,
+                         const uint8_t seed[CRHBYTES],
+                         uint16_t nonce0,
+                         uint16_t nonce1,
+                         uint16_t nonce2,
+                         uint16_t nonce3);
+#define poly_uniform_gamma1_4x DILITHIUM_NAMESPACE(poly_uniform_gamma1_4x)
+void poly_uniform_gamma1_4x(poly *a0,
+                            poly *a1,
+                            poly *a2,
+                            poly *a3,
+                            const uint8_t seed[CRHBYTES],
+                            uint16_t nonce0,
+                            uint16_t nonce1,
+                            uint16_t nonce2,
+                            uint16_t nonce3);
 #define poly_challenge DILITHIUM_NAMESPACE(poly_challenge)
 void poly_challenge(poly *c, const uint8_t seed[CTILDEBYTES]);
 
+/* Challenge by its TAU nonzero coefficients, for the sparse products */
+typedef struct {
+  uint8_t pos[TAU]; // positions
+  uint8_t neg[TAU]; // 1 where the coefficient is -1
+} poly_sparse;
+
+#define poly_challenge_sparse DILITHIUM_NAMESPACE(poly_challenge_sparse)
+void poly_challenge_sparse(poly_sparse *cs, const poly *c);
+#define poly_sparse_mul_eta DILITHIUM_NAMESPACE(poly_sparse_mul_eta)
+void poly_sparse_mul_eta(poly *r, const poly_sparse *c, const poly *a);
+#define poly_sparse_mul DILITHIUM_NAMESPACE(poly_sparse_mul)
+void poly_sparse_mul(poly *r, const poly_sparse *c, const poly *a);
+
 #define polyeta_pack DILITHIUM_NAMESPACE(polyeta_pack)
 void polyeta_pack(uint8_t *r, const poly *a);
 #define polyeta_unpack DILITHIUM_NAMESPACE(polyeta_unpack)
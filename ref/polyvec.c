@@ -14,11 +14,38 @@
 *              - const uint8_t rho[]: byte array containing seed rho
 **************************************************/
 void polyvec_matrix_expand(polyvecl mat[K], const uint8_t rho[SEEDBYTES]) {
-  unsigned int i, j;
+  unsigned int i;
 
-  for(i = 0; i < K; ++i)
-    for(j = 0; j < L; ++j)
-      poly_uniform(&mat[i].vec[j], rho, (i << 8) + j);
+  /* Walk the K*L entries row by row, four SHAKE128 streams at a time */
+  for(i = 0; i < K*L/4*4; i += 4)
+    poly_uniform_4x(&mat[(i+0)/L].vec[(i+0)%L], &mat[(i+1)/L].vec[(i+1)%L],
+                    &mat[(i+2)/L].vec[(i+2)%L], &mat[(i+3)/L].vec[(i+3)%L], rho,
+                    (((i+0)/L) << 8) + (i+0)%L, (((i+1)/L) << 8) + (i+1)%L,
+                    (((i+2)/L) << 8) + (i+2)%L, (((i+3)/L) << 8) + (i+3)%L);
+
+  for(i = K*L/4*4; i < K*L; ++i)
+    poly_uniform(&mat[i/L].vec[i%L], rho, ((i/L) << 8) + i%L);
+}
+
+/*************************************************
+* Name:        polyvec_matrix_expand_row
+*
+* Description: Generates row i of matrix A, the same polynomials as
+*              polyvec_matrix_expand, independently of the other rows.
+*
+* Arguments:   - polyvecl *row: output row
+*              - const uint8_t rho[]: byte array containing seed rho
+*              - unsigned int i: row index
+**************************************************/
+void polyvec_matrix_expand_row(polyvecl *row, const uint8_t rho[SEEDBYTES], unsigned int i) {
+  unsigned int j;
+
+  for(j = 0; j < L/4*4; j += 4)
+    poly_uniform_4x(&row->vec[j], &row->vec[j+1], &row->vec[j+2], &row->vec[j+3], rho,
+                    (i << 8) + j, (i << 8) + j + 1, (i << 8) + j + 2, (i << 8) + j + 3);
+
+  for(j = L/4*4; j < L; ++j)
+    poly_uniform(&row->vec[j], rho, (i << 8) + j);
 }
 
 void polyvec_matrix_pointwise_montgomery(polyveck *t, const polyvecl mat[K], const polyvecl *v) {
@@ -35,14 +62,22 @@ void polyvec_matrix_pointwise_montgomery(polyveck *t, const polyvecl mat[K], con
 void polyvecl_uniform_eta(polyvecl *v, const uint8_t seed[CRHBYTES], uint16_t nonce) {
   unsigned int i;
 
-  for(i = 0; i < L; ++i)
-    poly_uniform_eta(&v->vec[i], seed, nonce++);
+  for(i = 0; i < L/4*4; i += 4)
+    poly_uniform_eta_4x(&v->vec[i], &v->vec[i+1], &v->vec[i+2], &v->vec[i+3], seed,
+                        nonce + i, nonce + i + 1, nonce + i + 2, nonce + i + 3);
+
+  for(i = L/4*4; i < L; ++i)
+    poly_uniform_eta(&v->vec[i], seed, nonce + i);
 }
 
 void polyvecl_uniform_gamma1(polyvecl *v, const uint8_t seed[CRHBYTES], uint16_t nonce) {
   unsigned int i;
 
-  for(i = 0; i < L; ++i)
+  for(i = 0; i < L/4*4; i += 4)
+    poly_uniform_gamma1_4x(&v->vec[i], &v->vec[i+1], &v->vec[i+2], &v->vec[i+3], seed,
+                           L*nonce + i, L*nonce + i + 1, L*nonce + i + 2, L*nonce + i + 3);
+
+  for(i = L/4*4; i < L; ++i)
     poly_uniform_gamma1(&v->vec[i], seed, L*nonce + i);
 }
 
@@ -99,6 +134,13 @@ void polyvecl_pointwise_poly_montgomery(polyvecl *r, const poly *a, const polyve
     poly_pointwise_montgomery(&r->vec[i], a, &v->vec[i]);
 }
 
+void polyvecl_sparse_mul_eta(polyvecl *r, const poly_sparse *c, const polyvecl *v) {
+  unsigned int i;
+
+  for(i = 0; i < L; ++i)
+    poly_sparse_mul_eta(&r->vec[i], c, &v->vec[i]);
+}
+
 /*************************************************
 * Name:        polyvecl_pointwise_acc_montgomery
 *
@@ -153,8 +195,12 @@ int polyvecl_chknorm(const polyvecl *v, int32_t bound)  {
 void polyveck_uniform_eta(polyveck *v, const uint8_t seed[CRHBYTES], uint16_t nonce) {
   unsigned int i;
 
-  for(i = 0; i < K; ++i)
-    poly_uniform_eta(&v->vec[i], seed, nonce++);
+  for(i = 0; i < K/4*4; i += 4)
+    poly_uniform_eta_4x(&v->vec[i], &v->vec[i+1], &v->vec[i+2], &v->vec[i+3], seed,
+                        nonce + i, nonce + i + 1, nonce + i + 2, nonce + i + 3);
+
+  for(i = K/4*4; i < K; ++i)
+    poly_uniform_eta(&v->vec[i], seed, nonce + i);
 }
 
 /*************************************************
@@ -275,6 +321,20 @@ void polyveck_pointwise_poly_montgomery(polyveck *r, const poly *a, const polyve
     poly_pointwise_montgomery(&r->vec[i], a, &v->vec[i]);
 }
 
+void polyveck_sparse_mul_eta(polyveck *r, const poly_sparse *c, const polyveck *v) {
+  unsigned int i;
+
+  for(i = 0; i < K; ++i)
+    poly_sparse_mul_eta(&r->vec[i], c, &v->vec[i]);
+}
+
+void polyveck_sparse_mul(polyveck *r, const poly_sparse *c, const polyveck *v) {
+  unsigned int i;
+
+  for(i = 0; i < K; ++i)
+    poly_sparse_mul(&r->vec[i], c, &v->vec[i]);
+}
+
 
 /*************************************************
 * Name:        polyveck_chknorm
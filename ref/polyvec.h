@@ -28,6 +28,8 @@ void polyvecl_ntt(polyvecl *v);
 void polyvecl_invntt_tomont(polyvecl *v);
 #define polyvecl_pointwise_poly_montgomery DILITHIUM_NAMESPACE(polyvecl_pointwise_poly_montgomery)
 void polyvecl_pointwise_poly_montgomery(polyvecl *r, const poly *a, const polyvecl *v);
+#define polyvecl_sparse_mul_eta DILITHIUM_NAMESPACE(polyvecl_sparse_mul_eta)
+void polyvecl_sparse_mul_eta(polyvecl *r, const poly_sparse *c, const polyvecl *v);
 #define polyvecl_pointwise_acc_montgomery \
         DILITHIUM_NAMESPACE(polyvecl_pointwise_acc_montgomery)
 void polyvecl_pointwise_acc_montgomery(poly *w,
@@ -66,6 +68,10 @@ void polyveck_ntt(polyveck *v);
 void polyveck_invntt_tomont(polyveck *v);
 #define polyveck_pointwise_poly_montgomery DILITHIUM_NAMESPACE(polyveck_pointwise_poly_montgomery)
 void polyveck_pointwise_poly_montgomery(polyveck *r, const poly *a, const polyveck *v);
+#define polyveck_sparse_mul_eta DILITHIUM_NAMESPACE(polyveck_sparse_mul_eta)
+void polyveck_sparse_mul_eta(polyveck *r, const poly_sparse *c, const polyveck *v);
+#define polyveck_sparse_mul DILITHIUM_NAMESPACE(polyveck_sparse_mul)
+void polyveck_sparse_mul(polyveck *r, const poly_sparse *c, const polyveck *v);
 
 #define polyveck_chknorm DILITHIUM_NAMESPACE(polyveck_chknorm)
 int polyveck_chknorm(const polyveck *v, int32_t B);
@@ -86,6 +92,8 @@ void polyveck_pack_w1(uint8_t r[K*POLYW1_PACKEDBYTES], const polyveck *w1);
 
 #define polyvec_matrix_expand DILITHIUM_NAMESPACE(polyvec_matrix_expand)
 void polyvec_matrix_expand(polyvecl mat[K], const uint8_t rho[SEEDBYTES]);
+#define polyvec_matrix_expand_row DILITHIUM_NAMESPACE(polyvec_matrix_expand_row)
+void polyvec_matrix_expand_row(polyvecl *row, const uint8_t rho[SEEDBYTES], unsigned int i);
 
 #define polyvec_matrix_pointwise_montgomery DILITHIUM_NAMESPACE(polyvec_matrix_pointwise_montgomery)
 void polyvec_matrix_pointwise_montgomery(polyveck *t, const polyvecl mat[K], const polyvecl *v);
@@ -1,6 +1,7 @@
 #define _POSIX_C_SOURCE 199309L // POSIX compliance
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include "params.h"
 #include "sign.h"
@@ -10,9 +11,118 @@
 #include "randombytes.h"
 #include "symmetric.h"
 #include "fips202.h"
+#include "fips202x4.h"
 
 // global timing struct now defined in sign.h
-timing_info_t g_time = {0};
+__thread timing_info_t g_time = {0};
+
+#define PREHASH_OIDBYTES 11
+
+/* Team of the row-parallel mode, per calling thread (crypto_sign_set_team) */
+static __thread const sign_team *row_team;
+
+/*************************************************
+* Name:        crypto_sign_set_team
+*
+* Description: Sets the thread team that operations on the calling thread
+*              split the rows of matrix A over (NULL: none).
+*
+* Arguments:   - const sign_team *team: thread team, or NULL
+**************************************************/
+void crypto_sign_set_team(const sign_team *team)
+{
+  row_team = team;
+}
+
+static int rows_parallel(void)
+{
+  return row_team && row_team->width >= 2;
+}
+
+typedef struct {
+  polyvecl *mat;
+  const uint8_t *rho;
+} expand_job;
+
+static void expand_row(void *arg, unsigned int i)
+{
+  expand_job *job = arg;
+
+  polyvec_matrix_expand_row(&job->mat[i], job->rho, i);
+}
+
+/* ExpandA, one row per team call if a team is set */
+static void matrix_expand(polyvecl mat[K], const uint8_t rho[SEEDBYTES])
+{
+  expand_job job;
+
+  if(!rows_parallel()) {
+    polyvec_matrix_expand(mat, rho);
+    return;
+  }
+  job.mat = mat;
+  job.rho = rho;
+  row_team->run(row_team, expand_row, &job, K);
+}
+
+/* t = A*v [- c*u], reduced and back in normal domain */
+typedef struct {
+  polyveck *t;
+  const polyvecl *mat;
+  const polyvecl *v;
+  const poly *c;
+  const polyveck *u;
+} product_job;
+
+static void product_row(void *arg, unsigned int i)
+{
+  product_job *job = arg;
+  poly *t = &job->t->vec[i];
+  poly cu;
+
+  polyvecl_pointwise_acc_montgomery(t, &job->mat[i], job->v);
+  if(job->c) {
+    poly_pointwise_montgomery(&cu, job->c, &job->u->vec[i]);
+    poly_sub(t, t, &cu);
+  }
+  poly_reduce(t);
+  poly_invntt_tomont(t);
+}
+
+/*************************************************
+* Name:        matrix_product
+*
+* Description: Computes t = A*v - c*u row by row, reduces it and
+*              transforms it out of NTT domain; one row per team call if
+*              a team is set. All inputs in NTT domain.
+*
+* Arguments:   - polyveck *t:          pointer to output vector
+*              - const polyvecl mat[K]: matrix A
+*              - const polyvecl *v:    pointer to input vector
+*              - const poly *c:        pointer to challenge, or NULL for t = A*v
+*              - const polyveck *u:    pointer to vector multiplied by c
+**************************************************/
+static void matrix_product(polyveck *t,
+                           const polyvecl mat[K],
+                           const polyvecl *v,
+                           const poly *c,
+                           const polyveck *u)
+{
+  unsigned int i;
+  product_job job;
+
+  job.t = t;
+  job.mat = mat;
+  job.v = v;
+  job.c = c;
+  job.u = u;
+  if(!rows_parallel()) {
+    for(i = 0; i < K; ++i)
+      product_row(&job, i);
+    return;
+  }
+  row_team->run(row_team, product_row, &job, K);
+}
 
 /*************************************************
 * Name:        crypto_sign_keypair
@@ -52,7 +162,7 @@ int crypto_sign_keypair(uint8_t *pk, uint8_t *sk)
   key = rhoprime + CRHBYTES;
   //printf("[Step 2] Derived rho, rhoprime, key from SHAKE256(seedbuf).\n");
 
-  polyvec_matrix_expand(mat, rho); // expand matrix
+  matrix_expand(mat, rho); // expand matrix
   //printf("[Step 3] Matrix A expanded from rho.\n");
 
   // Sample short vectors s1 and s2 
@@ -64,9 +174,7 @@ int crypto_sign_keypair(uint8_t *pk, uint8_t *sk)
   //printf("[Step 5] Compute t = A*s1 + s2\n");
   s1hat = s1;
   polyvecl_ntt(&s1hat);
-  polyvec_matrix_pointwise_montgomery(&t1, mat, &s1hat);
-  polyveck_reduce(&t1);
-  polyveck_invntt_tomont(&t1);
+  matrix_product(&t1, mat, &s1hat, NULL, NULL);
   /* printf("[Step 5] Computed t = A*s1.\n"); 
   printf("[Step 5] t (first 8 coeffs of t1): "); // Print the initial values of t1
   for(int i=0;i<8;i++) printf("%08x ", t1.vec[0].coeffs[i]);
@@ -108,9 +216,36 @@ int crypto_sign_keypair(uint8_t *pk, uint8_t *sk)
 }
 
 /*************************************************
-* Name:        crypto_sign_signature_internal
+* Name:        crypto_sign_key_expand
 *
-* Description: Computes signature. Internal API.
+* Description: Unpacks secret key, expands matrix A and transforms the
+*              secret vectors that are multiplied by the challenge through
+*              the NTT (SPARSE_CS, SPARSE_CT0) to NTT domain, so that
+*              repeated signatures under the same key skip this work.
+*
+* Arguments:   - sign_ctx *sctx: pointer to output expanded key
+*              - uint8_t *sk:    pointer to bit-packed secret key
+**************************************************/
+void crypto_sign_key_expand(sign_ctx *sctx, const uint8_t *sk)
+{
+  uint8_t rho[SEEDBYTES];
+
+  unpack_sk(rho, sctx->tr, sctx->key, &sctx->t0, &sctx->s1, &sctx->s2, sk);
+
+  matrix_expand(sctx->mat, rho);
+#if !SPARSE_CS
+  polyvecl_ntt(&sctx->s1);
+  polyveck_ntt(&sctx->s2);
+#endif
+#if !SPARSE_CT0
+  polyveck_ntt(&sctx->t0);
+#endif
+}
+
+/*************************************************
+* Name:        crypto_sign_signature_ctx_internal
+*
+* Description: Computes signature with expanded secret key. Internal API.
 *
 * Arguments:   - uint8_t *sig:   pointer to output signature (of length CRYPTO_BYTES)
 *              - size_t *siglen: pointer to output length of signature
@@ -119,76 +254,180 @@ int crypto_sign_keypair(uint8_t *pk, uint8_t *sk)
 *              - uint8_t *pre:   pointer to prefix string
 *              - size_t prelen:  length of prefix string
 *              - uint8_t *rnd:   pointer to random seed
-*              - uint8_t *sk:    pointer to bit-packed secret key
+*              - sign_ctx *sctx: pointer to expanded secret key
 *
 * Returns 0 (success)
 **************************************************/
-
-int crypto_sign_signature_internal(uint8_t *sig,
-                                   size_t *siglen,
-                                   const uint8_t *m,
-                                   size_t mlen,
-                                   const uint8_t *pre,
-                                   size_t prelen,
-                                   const uint8_t rnd[RNDBYTES],
-                                   const uint8_t *sk) 
+int crypto_sign_signature_ctx_internal(uint8_t *sig,
+                                       size_t *siglen,
+                                       const uint8_t *m,
+                                       size_t mlen,
+                                       const uint8_t *pre,
+                                       size_t prelen,
+                                       const uint8_t rnd[RNDBYTES],
+                                       const sign_ctx *sctx)
 {
-  unsigned int n;
-  uint8_t seedbuf[2*SEEDBYTES + TRBYTES + 2*CRHBYTES];
-  uint8_t *rho, *tr, *key, *mu, *rhoprime;
-  uint16_t nonce = 0;
-  polyvecl mat[K], s1, y, z;
-  polyveck t0, s2, w1, w0, h;
-  poly cp;
-  keccak_state state;
+  uint8_t mu[CRHBYTES];
 
   //printf("\n====== SIGNING STAGE ======\n\n");
-  // Step 1: Unpack secret key
-  //printf("[Step 1] Unpack secret key (unpack_sk)\n");
-  rho = seedbuf;
-  tr = rho + SEEDBYTES;
-  key = tr + TRBYTES;
-  mu = key + SEEDBYTES;
-  rhoprime = mu + CRHBYTES;
-  unpack_sk(rho, tr, key, &t0, &s1, &s2, sk);
+  // Step 1: Secret key already unpacked into sctx
 
   // Step 2: Hash tr, pre, m to get mu
   //printf("[Step 2] Hash tr, pre, m to get mu (SHAKE256)\n");
+  crypto_sign_mu_internal(mu, m, mlen, pre, prelen, sctx);
+
+  return crypto_sign_signature_mu_internal(sig, siglen, mu, rnd, sctx);
+}
+
+/*************************************************
+* Name:        crypto_sign_mu_internal
+*
+* Description: Computes the message representative mu = CRH(tr, pre, m)
+*              from an expanded secret key. Internal API.
+*
+* Arguments:   - uint8_t *mu:    output mu (of length CRHBYTES)
+*              - uint8_t *m:     pointer to message
+*              - size_t mlen:    length of message
+*              - uint8_t *pre:   pointer to prefix string
+*              - size_t prelen:  length of prefix string
+*              - sign_ctx *sctx: pointer to expanded secret key
+**************************************************/
+void crypto_sign_mu_internal(uint8_t mu[CRHBYTES],
+                             const uint8_t *m,
+                             size_t mlen,
+                             const uint8_t *pre,
+                             size_t prelen,
+                             const sign_ctx *sctx)
+{
+  keccak_state state;
+
   shake256_init(&state);
-  shake256_absorb(&state, tr, TRBYTES);
+  shake256_absorb(&state, sctx->tr, TRBYTES);
   shake256_absorb(&state, pre, prelen);
   shake256_absorb(&state, m, mlen);
   shake256_finalize(&state);
   shake256_squeeze(mu, CRHBYTES, &state);
+}
 
-  // Step 3: Hash key, rnd, mu to get rhoprime
-  //printf("[Step 3] Hash key, rnd, mu to get rhoprime (SHAKE256)\n");
-  shake256_init(&state);
-  shake256_absorb(&state, key, SEEDBYTES);
-  shake256_absorb(&state, rnd, RNDBYTES);
-  shake256_absorb(&state, mu, CRHBYTES);
-  shake256_finalize(&state);
-  shake256_squeeze(rhoprime, CRHBYTES, &state);
+/* Challenge c in the forms its products with the secret vectors take:
+ * sparse (SPARSE_CS, SPARSE_CT0 in config.h) or NTT domain */
+typedef struct {
+  poly ntt;
+  poly_sparse sparse;
+} challenge;
 
-  // Auxiliary: Expand matrix and transform vectors
-  polyvec_matrix_expand(mat, rho);
-  polyvecl_ntt(&s1);
-  polyveck_ntt(&s2);
-  polyveck_ntt(&t0);
+/*************************************************
+* Name:        challenge_expand
+*
+* Description: Samples the challenge from c_tilde and prepares it for
+*              challenge_mul_cs and challenge_mul_ct0.
+*
+* Arguments:   - challenge *c:  pointer to output challenge
+*              - uint8_t *seed: pointer to c_tilde
+**************************************************/
+static void challenge_expand(challenge *c, const uint8_t seed[CTILDEBYTES])
+{
+  poly_challenge(&c->ntt, seed);
+#if SPARSE_CS || SPARSE_CT0
+  poly_challenge_sparse(&c->sparse, &c->ntt);
+#endif
+#if !SPARSE_CS || !SPARSE_CT0
+  poly_ntt(&c->ntt);
+#endif
+}
 
-rej:
+/*************************************************
+* Name:        challenge_mul_cs
+*
+* Description: Computes c*s1 and c*s2 of the expanded key, in normal
+*              domain and not reduced.
+*
+* Arguments:   - polyvecl *cs1:     pointer to output c*s1, or NULL
+*              - polyveck *cs2:     pointer to output c*s2, or NULL
+*              - challenge *c:      pointer to challenge
+*              - sign_ctx *sctx:    pointer to expanded secret key
+**************************************************/
+static void challenge_mul_cs(polyvecl *cs1,
+                             polyveck *cs2,
+                             const challenge *c,
+                             const sign_ctx *sctx)
+{
+#if SPARSE_CS
+  if(cs1)
+    polyvecl_sparse_mul_eta(cs1, &c->sparse, &sctx->s1);
+  if(cs2)
+    polyveck_sparse_mul_eta(cs2, &c->sparse, &sctx->s2);
+#else
+  if(cs1) {
+    polyvecl_pointwise_poly_montgomery(cs1, &c->ntt, &sctx->s1);
+    polyvecl_invntt_tomont(cs1);
+  }
+  if(cs2) {
+    polyveck_pointwise_poly_montgomery(cs2, &c->ntt, &sctx->s2);
+    polyveck_invntt_tomont(cs2);
+  }
+#endif
+}
+
+/*************************************************
+* Name:        challenge_mul_ct0
+*
+* Description: Computes c*t0 of the expanded key, in normal domain and not
+*              reduced.
+*
+* Arguments:   - polyveck *ct0:     pointer to output c*t0
+*              - challenge *c:      pointer to challenge
+*              - sign_ctx *sctx:    pointer to expanded secret key
+**************************************************/
+static void challenge_mul_ct0(polyveck *ct0,
+                              const challenge *c,
+                              const sign_ctx *sctx)
+{
+#if SPARSE_CT0
+  polyveck_sparse_mul(ct0, &c->sparse, &sctx->t0);
+#else
+  polyveck_pointwise_poly_montgomery(ct0, &c->ntt, &sctx->t0);
+  polyveck_invntt_tomont(ct0);
+#endif
+}
+
+/*************************************************
+* Name:        sign_attempt
+*
+* Description: One pass of the rejection loop: samples y for the given
+*              nonce, computes w, the challenge and the response and checks
+*              them. Attempts with different nonces are independent.
+*
+* Arguments:   - uint8_t *sig:      pointer to output signature, complete only
+*                                   if the attempt is accepted
+*              - uint8_t *mu:       pointer to message representative
+*              - uint8_t *rhoprime: pointer to seed for y
+*              - uint16_t nonce:    attempt number
+*              - sign_ctx *sctx:    pointer to expanded secret key
+*
+* Returns 0 (accepted) or -1 (rejected)
+**************************************************/
+static int sign_attempt(uint8_t *sig,
+                        const uint8_t mu[CRHBYTES],
+                        const uint8_t rhoprime[CRHBYTES],
+                        uint16_t nonce,
+                        const sign_ctx *sctx)
+{
+  unsigned int n;
+  polyvecl y, z;
+  polyveck w1, w0, h;
+  challenge cp;
+  keccak_state state;
 
   // Step 4: Sample vector y (rejection sampling loop)
   //printf("[Step 4] Create sample vector y (start rejection sampling loop)\n");
-  polyvecl_uniform_gamma1(&y, rhoprime, nonce++);
+  polyvecl_uniform_gamma1(&y, rhoprime, nonce);
 
   // Step 5: Compute w1 and w0 from matrix A and vector y
   //printf("[Step 5] Compute w1 and w0 from matrix A and vector y\n");
   z = y;
   polyvecl_ntt(&z);
-  polyvec_matrix_pointwise_montgomery(&w1, mat, &z);
-  polyveck_reduce(&w1);
-  polyveck_invntt_tomont(&w1);
+  matrix_product(&w1, sctx->mat, &z, NULL, NULL);
 
   polyveck_caddq(&w1); 
   polyveck_decompose(&w1, &w0, &w1);
@@ -201,41 +440,37 @@ rej:
   shake256_absorb(&state, sig, K*POLYW1_PACKEDBYTES);
   shake256_finalize(&state);
   shake256_squeeze(sig, CTILDEBYTES, &state);
-  poly_challenge(&cp, sig);
-  poly_ntt(&cp);
+  challenge_expand(&cp, sig);
 
   // Step 7: Compute z = y + c*s1
   //printf("[Step 7] Compute z = y + c*s1\n");
-  polyvecl_pointwise_poly_montgomery(&z, &cp, &s1);
-  polyvecl_invntt_tomont(&z);
+  challenge_mul_cs(&z, NULL, &cp, sctx);
   polyvecl_add(&z, &z, &y);
   polyvecl_reduce(&z);
 
   //printf("[Step 8] Check norm(z)\n");
   if(polyvecl_chknorm(&z, GAMMA1 - BETA)) {
     //printf("[Step 8] z rejected, retrying...\n");
-    goto rej;
+    return -1;
   }
 
   // Step 9: Compute and check w0' = w0 - c*s2
   //printf("[Step 9] Compute and check w0' = w0 - c*s2\n");
-  polyveck_pointwise_poly_montgomery(&h, &cp, &s2);
-  polyveck_invntt_tomont(&h);
+  challenge_mul_cs(NULL, &h, &cp, sctx);
   polyveck_sub(&w0, &w0, &h);
   polyveck_reduce(&w0);
   if(polyveck_chknorm(&w0, GAMMA2 - BETA)) {
     //printf("[Step 9] w0' rejected, retrying...\n");
-    goto rej;
+    return -1;
   }
 
   // Step 10: Compute hints for w1
   //printf("[Step 10] Compute hints for w1\n");
-  polyveck_pointwise_poly_montgomery(&h, &cp, &t0);
-  polyveck_invntt_tomont(&h);
+  challenge_mul_ct0(&h, &cp, sctx);
   polyveck_reduce(&h);
   if(polyveck_chknorm(&h, GAMMA2)) {
     //printf("[Step 10] hint rejected, retrying...\n");
-    goto rej;
+    return -1;
   }
 
   //printf("[Step 11] Check hints for w0 and w1\n");
@@ -243,225 +478,1506 @@ rej:
   n = polyveck_make_hint(&h, &w0, &w1);
   if(n > OMEGA) {
     //printf("[Step 11] Too many hints, retrying...\n");
-    goto rej;
+    return -1;
   }
 
   // Step 12: Pack signature
   //printf("[Step 12] Pack signature (pack_sig)\n");
   pack_sig(sig, sig, &z, &h);
-  *siglen = CRYPTO_BYTES;
-
   return 0;
 }
 
+/* rhoprime = CRH(key, rnd, mu) */
+static void sign_rhoprime(uint8_t rhoprime[CRHBYTES],
+                          const uint8_t mu[CRHBYTES],
+                          const uint8_t rnd[RNDBYTES],
+                          const sign_ctx *sctx)
+{
+  keccak_state state;
+
+  shake256_init(&state);
+  shake256_absorb(&state, sctx->key, SEEDBYTES);
+  shake256_absorb(&state, rnd, RNDBYTES);
+  shake256_absorb(&state, mu, CRHBYTES);
+  shake256_finalize(&state);
+  shake256_squeeze(rhoprime, CRHBYTES, &state);
+}
+
 /*************************************************
-* Name:        crypto_sign_signature
+* Name:        crypto_sign_signature_mu_internal
 *
-* Description: Computes signature.
+* Description: Computes signature over a precomputed message
+*              representative mu = CRH(tr, pre, m). Internal API.
 *
 * Arguments:   - uint8_t *sig:   pointer to output signature (of length CRYPTO_BYTES)
 *              - size_t *siglen: pointer to output length of signature
-*              - uint8_t *m:     pointer to message to be signed
-*              - size_t mlen:    length of message
-*              - uint8_t *ctx:   pointer to contex string
-*              - size_t ctxlen:  length of contex string
-*              - uint8_t *sk:    pointer to bit-packed secret key
+*              - uint8_t *mu:    pointer to message representative
+*              - uint8_t *rnd:   pointer to random seed
+*              - sign_ctx *sctx: pointer to expanded secret key
 *
-* Returns 0 (success) or -1 (context string too long)
+* Returns 0 (success)
 **************************************************/
-int crypto_sign_signature(uint8_t *sig,
-                          size_t *siglen,
-                          const uint8_t *m,
-                          size_t mlen,
-                          const uint8_t *ctx,
-                          size_t ctxlen,
-                          const uint8_t *sk) 
+int crypto_sign_signature_mu_internal(uint8_t *sig,
+                                      size_t *siglen,
+                                      const uint8_t mu[CRHBYTES],
+                                      const uint8_t rnd[RNDBYTES],
+                                      const sign_ctx *sctx)
 {
-  struct timespec start, end;
-  clock_gettime(CLOCK_MONOTONIC, &start);
-
-  size_t i;
-  uint8_t pre[257];
-  uint8_t rnd[RNDBYTES];
+  uint8_t rhoprime[CRHBYTES];
+  uint16_t nonce = 0;
 
-  if(ctxlen > 255)
-    return -1;
+  // Step 3: Hash key, rnd, mu to get rhoprime
+  //printf("[Step 3] Hash key, rnd, mu to get rhoprime (SHAKE256)\n");
+  sign_rhoprime(rhoprime, mu, rnd, sctx);
 
-  /* Prepare pre = (0, ctxlen, ctx) */
-  pre[0] = 0;
-  pre[1] = ctxlen;
-  for(i = 0; i < ctxlen; i++)
-    pre[2 + i] = ctx[i];
+  // Steps 4-12 until an attempt is accepted
+  while(sign_attempt(sig, mu, rhoprime, nonce++, sctx))
+    ;
+  *siglen = CRYPTO_BYTES;
 
-  #ifdef DILITHIUM_RANDOMIZED_SIGNING
-    randombytes(rnd, RNDBYTES);
-  #else
-    for(i=0;i<RNDBYTES;i++)
-      rnd[i] = 0;
-  #endif
+  return 0;
+}
 
-  crypto_sign_signature_internal(sig,siglen,m,mlen,pre,2+ctxlen,rnd,sk);
-  //printf("[Done] Signature generated successfully!\n");
+/* One round of speculative signing: candidates nonce .. nonce + width - 1 */
+typedef struct {
+  uint8_t sig[SIGN_SPEC_MAX_WIDTH][CRYPTO_BYTES];
+  unsigned int first; // lowest accepted candidate so far, width if none
+  uint16_t nonce;
+  const uint8_t *mu;
+  const uint8_t *rhoprime;
+  const sign_ctx *sctx;
+} spec_round;
+
+static void spec_candidate(void *arg, unsigned int i)
+{
+  spec_round *r = arg;
+  unsigned int first;
+
+  // A candidate behind an accepted one can no longer be the result
+  if(i > __atomic_load_n(&r->first, __ATOMIC_ACQUIRE))
+    return;
+  if(sign_attempt(r->sig[i], r->mu, r->rhoprime, r->nonce + i, r->sctx))
+    return;
+  first = __atomic_load_n(&r->first, __ATOMIC_RELAXED);
+  while(i < first && !__atomic_compare_exchange_n(&r->first, &first, i, 0,
+                                                  __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    ;
+}
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
-  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
-  g_time.sign += t;
+/*************************************************
+* Name:        crypto_sign_signature_mu_spec
+*
+* Description: Like crypto_sign_signature_mu_internal, but evaluates the
+*              attempts for up to SIGN_SPEC_MAX_WIDTH nonces at once on a
+*              thread team and keeps the first accepted one in nonce
+*              order, so the signature is the same as the sequential one.
+*              Without a team (NULL or width 1) it signs sequentially.
+*
+* Arguments:   - uint8_t *sig:         pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen:       pointer to output length of signature
+*              - uint8_t *mu:          pointer to message representative
+*              - uint8_t *rnd:         pointer to random seed
+*              - sign_ctx *sctx:       pointer to expanded secret key
+*              - const sign_team *team: thread team to spread the attempts over
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_sign_signature_mu_spec(uint8_t *sig,
+                                  size_t *siglen,
+                                  const uint8_t mu[CRHBYTES],
+                                  const uint8_t rnd[RNDBYTES],
+                                  const sign_ctx *sctx,
+                                  const sign_team *team)
+{
+  uint8_t rhoprime[CRHBYTES];
+  unsigned int width;
+  spec_round r;
+  const sign_team *rows;
+
+  if(!team || team->width < 2)
+    return crypto_sign_signature_mu_internal(sig, siglen, mu, rnd, sctx);
+
+  // The attempts run whole on the team members, not split by rows
+  rows = row_team;
+  row_team = NULL;
+
+  width = team->width < SIGN_SPEC_MAX_WIDTH ? team->width : SIGN_SPEC_MAX_WIDTH;
+  sign_rhoprime(rhoprime, mu, rnd, sctx);
+  r.nonce = 0;
+  r.mu = mu;
+  r.rhoprime = rhoprime;
+  r.sctx = sctx;
+  for(;;) {
+    r.first = width;
+    team->run(team, spec_candidate, &r, width);
+    if(r.first < width)
+      break;
+    r.nonce += width;
+  }
+  row_team = rows;
 
+  memcpy(sig, r.sig[r.first], CRYPTO_BYTES);
+  *siglen = CRYPTO_BYTES;
   return 0;
 }
 
+/* memset that the compiler may not drop as a dead store */
+static void wipe(void *p, size_t len)
+{
+  memset(p, 0, len);
+  __asm__ __volatile__("" : : "r"(p) : "memory");
+}
+
 /*************************************************
-* Name:        crypto_sign_verify_internal
-*
-* Description: Verifies signature. Internal API.
+* Name:        crypto_sign_commit
 *
-* Arguments:   - uint8_t *m: pointer to input signature
-*              - size_t siglen: length of signature
-*              - const uint8_t *m: pointer to message
-*              - size_t mlen: length of message
-*              - const uint8_t *pre: pointer to prefix string
-*              - size_t prelen: length of prefix string
-*              - const uint8_t *pk: pointer to bit-packed public key
+* Description: Offline half of offline/online signing (not FIPS 204, see
+*              sign.h): samples a mask y from fresh randomness and the key
+*              and computes the decomposed commitment w = A*y.
 *
-* Returns 0 if signature could be verified correctly and -1 otherwise
+* Arguments:   - sign_commitment *cm: pointer to output commitment
+*              - sign_ctx *sctx:      pointer to expanded secret key
 **************************************************/
-int crypto_sign_verify_internal(const uint8_t *sig,
-                                size_t siglen,
-                                const uint8_t *m,
-                                size_t mlen,
-                                const uint8_t *pre,
-                                size_t prelen,
-                                const uint8_t *pk)
+void crypto_sign_commit(sign_commitment *cm, const sign_ctx *sctx)
 {
-  unsigned int i;
-  uint8_t buf[K*POLYW1_PACKEDBYTES];
-  uint8_t rho[SEEDBYTES];
-  uint8_t mu[CRHBYTES];
-  uint8_t c[CTILDEBYTES];
-  uint8_t c2[CTILDEBYTES];
-  poly cp;
-  polyvecl mat[K], z;
-  polyveck t1, w1, h;
+  uint8_t rnd[RNDBYTES];
+  uint8_t rhoprime[CRHBYTES];
+  polyvecl yhat;
   keccak_state state;
 
-  //printf("\n====== VERIFYING STAGE ======\n\n");
-  // Auxiliary: Check signature length
-  //printf("Check signature length\n");
-  if(siglen != CRYPTO_BYTES) {
-    //printf("Invalid signature length!\n");
-    return -1;
-  }
+  // rhoprime = H(key, rnd): mu is not known yet
+  randombytes(rnd, RNDBYTES);
+  shake256_init(&state);
+  shake256_absorb(&state, sctx->key, SEEDBYTES);
+  shake256_absorb(&state, rnd, RNDBYTES);
+  shake256_finalize(&state);
+  shake256_squeeze(rhoprime, CRHBYTES, &state);
+  polyvecl_uniform_gamma1(&cm->y, rhoprime, 0);
+  wipe(rnd, sizeof(rnd));
+  wipe(rhoprime, sizeof(rhoprime));
+
+  yhat = cm->y;
+  polyvecl_ntt(&yhat);
+  matrix_product(&cm->w1, sctx->mat, &yhat, NULL, NULL);
+
+  polyveck_caddq(&cm->w1);
+  polyveck_decompose(&cm->w1, &cm->w0, &cm->w1);
+  polyveck_pack_w1(cm->w1_packed, &cm->w1);
+  wipe(&yhat, sizeof(yhat));
+  cm->ready = 1;
+}
 
-  // Step 1: Unpack pk and sig 
-  //printf("[Step 1] Unpack pk and sig (unpack_pk, unpack_sig)\n");
-  unpack_pk(rho, &t1, pk);
-  if(unpack_sig(c, &z, &h, sig)) {
-    //printf("[Step 1] unpack_sig failed!\n");
-    return -1;
-  }
+/*************************************************
+* Name:        crypto_sign_signature_commit
+*
+* Description: Online half of offline/online signing: one signing attempt
+*              over mu with a commitment from crypto_sign_commit. The
+*              commitment is wiped in any case; one that is not ready is
+*              refused without writing a signature.
+*
+* Arguments:   - uint8_t *sig:        pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen:      pointer to output length of signature
+*              - uint8_t *mu:         pointer to message representative
+*              - sign_commitment *cm: pointer to commitment, used up
+*              - sign_ctx *sctx:      pointer to expanded secret key
+*
+* Returns 0 (success) or -1 (attempt rejected or commitment not ready;
+* retry with a new commitment)
+**************************************************/
+int crypto_sign_signature_commit(uint8_t *sig,
+                                 size_t *siglen,
+                                 const uint8_t mu[CRHBYTES],
+                                 sign_commitment *cm,
+                                 const sign_ctx *sctx)
+{
+  unsigned int n;
+  polyvecl z;
+  polyveck w0, h;
+  challenge cp;
+  keccak_state state;
 
-  // Step 2: Check z 
-  //printf("[Step 2] Check z (polyvecl_chknorm)\n");
-  if(polyvecl_chknorm(&z, GAMMA1 - BETA)) {
-    //printf("[Step 2] z out of bounds!\n");
+  // Never sign twice with the same y
+  if(!cm->ready)
     return -1;
-  }
-
-  // Step 3: Reconstruct matrix A
-  //printf("[Step 3] Reconstruct matrix A\n");
-  poly_challenge(&cp, c);
-  polyvec_matrix_expand(mat, rho);
+  cm->ready = 0;
 
-  // Step 4: Reconstruct mu = CRH(H(rho, t1), pre, msg)
-  //printf("[Step 4] Reconstruct mu = CRH(H(rho, t1), pre, msg)\n");
-  shake256(mu, TRBYTES, pk, CRYPTO_PUBLICKEYBYTES);
+  // Steps 6-12 of crypto_sign_signature_mu_internal with y, w0, w1 given
   shake256_init(&state);
-  shake256_absorb(&state, mu, TRBYTES);
-  shake256_absorb(&state, pre, prelen);
-  shake256_absorb(&state, m, mlen);
+  shake256_absorb(&state, mu, CRHBYTES);
+  shake256_absorb(&state, cm->w1_packed, K*POLYW1_PACKEDBYTES);
   shake256_finalize(&state);
-  shake256_squeeze(mu, CRHBYTES, &state);
+  shake256_squeeze(sig, CTILDEBYTES, &state);
+  challenge_expand(&cp, sig);
+
+  challenge_mul_cs(&z, NULL, &cp, sctx);
+  polyvecl_add(&z, &z, &cm->y);
+  polyvecl_reduce(&z);
+  if(polyvecl_chknorm(&z, GAMMA1 - BETA))
+    goto rej;
+
+  challenge_mul_cs(NULL, &h, &cp, sctx);
+  polyveck_sub(&w0, &cm->w0, &h);
+  polyveck_reduce(&w0);
+  if(polyveck_chknorm(&w0, GAMMA2 - BETA))
+    goto rej;
+
+  challenge_mul_ct0(&h, &cp, sctx);
+  polyveck_reduce(&h);
+  if(polyveck_chknorm(&h, GAMMA2))
+    goto rej;
+
+  polyveck_add(&w0, &w0, &h);
+  n = polyveck_make_hint(&h, &w0, &cm->w1);
+  if(n > OMEGA)
+    goto rej;
+
+  pack_sig(sig, sig, &z, &h);
+  *siglen = CRYPTO_BYTES;
+  wipe(cm, sizeof(*cm));
+  return 0;
+
+rej:
+  wipe(sig, CTILDEBYTES);
+  wipe(cm, sizeof(*cm));
+  return -1;
+}
+
+/*************************************************
+* Name:        crypto_sign_signature_internal
+*
+* Description: Computes signature. Internal API.
+*
+* Arguments:   - uint8_t *sig:   pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen: pointer to output length of signature
+*              - uint8_t *m:     pointer to message to be signed
+*              - size_t mlen:    length of message
+*              - uint8_t *pre:   pointer to prefix string
+*              - size_t prelen:  length of prefix string
+*              - uint8_t *rnd:   pointer to random seed
+*              - uint8_t *sk:    pointer to bit-packed secret key
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_sign_signature_internal(uint8_t *sig,
+                                   size_t *siglen,
+                                   const uint8_t *m,
+                                   size_t mlen,
+                                   const uint8_t *pre,
+                                   size_t prelen,
+                                   const uint8_t rnd[RNDBYTES],
+                                   const uint8_t *sk)
+{
+  sign_ctx sctx;
+
+  //printf("[Step 1] Unpack secret key (unpack_sk)\n");
+  crypto_sign_key_expand(&sctx, sk);
+  return crypto_sign_signature_ctx_internal(sig, siglen, m, mlen, pre, prelen, rnd, &sctx);
+}
+
+/*************************************************
+* Name:        build_prefix
+*
+* Description: Writes pre = (domain, ctxlen, ctx). ctx may be NULL when
+*              ctxlen is 0.
+*
+* Arguments:   - uint8_t *pre:   pointer to output prefix (of length 2 + ctxlen)
+*              - uint8_t domain: 0 for ML-DSA, 1 for HashML-DSA
+*              - uint8_t *ctx:   pointer to context string
+*              - size_t ctxlen:  length of context string, at most 255
+*
+* Returns length of the prefix
+**************************************************/
+static size_t build_prefix(uint8_t *pre,
+                           uint8_t domain,
+                           const uint8_t *ctx,
+                           size_t ctxlen)
+{
+  pre[0] = domain;
+  pre[1] = ctxlen;
+  if(ctxlen)
+    memcpy(&pre[2], ctx, ctxlen);
+  return 2 + ctxlen;
+}
+
+/*************************************************
+* Name:        crypto_sign_signature
+*
+* Description: Computes signature.
+*
+* Arguments:   - uint8_t *sig:   pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen: pointer to output length of signature
+*              - uint8_t *m:     pointer to message to be signed
+*              - size_t mlen:    length of message
+*              - uint8_t *ctx:   pointer to contex string
+*              - size_t ctxlen:  length of contex string
+*              - uint8_t *sk:    pointer to bit-packed secret key
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_signature(uint8_t *sig,
+                          size_t *siglen,
+                          const uint8_t *m,
+                          size_t mlen,
+                          const uint8_t *ctx,
+                          size_t ctxlen,
+                          const uint8_t *sk) 
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint8_t pre[257];
+  uint8_t rnd[RNDBYTES];
+
+  if(ctxlen > 255)
+    return -1;
+
+  /* Prepare pre = (0, ctxlen, ctx) */
+  build_prefix(pre, 0, ctx, ctxlen);
+
+  #ifdef DILITHIUM_RANDOMIZED_SIGNING
+    randombytes(rnd, RNDBYTES);
+  #else
+    memset(rnd, 0, RNDBYTES);
+  #endif
+
+  crypto_sign_signature_internal(sig,siglen,m,mlen,pre,2+ctxlen,rnd,sk);
+  //printf("[Done] Signature generated successfully!\n");
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.sign += t;
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_signature_ctx
+*
+* Description: Computes signature with expanded secret key.
+*
+* Arguments:   - uint8_t *sig:   pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen: pointer to output length of signature
+*              - uint8_t *m:     pointer to message to be signed
+*              - size_t mlen:    length of message
+*              - uint8_t *ctx:   pointer to contex string
+*              - size_t ctxlen:  length of contex string
+*              - sign_ctx *sctx: pointer to expanded secret key
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_signature_ctx(uint8_t *sig,
+                              size_t *siglen,
+                              const uint8_t *m,
+                              size_t mlen,
+                              const uint8_t *ctx,
+                              size_t ctxlen,
+                              const sign_ctx *sctx)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint8_t pre[257];
+  uint8_t rnd[RNDBYTES];
+
+  if(ctxlen > 255)
+    return -1;
+
+  /* Prepare pre = (0, ctxlen, ctx) */
+  build_prefix(pre, 0, ctx, ctxlen);
+
+  #ifdef DILITHIUM_RANDOMIZED_SIGNING
+    randombytes(rnd, RNDBYTES);
+  #else
+    memset(rnd, 0, RNDBYTES);
+  #endif
+
+  crypto_sign_signature_ctx_internal(sig,siglen,m,mlen,pre,2+ctxlen,rnd,sctx);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.sign += t;
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_init
+*
+* Description: Starts a streaming signature. The message is absorbed
+*              incrementally with crypto_sign_update, so memory use does
+*              not depend on the message length.
+*
+* Arguments:   - sign_stream *st: pointer to stream state
+*              - uint8_t *ctx:    pointer to contex string
+*              - size_t ctxlen:   length of contex string
+*              - uint8_t *sk:     pointer to bit-packed secret key
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_init(sign_stream *st,
+                     const uint8_t *ctx,
+                     size_t ctxlen,
+                     const uint8_t *sk)
+{
+  uint8_t pre[257];
+
+  if(ctxlen > 255)
+    return -1;
+
+  build_prefix(pre, 0, ctx, ctxlen);
+
+  /* tr follows rho and key in the packed secret key */
+  shake256_init(&st->state);
+  shake256_absorb(&st->state, sk + 2*SEEDBYTES, TRBYTES);
+  shake256_absorb(&st->state, pre, 2+ctxlen);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_update
+*
+* Description: Absorbs the next part of the message to be signed.
+*
+* Arguments:   - sign_stream *st: pointer to stream state
+*              - uint8_t *m:      pointer to message part
+*              - size_t mlen:     length of message part
+**************************************************/
+void crypto_sign_update(sign_stream *st, const uint8_t *m, size_t mlen)
+{
+  shake256_absorb(&st->state, m, mlen);
+}
+
+/*************************************************
+* Name:        crypto_sign_final
+*
+* Description: Computes signature over all absorbed message parts.
+*
+* Arguments:   - sign_stream *st: pointer to stream state
+*              - uint8_t *sig:    pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen:  pointer to output length of signature
+*              - uint8_t *sk:     pointer to bit-packed secret key
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_sign_final(sign_stream *st,
+                      uint8_t *sig,
+                      size_t *siglen,
+                      const uint8_t *sk)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint8_t mu[CRHBYTES];
+  uint8_t rnd[RNDBYTES];
+  sign_ctx sctx;
+
+  shake256_finalize(&st->state);
+  shake256_squeeze(mu, CRHBYTES, &st->state);
+
+  #ifdef DILITHIUM_RANDOMIZED_SIGNING
+    randombytes(rnd, RNDBYTES);
+  #else
+    memset(rnd, 0, RNDBYTES);
+  #endif
+
+  crypto_sign_key_expand(&sctx, sk);
+  crypto_sign_signature_mu_internal(sig, siglen, mu, rnd, &sctx);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.sign += t;
+
+  return 0;
+}
+
+/* DER-encoded OIDs of the HashML-DSA pre-hash functions, indexed by
+ * DILITHIUM_PH_* (FIPS 204, Section 5.4) */
+static const uint8_t prehash_oid[4][PREHASH_OIDBYTES] = {
+  {0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x08},
+  {0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x0A},
+  {0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x0B},
+  {0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x0C}
+};
+static const size_t prehash_bytes[4] = {32, 64, 32, 64};
+
+/*************************************************
+* Name:        prehash_pre
+*
+* Description: Prepares the HashML-DSA prefix pre = (1, ctxlen, ctx, OID).
+*              The digest itself is passed as message to the internal API.
+*
+* Arguments:   - uint8_t *pre:   output prefix of at least 257+PREHASH_OIDBYTES bytes
+*              - uint8_t *ctx:   pointer to contex string
+*              - size_t ctxlen:  length of contex string
+*              - int phalg:      pre-hash function (DILITHIUM_PH_*)
+*              - size_t phlen:   length of digest
+*
+* Returns length of prefix or -1 (bad context, pre-hash or digest length)
+**************************************************/
+static int prehash_pre(uint8_t *pre,
+                       const uint8_t *ctx,
+                       size_t ctxlen,
+                       int phalg,
+                       size_t phlen)
+{
+  if(ctxlen > 255 || phalg < 0 || phalg > 3 || phlen != prehash_bytes[phalg])
+    return -1;
+
+  build_prefix(pre, 1, ctx, ctxlen);
+  memcpy(&pre[2 + ctxlen], prehash_oid[phalg], PREHASH_OIDBYTES);
+
+  return 2 + ctxlen + PREHASH_OIDBYTES;
+}
+
+/*************************************************
+* Name:        crypto_sign_prehash
+*
+* Description: Computes the HashML-DSA message digest PH(m).
+*
+* Arguments:   - uint8_t *ph:    output digest (of length DILITHIUM_PH_MAXBYTES)
+*              - uint8_t *m:     pointer to message
+*              - size_t mlen:    length of message
+*              - int phalg:      pre-hash function (DILITHIUM_PH_*)
+*
+* Returns length of digest or -1 (unknown pre-hash function)
+**************************************************/
+int crypto_sign_prehash(uint8_t ph[DILITHIUM_PH_MAXBYTES],
+                        const uint8_t *m,
+                        size_t mlen,
+                        int phalg)
+{
+  switch(phalg) {
+    case DILITHIUM_PH_SHA3_256:
+      sha3_256(ph, m, mlen);
+      break;
+    case DILITHIUM_PH_SHA3_512:
+      sha3_512(ph, m, mlen);
+      break;
+    case DILITHIUM_PH_SHAKE128:
+      shake128(ph, 32, m, mlen);
+      break;
+    case DILITHIUM_PH_SHAKE256:
+      shake256(ph, 64, m, mlen);
+      break;
+    default:
+      return -1;
+  }
+
+  return prehash_bytes[phalg];
+}
+
+/*************************************************
+* Name:        crypto_sign_mu
+*
+* Description: Computes the message representative mu = CRH(tr, pre, m)
+*              for the external-mu API, e.g. on a node that only holds pk.
+*
+* Arguments:   - uint8_t *mu:    output mu (of length CRHBYTES)
+*              - uint8_t *m:     pointer to message
+*              - size_t mlen:    length of message
+*              - uint8_t *ctx:   pointer to contex string
+*              - size_t ctxlen:  length of contex string
+*              - uint8_t *pk:    pointer to bit-packed public key
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_mu(uint8_t mu[CRHBYTES],
+                   const uint8_t *m,
+                   size_t mlen,
+                   const uint8_t *ctx,
+                   size_t ctxlen,
+                   const uint8_t *pk)
+{
+  verify_stream st;
+
+  if(crypto_verify_init(&st, ctx, ctxlen, pk))
+    return -1;
+  crypto_verify_update(&st, m, mlen);
+  shake256_finalize(&st.state);
+  shake256_squeeze(mu, CRHBYTES, &st.state);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_signature_prehash
+*
+* Description: Computes HashML-DSA signature over a message digest.
+*
+* Arguments:   - uint8_t *sig:   pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen: pointer to output length of signature
+*              - uint8_t *ph:    pointer to digest PH(m)
+*              - size_t phlen:   length of digest
+*              - uint8_t *ctx:   pointer to contex string
+*              - size_t ctxlen:  length of contex string
+*              - int phalg:      pre-hash function (DILITHIUM_PH_*)
+*              - uint8_t *sk:    pointer to bit-packed secret key
+*
+* Returns 0 (success) or -1 (bad context, pre-hash or digest length)
+**************************************************/
+int crypto_sign_signature_prehash(uint8_t *sig,
+                                  size_t *siglen,
+                                  const uint8_t *ph,
+                                  size_t phlen,
+                                  const uint8_t *ctx,
+                                  size_t ctxlen,
+                                  int phalg,
+                                  const uint8_t *sk)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  int prelen;
+  uint8_t pre[257 + PREHASH_OIDBYTES];
+  uint8_t rnd[RNDBYTES];
+
+  prelen = prehash_pre(pre, ctx, ctxlen, phalg, phlen);
+  if(prelen < 0)
+    return -1;
+
+  #ifdef DILITHIUM_RANDOMIZED_SIGNING
+    randombytes(rnd, RNDBYTES);
+  #else
+    memset(rnd, 0, RNDBYTES);
+  #endif
+
+  crypto_sign_signature_internal(sig, siglen, ph, phlen, pre, prelen, rnd, sk);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.sign += t;
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_signature_extmu
+*
+* Description: Computes signature over an externally supplied message
+*              representative mu (see crypto_sign_mu).
+*
+* Arguments:   - uint8_t *sig:   pointer to output signature (of length CRYPTO_BYTES)
+*              - size_t *siglen: pointer to output length of signature
+*              - uint8_t *mu:    pointer to message representative
+*              - uint8_t *sk:    pointer to bit-packed secret key
+*
+* Returns 0 (success)
+**************************************************/
+int crypto_sign_signature_extmu(uint8_t *sig,
+                                size_t *siglen,
+                                const uint8_t mu[CRHBYTES],
+                                const uint8_t *sk)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint8_t rnd[RNDBYTES];
+  sign_ctx sctx;
+
+  #ifdef DILITHIUM_RANDOMIZED_SIGNING
+    randombytes(rnd, RNDBYTES);
+  #else
+    memset(rnd, 0, RNDBYTES);
+  #endif
+
+  crypto_sign_key_expand(&sctx, sk);
+  crypto_sign_signature_mu_internal(sig, siglen, mu, rnd, &sctx);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.sign += t;
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_pk_expand
+*
+* Description: Computes tr = H(pk), expands matrix A and transforms
+*              t1*2^D to NTT domain, so that repeated verifications
+*              under the same key skip this work.
+*
+* Arguments:   - verify_ctx *vctx: pointer to output expanded key
+*              - const uint8_t *pk: pointer to bit-packed public key
+**************************************************/
+void crypto_sign_pk_expand(verify_ctx *vctx, const uint8_t *pk)
+{
+  uint8_t rho[SEEDBYTES];
+
+  unpack_pk(rho, &vctx->t1, pk);
+  shake256(vctx->tr, TRBYTES, pk, CRYPTO_PUBLICKEYBYTES);
+
+  matrix_expand(vctx->mat, rho);
+  polyveck_shiftl(&vctx->t1);
+  polyveck_ntt(&vctx->t1);
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_ctx_internal
+*
+* Description: Verifies signature with expanded public key. Internal API.
+*
+* Arguments:   - uint8_t *m: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *m: pointer to message
+*              - size_t mlen: length of message
+*              - const uint8_t *pre: pointer to prefix string
+*              - size_t prelen: length of prefix string
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_ctx_internal(const uint8_t *sig,
+                                    size_t siglen,
+                                    const uint8_t *m,
+                                    size_t mlen,
+                                    const uint8_t *pre,
+                                    size_t prelen,
+                                    const verify_ctx *vctx)
+{
+  uint8_t mu[CRHBYTES];
+  keccak_state state;
+
+  // Reconstruct mu = CRH(tr, pre, msg)
+  shake256_init(&state);
+  shake256_absorb(&state, vctx->tr, TRBYTES);
+  shake256_absorb(&state, pre, prelen);
+  shake256_absorb(&state, m, mlen);
+  shake256_finalize(&state);
+  shake256_squeeze(mu, CRHBYTES, &state);
+
+  return crypto_sign_verify_mu_internal(sig, siglen, mu, vctx);
+}
+
+/*************************************************
+* Name:        verify_recover_w1
+*
+* Description: Unpacks a signature and computes the packed
+*              w1' = UseHint(h, A*z - c*t1*2^D) from an expanded public key.
+*
+* Arguments:   - uint8_t *buf: output packed w1' (K*POLYW1_PACKEDBYTES)
+*              - uint8_t *c: output challenge seed c~ from the signature
+*              - const uint8_t *sig: pointer to signature of CRYPTO_BYTES
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 on success and -1 if the signature is malformed or z too big
+**************************************************/
+static int verify_recover_w1(uint8_t buf[K*POLYW1_PACKEDBYTES],
+                             uint8_t c[CTILDEBYTES],
+                             const uint8_t *sig,
+                             const verify_ctx *vctx)
+{
+  poly cp;
+  polyvecl z;
+  polyveck w1, h;
+
+  // Step 1: Unpack sig (pk already unpacked into vctx)
+  //printf("[Step 1] Unpack sig (unpack_sig)\n");
+  if(unpack_sig(c, &z, &h, sig)) {
+    //printf("[Step 1] unpack_sig failed!\n");
+    return -1;
+  }
+
+  // Step 2: Check z 
+  //printf("[Step 2] Check z (polyvecl_chknorm)\n");
+  if(polyvecl_chknorm(&z, GAMMA1 - BETA)) {
+    //printf("[Step 2] z out of bounds!\n");
+    return -1;
+  }
+
+  // Step 3: Matrix A is cached in vctx, only expand the challenge
+  poly_challenge(&cp, c);
+
+  // Step 4: mu = CRH(tr, pre, msg) is supplied by the caller
 
   // Step 5: Compute w1' = A*z - c*t1
   //printf("[Step 5] Compute w1' = A*z - c*t1 to reconstruct w1\n");
   polyvecl_ntt(&z);
-  polyvec_matrix_pointwise_montgomery(&w1, mat, &z);
+  poly_ntt(&cp);
+  matrix_product(&w1, vctx->mat, &z, &cp, &vctx->t1);
+
+  // Step 6: Use hint to reconstruct w1 
+  //printf("[Step 6] Use hint to reconstruct w1 without knowing secret vectors\n");
+  polyveck_caddq(&w1);
+  polyveck_use_hint(&w1, &w1, &h);
+  polyveck_pack_w1(buf, &w1);
+
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_mu_internal
+*
+* Description: Verifies signature over a precomputed message
+*              representative mu = CRH(tr, pre, m). Internal API.
+*
+* Arguments:   - uint8_t *m: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *mu: pointer to message representative
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_mu_internal(const uint8_t *sig,
+                                   size_t siglen,
+                                   const uint8_t mu[CRHBYTES],
+                                   const verify_ctx *vctx)
+{
+  unsigned int i;
+  uint8_t buf[K*POLYW1_PACKEDBYTES];
+  uint8_t c[CTILDEBYTES];
+  uint8_t c2[CTILDEBYTES];
+  keccak_state state;
+
+  //printf("\n====== VERIFYING STAGE ======\n\n");
+  // Auxiliary: Check signature length
+  //printf("Check signature length\n");
+  if(siglen != CRYPTO_BYTES) {
+    //printf("Invalid signature length!\n");
+    return -1;
+  }
+
+  // Steps 1-6: Reconstruct w1
+  if(verify_recover_w1(buf, c, sig, vctx))
+    return -1;
+
+  // Step 7: Recompute challenge c'' (c_tilde_prime)
+  //printf("[Step 7] Recompute challenge c''\n");
+  shake256_init(&state);
+  shake256_absorb(&state, mu, CRHBYTES);
+  shake256_absorb(&state, buf, K*POLYW1_PACKEDBYTES);
+  shake256_finalize(&state);
+  shake256_squeeze(c2, CTILDEBYTES, &state);
+
+  // Step 8: Compare challenges
+  //printf("[Step 8] Compare c' (from sig) and c'' (recomputed) \n");
+  for(i = 0; i < CTILDEBYTES; ++i) {
+    if(c[i] != c2[i]) {
+      //printf("[Done] Challenge mismatch, verification failed!\n");
+      return -1; 
+    }
+  }
+
+  //printf("[Done] Signature verification successful!\n");
+  
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_internal
+*
+* Description: Verifies signature. Internal API.
+*
+* Arguments:   - uint8_t *m: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *m: pointer to message
+*              - size_t mlen: length of message
+*              - const uint8_t *pre: pointer to prefix string
+*              - size_t prelen: length of prefix string
+*              - const uint8_t *pk: pointer to bit-packed public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_internal(const uint8_t *sig,
+                                size_t siglen,
+                                const uint8_t *m,
+                                size_t mlen,
+                                const uint8_t *pre,
+                                size_t prelen,
+                                const uint8_t *pk)
+{
+  verify_ctx vctx;
+
+  if(siglen != CRYPTO_BYTES)
+    return -1;
+
+  crypto_sign_pk_expand(&vctx, pk);
+  return crypto_sign_verify_ctx_internal(sig, siglen, m, mlen, pre, prelen, &vctx);
+}
+
+/*************************************************
+* Name:        crypto_sign_verify
+*
+* Description: Verifies signature.
+*
+* Arguments:   - uint8_t *m: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *m: pointer to message
+*              - size_t mlen: length of message
+*              - const uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - const uint8_t *pk: pointer to bit-packed public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify(const uint8_t *sig,
+                       size_t siglen,
+                       const uint8_t *m,
+                       size_t mlen,
+                       const uint8_t *ctx,
+                       size_t ctxlen,
+                       const uint8_t *pk)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint8_t pre[257];
+
+  if(ctxlen > 255)
+    return -1;
+
+  build_prefix(pre, 0, ctx, ctxlen);
+  
+  int valid = crypto_sign_verify_internal(sig,siglen,m,mlen,pre,2+ctxlen,pk);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return valid;
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_ctx
+*
+* Description: Verifies signature with expanded public key.
+*
+* Arguments:   - uint8_t *m: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *m: pointer to message
+*              - size_t mlen: length of message
+*              - const uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_ctx(const uint8_t *sig,
+                           size_t siglen,
+                           const uint8_t *m,
+                           size_t mlen,
+                           const uint8_t *ctx,
+                           size_t ctxlen,
+                           const verify_ctx *vctx)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint8_t pre[257];
 
-  poly_ntt(&cp);
-  polyveck_shiftl(&t1);
-  polyveck_ntt(&t1);
-  polyveck_pointwise_poly_montgomery(&t1, &cp, &t1);
+  if(ctxlen > 255)
+    return -1;
 
-  polyveck_sub(&w1, &w1, &t1);
-  polyveck_reduce(&w1);
-  polyveck_invntt_tomont(&w1);
+  build_prefix(pre, 0, ctx, ctxlen);
+  
+  int valid = crypto_sign_verify_ctx_internal(sig,siglen,m,mlen,pre,2+ctxlen,vctx);
 
-  // Step 6: Use hint to reconstruct w1 
-  //printf("[Step 6] Use hint to reconstruct w1 without knowing secret vectors\n");
-  polyveck_caddq(&w1);
-  polyveck_use_hint(&w1, &w1, &h);
-  polyveck_pack_w1(buf, &w1);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
 
-  // Step 7: Recompute challenge c'' (c_tilde_prime)
-  //printf("[Step 7] Recompute challenge c''\n");
+  return valid;
+}
+
+/*************************************************
+* Name:        crypto_sign_mu_ctx
+*
+* Description: Computes mu = CRH(tr, pre, m) from an expanded public key,
+*              without hashing pk again. With a fixed message the result
+*              can be reused by crypto_sign_verify_ctx_mu.
+*
+* Arguments:   - uint8_t *mu:    output mu (of length CRHBYTES)
+*              - uint8_t *m:     pointer to message
+*              - size_t mlen:    length of message
+*              - uint8_t *ctx:   pointer to contex string
+*              - size_t ctxlen:  length of contex string
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_sign_mu_ctx(uint8_t mu[CRHBYTES],
+                       const uint8_t *m,
+                       size_t mlen,
+                       const uint8_t *ctx,
+                       size_t ctxlen,
+                       const verify_ctx *vctx)
+{
+  uint8_t pre[257];
+  keccak_state state;
+
+  if(ctxlen > 255)
+    return -1;
+
+  build_prefix(pre, 0, ctx, ctxlen);
   shake256_init(&state);
-  shake256_absorb(&state, mu, CRHBYTES);
-  shake256_absorb(&state, buf, K*POLYW1_PACKEDBYTES);
+  shake256_absorb(&state, vctx->tr, TRBYTES);
+  shake256_absorb(&state, pre, 2+ctxlen);
+  shake256_absorb(&state, m, mlen);
   shake256_finalize(&state);
-  shake256_squeeze(c2, CTILDEBYTES, &state);
+  shake256_squeeze(mu, CRHBYTES, &state);
+  return 0;
+}
 
-  // Step 8: Compare challenges
-  //printf("[Step 8] Compare c' (from sig) and c'' (recomputed) \n");
-  for(i = 0; i < CTILDEBYTES; ++i) {
-    if(c[i] != c2[i]) {
-      //printf("[Done] Challenge mismatch, verification failed!\n");
-      return -1; 
+/*************************************************
+* Name:        crypto_sign_verify_ctx_mu
+*
+* Description: Verifies signature over a precomputed mu (see
+*              crypto_sign_mu_ctx) with expanded public key.
+*
+* Arguments:   - const uint8_t *sig: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *mu: pointer to message representative
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_ctx_mu(const uint8_t *sig,
+                              size_t siglen,
+                              const uint8_t mu[CRHBYTES],
+                              const verify_ctx *vctx)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  int valid = crypto_sign_verify_mu_internal(sig, siglen, mu, vctx);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return valid;
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_batch_mu
+*
+* Description: Verifies n signatures over one precomputed mu (see
+*              crypto_sign_mu_ctx) with one expanded public key. The final
+*              challenge hashes H(mu, w1') of four signatures at a time run
+*              on 4-way Keccak.
+*
+* Arguments:   - int *results: pointer to output array of n verification
+*                              results (0 or -1)
+*              - const uint8_t *const *sigs: array of n pointers to signatures
+*              - const size_t *siglens: array of n signature lengths
+*              - const uint8_t *mu: pointer to message representative
+*              - const verify_ctx *vctx: pointer to expanded public key
+*              - size_t n: number of signatures
+*
+* Returns 0 if all signatures could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_batch_mu(int *results,
+                                const uint8_t *const *sigs,
+                                const size_t *siglens,
+                                const uint8_t mu[CRHBYTES],
+                                const verify_ctx *vctx,
+                                size_t n)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  unsigned int i, j;
+  size_t b;
+  int valid[4], ret = 0;
+  /* mu followed by packed w1 */
+  uint8_t buf[4][CRHBYTES + K*POLYW1_PACKEDBYTES];
+  uint8_t c[4][CTILDEBYTES];
+  uint8_t c2[4][SHAKE256_RATE];
+  keccakx4_state state;
+
+  memset(buf, 0, sizeof(buf));
+  for(j = 0; j < 4; ++j)
+    memcpy(buf[j], mu, CRHBYTES);
+
+  for(b = 0; b < n; b += 4) {
+    /* Reconstruct w1 behind mu; missing lanes of the last group hash
+     * whatever their buffer holds and are discarded */
+    for(j = 0; j < 4; ++j) {
+      valid[j] = -1;
+      if(b + j < n && siglens[b + j] == CRYPTO_BYTES)
+        valid[j] = verify_recover_w1(buf[j] + CRHBYTES, c[j], sigs[b + j], vctx);
+    }
+
+    /* Call random oracle and verify challenges */
+    shake256x4_absorb_once(&state, buf[0], buf[1], buf[2], buf[3], CRHBYTES + K*POLYW1_PACKEDBYTES);
+    shake256x4_squeezeblocks(c2[0], c2[1], c2[2], c2[3], 1, &state);
+
+    for(j = 0; j < 4 && b + j < n; ++j) {
+      for(i = 0; !valid[j] && i < CTILDEBYTES; ++i)
+        if(c[j][i] != c2[j][i])
+          valid[j] = -1;
+      results[b + j] = valid[j];
+      ret |= valid[j];
     }
   }
 
-  //printf("[Done] Signature verification successful!\n");
-  
-  return 0;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return ret;
+}
+
+/* Signatures of a batch are ordered by public key in chunks of this many,
+ * so that each key is expanded once per chunk however they are mixed */
+#define VERIFY_BATCH_CHUNK 64
+
+static int pk_cmp(const uint8_t *a, const uint8_t *b)
+{
+  return (a == b) ? 0 : memcmp(a, b, CRYPTO_PUBLICKEYBYTES);
 }
 
 /*************************************************
-* Name:        crypto_sign_verify
+* Name:        sort_by_pk
 *
-* Description: Verifies signature.
+* Description: Stable insertion sort of signature indices by public key.
 *
-* Arguments:   - uint8_t *m: pointer to input signature
-*              - size_t siglen: length of signature
-*              - const uint8_t *m: pointer to message
-*              - size_t mlen: length of message
+* Arguments:   - size_t *idx: array of len indices into pks, sorted in place
+*              - size_t len: number of indices
+*              - const uint8_t *const *pks: array of pointers to public keys
+**************************************************/
+static void sort_by_pk(size_t *idx, size_t len, const uint8_t *const *pks)
+{
+  size_t i, j, t;
+
+  for(i = 1; i < len; ++i) {
+    t = idx[i];
+    for(j = i; j > 0 && pk_cmp(pks[idx[j-1]], pks[t]) > 0; --j)
+      idx[j] = idx[j-1];
+    idx[j] = t;
+  }
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_batch
+*
+* Description: Verifies n independent signatures. Within chunks of
+*              VERIFY_BATCH_CHUNK signatures they are taken in public key
+*              order, so signatures under the same public key share one
+*              expansion of it (tr, matrix A and NTT(t1*2^D)) wherever
+*              they are in the chunk. The final challenge hashes of four
+*              signatures at a time run on 4-way Keccak.
+*
+* Arguments:   - int *results: pointer to output array of n verification
+*                              results (0 or -1)
+*              - const uint8_t *const *sigs: array of n pointers to signatures
+*              - const size_t *siglens: array of n signature lengths
+*              - const uint8_t *const *msgs: array of n pointers to messages
+*              - const size_t *mlens: array of n message lengths
+*              - const uint8_t *ctx: pointer to context string shared by
+*                                    all signatures
+*              - size_t ctxlen: length of context string
+*              - const uint8_t *const *pks: array of n pointers to
+*                                           bit-packed public keys
+*              - size_t n: number of signatures
+*
+* Returns 0 if all signatures could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_batch(int *results,
+                             const uint8_t *const *sigs,
+                             const size_t *siglens,
+                             const uint8_t *const *msgs,
+                             const size_t *mlens,
+                             const uint8_t *ctx,
+                             size_t ctxlen,
+                             const uint8_t *const *pks,
+                             size_t n)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  unsigned int i, j;
+  size_t b, g, k, len, order[VERIFY_BATCH_CHUNK];
+  int valid[4], ret = 0;
+  uint8_t pre[257];
+  /* mu followed by packed w1 */
+  uint8_t buf[4][CRHBYTES + K*POLYW1_PACKEDBYTES];
+  uint8_t c[4][CTILDEBYTES];
+  uint8_t c2[4][SHAKE256_RATE];
+  const uint8_t *vpk = NULL;
+  keccakx4_state statex4;
+  keccak_state state;
+  verify_ctx vctx;
+
+  if(ctxlen > 255) {
+    for(b = 0; b < n; ++b)
+      results[b] = -1;
+    return -1;
+  }
+
+  build_prefix(pre, 0, ctx, ctxlen);
+  memset(buf, 0, sizeof(buf));
+
+  for(b = 0; b < n; b += len) {
+    len = (n - b < VERIFY_BATCH_CHUNK) ? n - b : VERIFY_BATCH_CHUNK;
+    for(g = 0; g < len; ++g)
+      order[g] = b + g;
+    sort_by_pk(order, len, pks);
+
+    for(g = 0; g < len; g += 4) {
+      /* Reconstruct mu and w1 lane by lane; missing lanes of the last
+       * group and malformed signatures hash whatever their buffer holds
+       * and are discarded */
+      for(j = 0; j < 4; ++j) {
+        valid[j] = -1;
+        if(g + j >= len || siglens[order[g + j]] != CRYPTO_BYTES)
+          continue;
+        k = order[g + j];
+
+        /* Re-expand only when the public key changes */
+        if(vpk == NULL || pk_cmp(vpk, pks[k]))
+          crypto_sign_pk_expand(&vctx, pks[k]);
+        vpk = pks[k];
+
+        shake256_init(&state);
+        shake256_absorb(&state, vctx.tr, TRBYTES);
+        shake256_absorb(&state, pre, 2+ctxlen);
+        shake256_absorb(&state, msgs[k], mlens[k]);
+        shake256_finalize(&state);
+        shake256_squeeze(buf[j], CRHBYTES, &state);
+
+        valid[j] = verify_recover_w1(buf[j] + CRHBYTES, c[j], sigs[k], &vctx);
+      }
+
+      /* Call random oracle and verify challenges */
+      shake256x4_absorb_once(&statex4, buf[0], buf[1], buf[2], buf[3], CRHBYTES + K*POLYW1_PACKEDBYTES);
+      shake256x4_squeezeblocks(c2[0], c2[1], c2[2], c2[3], 1, &statex4);
+
+      for(j = 0; j < 4 && g + j < len; ++j) {
+        for(i = 0; !valid[j] && i < CTILDEBYTES; ++i)
+          if(c[j][i] != c2[j][i])
+            valid[j] = -1;
+        results[order[g + j]] = valid[j];
+        ret |= valid[j];
+      }
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return ret;
+}
+
+/*************************************************
+* Name:        crypto_verify_init
+*
+* Description: Starts a streaming verification. The message is absorbed
+*              incrementally with crypto_verify_update.
+*
+* Arguments:   - verify_stream *st: pointer to stream state
 *              - const uint8_t *ctx: pointer to context string
 *              - size_t ctxlen: length of context string
 *              - const uint8_t *pk: pointer to bit-packed public key
 *
-* Returns 0 if signature could be verified correctly and -1 otherwise
+* Returns 0 (success) or -1 (context string too long)
 **************************************************/
-int crypto_sign_verify(const uint8_t *sig,
-                       size_t siglen,
-                       const uint8_t *m,
-                       size_t mlen,
+int crypto_verify_init(verify_stream *st,
                        const uint8_t *ctx,
                        size_t ctxlen,
                        const uint8_t *pk)
+{
+  uint8_t pre[257];
+  uint8_t tr[TRBYTES];
+
+  if(ctxlen > 255)
+    return -1;
+
+  build_prefix(pre, 0, ctx, ctxlen);
+
+  shake256(tr, TRBYTES, pk, CRYPTO_PUBLICKEYBYTES);
+  shake256_init(&st->state);
+  shake256_absorb(&st->state, tr, TRBYTES);
+  shake256_absorb(&st->state, pre, 2+ctxlen);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_verify_update
+*
+* Description: Absorbs the next part of the signed message.
+*
+* Arguments:   - verify_stream *st: pointer to stream state
+*              - const uint8_t *m: pointer to message part
+*              - size_t mlen: length of message part
+**************************************************/
+void crypto_verify_update(verify_stream *st, const uint8_t *m, size_t mlen)
+{
+  shake256_absorb(&st->state, m, mlen);
+}
+
+/*************************************************
+* Name:        crypto_verify_final
+*
+* Description: Verifies signature over all absorbed message parts.
+*
+* Arguments:   - verify_stream *st: pointer to stream state
+*              - const uint8_t *sig: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *pk: pointer to bit-packed public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_verify_final(verify_stream *st,
+                        const uint8_t *sig,
+                        size_t siglen,
+                        const uint8_t *pk)
 {
   struct timespec start, end;
   clock_gettime(CLOCK_MONOTONIC, &start);
 
-  size_t i;
+  uint8_t mu[CRHBYTES];
+  verify_ctx vctx;
+
+  shake256_finalize(&st->state);
+  shake256_squeeze(mu, CRHBYTES, &st->state);
+
+  crypto_sign_pk_expand(&vctx, pk);
+  int valid = crypto_sign_verify_mu_internal(sig, siglen, mu, &vctx);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return valid;
+}
+
+/*************************************************
+* Name:        crypto_verify_init_ctx
+*
+* Description: Starts a streaming verification under an expanded public
+*              key; continue with crypto_verify_update and end with
+*              crypto_verify_final_ctx.
+*
+* Arguments:   - verify_stream *st: pointer to stream state
+*              - const uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 (success) or -1 (context string too long)
+**************************************************/
+int crypto_verify_init_ctx(verify_stream *st,
+                           const uint8_t *ctx,
+                           size_t ctxlen,
+                           const verify_ctx *vctx)
+{
   uint8_t pre[257];
 
   if(ctxlen > 255)
     return -1;
 
-  pre[0] = 0;
-  pre[1] = ctxlen;
-  for(i = 0; i < ctxlen; i++)
-    pre[2 + i] = ctx[i];
-  
-  int valid = crypto_sign_verify_internal(sig,siglen,m,mlen,pre,2+ctxlen,pk);
+  build_prefix(pre, 0, ctx, ctxlen);
+
+  shake256_init(&st->state);
+  shake256_absorb(&st->state, vctx->tr, TRBYTES);
+  shake256_absorb(&st->state, pre, 2+ctxlen);
+  return 0;
+}
+
+/*************************************************
+* Name:        crypto_verify_final_ctx
+*
+* Description: Verifies signature over all absorbed message parts with
+*              expanded public key.
+*
+* Arguments:   - verify_stream *st: pointer to stream state
+*              - const uint8_t *sig: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const verify_ctx *vctx: pointer to expanded public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_verify_final_ctx(verify_stream *st,
+                            const uint8_t *sig,
+                            size_t siglen,
+                            const verify_ctx *vctx)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint8_t mu[CRHBYTES];
+
+  shake256_finalize(&st->state);
+  shake256_squeeze(mu, CRHBYTES, &st->state);
+
+  int valid = crypto_sign_verify_mu_internal(sig, siglen, mu, vctx);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return valid;
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_prehash
+*
+* Description: Verifies HashML-DSA signature over a message digest.
+*
+* Arguments:   - const uint8_t *sig: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *ph: pointer to digest PH(m)
+*              - size_t phlen: length of digest
+*              - const uint8_t *ctx: pointer to context string
+*              - size_t ctxlen: length of context string
+*              - int phalg: pre-hash function (DILITHIUM_PH_*)
+*              - const uint8_t *pk: pointer to bit-packed public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_prehash(const uint8_t *sig,
+                               size_t siglen,
+                               const uint8_t *ph,
+                               size_t phlen,
+                               const uint8_t *ctx,
+                               size_t ctxlen,
+                               int phalg,
+                               const uint8_t *pk)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  int prelen;
+  uint8_t pre[257 + PREHASH_OIDBYTES];
+
+  prelen = prehash_pre(pre, ctx, ctxlen, phalg, phlen);
+  if(prelen < 0)
+    return -1;
+
+  int valid = crypto_sign_verify_internal(sig, siglen, ph, phlen, pre, prelen, pk);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  g_time.verify += t;
+
+  return valid;
+}
+
+/*************************************************
+* Name:        crypto_sign_verify_extmu
+*
+* Description: Verifies signature over an externally supplied message
+*              representative mu (see crypto_sign_mu).
+*
+* Arguments:   - const uint8_t *sig: pointer to input signature
+*              - size_t siglen: length of signature
+*              - const uint8_t *mu: pointer to message representative
+*              - const uint8_t *pk: pointer to bit-packed public key
+*
+* Returns 0 if signature could be verified correctly and -1 otherwise
+**************************************************/
+int crypto_sign_verify_extmu(const uint8_t *sig,
+                             size_t siglen,
+                             const uint8_t mu[CRHBYTES],
+                             const uint8_t *pk)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  verify_ctx vctx;
+
+  crypto_sign_pk_expand(&vctx, pk);
+  int valid = crypto_sign_verify_mu_internal(sig, siglen, mu, &vctx);
 
   clock_gettime(CLOCK_MONOTONIC, &end);
   double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
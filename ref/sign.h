@@ -6,6 +6,7 @@
 #include "params.h"
 #include "polyvec.h"
 #include "poly.h"
+#include "fips202.h"
 
 #define crypto_sign_keypair DILITHIUM_NAMESPACE(keypair)
 int crypto_sign_keypair(uint8_t *pk, uint8_t *sk);
@@ -20,12 +21,166 @@ int crypto_sign_signature_internal(uint8_t *sig,
                                    const uint8_t rnd[RNDBYTES],
                                    const uint8_t *sk);
 
+/* Secret key expanded once for repeated signing: matrix A, and the secret
+ * vectors s1, s2, t0 in the domain their challenge products use (NTT, or
+ * normal where config.h picks the sparse product). On avx2 the struct must be
+ * 32-byte aligned (stack and static objects are; use aligned_alloc). */
+typedef struct {
+  uint8_t tr[TRBYTES];
+  uint8_t key[SEEDBYTES];
+  polyvecl mat[K];
+  polyvecl s1;
+  polyveck s2;
+  polyveck t0;
+} sign_ctx;
+
+#define crypto_sign_key_expand DILITHIUM_NAMESPACE(key_expand)
+void crypto_sign_key_expand(sign_ctx *sctx, const uint8_t *sk);
+
+#define crypto_sign_signature_ctx_internal DILITHIUM_NAMESPACE(signature_ctx_internal)
+int crypto_sign_signature_ctx_internal(uint8_t *sig,
+                                       size_t *siglen,
+                                       const uint8_t *m,
+                                       size_t mlen,
+                                       const uint8_t *pre,
+                                       size_t prelen,
+                                       const uint8_t rnd[RNDBYTES],
+                                       const sign_ctx *sctx);
+
+#define crypto_sign_signature_mu_internal DILITHIUM_NAMESPACE(signature_mu_internal)
+int crypto_sign_signature_mu_internal(uint8_t *sig,
+                                      size_t *siglen,
+                                      const uint8_t mu[CRHBYTES],
+                                      const uint8_t rnd[RNDBYTES],
+                                      const sign_ctx *sctx);
+
+/* Thread team supplied by the caller (ref/test/team.h has one built on
+ * pthreads). run(team, fn, arg, n) calls fn(arg, i) once for every i < n,
+ * on up to width threads including the caller, and returns when all calls
+ * have returned. */
+typedef struct sign_team {
+  unsigned int width;
+  void (*run)(const struct sign_team *team,
+              void (*fn)(void *arg, unsigned int i), void *arg, unsigned int n);
+  void *priv;
+} sign_team;
+
+/* Speculative rejection loop: the attempts for several nonces run in
+ * parallel and the first accepted one in nonce order wins, so signatures
+ * are byte for byte those of crypto_sign_signature_mu_internal. */
+#define SIGN_SPEC_MAX_WIDTH 8
+
+#define crypto_sign_signature_mu_spec DILITHIUM_NAMESPACE(signature_mu_spec)
+int crypto_sign_signature_mu_spec(uint8_t *sig,
+                                  size_t *siglen,
+                                  const uint8_t mu[CRHBYTES],
+                                  const uint8_t rnd[RNDBYTES],
+                                  const sign_ctx *sctx,
+                                  const sign_team *team);
+
+/* Row-parallel mode: while a team is set for the calling thread, key
+ * generation, key expansion, signing and verification on that thread
+ * split the rows of matrix A (expansion, row products and their inverse
+ * NTTs) over the team. Outputs do not change. NULL switches it off. The
+ * team must not be in use by another thread at the same time. */
+#define crypto_sign_set_team DILITHIUM_NAMESPACE(set_team)
+void crypto_sign_set_team(const sign_team *team);
+
+#define crypto_sign_mu_internal DILITHIUM_NAMESPACE(mu_internal)
+void crypto_sign_mu_internal(uint8_t mu[CRHBYTES],
+                             const uint8_t *m, size_t mlen,
+                             const uint8_t *pre, size_t prelen,
+                             const sign_ctx *sctx);
+
+/* Offline/online signing. NOT THE FIPS 204 SIGNING ALGORITHM: the mask y
+ * is derived from fresh randomness and the key, but not from the message,
+ * so the signatures verify normally but cannot be reproduced from test
+ * vectors. crypto_sign_commit does the message-independent part of one
+ * signing attempt (sampling y, A*y, decomposing w) ahead of time;
+ * crypto_sign_signature_commit finishes the attempt for a message and
+ * wipes the commitment whether or not it was accepted. A commitment must
+ * never be used twice: two signatures with the same y reveal the key, so
+ * crypto_sign_signature_commit refuses a commitment that is not ready
+ * (already used, wiped, or never filled in by crypto_sign_commit). */
+typedef struct {
+  polyvecl y;
+  polyveck w0;
+  polyveck w1;
+  uint8_t w1_packed[K*POLYW1_PACKEDBYTES];
+  int ready;
+} sign_commitment;
+
+#define crypto_sign_commit DILITHIUM_NAMESPACE(commit)
+void crypto_sign_commit(sign_commitment *cm, const sign_ctx *sctx);
+
+#define crypto_sign_signature_commit DILITHIUM_NAMESPACE(signature_commit)
+int crypto_sign_signature_commit(uint8_t *sig, size_t *siglen,
+                                 const uint8_t mu[CRHBYTES],
+                                 sign_commitment *cm,
+                                 const sign_ctx *sctx);
+
+#define crypto_sign_signature_ctx DILITHIUM_NAMESPACE(signature_ctx)
+int crypto_sign_signature_ctx(uint8_t *sig, size_t *siglen,
+                              const uint8_t *m, size_t mlen,
+                              const uint8_t *ctx, size_t ctxlen,
+                              const sign_ctx *sctx);
+
 #define crypto_sign_signature DILITHIUM_NAMESPACE(signature)
 int crypto_sign_signature(uint8_t *sig, size_t *siglen,
                           const uint8_t *m, size_t mlen,
                           const uint8_t *ctx, size_t ctxlen,
                           const uint8_t *sk);
 
+/* Streaming signing: mu = CRH(tr, pre, m) is absorbed incrementally so the
+ * message never has to be held in one buffer. */
+typedef struct {
+  keccak_state state;
+} sign_stream;
+
+#define crypto_sign_init DILITHIUM_NAMESPACE(sign_init)
+int crypto_sign_init(sign_stream *st,
+                     const uint8_t *ctx, size_t ctxlen,
+                     const uint8_t *sk);
+
+#define crypto_sign_update DILITHIUM_NAMESPACE(sign_update)
+void crypto_sign_update(sign_stream *st, const uint8_t *m, size_t mlen);
+
+#define crypto_sign_final DILITHIUM_NAMESPACE(sign_final)
+int crypto_sign_final(sign_stream *st,
+                      uint8_t *sig, size_t *siglen,
+                      const uint8_t *sk);
+
+/* HashML-DSA pre-hash functions (FIPS 204, Section 5.4) */
+#define DILITHIUM_PH_SHA3_256 0
+#define DILITHIUM_PH_SHA3_512 1
+#define DILITHIUM_PH_SHAKE128 2
+#define DILITHIUM_PH_SHAKE256 3
+#define DILITHIUM_PH_MAXBYTES 64
+
+#define crypto_sign_prehash DILITHIUM_NAMESPACE(prehash)
+int crypto_sign_prehash(uint8_t ph[DILITHIUM_PH_MAXBYTES],
+                        const uint8_t *m, size_t mlen,
+                        int phalg);
+
+#define crypto_sign_signature_prehash DILITHIUM_NAMESPACE(signature_prehash)
+int crypto_sign_signature_prehash(uint8_t *sig, size_t *siglen,
+                                  const uint8_t *ph, size_t phlen,
+                                  const uint8_t *ctx, size_t ctxlen,
+                                  int phalg, const uint8_t *sk);
+
+/* External mu: the message representative CRH(tr, pre, m) is computed
+ * away from the signer and only CRHBYTES are shipped. */
+#define crypto_sign_mu DILITHIUM_NAMESPACE(mu)
+int crypto_sign_mu(uint8_t mu[CRHBYTES],
+                   const uint8_t *m, size_t mlen,
+                   const uint8_t *ctx, size_t ctxlen,
+                   const uint8_t *pk);
+
+#define crypto_sign_signature_extmu DILITHIUM_NAMESPACE(signature_extmu)
+int crypto_sign_signature_extmu(uint8_t *sig, size_t *siglen,
+                                const uint8_t mu[CRHBYTES],
+                                const uint8_t *sk);
+
 #define crypto_sign DILITHIUM_NAMESPACETOP
 int crypto_sign(uint8_t *sm, size_t *smlen,
                 const uint8_t *m, size_t mlen,
@@ -41,12 +196,116 @@ int crypto_sign_verify_internal(const uint8_t *sig,
                                 size_t prelen,
                                 const uint8_t *pk);
 
+/* Public key expanded once for repeated verification: tr = H(pk), matrix A
+ * and t1*2^D in NTT domain. Same alignment rule as sign_ctx on avx2. */
+typedef struct {
+  uint8_t tr[TRBYTES];
+  polyvecl mat[K];
+  polyveck t1;
+} verify_ctx;
+
+#define crypto_sign_pk_expand DILITHIUM_NAMESPACE(pk_expand)
+void crypto_sign_pk_expand(verify_ctx *vctx, const uint8_t *pk);
+
+#define crypto_sign_verify_ctx_internal DILITHIUM_NAMESPACE(verify_ctx_internal)
+int crypto_sign_verify_ctx_internal(const uint8_t *sig,
+                                    size_t siglen,
+                                    const uint8_t *m,
+                                    size_t mlen,
+                                    const uint8_t *pre,
+                                    size_t prelen,
+                                    const verify_ctx *vctx);
+
+#define crypto_sign_verify_mu_internal DILITHIUM_NAMESPACE(verify_mu_internal)
+int crypto_sign_verify_mu_internal(const uint8_t *sig,
+                                   size_t siglen,
+                                   const uint8_t mu[CRHBYTES],
+                                   const verify_ctx *vctx);
+
+#define crypto_sign_verify_ctx DILITHIUM_NAMESPACE(verify_ctx)
+int crypto_sign_verify_ctx(const uint8_t *sig, size_t siglen,
+                           const uint8_t *m, size_t mlen,
+                           const uint8_t *ctx, size_t ctxlen,
+                           const verify_ctx *vctx);
+
+/* Memoised mu: when the same message is verified under the same key over
+ * and over (a server's fixed challenge), mu = CRH(tr, pre, m) is computed
+ * once from the expanded key and each verification is the lattice part
+ * plus the final challenge hash. */
+#define crypto_sign_mu_ctx DILITHIUM_NAMESPACE(mu_ctx)
+int crypto_sign_mu_ctx(uint8_t mu[CRHBYTES],
+                       const uint8_t *m, size_t mlen,
+                       const uint8_t *ctx, size_t ctxlen,
+                       const verify_ctx *vctx);
+
+#define crypto_sign_verify_ctx_mu DILITHIUM_NAMESPACE(verify_ctx_mu)
+int crypto_sign_verify_ctx_mu(const uint8_t *sig, size_t siglen,
+                              const uint8_t mu[CRHBYTES],
+                              const verify_ctx *vctx);
+
+/* Batched counterpart of crypto_sign_verify_ctx_mu: n signatures over one
+ * mu and one expanded key, four final challenge hashes per 4-way Keccak */
+#define crypto_sign_verify_batch_mu DILITHIUM_NAMESPACE(verify_batch_mu)
+int crypto_sign_verify_batch_mu(int *results,
+                                const uint8_t *const *sigs, const size_t *siglens,
+                                const uint8_t mu[CRHBYTES],
+                                const verify_ctx *vctx, size_t n);
+
+#define crypto_sign_verify_batch DILITHIUM_NAMESPACE(verify_batch)
+int crypto_sign_verify_batch(int *results,
+                             const uint8_t *const *sigs, const size_t *siglens,
+                             const uint8_t *const *msgs, const size_t *mlens,
+                             const uint8_t *ctx, size_t ctxlen,
+                             const uint8_t *const *pks, size_t n);
+
 #define crypto_sign_verify DILITHIUM_NAMESPACE(verify)
 int crypto_sign_verify(const uint8_t *sig, size_t siglen,
                        const uint8_t *m, size_t mlen,
                        const uint8_t *ctx, size_t ctxlen,
                        const uint8_t *pk);
 
+/* Streaming verification, counterpart of sign_stream */
+typedef struct {
+  keccak_state state;
+} verify_stream;
+
+#define crypto_verify_init DILITHIUM_NAMESPACE(verify_init)
+int crypto_verify_init(verify_stream *st,
+                       const uint8_t *ctx, size_t ctxlen,
+                       const uint8_t *pk);
+
+#define crypto_verify_update DILITHIUM_NAMESPACE(verify_update)
+void crypto_verify_update(verify_stream *st, const uint8_t *m, size_t mlen);
+
+#define crypto_verify_final DILITHIUM_NAMESPACE(verify_final)
+int crypto_verify_final(verify_stream *st,
+                        const uint8_t *sig, size_t siglen,
+                        const uint8_t *pk);
+
+/* Streaming against an expanded key: init absorbs vctx->tr instead of
+ * hashing pk, and final goes straight to the lattice checks, so a server
+ * that hashes each chunk as it arrives has only those left at the end. */
+#define crypto_verify_init_ctx DILITHIUM_NAMESPACE(verify_init_ctx)
+int crypto_verify_init_ctx(verify_stream *st,
+                           const uint8_t *ctx, size_t ctxlen,
+                           const verify_ctx *vctx);
+
+#define crypto_verify_final_ctx DILITHIUM_NAMESPACE(verify_final_ctx)
+int crypto_verify_final_ctx(verify_stream *st,
+                            const uint8_t *sig, size_t siglen,
+                            const verify_ctx *vctx);
+
+#define crypto_sign_verify_prehash DILITHIUM_NAMESPACE(verify_prehash)
+int crypto_sign_verify_prehash(const uint8_t *sig, size_t siglen,
+                               const uint8_t *ph, size_t phlen,
+                               const uint8_t *ctx, size_t ctxlen,
+                               int phalg, const uint8_t *pk);
+
+#define crypto_sign_verify_extmu DILITHIUM_NAMESPACE(verify_extmu)
+int crypto_sign_verify_extmu(const uint8_t *sig, size_t siglen,
+                             const uint8_t mu[CRHBYTES],
+                             const uint8_t *pk);
+
 #define crypto_sign_open DILITHIUM_NAMESPACE(open)
 int crypto_sign_open(uint8_t *m, size_t *mlen,
                      const uint8_t *sm, size_t smlen,
@@ -62,10 +321,13 @@ typedef struct {
     double temp;
 } timing_info_t;
 
-// Expose global timing variable for test aggregation
-extern timing_info_t g_time;
+// Per-thread timing totals for test aggregation; the verify entry points
+// are called concurrently by the servers, so each thread accumulates its own
+#define g_time DILITHIUM_NAMESPACE(g_time)
+extern __thread timing_info_t g_time;
 
-// Print and return timing info
+// Print and return the calling thread's timing info
+#define print_timing_info DILITHIUM_NAMESPACE(print_timing_info)
 timing_info_t print_timing_info(void);
 
 void run_test(const uint8_t *m, size_t mlen, int test_idx);
@@ -0,0 +1,331 @@
+#define _GNU_SOURCE // RUSAGE_THREAD
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "binlog.h"
+
+#define BINLOG_CACHELINE 64
+#define BINLOG_WRITE_RECS 256       // records per write()
+#define BINLOG_IDLE_NS 1000000      // writer poll interval when all rings are empty
+#define BINLOG_STALL_NS 1000000000  // claimed but unpublished this long: skip the slot
+#define BINLOG_BUSY ((size_t)1 << (sizeof(size_t) * 8 - 1)) // seq of a slot being written, | pid
+
+typedef struct {
+  size_t seq;
+  binlog_rec_t rec;
+} binlog_slot;
+
+/* Vyukov's sequence-numbered ring (as in lfqueue.h) holding records by
+ * value. Producers claim slots with a CAS; the writer is the only
+ * consumer. Slots follow the header in the same block, so a ring is
+ * position independent and can sit in memory shared with children.
+ * A child killed between claiming and publishing would stop the writer
+ * at its slot for good, so the writer skips a slot that stays claimed
+ * for BINLOG_STALL_NS and counts it as dropped. Before copying its
+ * record a producer marks the slot BINLOG_BUSY | pid with a CAS: once
+ * the writer has skipped a claimed slot (and possibly handed it to the
+ * next lap) that mark fails and the producer drops its record without
+ * touching the slot. A marked slot is only skipped when its pid is gone,
+ * so a live producer is never overwritten mid-copy by the next lap. */
+struct binlog_ring {
+  size_t mask;
+  char pad0[BINLOG_CACHELINE];
+  size_t head; // next slot to push
+  char pad1[BINLOG_CACHELINE];
+  size_t tail; // next slot to write out
+  uint64_t dropped;
+  size_t stall_tail;  // tail + 1 when the writer first found it claimed, else 0
+  uint64_t stall_ns;  // and when
+  char pad2[BINLOG_CACHELINE];
+  binlog_slot slots[];
+};
+
+struct binlog {
+  int fd;
+  int stop;
+  unsigned int nrings;
+  size_t ring_bytes;
+  uint8_t *rings;
+  size_t rings_len;
+  int shared;
+  pthread_t writer;
+  binlog_rec_t buf[BINLOG_WRITE_RECS];
+};
+
+binlog_ring_t *binlog_ring(binlog_t *log, unsigned int idx) {
+  return (binlog_ring_t *)(log->rings + (size_t)(idx % log->nrings) * log->ring_bytes);
+}
+
+int binlog_push(binlog_ring_t *ring, const binlog_rec_t *rec) {
+  binlog_slot *slot;
+  size_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+  size_t seq;
+  intptr_t diff;
+
+  for (;;) {
+    slot = &ring->slots[pos & ring->mask];
+    seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    if (seq & BINLOG_BUSY) {
+      /* Being written: by this lap's producer once head has moved past
+       * pos, else still by the previous lap's, so the ring is full */
+      diff = (__atomic_load_n(&ring->head, __ATOMIC_RELAXED) == pos) ? -1 : 1;
+    } else {
+      diff = (intptr_t)seq - (intptr_t)pos;
+    }
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if (diff < 0) {
+      __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+      return -1;
+    } else {
+      pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    }
+  }
+
+  seq = pos;
+  if (!__atomic_compare_exchange_n(&slot->seq, &seq, BINLOG_BUSY | (size_t)getpid(), 0,
+                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+    return -1; // the writer gave up on the slot; it counted the drop
+  }
+  slot->rec = *rec;
+  seq = BINLOG_BUSY | (size_t)getpid();
+  if (!__atomic_compare_exchange_n(&slot->seq, &seq, pos + 1, 0,
+                                   __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    return -1; // skipped although alive (pid from another namespace)
+  }
+  return 0;
+}
+
+static int write_all(int fd, const void *data, size_t len) {
+  const uint8_t *p = data;
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    p += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* The writer's slot at tail is claimed (seq == tail) or being written
+ * (seq == BINLOG_BUSY | pid) but not published. Returns 1 once it has
+ * been so for BINLOG_STALL_NS, and in the second case the writing process
+ * has exited, after which the slot is released (seq advanced a lap, as
+ * if written out) and counted as dropped. */
+static int binlog_skip_stalled(binlog_ring_t *ring, binlog_slot *slot, size_t seq) {
+  uint64_t now = now_ns();
+
+  if (ring->stall_tail != ring->tail + 1) {
+    ring->stall_tail = ring->tail + 1;
+    ring->stall_ns = now;
+    return 0;
+  }
+  if (now - ring->stall_ns < BINLOG_STALL_NS) {
+    return 0;
+  }
+  if ((seq & BINLOG_BUSY) &&
+      (kill((pid_t)(seq & ~BINLOG_BUSY), 0) == 0 || errno != ESRCH)) {
+    return 0; // its producer is still copying
+  }
+  if (!__atomic_compare_exchange_n(&slot->seq, &seq, ring->tail + ring->mask + 1, 0,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    return 0; // marked or published just now
+  }
+  __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+  ring->stall_tail = 0;
+  ring->tail++;
+  return 1;
+}
+
+/* Move everything published so far to the file; returns records written */
+static size_t binlog_drain(binlog_t *log) {
+  size_t total = 0, n = 0;
+  unsigned int i;
+
+  for (i = 0; i < log->nrings; ++i) {
+    binlog_ring_t *ring = binlog_ring(log, i);
+    for (;;) {
+      binlog_slot *slot = &ring->slots[ring->tail & ring->mask];
+      size_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+      if (seq != ring->tail + 1) {
+        if (((seq & BINLOG_BUSY) ||
+             (seq == ring->tail && __atomic_load_n(&ring->head, __ATOMIC_RELAXED) != ring->tail)) &&
+            binlog_skip_stalled(ring, slot, seq)) {
+          continue;
+        }
+        break;
+      }
+      log->buf[n++] = slot->rec;
+      __atomic_store_n(&slot->seq, ring->tail + ring->mask + 1, __ATOMIC_RELEASE);
+      ring->tail++;
+      if (n == BINLOG_WRITE_RECS) {
+        write_all(log->fd, log->buf, n * sizeof(binlog_rec_t));
+        total += n;
+        n = 0;
+      }
+    }
+  }
+  if (n > 0) {
+    write_all(log->fd, log->buf, n * sizeof(binlog_rec_t));
+    total += n;
+  }
+  return total;
+}
+
+static void *binlog_writer(void *arg) {
+  binlog_t *log = arg;
+  struct timespec idle = {0, BINLOG_IDLE_NS};
+
+  while (!__atomic_load_n(&log->stop, __ATOMIC_ACQUIRE)) {
+    if (binlog_drain(log) == 0) {
+      nanosleep(&idle, NULL);
+    }
+  }
+  binlog_drain(log);
+  return NULL;
+}
+
+binlog_t *binlog_open(const char *path, unsigned int nrings, unsigned int capacity, int shared) {
+  binlog_t *log;
+  struct stat st;
+  size_t cap = 2;
+  unsigned int i, j;
+
+  while (cap < capacity) {
+    cap <<= 1;
+  }
+  if (nrings == 0) {
+    nrings = 1;
+  }
+
+  log = calloc(1, sizeof(*log));
+  if (!log) {
+    return NULL;
+  }
+  log->nrings = nrings;
+  log->shared = shared;
+  log->ring_bytes = sizeof(binlog_ring_t) + cap * sizeof(binlog_slot);
+  log->ring_bytes = (log->ring_bytes + BINLOG_CACHELINE - 1) & ~(size_t)(BINLOG_CACHELINE - 1);
+  log->rings_len = log->ring_bytes * nrings;
+  if (shared) {
+    log->rings = mmap(NULL, log->rings_len, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (log->rings == MAP_FAILED) {
+      free(log);
+      return NULL;
+    }
+  } else {
+    log->rings = aligned_alloc(BINLOG_CACHELINE, log->rings_len);
+    if (!log->rings) {
+      free(log);
+      return NULL;
+    }
+  }
+  memset(log->rings, 0, log->rings_len);
+  for (i = 0; i < nrings; ++i) {
+    binlog_ring_t *ring = binlog_ring(log, i);
+    ring->mask = cap - 1;
+    for (j = 0; j < cap; ++j) {
+      ring->slots[j].seq = j;
+    }
+  }
+
+  log->fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (log->fd < 0) {
+    goto fail;
+  }
+  if (fstat(log->fd, &st) == 0 && st.st_size == 0) {
+    binlog_file_hdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = BINLOG_MAGIC;
+    hdr.version = BINLOG_VERSION;
+    hdr.rec_size = sizeof(binlog_rec_t);
+    if (write_all(log->fd, &hdr, sizeof(hdr)) < 0) {
+      close(log->fd);
+      goto fail;
+    }
+  }
+
+  if (pthread_create(&log->writer, NULL, binlog_writer, log) != 0) {
+    close(log->fd);
+    goto fail;
+  }
+  return log;
+
+fail:
+  if (shared) {
+    munmap(log->rings, log->rings_len);
+  } else {
+    free(log->rings);
+  }
+  free(log);
+  return NULL;
+}
+
+uint64_t binlog_close(binlog_t *log) {
+  uint64_t dropped = 0;
+  unsigned int i;
+
+  if (!log) {
+    return 0;
+  }
+  __atomic_store_n(&log->stop, 1, __ATOMIC_RELEASE);
+  pthread_join(log->writer, NULL);
+  close(log->fd);
+  for (i = 0; i < log->nrings; ++i) {
+    dropped += __atomic_load_n(&binlog_ring(log, i)->dropped, __ATOMIC_RELAXED);
+  }
+  if (log->shared) {
+    munmap(log->rings, log->rings_len);
+  } else {
+    free(log->rings);
+  }
+  free(log);
+  return dropped;
+}
+
+void binlog_stamp(binlog_rec_t *rec, binlog_cpu_t *mark) {
+  struct timespec ts;
+  struct rusage ru;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  rec->ts_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+  rec->pid = (uint32_t)syscall(SYS_gettid);
+  if (getrusage(RUSAGE_THREAD, &ru) == 0) {
+    uint64_t user = (uint64_t)ru.ru_utime.tv_sec * 1000000u + (uint64_t)ru.ru_utime.tv_usec;
+    uint64_t sys = (uint64_t)ru.ru_stime.tv_sec * 1000000u + (uint64_t)ru.ru_stime.tv_usec;
+    rec->cpu_user_us = (uint32_t)(user - mark->user_us);
+    rec->cpu_sys_us = (uint32_t)(sys - mark->sys_us);
+    rec->maxrss_kb = (uint32_t)ru.ru_maxrss;
+    mark->user_us = user;
+    mark->sys_us = sys;
+  }
+}
@@ -0,0 +1,92 @@
+#ifndef BINLOG_H
+#define BINLOG_H
+
+/* Asynchronous binary request log for the TCP demo.
+ *
+ * Producers fill a fixed-size binlog_rec_t and push it into a lock-free
+ * ring (one per thread, or one shared by forked children); a background
+ * writer thread drains all rings into the log file with large write()s.
+ * Pushing never blocks and never touches the filesystem: when a ring is
+ * full the record is dropped and counted instead.
+ *
+ * File layout: a binlog_file_hdr followed by binlog_rec_t records, both in
+ * host byte order (the magic tells a reader whether it matches).
+ * test_dilithium_logdump converts a log to CSV or JSON. */
+
+#include <stdint.h>
+
+#define BINLOG_MAGIC 0x474F4C44u // "DLOG" on little-endian hosts
+#define BINLOG_VERSION 1
+#define BINLOG_STAGES 4
+
+enum {
+  BINLOG_SRC_SERVER = 1,       // fork server: send, recv, verify
+  BINLOG_SRC_SERVER_EPOLL = 2, // epoll/io_uring server: io, wait, verify
+  BINLOG_SRC_CLIENT = 3,       // client: connect, recv, sign, send
+  BINLOG_SRC_STRESS = 4        // stress tool: same stages as the client
+};
+
+enum {
+  BINLOG_RESULT_OK = 0,
+  BINLOG_RESULT_FAIL = 1, // signature rejected
+  BINLOG_RESULT_ERROR = 2 // I/O or protocol error
+};
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t rec_size;
+  uint64_t reserved;
+} binlog_file_hdr;
+
+typedef struct {
+  uint64_t ts_ns;                    // CLOCK_REALTIME when the request finished
+  uint32_t peer_addr;                // IPv4, network byte order
+  uint16_t peer_port;
+  uint8_t source;                    // BINLOG_SRC_*
+  uint8_t result;                    // BINLOG_RESULT_*
+  uint32_t pid;                      // process or thread id
+  uint32_t rounds;                   // signatures covered by this record
+  uint32_t stage_us[BINLOG_STAGES];  // per source, see BINLOG_SRC_*
+  uint32_t total_us;
+  uint32_t challenge_len;
+  uint32_t sig_len;
+  uint32_t cpu_user_us;              // rusage delta for this request
+  uint32_t cpu_sys_us;
+  uint32_t maxrss_kb;
+} binlog_rec_t;
+
+typedef struct binlog binlog_t;
+typedef struct binlog_ring binlog_ring_t;
+
+/* CPU time already accounted to earlier records of this thread */
+typedef struct {
+  uint64_t user_us;
+  uint64_t sys_us;
+} binlog_cpu_t;
+
+/* Open (append to) path with nrings rings of capacity records each
+ * (rounded up to a power of two) and start the writer thread. With
+ * shared != 0 the rings live in MAP_SHARED memory, so children forked
+ * afterwards can push into them; the writer stays in this process.
+ * Returns NULL on failure. */
+binlog_t *binlog_open(const char *path, unsigned int nrings, unsigned int capacity, int shared);
+
+binlog_ring_t *binlog_ring(binlog_t *log, unsigned int idx);
+
+/* Copy rec into the ring. Safe for several producers per ring. Returns 0,
+ * or -1 if the ring was full, or the producer stalled so long between
+ * claiming its slot and starting to copy that the writer skipped the
+ * slot, and the record was dropped. */
+int binlog_push(binlog_ring_t *ring, const binlog_rec_t *rec);
+
+/* Stop the writer, flush everything still queued and close the file.
+ * Returns the number of dropped records. */
+uint64_t binlog_close(binlog_t *log);
+
+/* Fill ts_ns, pid and the rusage fields of rec for the calling thread
+ * and advance mark. A zeroed mark in a freshly forked child covers the
+ * whole child. */
+void binlog_stamp(binlog_rec_t *rec, binlog_cpu_t *mark);
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef HIST_H
+#define HIST_H
+
+/* Log-linear latency histogram in the style of HdrHistogram: every power
+ * of two is split into HIST_SUB linear sub-buckets, so any recorded value
+ * is reported within 1/HIST_SUB (about 3%) of its true value over the
+ * whole 64-bit range. Values are nanoseconds by convention.
+ *
+ * hist_add() is meant for a single writer thread; other threads may read
+ * or merge concurrently and see a slightly stale but consistent-enough
+ * snapshot (relaxed atomics, no locks). */
+
+#include <stdint.h>
+#include <string.h>
+
+#define HIST_SUB_BITS 5
+#define HIST_SUB (1u << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 1) * HIST_SUB)
+
+typedef struct {
+  uint64_t count[HIST_BUCKETS];
+  uint64_t total;
+  uint64_t sum;
+  uint64_t max;
+} hist_t;
+
+static inline unsigned int hist_index(uint64_t v) {
+  unsigned int msb, shift;
+
+  if (v < HIST_SUB) {
+    return (unsigned int)v;
+  }
+  msb = 63 - (unsigned int)__builtin_clzll(v);
+  shift = msb - HIST_SUB_BITS;
+  return (shift + 1) * HIST_SUB + (unsigned int)((v >> shift) - HIST_SUB);
+}
+
+/* Midpoint of the values that map to bucket idx */
+static inline uint64_t hist_value(unsigned int idx) {
+  unsigned int shift;
+
+  if (idx < HIST_SUB) {
+    return idx;
+  }
+  shift = idx / HIST_SUB - 1;
+  return ((uint64_t)(HIST_SUB + idx % HIST_SUB) << shift) + ((1ull << shift) >> 1);
+}
+
+static inline void hist_reset(hist_t *h) {
+  memset(h, 0, sizeof(*h));
+}
+
+static inline void hist_bump(uint64_t *c, uint64_t n) {
+  __atomic_store_n(c, __atomic_load_n(c, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+static inline void hist_add(hist_t *h, uint64_t v) {
+  hist_bump(&h->count[hist_index(v)], 1);
+  hist_bump(&h->total, 1);
+  hist_bump(&h->sum, v);
+  if (v > __atomic_load_n(&h->max, __ATOMIC_RELAXED)) {
+    __atomic_store_n(&h->max, v, __ATOMIC_RELAXED);
+  }
+}
+
+/* hist_add() for histograms that several threads or processes write */
+static inline void hist_add_atomic(hist_t *h, uint64_t v) {
+  uint64_t m = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+
+  __atomic_fetch_add(&h->count[hist_index(v)], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&h->total, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&h->sum, v, __ATOMIC_RELAXED);
+  while (v > m && !__atomic_compare_exchange_n(&h->max, &m, v, 1,
+                                               __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+}
+
+/* dst += src; dst must not be written by anyone else meanwhile */
+static inline void hist_merge(hist_t *dst, const hist_t *src) {
+  unsigned int i;
+  uint64_t m;
+
+  for (i = 0; i < HIST_BUCKETS; ++i) {
+    dst->count[i] += __atomic_load_n(&src->count[i], __ATOMIC_RELAXED);
+  }
+  dst->total += __atomic_load_n(&src->total, __ATOMIC_RELAXED);
+  dst->sum += __atomic_load_n(&src->sum, __ATOMIC_RELAXED);
+  m = __atomic_load_n(&src->max, __ATOMIC_RELAXED);
+  if (m > dst->max) {
+    dst->max = m;
+  }
+}
+
+/* Value at quantile q in [0,1]; 0 for an empty histogram */
+static inline uint64_t hist_quantile(const hist_t *h, double q) {
+  uint64_t rank, seen = 0;
+  unsigned int i;
+
+  if (h->total == 0) {
+    return 0;
+  }
+  rank = (uint64_t)(q * (double)h->total);
+  if (rank >= h->total) {
+    rank = h->total - 1;
+  }
+  for (i = 0; i < HIST_BUCKETS; ++i) {
+    seen += h->count[i];
+    if (seen > rank) {
+      return hist_value(i) < h->max ? hist_value(i) : h->max;
+    }
+  }
+  return h->max;
+}
+
+static inline double hist_mean(const hist_t *h) {
+  return h->total ? (double)h->sum / (double)h->total : 0.0;
+}
+
+#endif
@@ -0,0 +1,374 @@
+#define _GNU_SOURCE // pthread_mutex_consistent
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "keycache.h"
+
+#define KC_PINNERS 64        // connections that can pin one slot at a time
+#define KC_LOAD_WAIT 100000  // yields spent waiting for another loader
+
+enum {
+  SLOT_EMPTY,
+  SLOT_LOADING, // claimed, being expanded outside the lock
+  SLOT_READY
+};
+
+typedef struct {
+  char id[KEYCACHE_MAX_ID + 1];
+  uint8_t state;
+  uint8_t referenced; // CLOCK bit, set on every hit
+  int32_t next;       // hash chain
+  pid_t loader;       // process expanding the key while SLOT_LOADING
+  pid_t pinner[KC_PINNERS]; // one entry per pin, 0 if free
+  verify_ctx vctx;
+} __attribute__((aligned(64))) kc_slot;
+
+/* Start of the shared block, followed by the buckets and then the slots */
+typedef struct {
+  pthread_mutex_t lock;
+  unsigned int nslots;
+  unsigned int nbuckets;
+  unsigned int hand;
+  unsigned int used;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  uint64_t bypass;
+} __attribute__((aligned(64))) kc_hdr;
+
+struct keycache {
+  char dir[PATH_MAX];
+  kc_hdr *hdr;
+  int32_t *buckets;
+  kc_slot *slots;
+  size_t len;
+};
+
+static void kc_lock(keycache_t *kc) {
+  /* A child killed while holding the lock leaves at worst one half-linked
+   * slot behind; carry on rather than wedge every later connection */
+  if (pthread_mutex_lock(&kc->hdr->lock) == EOWNERDEAD) {
+    pthread_mutex_consistent(&kc->hdr->lock);
+  }
+}
+
+static void kc_unlock(keycache_t *kc) {
+  pthread_mutex_unlock(&kc->hdr->lock);
+}
+
+static void kc_count(uint64_t *c) {
+  __atomic_fetch_add(c, 1, __ATOMIC_RELAXED);
+}
+
+static uint32_t kc_hash(const char *id) {
+  uint32_t h = 2166136261u; // FNV-1a
+  while (*id) {
+    h = (h ^ (uint8_t)*id++) * 16777619u;
+  }
+  return h;
+}
+
+keycache_t *keycache_create(const char *dir, size_t budget_bytes) {
+  pthread_mutexattr_t attr;
+  keycache_t *kc;
+  unsigned int nslots, nbuckets = 2, i;
+  size_t hdr_len;
+
+  nslots = budget_bytes / sizeof(kc_slot) > 0 ? (unsigned int)(budget_bytes / sizeof(kc_slot)) : 1;
+  while (nbuckets < 2 * nslots) {
+    nbuckets <<= 1;
+  }
+  if (strlen(dir) >= sizeof(kc->dir)) {
+    return NULL;
+  }
+
+  kc = calloc(1, sizeof(*kc));
+  if (!kc) {
+    return NULL;
+  }
+  strcpy(kc->dir, dir);
+  hdr_len = sizeof(kc_hdr) + nbuckets * sizeof(int32_t);
+  hdr_len = (hdr_len + _Alignof(kc_slot) - 1) & ~(size_t)(_Alignof(kc_slot) - 1);
+  kc->len = hdr_len + (size_t)nslots * sizeof(kc_slot);
+  kc->hdr = mmap(NULL, kc->len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (kc->hdr == MAP_FAILED) {
+    free(kc);
+    return NULL;
+  }
+  kc->buckets = (int32_t *)(kc->hdr + 1);
+  kc->slots = (kc_slot *)((uint8_t *)kc->hdr + hdr_len);
+
+  if (pthread_mutexattr_init(&attr) != 0 ||
+      pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) != 0 ||
+      pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST) != 0 ||
+      pthread_mutex_init(&kc->hdr->lock, &attr) != 0) {
+    munmap(kc->hdr, kc->len);
+    free(kc);
+    return NULL;
+  }
+  pthread_mutexattr_destroy(&attr);
+
+  kc->hdr->nslots = nslots;
+  kc->hdr->nbuckets = nbuckets;
+  for (i = 0; i < nbuckets; ++i) {
+    kc->buckets[i] = -1;
+  }
+  return kc;
+}
+
+int keycache_valid_id(const char *id, size_t len) {
+  size_t i;
+
+  if (len == 0 || len > KEYCACHE_MAX_ID || id[0] == '.') {
+    return 0;
+  }
+  for (i = 0; i < len; ++i) {
+    char c = id[i];
+    if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+          c == '.' || c == '_' || c == '-')) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* A pid that no longer exists. Children are reaped automatically
+ * (SIGCHLD ignored), so a dead child's pid gives ESRCH unless reused. */
+static int kc_dead(pid_t pid) {
+  return kill(pid, 0) < 0 && errno == ESRCH;
+}
+
+/* Caller holds the lock for all of the following */
+static int kc_pin(kc_slot *s, pid_t pid) {
+  unsigned int i;
+
+  for (i = 0; i < KC_PINNERS; ++i) {
+    if (s->pinner[i] == 0) {
+      s->pinner[i] = pid;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/* Drops the pins of processes that died holding them; returns whether
+ * any pin is left */
+static int kc_pinned(kc_slot *s) {
+  unsigned int i;
+  int pinned = 0;
+
+  for (i = 0; i < KC_PINNERS; ++i) {
+    if (s->pinner[i] != 0 && kc_dead(s->pinner[i])) {
+      s->pinner[i] = 0;
+    }
+    pinned |= s->pinner[i] != 0;
+  }
+  return pinned;
+}
+
+static int kc_find(keycache_t *kc, const char *id, uint32_t bucket) {
+  int32_t i;
+
+  for (i = kc->buckets[bucket]; i >= 0; i = kc->slots[i].next) {
+    if (strcmp(kc->slots[i].id, id) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void kc_unlink(keycache_t *kc, int32_t idx) {
+  int32_t *p = &kc->buckets[kc_hash(kc->slots[idx].id) & (kc->hdr->nbuckets - 1)];
+
+  while (*p != idx) {
+    p = &kc->slots[*p].next;
+  }
+  *p = kc->slots[idx].next;
+}
+
+static void kc_drop(keycache_t *kc, int32_t idx) {
+  kc_slot *s = &kc->slots[idx];
+
+  kc_unlink(kc, idx);
+  memset(s->pinner, 0, sizeof(s->pinner));
+  s->state = SLOT_EMPTY;
+  __atomic_fetch_sub(&kc->hdr->used, 1, __ATOMIC_RELAXED);
+}
+
+/* CLOCK: sweep at most twice round the table; a referenced slot gets its
+ * bit cleared and a second chance, pinned or loading slots are skipped.
+ * Loads and pins of dead processes no longer count. */
+static int kc_victim(keycache_t *kc) {
+  kc_hdr *h = kc->hdr;
+  unsigned int step;
+
+  for (step = 0; step < 2 * h->nslots; ++step) {
+    kc_slot *s = &kc->slots[h->hand];
+    int idx = (int)h->hand;
+
+    h->hand = (h->hand + 1) % h->nslots;
+    if (s->state == SLOT_EMPTY) {
+      __atomic_fetch_add(&h->used, 1, __ATOMIC_RELAXED);
+      return idx;
+    }
+    if (s->state == SLOT_LOADING && !kc_dead(s->loader)) {
+      continue;
+    }
+    if (kc_pinned(s)) {
+      continue;
+    }
+    if (s->state == SLOT_READY && s->referenced) {
+      s->referenced = 0;
+      continue;
+    }
+    kc_unlink(kc, idx);
+    kc_count(&h->evictions);
+    return idx;
+  }
+  return -1;
+}
+
+static int kc_read_pk(const keycache_t *kc, const char *id, uint8_t pk[CRYPTO_PUBLICKEYBYTES]) {
+  char path[PATH_MAX + KEYCACHE_MAX_ID + 8];
+  FILE *f;
+  size_t n;
+
+  snprintf(path, sizeof(path), "%s/%s.pk", kc->dir, id);
+  f = fopen(path, "rb");
+  if (!f) {
+    return -1;
+  }
+  n = fread(pk, 1, CRYPTO_PUBLICKEYBYTES, f);
+  fclose(f);
+  return n == CRYPTO_PUBLICKEYBYTES ? 0 : -1;
+}
+
+const verify_ctx *keycache_acquire(keycache_t *kc, const char *key_id,
+                                   verify_ctx *scratch, int *slot) {
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint32_t bucket;
+  unsigned int waits = 0;
+  int idx, have_pk = 0, bypass = 0;
+  pid_t pid = getpid();
+
+  *slot = -1;
+  if (!keycache_valid_id(key_id, strlen(key_id))) {
+    return NULL;
+  }
+  bucket = kc_hash(key_id) & (kc->hdr->nbuckets - 1);
+
+  kc_lock(kc);
+  for (;;) {
+    idx = kc_find(kc, key_id, bucket);
+    if (idx >= 0 && kc->slots[idx].state == SLOT_LOADING && !bypass) {
+      if (kc_dead(kc->slots[idx].loader)) {
+        kc_drop(kc, idx); // the loader died half way
+        continue;
+      }
+      if (++waits < KC_LOAD_WAIT) {
+        kc_unlock(kc); // another connection is expanding it right now
+        sched_yield();
+        kc_lock(kc);
+        continue;
+      }
+      bypass = 1; // stuck (a recycled pid?): expand privately
+    }
+    if (idx >= 0 && kc->slots[idx].state == SLOT_READY &&
+        kc_pin(&kc->slots[idx], pid) == 0) {
+      kc_slot *s = &kc->slots[idx];
+      s->referenced = 1;
+      kc_count(&kc->hdr->hits);
+      kc_unlock(kc);
+      *slot = idx;
+      return &s->vctx;
+    }
+    if (idx >= 0) {
+      bypass = 1; // cached but every pin in use, or not loaded in time
+    }
+    if (have_pk) {
+      break;
+    }
+    /* Read the file before claiming a slot, so unknown IDs evict nothing;
+     * then look again, the key may have arrived in the meantime */
+    kc_unlock(kc);
+    if (kc_read_pk(kc, key_id, pk) < 0) {
+      return NULL;
+    }
+    have_pk = 1;
+    kc_lock(kc);
+  }
+
+  kc_count(&kc->hdr->misses);
+  idx = bypass ? -1 : kc_victim(kc);
+  if (idx < 0) {
+    kc_count(&kc->hdr->bypass);
+    kc_unlock(kc);
+    crypto_sign_pk_expand(scratch, pk);
+    return scratch;
+  }
+  kc_slot *s = &kc->slots[idx];
+  strcpy(s->id, key_id);
+  s->state = SLOT_LOADING;
+  s->loader = pid;
+  s->referenced = 1;
+  memset(s->pinner, 0, sizeof(s->pinner));
+  s->pinner[0] = pid;
+  s->next = kc->buckets[bucket];
+  kc->buckets[bucket] = idx;
+  kc_unlock(kc);
+
+  crypto_sign_pk_expand(&s->vctx, pk);
+
+  kc_lock(kc);
+  s->state = SLOT_READY;
+  kc_unlock(kc);
+  *slot = idx;
+  return &s->vctx;
+}
+
+void keycache_release(keycache_t *kc, int slot) {
+  pid_t pid = getpid();
+  unsigned int i;
+
+  if (slot < 0) {
+    return;
+  }
+  kc_lock(kc);
+  for (i = 0; i < KC_PINNERS; ++i) {
+    if (kc->slots[slot].pinner[i] == pid) {
+      kc->slots[slot].pinner[i] = 0;
+      break;
+    }
+  }
+  kc_unlock(kc);
+}
+
+void keycache_stats(const keycache_t *kc, keycache_stats_t *st) {
+  st->hits = __atomic_load_n(&kc->hdr->hits, __ATOMIC_RELAXED);
+  st->misses = __atomic_load_n(&kc->hdr->misses, __ATOMIC_RELAXED);
+  st->evictions = __atomic_load_n(&kc->hdr->evictions, __ATOMIC_RELAXED);
+  st->bypass = __atomic_load_n(&kc->hdr->bypass, __ATOMIC_RELAXED);
+  st->slots = kc->hdr->nslots;
+  st->used = __atomic_load_n(&kc->hdr->used, __ATOMIC_RELAXED);
+}
+
+void keycache_destroy(keycache_t *kc) {
+  if (!kc) {
+    return;
+  }
+  pthread_mutex_destroy(&kc->hdr->lock);
+  munmap(kc->hdr, kc->len);
+  free(kc);
+}
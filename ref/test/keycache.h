@@ -0,0 +1,62 @@
+#ifndef KEYCACHE_H
+#define KEYCACHE_H
+
+/* Bounded cache of expanded public keys for the multi-tenant server.
+ *
+ * Clients name their key in a HELLO frame (proto.h); the server reads
+ * <dir>/<key_id>.pk on a miss and keeps the verify_ctx (tr = H(pk), A and
+ * NTT(t1)), so a hit skips both the pk hash and the matrix expansion.
+ *
+ * The table sits in one MAP_SHARED block created before the fork server
+ * starts accepting, so every child shares it. A robust process-shared
+ * mutex guards the index only; keys are read and expanded outside it.
+ * Slots pinned by a live connection are never evicted, the others are
+ * replaced in CLOCK (second chance) order. When every slot is pinned the
+ * key is expanded into the caller's scratch context instead (a bypass).
+ * Slots record the pids loading and pinning them, so a child killed in
+ * the middle leaves no slot loading or pinned for good: its load is
+ * dropped and its pins released by the next process that runs into
+ * them. Waiting for a load is bounded as well; past that, or when a
+ * slot already has as many pins as it can record, the caller bypasses.
+ * A slot records KC_PINNERS (64) pins, so with more concurrent
+ * connections on one hot key than that, the extra connections each
+ * expand the key privately (counted in bypass) until pins are released. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../sign.h"
+
+#define KEYCACHE_MAX_ID 64
+
+typedef struct keycache keycache_t;
+
+typedef struct {
+  uint64_t hits;
+  uint64_t misses;    // key read and expanded (includes bypasses)
+  uint64_t evictions;
+  uint64_t bypass;    // misses that found every slot pinned, or the key's pins full
+  unsigned int slots; // capacity under the memory budget
+  unsigned int used;
+} keycache_stats_t;
+
+/* Room for as many keys as fit in budget_bytes (at least one). Returns
+ * NULL if the shared mapping or the mutex cannot be set up. */
+keycache_t *keycache_create(const char *dir, size_t budget_bytes);
+
+/* 1-64 characters from [A-Za-z0-9._-], not starting with '.' */
+int keycache_valid_id(const char *id, size_t len);
+
+/* Expanded key for key_id, or NULL if the ID is invalid or has no key
+ * file. *slot receives what keycache_release() needs: the pinned slot,
+ * or -1 when the key was expanded into *scratch. */
+const verify_ctx *keycache_acquire(keycache_t *kc, const char *key_id,
+                                   verify_ctx *scratch, int *slot);
+
+void keycache_release(keycache_t *kc, int slot);
+
+/* Counters are read without the lock, so they may be slightly stale */
+void keycache_stats(const keycache_t *kc, keycache_stats_t *st);
+
+void keycache_destroy(keycache_t *kc);
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef LFQUEUE_H
+#define LFQUEUE_H
+
+/* Bounded lock-free multi-producer/multi-consumer queue of pointers
+ * (Vyukov's sequence-numbered ring). Each cell carries a sequence number
+ * that tells producers and consumers whose turn it is, so push and pop
+ * are a single CAS on the fast path and never take a lock. Capacity must
+ * be a power of two. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define LFQ_CACHELINE 64
+
+typedef struct {
+  size_t seq;
+  void *data;
+} lfq_cell;
+
+typedef struct {
+  lfq_cell *cells;
+  size_t mask;
+  char pad0[LFQ_CACHELINE];
+  size_t head; // next position to push
+  char pad1[LFQ_CACHELINE];
+  size_t tail; // next position to pop
+  char pad2[LFQ_CACHELINE];
+} lfqueue;
+
+static inline int lfq_init(lfqueue *q, size_t capacity) {
+  size_t i;
+
+  if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+    return -1;
+  }
+  q->cells = malloc(capacity * sizeof(lfq_cell));
+  if (!q->cells) {
+    return -1;
+  }
+  for (i = 0; i < capacity; ++i) {
+    q->cells[i].seq = i;
+    q->cells[i].data = NULL;
+  }
+  q->mask = capacity - 1;
+  q->head = 0;
+  q->tail = 0;
+  return 0;
+}
+
+static inline void lfq_free(lfqueue *q) {
+  free(q->cells);
+  q->cells = NULL;
+}
+
+/* Returns 0 on success, -1 if the queue is full */
+static inline int lfq_push(lfqueue *q, void *data) {
+  lfq_cell *cell;
+  size_t pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+  size_t seq;
+  intptr_t diff;
+
+  for (;;) {
+    cell = &q->cells[pos & q->mask];
+    seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+    diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&q->head, &pos, pos + 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return -1;
+    } else {
+      pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    }
+  }
+
+  cell->data = data;
+  __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+  return 0;
+}
+
+/* Returns 0 on success, -1 if no published element is available. A
+ * concurrent push may have claimed a slot without publishing it yet, so
+ * callers that know an element is coming should retry. */
+static inline int lfq_pop(lfqueue *q, void **data) {
+  lfq_cell *cell;
+  size_t pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+  size_t seq;
+  intptr_t diff;
+
+  for (;;) {
+    cell = &q->cells[pos & q->mask];
+    seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+    diff = (intptr_t)seq - (intptr_t)(pos + 1);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&q->tail, &pos, pos + 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return -1;
+    } else {
+      pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    }
+  }
+
+  *data = cell->data;
+  __atomic_store_n(&cell->seq, pos + q->mask + 1, __ATOMIC_RELEASE);
+  return 0;
+}
+
+#endif
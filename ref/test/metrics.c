@@ -0,0 +1,367 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "metrics.h"
+
+#define METRICS_REQUEST_MAX 2048
+#define METRICS_POLL_MS 200 // how quickly metrics_stop() is noticed
+
+/* Histogram bucket bounds in seconds; a signature verify is ~50-500 us */
+static const double bucket_le[] = {
+  0.00001, 0.000025, 0.00005, 0.0001, 0.00025, 0.0005,
+  0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5
+};
+
+static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+struct metrics_server {
+  int fd;
+  int stop;
+  char prefix[64];
+  char unix_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+  metrics_collect_fn collect;
+  void *arg;
+  uint64_t t_start;
+  pthread_t thread;
+};
+
+typedef struct {
+  char *data;
+  size_t len;
+  size_t cap;
+} strbuf;
+
+static void sb_printf(strbuf *sb, const char *fmt, ...) {
+  va_list ap;
+  int n;
+
+  for (;;) {
+    va_start(ap, fmt);
+    n = vsnprintf(sb->data + sb->len, sb->cap - sb->len, fmt, ap);
+    va_end(ap);
+    if (n < 0) {
+      return;
+    }
+    if ((size_t)n < sb->cap - sb->len) {
+      sb->len += (size_t)n;
+      return;
+    }
+    size_t cap = sb->cap * 2 + (size_t)n;
+    char *p = realloc(sb->data, cap);
+    if (!p) {
+      return;
+    }
+    sb->data = p;
+    sb->cap = cap;
+  }
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+metrics_slot_t *metrics_slots_shared(unsigned int nslots) {
+  void *p = mmap(NULL, nslots * sizeof(metrics_slot_t), PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  return p == MAP_FAILED ? NULL : p; // anonymous mappings start zeroed
+}
+
+void metrics_slots_collect(metrics_snapshot_t *snap, const metrics_slot_t *slots,
+                           unsigned int nslots, unsigned int nstages) {
+  unsigned int i, j;
+
+  snap->nstages = nstages;
+  for (i = 0; i < nslots; ++i) {
+    snap->connections += __atomic_load_n(&slots[i].connections, __ATOMIC_RELAXED);
+    snap->valid += __atomic_load_n(&slots[i].valid, __ATOMIC_RELAXED);
+    snap->invalid += __atomic_load_n(&slots[i].invalid, __ATOMIC_RELAXED);
+    snap->errors += __atomic_load_n(&slots[i].errors, __ATOMIC_RELAXED);
+    for (j = 0; j < nstages; ++j) {
+      hist_merge(&snap->stage_ns[j], &slots[i].stage_ns[j]);
+    }
+  }
+}
+
+/* Values up to and including the bucket that holds le_ns; within the
+ * histogram's ~3% resolution of an exact "<= le" count */
+static uint64_t hist_count_le(const hist_t *h, uint64_t le_ns) {
+  unsigned int i, last = hist_index(le_ns);
+  uint64_t n = 0;
+
+  for (i = 0; i <= last && i < HIST_BUCKETS; ++i) {
+    n += h->count[i];
+  }
+  return n;
+}
+
+static void format_metrics(strbuf *sb, const struct metrics_server *m,
+                           const metrics_snapshot_t *s) {
+  const char *p = m->prefix;
+  unsigned int i, j;
+
+  sb_printf(sb, "# HELP %s_uptime_seconds Time since the server started.\n"
+                "# TYPE %s_uptime_seconds gauge\n%s_uptime_seconds %.3f\n",
+            p, p, p, (double)(now_ns() - m->t_start) / 1e9);
+  sb_printf(sb, "# HELP %s_connections_total Connections accepted.\n"
+                "# TYPE %s_connections_total counter\n%s_connections_total %llu\n",
+            p, p, p, (unsigned long long)s->connections);
+  sb_printf(sb, "# HELP %s_signatures_total Signatures verified, by result.\n"
+                "# TYPE %s_signatures_total counter\n"
+                "%s_signatures_total{result=\"valid\"} %llu\n"
+                "%s_signatures_total{result=\"invalid\"} %llu\n",
+            p, p, p, (unsigned long long)s->valid, p, (unsigned long long)s->invalid);
+  sb_printf(sb, "# HELP %s_errors_total Connections dropped on I/O or protocol errors.\n"
+                "# TYPE %s_errors_total counter\n%s_errors_total %llu\n",
+            p, p, p, (unsigned long long)s->errors);
+  for (i = 0; i < s->nextra; ++i) {
+    sb_printf(sb, "# HELP %s_%s_total %s\n# TYPE %s_%s_total counter\n%s_%s_total %llu\n",
+              p, s->extra_names[i], s->extra_help[i], p, s->extra_names[i],
+              p, s->extra_names[i], (unsigned long long)s->extra[i]);
+  }
+
+  sb_printf(sb, "# HELP %s_stage_seconds Latency of each request stage.\n"
+                "# TYPE %s_stage_seconds histogram\n", p, p);
+  for (i = 0; i < s->nstages; ++i) {
+    const hist_t *h = &s->stage_ns[i];
+    for (j = 0; j < sizeof(bucket_le) / sizeof(bucket_le[0]); ++j) {
+      sb_printf(sb, "%s_stage_seconds_bucket{stage=\"%s\",le=\"%g\"} %llu\n", p,
+                s->stage_names[i], bucket_le[j],
+                (unsigned long long)hist_count_le(h, (uint64_t)(bucket_le[j] * 1e9)));
+    }
+    sb_printf(sb, "%s_stage_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %llu\n"
+                  "%s_stage_seconds_sum{stage=\"%s\"} %.9f\n"
+                  "%s_stage_seconds_count{stage=\"%s\"} %llu\n",
+              p, s->stage_names[i], (unsigned long long)h->total,
+              p, s->stage_names[i], (double)h->sum / 1e9,
+              p, s->stage_names[i], (unsigned long long)h->total);
+  }
+
+  /* The same data at full histogram resolution, for scrapers that just
+   * want a p99 without histogram_quantile() */
+  sb_printf(sb, "# HELP %s_stage_quantile_seconds Stage latency quantiles since start.\n"
+                "# TYPE %s_stage_quantile_seconds gauge\n", p, p);
+  for (i = 0; i < s->nstages; ++i) {
+    for (j = 0; j < sizeof(quantiles) / sizeof(quantiles[0]); ++j) {
+      sb_printf(sb, "%s_stage_quantile_seconds{stage=\"%s\",quantile=\"%g\"} %.9f\n", p,
+                s->stage_names[i], quantiles[j],
+                (double)hist_quantile(&s->stage_ns[i], quantiles[j]) / 1e9);
+    }
+  }
+}
+
+static int send_all(int fd, const char *buf, size_t len) {
+  while (len > 0) {
+    ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    buf += n;
+    len -= (size_t)n;
+  }
+  return 0;
+}
+
+static void serve_one(struct metrics_server *m, int fd, metrics_snapshot_t *snap, strbuf *body) {
+  char req[METRICS_REQUEST_MAX + 1];
+  char head[256];
+  size_t len = 0;
+  struct timeval tv = {1, 0};
+
+  /* A scrape is a single small GET; don't let a silent peer stall us */
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  while (len < METRICS_REQUEST_MAX) {
+    ssize_t n = recv(fd, req + len, METRICS_REQUEST_MAX - len, 0);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    len += (size_t)n;
+    req[len] = '\0';
+    if (strstr(req, "\r\n\r\n") || strstr(req, "\n\n")) {
+      break;
+    }
+  }
+  req[len] = '\0';
+
+  if (strncmp(req, "GET /metrics", 12) != 0 ||
+      (req[12] != ' ' && req[12] != '?' && req[12] != '\r' && req[12] != '\n')) {
+    static const char not_found[] =
+        "HTTP/1.0 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 17\r\n"
+        "Connection: close\r\n\r\ntry GET /metrics\n";
+    send_all(fd, not_found, sizeof(not_found) - 1);
+    return;
+  }
+
+  memset(snap, 0, sizeof(*snap));
+  m->collect(snap, m->arg);
+  body->len = 0;
+  body->data[0] = '\0';
+  format_metrics(body, m, snap);
+  int n = snprintf(head, sizeof(head),
+                   "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                   "Content-Length: %zu\r\nConnection: close\r\n\r\n", body->len);
+  if (send_all(fd, head, (size_t)n) == 0) {
+    send_all(fd, body->data, body->len);
+  }
+}
+
+static void *metrics_thread(void *arg) {
+  struct metrics_server *m = arg;
+  metrics_snapshot_t *snap = malloc(sizeof(*snap));
+  strbuf body = {malloc(16384), 0, 16384};
+
+  if (!snap || !body.data) {
+    fprintf(stderr, "[METRICS] out of memory\n");
+    free(snap);
+    free(body.data);
+    return NULL;
+  }
+
+  while (!__atomic_load_n(&m->stop, __ATOMIC_ACQUIRE)) {
+    struct pollfd pfd = {m->fd, POLLIN, 0};
+    if (poll(&pfd, 1, METRICS_POLL_MS) <= 0) {
+      continue;
+    }
+    int fd = accept(m->fd, NULL, NULL);
+    if (fd < 0) {
+      continue;
+    }
+    serve_one(m, fd, snap, &body);
+    close(fd);
+  }
+
+  free(snap);
+  free(body.data);
+  return NULL;
+}
+
+static int listen_tcp(const char *spec) {
+  struct sockaddr_in addr;
+  const char *colon = strrchr(spec, ':');
+  char host[INET_ADDRSTRLEN] = "127.0.0.1";
+  unsigned long port;
+  char *end = NULL;
+  int one = 1;
+
+  if (colon) {
+    size_t n = (size_t)(colon - spec);
+    if (n >= sizeof(host)) {
+      return -1;
+    }
+    memcpy(host, spec, n);
+    host[n] = '\0';
+    spec = colon + 1;
+  }
+  port = strtoul(spec, &end, 10);
+  if (!end || *end != '\0' || port == 0 || port > 65535) {
+    return -1;
+  }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((uint16_t)port);
+  if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+    return -1;
+  }
+
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int listen_unix(const char *path) {
+  struct sockaddr_un addr;
+
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  unlink(path); // stale socket from an earlier run
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+metrics_server_t *metrics_start(const char *listen_on, const char *prefix,
+                                metrics_collect_fn collect, void *arg) {
+  struct metrics_server *m = calloc(1, sizeof(*m));
+  int is_unix = strchr(listen_on, '/') != NULL;
+
+  if (!m) {
+    return NULL;
+  }
+  snprintf(m->prefix, sizeof(m->prefix), "%s", prefix);
+  m->collect = collect;
+  m->arg = arg;
+  m->t_start = now_ns();
+  errno = 0;
+  m->fd = is_unix ? listen_unix(listen_on) : listen_tcp(listen_on);
+  if (m->fd < 0) {
+    fprintf(stderr, "[METRICS] cannot listen on %s: %s\n", listen_on,
+            errno ? strerror(errno) : "bad address");
+    free(m);
+    return NULL;
+  }
+  if (is_unix) {
+    snprintf(m->unix_path, sizeof(m->unix_path), "%s", listen_on);
+  }
+  if (pthread_create(&m->thread, NULL, metrics_thread, m) != 0) {
+    close(m->fd);
+    free(m);
+    return NULL;
+  }
+  return m;
+}
+
+void metrics_stop(metrics_server_t *m) {
+  if (!m) {
+    return;
+  }
+  __atomic_store_n(&m->stop, 1, __ATOMIC_RELEASE);
+  pthread_join(m->thread, NULL);
+  close(m->fd);
+  if (m->unix_path[0]) {
+    unlink(m->unix_path);
+  }
+  free(m);
+}
@@ -0,0 +1,72 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+/* Prometheus text endpoint for the demo servers.
+ *
+ * Servers keep their own lock-free counters and hist.h histograms (per
+ * worker thread, or per slot of a shared-memory table for the forking
+ * server). On every scrape the metrics thread calls the server's collect
+ * callback, which merges them into a metrics_snapshot_t, and answers
+ * GET /metrics with counters, one Prometheus histogram per stage and
+ * precomputed p50/p90/p99/p99.9 gauges, all cumulative since start.
+ *
+ * The endpoint is plain HTTP/1.0 on a TCP port (loopback unless an
+ * address is given) or on a Unix socket, e.g.
+ *   curl -s localhost:9100/metrics
+ *   curl -s --unix-socket /tmp/dilithium.sock http://x/metrics */
+
+#include <stdint.h>
+#include "hist.h"
+
+#define METRICS_MAX_STAGES 6
+#define METRICS_MAX_EXTRA 4
+
+typedef struct {
+  uint64_t connections; // accepted
+  uint64_t valid;       // signatures that verified
+  uint64_t invalid;     // signatures that did not
+  uint64_t errors;      // connections dropped on I/O or protocol errors
+  unsigned int nstages;
+  const char *stage_names[METRICS_MAX_STAGES];
+  hist_t stage_ns[METRICS_MAX_STAGES];
+  /* Server-specific counters, exported as <prefix>_<name>_total */
+  unsigned int nextra;
+  const char *extra_names[METRICS_MAX_EXTRA];
+  const char *extra_help[METRICS_MAX_EXTRA];
+  uint64_t extra[METRICS_MAX_EXTRA];
+} metrics_snapshot_t;
+
+/* Fill snap (zeroed by the caller); runs on the metrics thread */
+typedef void (*metrics_collect_fn)(metrics_snapshot_t *snap, void *arg);
+
+/* Counters for one worker, or one slot shared by several processes */
+typedef struct {
+  uint64_t connections;
+  uint64_t valid;
+  uint64_t invalid;
+  uint64_t errors;
+  hist_t stage_ns[METRICS_MAX_STAGES];
+} __attribute__((aligned(64))) metrics_slot_t;
+
+static inline void metrics_inc(uint64_t *c) {
+  __atomic_fetch_add(c, 1, __ATOMIC_RELAXED);
+}
+
+/* nslots zeroed slots in MAP_SHARED memory, visible to forked children */
+metrics_slot_t *metrics_slots_shared(unsigned int nslots);
+
+/* Sum slots into snap; stage names are left to the caller */
+void metrics_slots_collect(metrics_snapshot_t *snap, const metrics_slot_t *slots,
+                           unsigned int nslots, unsigned int nstages);
+
+typedef struct metrics_server metrics_server_t;
+
+/* Serve metrics named <prefix>_* on listen_on: "PORT" (127.0.0.1),
+ * "ADDR:PORT" or a Unix socket path (anything containing '/'). Returns
+ * NULL and prints the reason on failure. */
+metrics_server_t *metrics_start(const char *listen_on, const char *prefix,
+                                metrics_collect_fn collect, void *arg);
+
+void metrics_stop(metrics_server_t *m);
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef PROTO_H
+#define PROTO_H
+
+/* Framed protocol (version 2) for the TCP demo.
+ *
+ * Version 1 is one challenge and one signature per connection, each as a
+ * uint32_be length plus bytes. Version 2 keeps the connection open for
+ * any number of rounds: right after accept the server sends PROTO_MAGIC
+ * (which can never be a valid version 1 challenge length, so clients
+ * detect the version from the first four bytes), after which both sides
+ * exchange frames
+ *
+ *   uint8 type | uint8 flags | uint16_be count | uint32_be request_id |
+ *   uint32_be length | payload[length]
+ *
+ *   CHALLENGE_REQ  c->s  empty; the client picks request_id
+ *   CHALLENGE      s->c  PROTO_CHALLENGE_BYTES fresh random bytes
+ *   SIGNATURE      c->s  signature over the challenge of request_id
+ *   RESULT         s->c  one status byte (PROTO_STATUS_*)
+ *   SIG_BATCH      c->s  count x (uint32_be request_id, uint32_be siglen, sig)
+ *   RESULT_BATCH   s->c  count x (uint32_be request_id, uint8 status)
+ *   ERROR          s->c  protocol violation; the server closes afterwards
+ *   HELLO          c->s  key ID (1-PROTO_MAX_KEY_ID bytes of [A-Za-z0-9._-])
+ *                        whose public key verifies this connection's
+ *                        signatures; answered by a RESULT, and the server
+ *                        closes after PROTO_STATUS_UNKNOWN_KEY
+ *   UPLOAD         c->s  uint32_be mlen | message[mlen] | signature over a
+ *                        message of the client's choosing (the frame length
+ *                        limits it to just under 4 GB); answered by a RESULT
+ *
+ * The server hashes an UPLOAD's message into mu as it comes in rather than
+ * buffering it, so large uploads cost it no memory. PROTO_FLAG_BUFFERED
+ * asks it to receive the whole message before hashing it, the baseline
+ * that test_dilithium_upload measures against.
+ *
+ * HELLO is optional and only allowed as the first frame; without it the
+ * server verifies against its default key. Clients may have up to
+ * PROTO_MAX_OUTSTANDING rounds in flight; request ids of outstanding
+ * rounds must differ modulo that window. */
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROTO_MAGIC 0x444C5032u // "DLP2"
+#define PROTO_HDR_BYTES 12
+#define PROTO_CHALLENGE_BYTES 32
+#define PROTO_MAX_OUTSTANDING 64
+#define PROTO_MAX_BATCH 64
+#define PROTO_BATCH_ENTRY_BYTES(siglen) (8 + (siglen))
+#define PROTO_RESULT_ENTRY_BYTES 5
+#define PROTO_MAX_KEY_ID 64
+
+enum {
+  PROTO_CHALLENGE_REQ = 1,
+  PROTO_CHALLENGE = 2,
+  PROTO_SIGNATURE = 3,
+  PROTO_RESULT = 4,
+  PROTO_SIG_BATCH = 5,
+  PROTO_RESULT_BATCH = 6,
+  PROTO_ERROR = 7,
+  PROTO_HELLO = 8,
+  PROTO_UPLOAD = 9
+};
+
+#define PROTO_FLAG_BUFFERED 0x01 // UPLOAD: hash only once the message is all in
+
+enum {
+  PROTO_STATUS_OK = 0,
+  PROTO_STATUS_INVALID = 1,  // signature did not verify
+  PROTO_STATUS_UNKNOWN = 2,  // no outstanding challenge with that id
+  PROTO_STATUS_UNKNOWN_KEY = 3 // HELLO named a key the server does not have
+};
+
+typedef struct {
+  uint8_t type;
+  uint8_t flags;
+  uint16_t count;
+  uint32_t request_id;
+  uint32_t length;
+} proto_hdr;
+
+static inline void proto_put32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static inline uint32_t proto_get32(const uint8_t *p) {
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static inline void proto_hdr_pack(uint8_t out[PROTO_HDR_BYTES], const proto_hdr *h) {
+  out[0] = h->type;
+  out[1] = h->flags;
+  out[2] = (uint8_t)(h->count >> 8);
+  out[3] = (uint8_t)h->count;
+  proto_put32(out + 4, h->request_id);
+  proto_put32(out + 8, h->length);
+}
+
+static inline void proto_hdr_unpack(proto_hdr *h, const uint8_t in[PROTO_HDR_BYTES]) {
+  h->type = in[0];
+  h->flags = in[1];
+  h->count = (uint16_t)(in[2] << 8 | in[3]);
+  h->request_id = proto_get32(in + 4);
+  h->length = proto_get32(in + 8);
+}
+
+#endif
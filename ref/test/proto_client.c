@@ -0,0 +1,348 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+
+#include "../sign.h"
+#include "proto.h"
+#include "proto_client.h"
+
+#define READ_BUFFER_SIZE 16384
+
+/* Buffered reader: pipelined CHALLENGE/RESULT frames are small and often
+ * arrive together, so read them with as few recv() calls as possible */
+typedef struct {
+    int sock;
+    size_t start;
+    size_t end;
+    uint8_t data[READ_BUFFER_SIZE];
+} reader_t;
+
+typedef struct {
+    uint32_t id;
+    int busy;
+    uint64_t t_start;
+} round_t;
+
+static uint64_t get_time_ns(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static unsigned int env_uint(const char *name, unsigned int def_value,
+                             unsigned int min_value, unsigned int max_value) {
+    const char *val = getenv(name);
+    if (!val || *val == '\0') {
+        return def_value;
+    }
+
+    char *end = NULL;
+    unsigned long parsed = strtoul(val, &end, 10);
+    if (!end || *end != '\0') {
+        return def_value;
+    }
+    if (parsed < min_value) {
+        return min_value;
+    }
+    if (parsed > max_value) {
+        return max_value;
+    }
+    return (unsigned int)parsed;
+}
+
+static int send_all(int sock, const uint8_t *buf, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+        ssize_t sent = send(sock, (const char *)buf + total, len - total, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (sent == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        total += (size_t)sent;
+    }
+    return 0;
+}
+
+static int read_exact(reader_t *rd, uint8_t *out, size_t len) {
+    while (len > 0) {
+        if (rd->start == rd->end) {
+            ssize_t n = recv(rd->sock, rd->data, sizeof(rd->data), 0);
+            if (n == 0) {
+                errno = ECONNRESET;
+                return -1;
+            }
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -1;
+            }
+            rd->start = 0;
+            rd->end = (size_t)n;
+        }
+
+        size_t take = rd->end - rd->start;
+        take = take < len ? take : len;
+        memcpy(out, rd->data + rd->start, take);
+        rd->start += take;
+        out += take;
+        len -= take;
+    }
+    return 0;
+}
+
+void proto_client_config(proto_client_cfg *cfg) {
+    cfg->rounds = env_uint("ROUNDS", 1, 1, UINT_MAX);
+    cfg->pipeline = env_uint("PIPELINE", 1, 1, PROTO_MAX_OUTSTANDING);
+    cfg->batch = env_uint("BATCH_SIGS", 1, 1, PROTO_MAX_BATCH);
+    cfg->signd = NULL;
+    cfg->key_id = getenv("KEY_ID");
+    if (cfg->key_id && *cfg->key_id == '\0') {
+        cfg->key_id = NULL;
+    }
+}
+
+/* Name our key and wait for the server to accept it */
+static int send_hello(int sock, reader_t *rd, const char *key_id) {
+    uint8_t frame[PROTO_HDR_BYTES + PROTO_MAX_KEY_ID];
+    uint8_t reply[PROTO_HDR_BYTES + 1];
+    size_t len = strlen(key_id);
+    proto_hdr h;
+
+    if (len == 0 || len > PROTO_MAX_KEY_ID) {
+        fprintf(stderr, "Key ID must be 1-%d characters\n", PROTO_MAX_KEY_ID);
+        return -1;
+    }
+    h.type = PROTO_HELLO;
+    h.flags = 0;
+    h.count = 0;
+    h.request_id = 0;
+    h.length = (uint32_t)len;
+    proto_hdr_pack(frame, &h);
+    memcpy(frame + PROTO_HDR_BYTES, key_id, len);
+    if (send_all(sock, frame, PROTO_HDR_BYTES + len) < 0) {
+        perror("send() hello failed");
+        return -1;
+    }
+
+    if (read_exact(rd, reply, sizeof(reply)) < 0) {
+        perror("recv() hello reply failed");
+        return -1;
+    }
+    proto_hdr_unpack(&h, reply);
+    if (h.type != PROTO_RESULT || h.length != 1 || reply[PROTO_HDR_BYTES] != PROTO_STATUS_OK) {
+        fprintf(stderr, "Server rejected key ID %s\n", key_id);
+        return -1;
+    }
+    return 0;
+}
+
+static int complete_round(round_t *rounds, uint32_t id, uint8_t status,
+                          proto_client_stats *st) {
+    round_t *r = &rounds[id % PROTO_MAX_OUTSTANDING];
+
+    if (!r->busy || r->id != id) {
+        fprintf(stderr, "Result for unknown request %u\n", id);
+        return -1;
+    }
+    r->busy = 0;
+    if (status == PROTO_STATUS_OK) {
+        st->ok++;
+    } else {
+        st->fail++;
+    }
+    if (st->round_ns) {
+        hist_add(st->round_ns, get_time_ns() - r->t_start);
+    }
+    return 0;
+}
+
+int proto_client_run(int sock, const uint8_t *sk,
+                     const proto_client_cfg *cfg,
+                     proto_client_stats *st) {
+    round_t rounds[PROTO_MAX_OUTSTANDING];
+    uint8_t requests[PROTO_MAX_OUTSTANDING * PROTO_HDR_BYTES];
+    uint8_t hdr_buf[PROTO_HDR_BYTES];
+    uint8_t payload[PROTO_MAX_BATCH * PROTO_RESULT_ENTRY_BYTES];
+    unsigned int batch = cfg->batch > PROTO_MAX_BATCH ? PROTO_MAX_BATCH : cfg->batch;
+    unsigned int pipeline = cfg->pipeline > PROTO_MAX_OUTSTANDING ? PROTO_MAX_OUTSTANDING
+                                                                  : cfg->pipeline;
+    unsigned int requested = 0, challenged = 0, completed = 0, nbatch = 0;
+    uint32_t next_id = 0;
+    proto_hdr h;
+    int ret = -1;
+
+    /* Outgoing frames are built in place behind PROTO_HDR_BYTES of headroom */
+    size_t out_cap = PROTO_HDR_BYTES + (size_t)batch * PROTO_BATCH_ENTRY_BYTES(CRYPTO_BYTES);
+    size_t out_len = PROTO_HDR_BYTES;
+    uint8_t *out = malloc(out_cap);
+    reader_t *rd = malloc(sizeof(reader_t));
+    if (!out || !rd) {
+        free(out);
+        free(rd);
+        return -1;
+    }
+    rd->sock = sock;
+    rd->start = rd->end = 0;
+
+    /* Small request frames must not wait for the ACK of a large batch */
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    memset(rounds, 0, sizeof(rounds));
+    if (pipeline == 0) {
+        pipeline = 1;
+    }
+    if (batch == 0) {
+        batch = 1;
+    }
+    if (cfg->key_id && send_hello(sock, rd, cfg->key_id) < 0) {
+        goto out;
+    }
+
+    while (completed < cfg->rounds) {
+        /* Keep the pipeline full, all new requests in one send */
+        size_t nreq = 0;
+        while (requested < cfg->rounds && requested - completed < pipeline) {
+            round_t *r = &rounds[next_id % PROTO_MAX_OUTSTANDING];
+            if (r->busy) {
+                break; // an older round still holds this slot
+            }
+            r->id = next_id;
+            r->busy = 1;
+            r->t_start = get_time_ns();
+
+            h.type = PROTO_CHALLENGE_REQ;
+            h.flags = 0;
+            h.count = 0;
+            h.request_id = next_id;
+            h.length = 0;
+            proto_hdr_pack(requests + nreq * PROTO_HDR_BYTES, &h);
+            nreq++;
+            next_id++;
+            requested++;
+        }
+        if (nreq > 0 && send_all(sock, requests, nreq * PROTO_HDR_BYTES) < 0) {
+            perror("send() challenge request failed");
+            goto out;
+        }
+
+        if (read_exact(rd, hdr_buf, sizeof(hdr_buf)) < 0) {
+            perror("recv() frame failed");
+            goto out;
+        }
+        proto_hdr_unpack(&h, hdr_buf);
+        if (h.length > sizeof(payload) || read_exact(rd, payload, h.length) < 0) {
+            fprintf(stderr, "Bad frame (type %u, %u bytes)\n", h.type, h.length);
+            goto out;
+        }
+
+        switch (h.type) {
+            case PROTO_CHALLENGE: {
+                round_t *r = &rounds[h.request_id % PROTO_MAX_OUTSTANDING];
+                uint8_t *entry = out + out_len;
+                uint8_t *sig = batch > 1 ? entry + 8 : entry;
+                size_t sig_len = 0;
+                uint64_t t0;
+
+                if (!r->busy || r->id != h.request_id) {
+                    fprintf(stderr, "Challenge for unknown request %u\n", h.request_id);
+                    goto out;
+                }
+                challenged++;
+
+                t0 = get_time_ns();
+                if ((cfg->signd ? signd_sign(cfg->signd, sig, &sig_len, payload, h.length)
+                                : crypto_sign_signature(sig, &sig_len, payload, h.length, NULL, 0, sk)) != 0) {
+                    fprintf(stderr, "Signature failed\n");
+                    goto out;
+                }
+                if (st->sign_ns) {
+                    hist_add(st->sign_ns, get_time_ns() - t0);
+                }
+
+                if (batch == 1) {
+                    h.type = PROTO_SIGNATURE;
+                    h.length = (uint32_t)sig_len;
+                    proto_hdr_pack(out, &h);
+                    if (send_all(sock, out, PROTO_HDR_BYTES + sig_len) < 0) {
+                        perror("send() signature failed");
+                        goto out;
+                    }
+                    break;
+                }
+
+                proto_put32(entry, h.request_id);
+                proto_put32(entry + 4, (uint32_t)sig_len);
+                out_len += PROTO_BATCH_ENTRY_BYTES(sig_len);
+                nbatch++;
+                /* Flush when full or when no further challenge is on its way */
+                if (nbatch == batch || challenged == requested) {
+                    h.type = PROTO_SIG_BATCH;
+                    h.count = (uint16_t)nbatch;
+                    h.request_id = 0;
+                    h.length = (uint32_t)(out_len - PROTO_HDR_BYTES);
+                    proto_hdr_pack(out, &h);
+                    if (send_all(sock, out, out_len) < 0) {
+                        perror("send() signature batch failed");
+                        goto out;
+                    }
+                    out_len = PROTO_HDR_BYTES;
+                    nbatch = 0;
+                }
+                break;
+            }
+
+            case PROTO_RESULT:
+                if (h.length < 1 || complete_round(rounds, h.request_id, payload[0], st) < 0) {
+                    goto out;
+                }
+                completed++;
+                break;
+
+            case PROTO_RESULT_BATCH: {
+                unsigned int i;
+                if ((size_t)h.count * PROTO_RESULT_ENTRY_BYTES != h.length) {
+                    fprintf(stderr, "Malformed result batch\n");
+                    goto out;
+                }
+                for (i = 0; i < h.count; ++i) {
+                    const uint8_t *e = payload + i * PROTO_RESULT_ENTRY_BYTES;
+                    if (complete_round(rounds, proto_get32(e), e[4], st) < 0) {
+                        goto out;
+                    }
+                    completed++;
+                }
+                break;
+            }
+
+            default:
+                fprintf(stderr, "Server sent frame type %u, giving up\n", h.type);
+                goto out;
+        }
+    }
+    ret = 0;
+
+out:
+    free(out);
+    free(rd);
+    return ret;
+}
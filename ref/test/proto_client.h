@@ -0,0 +1,38 @@
+#ifndef PROTO_CLIENT_H
+#define PROTO_CLIENT_H
+
+/* Client side of the version 2 protocol (proto.h), shared by
+ * test_dilithium_client and test_dilithium_stress. */
+
+#include <stdint.h>
+#include "hist.h"
+#include "signd_client.h"
+
+typedef struct {
+    unsigned int rounds;   /* challenge/signature rounds on the connection */
+    unsigned int pipeline; /* rounds in flight, at most PROTO_MAX_OUTSTANDING */
+    unsigned int batch;    /* signatures per SIG_BATCH frame, 1 = SIGNATURE frames */
+    const char *key_id;    /* sent in a HELLO frame first; NULL: server's default key */
+    signd_client *signd;   /* sign through the signing daemon instead of with sk */
+} proto_client_cfg;
+
+typedef struct {
+    unsigned int ok;
+    unsigned int fail;
+    hist_t *sign_ns;  /* optional: crypto_sign_signature per round */
+    hist_t *round_ns; /* optional: CHALLENGE_REQ sent to result received */
+} proto_client_stats;
+
+/* ROUNDS (default 1), PIPELINE (default 1), BATCH_SIGS (default 1) and
+ * KEY_ID (default unset) from the environment, clamped to what the
+ * protocol allows; signd is left NULL for the caller to fill in */
+void proto_client_config(proto_client_cfg *cfg);
+
+/* Run cfg->rounds rounds on sock, after the server's PROTO_MAGIC has been
+ * read; sk may be NULL when cfg->signd is set. Returns 0 once every round has a result (valid or not), -1 on I/O
+ * or protocol errors. */
+int proto_client_run(int sock, const uint8_t *sk,
+                     const proto_client_cfg *cfg,
+                     proto_client_stats *st);
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef SIGND_H
+#define SIGND_H
+
+/* Wire formats of the local signing daemon (test_dilithium_signd).
+ *
+ * The daemon loads one secret key at startup, expands it once
+ * (crypto_sign_key_expand) and signs for other processes on the same
+ * host, so callers neither read the key file nor pay for unpacking it and
+ * expanding the matrix on every signature.
+ *
+ * Unix socket: proto.h frame headers, any number of requests in flight
+ *
+ *   SIGND_SIGN       c->d  message (at most SIGND_MAX_MSG bytes); the
+ *                          client picks request_id
+ *   SIGND_SIGNATURE  d->c  signature for request_id
+ *   SIGND_ERROR      d->c  request_id could not be signed (message too
+ *                          long); the daemon closes afterwards
+ *
+ * Shared memory (SIGND_SHM): a table of slots in a POSIX shared memory
+ * object. A caller claims a free slot, writes the message, marks it
+ * SIGND_SLOT_REQUEST and rings the doorbell; a daemon thread hands
+ * requested slots to the signing workers, which write the signature and
+ * mark the slot SIGND_SLOT_DONE. Both sides spin briefly before sleeping
+ * on a futex, so an idle daemon costs nothing and a busy one answers
+ * without a system call on either side. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../params.h"
+#include "proto.h"
+
+#define SIGND_SOCKET "signd.sock"
+#define SIGND_MAX_MSG 65536
+
+enum {
+  SIGND_SIGN = 1,
+  SIGND_SIGNATURE = 2,
+  SIGND_ERROR = 3
+};
+
+#define SIGND_SHM_MAGIC 0x5349474Eu // "SIGN"
+#define SIGND_SHM_MSG_MAX 8192
+#define SIGND_SHM_SLOTS 64
+
+enum {
+  SIGND_SLOT_FREE,
+  SIGND_SLOT_CLAIMED, // a caller is writing the message
+  SIGND_SLOT_REQUEST, // waiting for the daemon
+  SIGND_SLOT_BUSY,    // queued or being signed
+  SIGND_SLOT_DONE     // signature ready for the caller
+};
+
+typedef struct {
+  uint32_t state;   // SIGND_SLOT_*, also the futex the caller sleeps on
+  uint32_t waiting; // the caller is (about to be) asleep on state
+  uint32_t mlen;
+  uint32_t siglen;  // 0: the daemon could not sign
+  uint8_t msg[SIGND_SHM_MSG_MAX];
+  uint8_t sig[CRYPTO_BYTES];
+} __attribute__((aligned(64))) signd_slot;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t sig_bytes; // CRYPTO_BYTES, so callers built for another mode refuse it
+  uint32_t nslots;
+  uint32_t doorbell __attribute__((aligned(64))); // bumped per request, futex word
+  uint32_t sleeping; // the daemon is (about to be) waiting on the doorbell
+  signd_slot slots[];
+} signd_shm;
+
+/* Busy-wait hint for the spinning phase */
+static inline void signd_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+static inline size_t signd_shm_size(uint32_t nslots) {
+  return sizeof(signd_shm) + (size_t)nslots * sizeof(signd_slot);
+}
+
+#endif
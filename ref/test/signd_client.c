@@ -0,0 +1,268 @@
+#define _GNU_SOURCE
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <unistd.h>
+
+#include "../params.h"
+#include "signd.h"
+#include "signd_client.h"
+
+#define SHM_PREFIX "shm:"
+#define SPIN_LOOPS 20000 /* polls of a slot before sleeping on it */
+
+struct signd_client {
+    int sock;           /* -1 in shared memory mode */
+    uint32_t next_id;
+    signd_shm *shm;
+    size_t shm_len;
+    unsigned int spin;  /* SPIN_LOOPS, or 0 on one CPU where spinning only delays the daemon */
+};
+
+static void futex_wait(uint32_t *addr, uint32_t val) {
+    syscall(SYS_futex, addr, FUTEX_WAIT, val, NULL, NULL, 0);
+}
+
+static void futex_wake(uint32_t *addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+static int send_all(int sock, const uint8_t *buf, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+        ssize_t sent = send(sock, (const char *)buf + total, len - total, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (sent == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        total += (size_t)sent;
+    }
+    return 0;
+}
+
+static int recv_all(int sock, uint8_t *buf, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+        ssize_t recvd = recv(sock, (char *)buf + total, len - total, 0);
+        if (recvd == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        if (recvd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        total += (size_t)recvd;
+    }
+    return 0;
+}
+
+static int open_shm(signd_client *c, const char *name) {
+    struct stat st;
+    int fd = shm_open(name, O_RDWR, 0);
+
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open shared memory %s: %s\n", name, strerror(errno));
+        return -1;
+    }
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(signd_shm)) {
+        fprintf(stderr, "%s is not a signing daemon table\n", name);
+        close(fd);
+        return -1;
+    }
+    c->shm_len = (size_t)st.st_size;
+    c->spin = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SPIN_LOOPS : 0;
+    c->shm = mmap(NULL, c->shm_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (c->shm == MAP_FAILED) {
+        perror("mmap() failed");
+        c->shm = NULL;
+        return -1;
+    }
+    if (c->shm->magic != SIGND_SHM_MAGIC || c->shm->sig_bytes != CRYPTO_BYTES ||
+        c->shm->nslots == 0 || signd_shm_size(c->shm->nslots) > c->shm_len) {
+        fprintf(stderr, "%s belongs to a daemon for another parameter set\n", name);
+        munmap(c->shm, c->shm_len);
+        c->shm = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+signd_client *signd_open(const char *where) {
+    struct sockaddr_un addr;
+    signd_client *c = calloc(1, sizeof(*c));
+
+    if (!c) {
+        return NULL;
+    }
+    c->sock = -1;
+    if (strncmp(where, SHM_PREFIX, strlen(SHM_PREFIX)) == 0) {
+        if (open_shm(c, where + strlen(SHM_PREFIX)) < 0) {
+            free(c);
+            return NULL;
+        }
+        return c;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(where) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", where);
+        free(c);
+        return NULL;
+    }
+    strcpy(addr.sun_path, where);
+    c->sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (c->sock < 0 || connect(c->sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "Cannot connect to signing daemon at %s: %s\n", where, strerror(errno));
+        if (c->sock >= 0) {
+            close(c->sock);
+        }
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+static int sign_socket(signd_client *c, uint8_t *sig, size_t *siglen,
+                       const uint8_t *m, size_t mlen) {
+    uint8_t hdr[PROTO_HDR_BYTES];
+    proto_hdr h;
+    uint32_t id = c->next_id++;
+
+    if (mlen > SIGND_MAX_MSG) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    h.type = SIGND_SIGN;
+    h.flags = 0;
+    h.count = 0;
+    h.request_id = id;
+    h.length = (uint32_t)mlen;
+    proto_hdr_pack(hdr, &h);
+    if (send_all(c->sock, hdr, sizeof(hdr)) < 0 || send_all(c->sock, m, mlen) < 0) {
+        return -1;
+    }
+
+    if (recv_all(c->sock, hdr, sizeof(hdr)) < 0) {
+        return -1;
+    }
+    proto_hdr_unpack(&h, hdr);
+    if (h.type != SIGND_SIGNATURE || h.request_id != id || h.length > CRYPTO_BYTES) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (recv_all(c->sock, sig, h.length) < 0) {
+        return -1;
+    }
+    *siglen = h.length;
+    return 0;
+}
+
+static signd_slot *claim_slot(signd_shm *s) {
+    static __thread uint32_t hint;
+    uint32_t i, n = s->nslots;
+
+    if (hint == 0) {
+        hint = (uint32_t)((uintptr_t)&hint >> 6) | 1; /* spread threads over the table */
+    }
+    for (;;) {
+        for (i = 0; i < n; ++i) {
+            signd_slot *slot = &s->slots[(hint + i) % n];
+            uint32_t expect = SIGND_SLOT_FREE;
+            if (__atomic_load_n(&slot->state, __ATOMIC_RELAXED) == SIGND_SLOT_FREE &&
+                __atomic_compare_exchange_n(&slot->state, &expect, SIGND_SLOT_CLAIMED, 0,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                hint = (hint + i) % n;
+                return slot;
+            }
+        }
+        sched_yield(); /* every slot in use */
+    }
+}
+
+static int sign_shm(signd_client *c, uint8_t *sig, size_t *siglen,
+                    const uint8_t *m, size_t mlen) {
+    signd_shm *s = c->shm;
+    signd_slot *slot;
+    uint32_t state;
+    unsigned int spin;
+    int rc = 0;
+
+    if (mlen > SIGND_SHM_MSG_MAX) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    slot = claim_slot(s);
+    memcpy(slot->msg, m, mlen);
+    slot->mlen = (uint32_t)mlen;
+    __atomic_store_n(&slot->state, SIGND_SLOT_REQUEST, __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&s->doorbell, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&s->sleeping, __ATOMIC_SEQ_CST)) {
+        futex_wake(&s->doorbell);
+    }
+
+    /* Signing takes long enough that a short spin usually ends in a sleep,
+     * but under load the daemon is often done by then */
+    for (spin = 0; spin < c->spin; ++spin) {
+        if (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) == SIGND_SLOT_DONE) {
+            break;
+        }
+        signd_relax();
+    }
+    __atomic_store_n(&slot->waiting, 1, __ATOMIC_SEQ_CST);
+    while ((state = __atomic_load_n(&slot->state, __ATOMIC_SEQ_CST)) != SIGND_SLOT_DONE) {
+        futex_wait(&slot->state, state);
+    }
+    __atomic_store_n(&slot->waiting, 0, __ATOMIC_RELAXED);
+
+    if (slot->siglen == 0 || slot->siglen > CRYPTO_BYTES) {
+        errno = EPROTO;
+        rc = -1;
+    } else {
+        memcpy(sig, slot->sig, slot->siglen);
+        *siglen = slot->siglen;
+    }
+    __atomic_store_n(&slot->state, SIGND_SLOT_FREE, __ATOMIC_RELEASE);
+    return rc;
+}
+
+int signd_sign(signd_client *c, uint8_t *sig, size_t *siglen,
+               const uint8_t *m, size_t mlen) {
+    return c->shm ? sign_shm(c, sig, siglen, m, mlen) : sign_socket(c, sig, siglen, m, mlen);
+}
+
+void signd_close(signd_client *c) {
+    if (!c) {
+        return;
+    }
+    if (c->shm) {
+        munmap(c->shm, c->shm_len);
+    }
+    if (c->sock >= 0) {
+        close(c->sock);
+    }
+    free(c);
+}
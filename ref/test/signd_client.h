@@ -0,0 +1,26 @@
+#ifndef SIGND_CLIENT_H
+#define SIGND_CLIENT_H
+
+/* Caller side of the signing daemon (signd.h), shared by
+ * test_dilithium_client and test_dilithium_stress when SIGND is set. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct signd_client signd_client;
+
+/* where is the daemon's Unix socket path, or "shm:" followed by the name
+ * of its shared memory object. Returns NULL and prints the reason on
+ * failure. A socket client carries one request at a time, so give every
+ * thread its own; a shared memory client may be used by any number of
+ * threads at once. */
+signd_client *signd_open(const char *where);
+
+/* Like crypto_sign_signature(sig, siglen, m, mlen, NULL, 0, sk) with the
+ * daemon's key. Returns 0 on success, -1 on error. */
+int signd_sign(signd_client *c, uint8_t *sig, size_t *siglen,
+               const uint8_t *m, size_t mlen);
+
+void signd_close(signd_client *c);
+
+#endif
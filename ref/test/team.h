@@ -0,0 +1,146 @@
+#ifndef TEAM_H
+#define TEAM_H
+
+/* Thread team for the library's sign_team interface (sign.h): width - 1
+ * helper threads and the thread calling run() take the calls of each run()
+ * one at a time (there are only a few, each a sizeable piece of work).
+ * Helpers poll for the next run for a short while before sleeping on a
+ * condition variable, so the rounds of one operation follow each other
+ * without a wakeup, while an idle team costs nothing. One run() at a time
+ * per team. */
+
+#include <pthread.h>
+#include <sched.h>
+#include "../sign.h"
+
+#define TEAM_MAX_WIDTH 64
+#define TEAM_SPIN 4000 // polls of the run counter before sleeping
+
+typedef struct {
+  sign_team team;
+  pthread_t tid[TEAM_MAX_WIDTH];
+  unsigned int helpers;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  int stop;
+  unsigned int gen; // bumped by every run()
+  // the current run, under lock except done
+  void (*fn)(void *arg, unsigned int i);
+  void *arg;
+  unsigned int n;
+  unsigned int next; // next call to hand out
+  unsigned int done; // calls finished
+} team_t;
+
+static inline void team_work(team_t *t) {
+  void (*fn)(void *arg, unsigned int i);
+  void *arg;
+  unsigned int i;
+
+  for (;;) {
+    pthread_mutex_lock(&t->lock);
+    if (t->next >= t->n) {
+      pthread_mutex_unlock(&t->lock);
+      return;
+    }
+    i = t->next++;
+    fn = t->fn;
+    arg = t->arg;
+    pthread_mutex_unlock(&t->lock);
+    fn(arg, i);
+    __atomic_fetch_add(&t->done, 1, __ATOMIC_RELEASE);
+  }
+}
+
+static inline void *team_helper(void *p) {
+  team_t *t = p;
+  unsigned int seen = 0, spin;
+
+  for (;;) {
+    for (spin = 0; spin < TEAM_SPIN; ++spin) {
+      if (__atomic_load_n(&t->gen, __ATOMIC_ACQUIRE) != seen) {
+        break;
+      }
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    }
+    pthread_mutex_lock(&t->lock);
+    while (__atomic_load_n(&t->gen, __ATOMIC_ACQUIRE) == seen && !t->stop) {
+      pthread_cond_wait(&t->wake, &t->lock);
+    }
+    pthread_mutex_unlock(&t->lock);
+    if (t->stop) {
+      return NULL;
+    }
+    seen = __atomic_load_n(&t->gen, __ATOMIC_ACQUIRE);
+    team_work(t);
+  }
+}
+
+static inline void team_run(const sign_team *team, void (*fn)(void *arg, unsigned int i),
+                            void *arg, unsigned int n) {
+  team_t *t = team->priv;
+
+  pthread_mutex_lock(&t->lock);
+  t->fn = fn;
+  t->arg = arg;
+  t->n = n;
+  t->next = 0;
+  __atomic_store_n(&t->done, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&t->gen, t->gen + 1, __ATOMIC_RELEASE);
+  pthread_cond_broadcast(&t->wake);
+  pthread_mutex_unlock(&t->lock);
+
+  team_work(t);
+  while (__atomic_load_n(&t->done, __ATOMIC_ACQUIRE) < n) {
+    sched_yield();
+  }
+}
+
+/* width counts the calling thread; 1 makes a team that runs everything
+ * on the caller. Returns 0, or -1 if no helper could be started. */
+static inline int team_init(team_t *t, unsigned int width) {
+  unsigned int i;
+
+  if (width < 1) {
+    width = 1;
+  }
+  if (width > TEAM_MAX_WIDTH) {
+    width = TEAM_MAX_WIDTH;
+  }
+  pthread_mutex_init(&t->lock, NULL);
+  pthread_cond_init(&t->wake, NULL);
+  t->stop = 0;
+  t->gen = 0;
+  t->n = 0;
+  t->next = 0;
+  t->done = 0;
+  t->helpers = 0;
+  for (i = 1; i < width; ++i) {
+    if (pthread_create(&t->tid[t->helpers], NULL, team_helper, t) != 0) {
+      break;
+    }
+    ++t->helpers;
+  }
+  t->team.width = t->helpers + 1;
+  t->team.run = team_run;
+  t->team.priv = t;
+  return width > 1 && t->helpers == 0 ? -1 : 0;
+}
+
+static inline void team_destroy(team_t *t) {
+  unsigned int i;
+
+  pthread_mutex_lock(&t->lock);
+  t->stop = 1;
+  pthread_cond_broadcast(&t->wake);
+  pthread_mutex_unlock(&t->lock);
+  for (i = 0; i < t->helpers; ++i) {
+    pthread_join(t->tid[i], NULL);
+  }
+  pthread_cond_destroy(&t->wake);
+  pthread_mutex_destroy(&t->lock);
+}
+
+#endif
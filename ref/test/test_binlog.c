@@ -0,0 +1,110 @@
+/* Recovery of binlog rings from producers that stop between claiming a
+ * slot and publishing it. Includes binlog.c to reach the ring internals,
+ * which is how such a producer is simulated. */
+#include "binlog.c"
+
+#include <sys/wait.h>
+
+#define TEST_LOG "test_binlog.dlog"
+#define TEST_CAP 4
+
+static int check(int cond, const char *what) {
+  if (!cond) {
+    printf("ERROR: %s\n", what);
+  }
+  return !cond;
+}
+
+static int push(binlog_ring_t *ring, unsigned int n) {
+  binlog_rec_t rec;
+  unsigned int i;
+  int fails = 0;
+
+  memset(&rec, 0, sizeof(rec));
+  for (i = 0; i < n; ++i) {
+    rec.rounds = i;
+    fails += binlog_push(ring, &rec) != 0;
+  }
+  return fails;
+}
+
+/* A pid that is certainly gone: a child that has exited and been reaped */
+static pid_t dead_pid(void) {
+  pid_t pid = fork();
+  if (pid == 0) {
+    _exit(0);
+  }
+  waitpid(pid, NULL, 0);
+  return pid;
+}
+
+/* Until the writer has caught up with every published record */
+static void wait_drained(binlog_ring_t *ring) {
+  struct timespec ts = {0, BINLOG_IDLE_NS};
+  while (__atomic_load_n(&ring->tail, __ATOMIC_RELAXED) != __atomic_load_n(&ring->head, __ATOMIC_RELAXED)) {
+    nanosleep(&ts, NULL);
+  }
+}
+
+static void wait_stall(void) {
+  struct timespec ts = {BINLOG_STALL_NS / 1000000000 + 1, 0};
+  nanosleep(&ts, NULL);
+}
+
+int main(void) {
+  binlog_t *log;
+  binlog_ring_t *ring;
+  binlog_slot *slot;
+  struct stat st;
+  uint64_t dropped;
+  size_t pos, written = 0;
+  int err = 0;
+
+  unlink(TEST_LOG);
+  log = binlog_open(TEST_LOG, 1, TEST_CAP, 1);
+  if (!log) {
+    printf("ERROR: binlog_open\n");
+    return 1;
+  }
+  ring = binlog_ring(log, 0);
+
+  /* Producer died after claiming slot 0, before marking it */
+  __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+  err |= check(push(ring, TEST_CAP - 1) == 0, "push behind a claimed slot");
+  wait_stall();
+  err |= check(__atomic_load_n(&ring->dropped, __ATOMIC_RELAXED) == 1, "claimed slot not skipped");
+  err |= check(push(ring, TEST_CAP) == 0, "push after skipping a claimed slot");
+  written += 2 * TEST_CAP - 1;
+
+  /* Producer died while copying its record into the slot */
+  wait_drained(ring);
+  pos = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+  slot = &ring->slots[pos & ring->mask];
+  __atomic_store_n(&slot->seq, BINLOG_BUSY | (size_t)dead_pid(), __ATOMIC_RELEASE);
+  wait_stall();
+  err |= check(__atomic_load_n(&ring->dropped, __ATOMIC_RELAXED) == 2, "dead writer's slot not skipped");
+
+  /* A live producer that is slow to copy is waited for, not overwritten */
+  wait_drained(ring);
+  pos = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+  slot = &ring->slots[pos & ring->mask];
+  __atomic_store_n(&slot->seq, BINLOG_BUSY | (size_t)getpid(), __ATOMIC_RELEASE);
+  wait_stall();
+  err |= check(__atomic_load_n(&ring->dropped, __ATOMIC_RELAXED) == 2, "live writer's slot skipped");
+  err |= check(push(ring, TEST_CAP) == 1, "ring behind a live writer not full");
+  memset(&slot->rec, 0, sizeof(slot->rec));
+  __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+  written += TEST_CAP;
+
+  dropped = binlog_close(log);
+  err |= check(dropped == 3, "wrong number of dropped records");
+  err |= check(stat(TEST_LOG, &st) == 0 &&
+               st.st_size == (off_t)(sizeof(binlog_file_hdr) + written * sizeof(binlog_rec_t)),
+               "wrong number of records written");
+  unlink(TEST_LOG);
+
+  if (!err) {
+    printf("binlog recovery OK\n");
+  }
+  return err;
+}
@@ -0,0 +1,572 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "../randombytes.h"
+#include "../sign.h"
+#include "../poly.h"
+
+#define MLEN 1200 // limit input for testing
+#define NTESTS 1 // test count
+#define BATCH 7 // signatures in batch verification test
+#define STREAM_MLEN 10000 // message length in streaming test
+
+void run_test(const uint8_t *m, size_t mlen, int test_idx) 
+{
+  // KeyGen
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  crypto_sign_keypair(pk, sk);
+
+  /*
+  fprintf(fout, "Test #%d\n", test_idx+1);
+  fprintf(fout, "KeyGen Stage:\n- Input: None\n- Output:\n");
+  fprintf(fout, "* Public Key: ");
+  for (int i = 0; i < CRYPTO_PUBLICKEYBYTES; i++) fprintf(fout, "%02x", pk[i]);
+  fprintf(fout, "\n* Secret Key: ");
+  for (int i = 0; i < CRYPTO_SECRETKEYBYTES; i++) fprintf(fout, "%02x", sk[i]);
+  fprintf(fout, "\n\n");
+  */
+
+  // Signing (NIST API)
+  uint8_t sm[MLEN + CRYPTO_BYTES];
+  size_t smlen = 0;
+  crypto_sign(sm, &smlen, m, mlen, NULL, 0, sk);
+
+  /*
+  fprintf(fout, "Signing Stage (NIST API):\n- Input: input.txt, sk\n- Output:\n");
+  fprintf(fout, "* Signed Message: ");
+  for (size_t i = 0; i < smlen; i++) fprintf(fout, "%02x", sm[i]);
+  fprintf(fout, "\n\n");
+  */
+
+  // Open/Verify (NIST API)
+  uint8_t m2[MLEN + CRYPTO_BYTES] = {0};
+  size_t m2len = 0;
+  int valid = crypto_sign_open(m2, &m2len, sm, smlen, NULL, 0, pk);
+  /*
+  fprintf(fout, "Verifying Stage (NIST API):\n- Input: signed message, pk\n- Output: %s\n", valid == 0 ? "Valid" : "Invalid");
+  if (!valid) {
+    fprintf(fout, "* Opened Message: ");
+    for (size_t i = 0; i < m2len; i++) fprintf(fout, "%02x", m2[i]);
+    fprintf(fout, "\n");
+  }
+  fprintf(fout, "\n");
+  */
+ 
+  (void)valid;
+  (void)test_idx;
+}
+
+static int test_key_ctx(const uint8_t *m, size_t mlen)
+{
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t sig[CRYPTO_BYTES];
+  uint8_t mu[CRHBYTES], mu_pk[CRHBYTES];
+  size_t siglen = 0;
+  static sign_ctx sctx;
+  static verify_ctx vctx;
+  int i;
+
+  crypto_sign_keypair(pk, sk);
+  crypto_sign_key_expand(&sctx, sk);
+  crypto_sign_pk_expand(&vctx, pk);
+
+  // mu memoised from the expanded key equals the one hashed from pk
+  crypto_sign_mu_ctx(mu, m, mlen, NULL, 0, &vctx);
+  crypto_sign_mu(mu_pk, m, mlen, NULL, 0, pk);
+  if (memcmp(mu, mu_pk, CRHBYTES)) {
+    printf("ERROR: mu from expanded key differs\n");
+    return 1;
+  }
+
+  // Several signatures under one expanded key must all verify
+  for (i = 0; i < 4; ++i) {
+    crypto_sign_signature_ctx(sig, &siglen, m, mlen, NULL, 0, &sctx);
+    if (siglen != CRYPTO_BYTES || crypto_sign_verify(sig, siglen, m, mlen, NULL, 0, pk)) {
+      printf("ERROR: signature from expanded key did not verify\n");
+      return 1;
+    }
+    if (crypto_sign_verify_ctx(sig, siglen, m, mlen, NULL, 0, &vctx)) {
+      printf("ERROR: expanded public key rejected valid signature\n");
+      return 1;
+    }
+    if (crypto_sign_verify_ctx_mu(sig, siglen, mu, &vctx)) {
+      printf("ERROR: memoised mu rejected valid signature\n");
+      return 1;
+    }
+  }
+
+  sig[CTILDEBYTES] ^= 1;
+  if (!crypto_sign_verify_ctx(sig, siglen, m, mlen, NULL, 0, &vctx) ||
+      !crypto_sign_verify_ctx_mu(sig, siglen, mu, &vctx)) {
+    printf("ERROR: expanded public key accepted forged signature\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+static int test_commit(const uint8_t *m, size_t mlen)
+{
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t sig[CRYPTO_BYTES];
+  uint8_t sig2[CRYPTO_BYTES];
+  uint8_t mu[CRHBYTES];
+  const uint8_t pre[2] = {0, 0};
+  size_t siglen = 0, siglen2;
+  static sign_ctx sctx;
+  static sign_commitment cm, zero;
+  int i, tries;
+
+  crypto_sign_keypair(pk, sk);
+  crypto_sign_key_expand(&sctx, sk);
+  crypto_sign_mu_internal(mu, m, mlen, pre, sizeof(pre), &sctx);
+
+  // Online signing consumes commitments until one is accepted
+  for (i = 0; i < 4; ++i) {
+    for (tries = 0; tries < 1000; ++tries) {
+      crypto_sign_commit(&cm, &sctx);
+      int rc = crypto_sign_signature_commit(sig, &siglen, mu, &cm, &sctx);
+      if (memcmp(&cm, &zero, sizeof(cm))) {
+        printf("ERROR: commitment not wiped after use\n");
+        return 1;
+      }
+      if (rc == 0)
+        break;
+    }
+    if (tries == 1000 || siglen != CRYPTO_BYTES ||
+        crypto_sign_verify(sig, siglen, m, mlen, NULL, 0, pk)) {
+      printf("ERROR: offline/online signature did not verify\n");
+      return 1;
+    }
+
+    // A used commitment is refused and leaves the output alone
+    memcpy(sig2, sig, CRYPTO_BYTES);
+    siglen2 = 0;
+    if (crypto_sign_signature_commit(sig2, &siglen2, mu, &cm, &sctx) != -1 ||
+        siglen2 != 0 || memcmp(sig2, sig, CRYPTO_BYTES)) {
+      printf("ERROR: commitment used twice\n");
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+// Runs the calls last to first to stand in for a thread team
+static void reversed_run(const sign_team *team, void (*fn)(void *arg, unsigned int i),
+                          void *arg, unsigned int n)
+{
+  unsigned int i;
+  (void)team;
+  for (i = 0; i < n; ++i)
+    fn(arg, n - 1 - i);
+}
+
+static int test_spec(const uint8_t *m, size_t mlen)
+{
+  uint8_t sk[CRYPTO_SECRETKEYBYTES], pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sig[CRYPTO_BYTES], sig_spec[CRYPTO_BYTES];
+  uint8_t mu[CRHBYTES], rnd[RNDBYTES];
+  const uint8_t pre[2] = {0, 0};
+  size_t siglen = 0, siglen_spec = 0;
+  static sign_ctx sctx;
+  sign_team team = {4, reversed_run, NULL};
+  int i;
+
+  crypto_sign_keypair(pk, sk);
+  crypto_sign_key_expand(&sctx, sk);
+
+  // Same signature as the sequential loop, whatever the team width
+  for (i = 0; i < 16; ++i) {
+    randombytes(rnd, RNDBYTES);
+    crypto_sign_mu_internal(mu, m, mlen > (size_t)i ? mlen - i : 0, pre, sizeof(pre), &sctx);
+    crypto_sign_signature_mu_internal(sig, &siglen, mu, rnd, &sctx);
+    team.width = 2 + i % 7;
+    crypto_sign_signature_mu_spec(sig_spec, &siglen_spec, mu, rnd, &sctx, &team);
+    if (siglen_spec != siglen || memcmp(sig, sig_spec, siglen)) {
+      printf("ERROR: speculative signature differs from sequential one\n");
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int test_rows(const uint8_t *m, size_t mlen)
+{
+  uint8_t sk[CRYPTO_SECRETKEYBYTES], pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sig[CRYPTO_BYTES], sig_rows[CRYPTO_BYTES];
+  uint8_t mu[CRHBYTES], rnd[RNDBYTES];
+  const uint8_t pre[2] = {0, 0};
+  size_t siglen = 0, siglen_rows = 0;
+  static sign_ctx sctx, sctx_rows;
+  static verify_ctx vctx, vctx_rows;
+  sign_team team = {4, reversed_run, NULL};
+  int i;
+
+  // Keys made and expanded with the rows split match the sequential ones
+  crypto_sign_set_team(&team);
+  crypto_sign_keypair(pk, sk);
+  crypto_sign_key_expand(&sctx_rows, sk);
+  crypto_sign_pk_expand(&vctx_rows, pk);
+  crypto_sign_set_team(NULL);
+  crypto_sign_key_expand(&sctx, sk);
+  crypto_sign_pk_expand(&vctx, pk);
+  if (memcmp(&sctx, &sctx_rows, sizeof(sctx)) || memcmp(&vctx, &vctx_rows, sizeof(vctx))) {
+    printf("ERROR: row-parallel key expansion differs from sequential one\n");
+    return 1;
+  }
+
+  for (i = 0; i < 4; ++i) {
+    randombytes(rnd, RNDBYTES);
+    crypto_sign_mu_internal(mu, m, mlen > (size_t)i ? mlen - i : 0, pre, sizeof(pre), &sctx);
+    crypto_sign_signature_mu_internal(sig, &siglen, mu, rnd, &sctx);
+    crypto_sign_set_team(&team);
+    if (i % 2)
+      crypto_sign_signature_mu_spec(sig_rows, &siglen_rows, mu, rnd, &sctx, &team);
+    else
+      crypto_sign_signature_mu_internal(sig_rows, &siglen_rows, mu, rnd, &sctx);
+    if (siglen_rows != siglen || memcmp(sig, sig_rows, siglen)) {
+      crypto_sign_set_team(NULL);
+      printf("ERROR: row-parallel signature differs from sequential one\n");
+      return 1;
+    }
+    sig_rows[CTILDEBYTES] ^= 1;
+    if (crypto_sign_verify(sig, siglen, m, mlen > (size_t)i ? mlen - i : 0, NULL, 0, pk) ||
+        !crypto_sign_verify(sig_rows, siglen, m, mlen > (size_t)i ? mlen - i : 0, NULL, 0, pk)) {
+      crypto_sign_set_team(NULL);
+      printf("ERROR: row-parallel verification failed\n");
+      return 1;
+    }
+    crypto_sign_set_team(NULL);
+  }
+
+  return 0;
+}
+
+static int sparse_differs(const poly *r, const poly *c, const poly *a)
+{
+  poly chat, ahat;
+  int i;
+
+  chat = *c;
+  ahat = *a;
+  poly_ntt(&chat);
+  poly_ntt(&ahat);
+  poly_pointwise_montgomery(&ahat, &chat, &ahat);
+  poly_invntt_tomont(&ahat);
+  for (i = 0; i < N; ++i)
+    if (((int64_t)ahat.coeffs[i] - r->coeffs[i]) % Q)
+      return 1;
+  return 0;
+}
+
+static int test_sparse(void)
+{
+  uint8_t seed[CTILDEBYTES];
+  uint32_t buf[N];
+  poly c, a, r;
+  poly_sparse cs;
+  int i, j;
+
+  // The sparse challenge products equal the NTT ones modulo q
+  for (i = 0; i < 8; ++i) {
+    randombytes(seed, sizeof(seed));
+    poly_challenge(&c, seed);
+    poly_challenge_sparse(&cs, &c);
+
+    randombytes((uint8_t *)buf, sizeof(buf));
+    for (j = 0; j < N; ++j)
+      a.coeffs[j] = (int32_t)(buf[j] % (2*ETA + 1)) - ETA;
+    if (i == 0)
+      for (j = 0; j < N; ++j)
+        a.coeffs[j] = j % 2 ? ETA : -ETA;
+    poly_sparse_mul_eta(&r, &cs, &a);
+    if (sparse_differs(&r, &c, &a)) {
+      printf("ERROR: sparse c*s differs from NTT product\n");
+      return 1;
+    }
+
+    for (j = 0; j < N; ++j)
+      a.coeffs[j] = (int32_t)(buf[j] % (1 << D)) - (1 << (D-1)) + 1;
+    poly_sparse_mul(&r, &cs, &a);
+    if (sparse_differs(&r, &c, &a)) {
+      printf("ERROR: sparse c*t0 differs from NTT product\n");
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int test_verify_batch(const uint8_t *m)
+{
+  uint8_t pk[2][CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[2][CRYPTO_SECRETKEYBYTES];
+  // Longer than one SHAKE256 block and not a whole number of lanes
+  uint8_t m4[4][200];
+  static uint8_t sigs[BATCH][CRYPTO_BYTES];
+  const uint8_t *sigp[BATCH], *msgp[BATCH], *pkp[BATCH];
+  size_t siglens[BATCH], mlens[BATCH];
+  int results[BATCH];
+  int i;
+
+  crypto_sign_keypair(pk[0], sk[0]);
+  crypto_sign_keypair(pk[1], sk[1]);
+  randombytes((uint8_t *)m4, sizeof(m4));
+
+  // First group shares key and message length, the rest mixes both
+  for (i = 0; i < BATCH; ++i) {
+    int k = (i < 4) ? 0 : i % 2;
+    mlens[i] = (i < 4) ? sizeof(m4[0]) : (size_t)i;
+    msgp[i] = (i < 4) ? m4[i] : m;
+    pkp[i] = pk[k];
+    sigp[i] = sigs[i];
+    crypto_sign_signature(sigs[i], &siglens[i], msgp[i], mlens[i], NULL, 0, sk[k]);
+  }
+
+  if (crypto_sign_verify_batch(results, sigp, siglens, msgp, mlens, NULL, 0, pkp, BATCH)) {
+    printf("ERROR: batch verification rejected valid signatures\n");
+    return 1;
+  }
+
+  sigs[BATCH - 2][CTILDEBYTES] ^= 1;
+  siglens[BATCH - 1] -= 1;
+  if (!crypto_sign_verify_batch(results, sigp, siglens, msgp, mlens, NULL, 0, pkp, BATCH)) {
+    printf("ERROR: batch verification accepted forged signatures\n");
+    return 1;
+  }
+
+  for (i = 0; i < BATCH; ++i) {
+    if (results[i] != ((i < BATCH - 2) ? 0 : -1)) {
+      printf("ERROR: wrong batch verification result for signature %d\n", i);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int test_verify_batch_mu(const uint8_t *m, size_t mlen)
+{
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t mu[CRHBYTES];
+  static uint8_t sigs[BATCH][CRYPTO_BYTES];
+  const uint8_t *sigp[BATCH];
+  size_t siglens[BATCH];
+  int results[BATCH];
+  verify_ctx vctx;
+  int i;
+
+  crypto_sign_keypair(pk, sk);
+  crypto_sign_pk_expand(&vctx, pk);
+  crypto_sign_mu_ctx(mu, m, mlen, NULL, 0, &vctx);
+
+  for (i = 0; i < BATCH; ++i) {
+    sigp[i] = sigs[i];
+    crypto_sign_signature(sigs[i], &siglens[i], m, mlen, NULL, 0, sk);
+  }
+
+  if (crypto_sign_verify_batch_mu(results, sigp, siglens, mu, &vctx, BATCH)) {
+    printf("ERROR: batch verification over mu rejected valid signatures\n");
+    return 1;
+  }
+
+  sigs[1][CTILDEBYTES] ^= 1;
+  siglens[BATCH - 1] -= 1;
+  if (!crypto_sign_verify_batch_mu(results, sigp, siglens, mu, &vctx, BATCH)) {
+    printf("ERROR: batch verification over mu accepted forged signatures\n");
+    return 1;
+  }
+
+  for (i = 0; i < BATCH; ++i) {
+    if (results[i] != ((i == 1 || i == BATCH - 1) ? -1 : 0)) {
+      printf("ERROR: wrong batch verification result over mu for signature %d\n", i);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int test_stream(void)
+{
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t sig[CRYPTO_BYTES];
+  static uint8_t m[STREAM_MLEN];
+  uint8_t buf[4096];
+  size_t mlen = STREAM_MLEN, siglen = 0, off, len, n;
+  sign_stream sst;
+  verify_stream vst;
+  static verify_ctx vctx;
+  FILE *f;
+
+  crypto_sign_keypair(pk, sk);
+  randombytes(m, mlen);
+
+  // Uneven chunks cross the SHAKE256 rate boundary at different offsets
+  crypto_sign_init(&sst, NULL, 0, sk);
+  for (off = 0, len = 1; off < mlen; off += len, len = 2 * len + 1) {
+    if (len > mlen - off)
+      len = mlen - off;
+    crypto_sign_update(&sst, m + off, len);
+  }
+  crypto_sign_final(&sst, sig, &siglen, sk);
+  if (siglen != CRYPTO_BYTES || crypto_sign_verify(sig, siglen, m, mlen, NULL, 0, pk)) {
+    printf("ERROR: streamed signature did not verify\n");
+    return 1;
+  }
+
+  crypto_sign_signature(sig, &siglen, m, mlen, NULL, 0, sk);
+  crypto_verify_init(&vst, NULL, 0, pk);
+  for (off = 0, len = 135; off < mlen; off += len) {
+    if (len > mlen - off)
+      len = mlen - off;
+    crypto_verify_update(&vst, m + off, len);
+  }
+  if (crypto_verify_final(&vst, sig, siglen, pk)) {
+    printf("ERROR: streamed verification rejected valid signature\n");
+    return 1;
+  }
+
+  crypto_sign_pk_expand(&vctx, pk);
+  crypto_verify_init_ctx(&vst, NULL, 0, &vctx);
+  for (off = 0, len = 1; off < mlen; off += len, len = 2 * len + 1) {
+    if (len > mlen - off)
+      len = mlen - off;
+    crypto_verify_update(&vst, m + off, len);
+  }
+  if (crypto_verify_final_ctx(&vst, sig, siglen, &vctx)) {
+    printf("ERROR: streamed verification (expanded key) rejected valid signature\n");
+    return 1;
+  }
+
+  // Whole input file, not limited to MLEN
+  f = fopen("test/input.txt", "rb");
+  if (!f) {
+    printf("File error\n");
+    return 1;
+  }
+  crypto_sign_init(&sst, NULL, 0, sk);
+  crypto_verify_init(&vst, NULL, 0, pk);
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    crypto_sign_update(&sst, buf, n);
+    crypto_verify_update(&vst, buf, n);
+  }
+  fclose(f);
+  crypto_sign_final(&sst, sig, &siglen, sk);
+  sig[0] ^= 1;
+  if (!crypto_verify_final(&vst, sig, siglen, pk)) {
+    printf("ERROR: streamed verification accepted forged signature\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+static int test_prehash_extmu(const uint8_t *m, size_t mlen)
+{
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t sig[CRYPTO_BYTES];
+  uint8_t ph[DILITHIUM_PH_MAXBYTES];
+  uint8_t mu[CRHBYTES];
+  const uint8_t ctx[] = "hashml-dsa";
+  size_t siglen = 0;
+  int alg, phlen;
+
+  crypto_sign_keypair(pk, sk);
+
+  for (alg = DILITHIUM_PH_SHA3_256; alg <= DILITHIUM_PH_SHAKE256; ++alg) {
+    phlen = crypto_sign_prehash(ph, m, mlen, alg);
+    if (phlen < 0 || crypto_sign_signature_prehash(sig, &siglen, ph, phlen, ctx, sizeof(ctx) - 1, alg, sk)) {
+      printf("ERROR: HashML-DSA signing failed\n");
+      return 1;
+    }
+    if (crypto_sign_verify_prehash(sig, siglen, ph, phlen, ctx, sizeof(ctx) - 1, alg, pk)) {
+      printf("ERROR: HashML-DSA signature did not verify\n");
+      return 1;
+    }
+    // Pure ML-DSA and a different pre-hash are domain separated
+    if (!crypto_sign_verify(sig, siglen, ph, phlen, ctx, sizeof(ctx) - 1, pk) ||
+        !crypto_sign_verify_prehash(sig, siglen, ph, phlen, ctx, sizeof(ctx) - 1, alg ^ 2, pk)) {
+      printf("ERROR: HashML-DSA signature accepted in wrong domain\n");
+      return 1;
+    }
+  }
+
+  // External mu signatures are ordinary ML-DSA signatures
+  crypto_sign_mu(mu, m, mlen, ctx, sizeof(ctx) - 1, pk);
+  crypto_sign_signature_extmu(sig, &siglen, mu, sk);
+  if (crypto_sign_verify(sig, siglen, m, mlen, ctx, sizeof(ctx) - 1, pk)) {
+    printf("ERROR: external mu signature did not verify\n");
+    return 1;
+  }
+  crypto_sign_signature(sig, &siglen, m, mlen, ctx, sizeof(ctx) - 1, sk);
+  if (crypto_sign_verify_extmu(sig, siglen, mu, pk)) {
+    printf("ERROR: external mu verification rejected valid signature\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+int main(void)
+{
+  FILE *fin = fopen("test/input.txt", "rb");
+  //FILE *fout = fopen("test/output.txt", "w");
+  if (!fin /*|| !fout*/) {
+    printf("File error\n");
+    return 1;
+  }
+
+  // Read message from input.txt only once
+  uint8_t m[MLEN + CRYPTO_BYTES] = {0};
+  size_t mlen = fread(m, 1, MLEN, fin);
+  fclose(fin);
+
+  for (int test = 0; test < NTESTS; ++test) {
+    run_test(m, mlen, test);
+  }
+  //fclose(fout);
+
+  // Print testing information
+  printf("\n[Testing Information - %d runs]\n\n", NTESTS);
+  timing_info_t t = print_timing_info();
+  printf("Average KeyGen time: %.6fs (%.2f ms)\n", t.keygen / NTESTS, (t.keygen / NTESTS) * 1000);
+  printf("Average Signing time: %.6fs (%.2f ms)\n", t.sign / NTESTS, (t.sign / NTESTS) * 1000);
+  printf("Average Verification time: %.6fs (%.2f ms)\n", t.verify / NTESTS, (t.verify / NTESTS) * 1000);
+  //printf("Average sum time (3 stages): %.6fs (%.2f ms)\n", t.temp / NTESTS, (t.temp / NTESTS) * 1000);
+  printf("Average all time (NIST compliance): %.6fs (%.2f ms)\n", t.all / NTESTS, (t.all / NTESTS) * 1000);
+  printf("Public key bytes = %d\n", CRYPTO_PUBLICKEYBYTES);
+  printf("Secret key bytes = %d\n", CRYPTO_SECRETKEYBYTES);
+  printf("Signature bytes = %d\n", CRYPTO_BYTES);
+  printf("Message bytes = %zu\n", mlen);
+
+  if (test_key_ctx(m, mlen))
+    return 1;
+  if (test_commit(m, mlen))
+    return 1;
+  if (test_spec(m, mlen))
+    return 1;
+  if (test_rows(m, mlen))
+    return 1;
+  if (test_sparse())
+    return 1;
+  if (test_verify_batch(m))
+    return 1;
+  if (test_verify_batch_mu(m, mlen))
+    return 1;
+  if (test_stream())
+    return 1;
+  if (test_prehash_extmu(m, mlen))
+    return 1;
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include "../randombytes.h"
+#include "../sign.h"
+#include "proto.h"
+#include "proto_client.h"
+#include "binlog.h"
+
+#define SERVER_PORT 5000
+#define BUFFER_SIZE 8192
+#define DEFAULT_TARGET_IP "192.168.4.85"
+#define CLIENT_SK_PATH "client_sk.bin"
+#define CLIENT_LOG_PATH "client.dlog"
+#define KEY_DIR "keys"
+
+static uint64_t get_time_us(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int load_file_exact(const char *path, uint8_t *buf, size_t len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return -1;
+    }
+
+    size_t n = fread(buf, 1, len, f);
+    fclose(f);
+
+    if (n != len) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int send_all(int sock, const uint8_t *buf, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+        ssize_t sent = send(sock, (const char *)buf + total, (int)(len - total), 0);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (sent == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        total += (size_t)sent;
+    }
+    return 0;
+}
+
+static int recv_all(int sock, uint8_t *buf, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+        ssize_t recvd = recv(sock, (char *)buf + total, (int)(len - total), 0);
+        if (recvd == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        if (recvd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        total += (size_t)recvd;
+    }
+    return 0;
+}
+
+static int send_blob(int sock, const uint8_t *data, uint32_t data_len) {
+    uint32_t len_net = htonl(data_len);
+    if (send_all(sock, (const uint8_t *)&len_net, sizeof(len_net)) < 0) {
+        return -1;
+    }
+    if (data_len == 0) {
+        return 0;
+    }
+    return send_all(sock, data, data_len);
+}
+
+/* rec already holds the peer, stage timings and sizes; finish and queue it */
+static void log_result(binlog_t *log, binlog_rec_t *rec, int result, uint64_t start_us) {
+    binlog_cpu_t cpu = {0, 0};
+
+    if (!log) {
+        return;
+    }
+    rec->result = (uint8_t)result;
+    rec->total_us = (uint32_t)(get_time_us() - start_us);
+    binlog_stamp(rec, &cpu);
+    binlog_push(binlog_ring(log, 0), rec);
+}
+
+int main(int argc, char *argv[]) {
+    int sock = -1;
+    struct sockaddr_in server_addr;
+    uint8_t sk[CRYPTO_SECRETKEYBYTES];
+    uint8_t challenge[BUFFER_SIZE];
+    uint32_t challenge_len = 0;
+    uint8_t signature[CRYPTO_BYTES];
+    size_t sig_len = 0;
+    binlog_rec_t rec;
+    uint64_t t;
+    int rc = 1;
+
+    const char *ip = (argc > 1) ? argv[1] : DEFAULT_TARGET_IP;
+
+    const char *log_path = getenv("CLIENT_LOG_PATH");
+    if (!log_path || *log_path == '\0') {
+        log_path = CLIENT_LOG_PATH;
+    }
+
+    /* KEY_ID: use keys/<KEY_ID>.sk and name that key to a version 2 server */
+    char sk_path[PATH_MAX];
+    const char *key_id = getenv("KEY_ID");
+    const char *key_dir = getenv("KEY_DIR");
+    if (key_id && *key_id != '\0') {
+        snprintf(sk_path, sizeof(sk_path), "%s/%s.sk", key_dir && *key_dir ? key_dir : KEY_DIR, key_id);
+    } else {
+        snprintf(sk_path, sizeof(sk_path), "%s", CLIENT_SK_PATH);
+    }
+
+    /* SIGND: let the signing daemon sign with its key instead of reading one */
+    signd_client *signd = NULL;
+    const char *signd_at = getenv("SIGND");
+    if (signd_at && *signd_at != '\0') {
+        if (key_id && *key_id != '\0') {
+            fprintf(stderr, "SIGND signs with the daemon's key; it cannot be combined with KEY_ID\n");
+            return 1;
+        }
+        if (!(signd = signd_open(signd_at))) {
+            return 1;
+        }
+        memset(sk, 0, sizeof(sk));
+    } else if (load_file_exact(sk_path, sk, sizeof(sk)) < 0) {
+        fprintf(stderr, "Missing %s. Run test_dilithium_keygen first.\n", sk_path);
+        return 1;
+    }
+
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(SERVER_PORT);
+    if (inet_pton(AF_INET, ip, &server_addr.sin_addr) != 1) {
+        fprintf(stderr, "Invalid server IP: %s\n", ip);
+        signd_close(signd);
+        return 1;
+    }
+
+    binlog_t *log = binlog_open(log_path, 1, 16, 0);
+    if (!log) {
+        fprintf(stderr, "Cannot open %s, logging disabled\n", log_path);
+    }
+    memset(&rec, 0, sizeof(rec));
+    rec.source = BINLOG_SRC_CLIENT;
+    rec.peer_addr = server_addr.sin_addr.s_addr;
+    rec.peer_port = SERVER_PORT;
+    rec.rounds = 1;
+
+    uint64_t start_us = get_time_us();
+
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        perror("socket failed");
+        goto out;
+    }
+
+    if (connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        perror("connect failed");
+        goto out;
+    }
+    printf("[+] Connected to %s\n", ip);
+    t = get_time_us();
+    rec.stage_us[0] = (uint32_t)(t - start_us);
+
+    printf("[*] Waiting for challenge from server...\n");
+    uint8_t first[4];
+    if (recv_all(sock, first, sizeof(first)) < 0) {
+        perror("recv() challenge failed");
+        goto out;
+    }
+
+    /* Version 2 server: many rounds over this connection */
+    if (proto_get32(first) == PROTO_MAGIC) {
+        proto_client_cfg cfg;
+        proto_client_stats st;
+        memset(&st, 0, sizeof(st));
+        proto_client_config(&cfg);
+        cfg.signd = signd;
+        printf("[+] Framed protocol: %u rounds, pipeline %u, %u signature(s) per frame\n",
+               cfg.rounds, cfg.pipeline, cfg.batch);
+
+        rec.stage_us[1] = (uint32_t)(get_time_us() - t);
+        rc = proto_client_run(sock, sk, &cfg, &st);
+        printf("[%s] %u valid, %u invalid in %llu ms\n", rc == 0 ? "DONE" : "FAIL",
+               st.ok, st.fail, (unsigned long long)((get_time_us() - start_us) / 1000));
+        rec.rounds = st.ok + st.fail;
+        rec.challenge_len = PROTO_CHALLENGE_BYTES;
+        rec.sig_len = CRYPTO_BYTES;
+        if (rc == 0 && st.fail != 0) {
+            rc = 1;
+            log_result(log, &rec, BINLOG_RESULT_FAIL, start_us);
+            goto done;
+        }
+        goto out;
+    }
+
+    if (key_id && *key_id != '\0') {
+        printf("[WARNING] Version 1 server: KEY_ID %s is not announced\n", key_id);
+    }
+    challenge_len = proto_get32(first);
+    rec.challenge_len = challenge_len;
+    if (challenge_len > BUFFER_SIZE) {
+        errno = EMSGSIZE;
+    }
+    if (challenge_len > BUFFER_SIZE ||
+        (challenge_len > 0 && recv_all(sock, challenge, challenge_len) < 0)) {
+        perror("recv() challenge failed");
+        goto out;
+    }
+    printf("[+] Received challenge: %u bytes\n", challenge_len);
+    rec.stage_us[1] = (uint32_t)(get_time_us() - t);
+
+    printf("[*] Signing challenge...\n");
+    t = get_time_us();
+    if ((signd ? signd_sign(signd, signature, &sig_len, challenge, (size_t)challenge_len)
+               : crypto_sign_signature(signature, &sig_len, challenge, (size_t)challenge_len, NULL, 0, sk)) != 0) {
+        fprintf(stderr, "Signature failed\n");
+        goto out;
+    }
+    rec.stage_us[2] = (uint32_t)(get_time_us() - t);
+    rec.sig_len = (uint32_t)sig_len;
+
+    if (sig_len > UINT32_MAX) {
+        fprintf(stderr, "Signature too large: %zu bytes\n", sig_len);
+        goto out;
+    }
+
+    printf("[*] Sending signature...\n");
+    t = get_time_us();
+    if (send_blob(sock, signature, (uint32_t)sig_len) < 0) {
+        perror("send() signature failed");
+        goto out;
+    }
+    rec.stage_us[3] = (uint32_t)(get_time_us() - t);
+
+    printf("[DONE] Dilithium process finished successfully.\n");
+    rc = 0;
+
+out:
+    log_result(log, &rec, rc == 0 ? BINLOG_RESULT_OK : BINLOG_RESULT_ERROR, start_us);
+done:
+    if (sock >= 0) {
+        close(sock);
+    }
+    binlog_close(log);
+    signd_close(signd);
+    return rc;
+}
@@ -0,0 +1,124 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "../randombytes.h"
+#include "../sign.h"
+
+#define CLIENT_SK_PATH "client_sk.bin"
+#define CLIENT_PK_PATH "client_pk.bin"
+#define SERVER_PK_PATH "server_pk.bin"
+#define KEY_DIR "keys"
+
+static int write_file(const char *path, const uint8_t *buf, size_t len) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return -1;
+    }
+    if (fwrite(buf, 1, len, f) != len) {
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+    return 0;
+}
+
+/* Multi-tenant keys: <dir>/<id>.sk for the client, <dir>/<id>.pk for the
+ * server's SERVER_KEY_DIR */
+static int write_key(const char *dir, const char *id) {
+    uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+    uint8_t sk[CRYPTO_SECRETKEYBYTES];
+    char path[PATH_MAX];
+
+    if (crypto_sign_keypair(pk, sk) != 0) {
+        fprintf(stderr, "Key generation failed\n");
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/%s.sk", dir, id);
+    if (write_file(path, sk, sizeof(sk)) < 0) {
+        fprintf(stderr, "Failed to write %s\n", path);
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/%s.pk", dir, id);
+    if (write_file(path, pk, sizeof(pk)) < 0) {
+        fprintf(stderr, "Failed to write %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static int write_keys(const char *dir, const char *key_id, unsigned long count) {
+    char id[32];
+    unsigned long i;
+
+    if (mkdir(dir, 0755) < 0 && errno != EEXIST) {
+        perror(dir);
+        return 1;
+    }
+    if (key_id) {
+        if (write_key(dir, key_id) < 0) {
+            return 1;
+        }
+        printf("[OK] Wrote %s/%s.sk and %s/%s.pk\n", dir, key_id, dir, key_id);
+        return 0;
+    }
+
+    printf("[*] Generating %lu Dilithium keypairs...\n", count);
+    for (i = 0; i < count; ++i) {
+        snprintf(id, sizeof(id), "key%lu", i);
+        if (write_key(dir, id) < 0) {
+            return 1;
+        }
+    }
+    printf("[OK] Wrote %s/key0 .. key%lu (.sk and .pk)\n", dir, count - 1);
+    return 0;
+}
+
+int main(void) {
+    uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+    uint8_t sk[CRYPTO_SECRETKEYBYTES];
+    const char *key_id = getenv("KEY_ID");
+    const char *key_count = getenv("KEY_COUNT");
+    const char *key_dir = getenv("KEY_DIR");
+
+    if (!key_dir || *key_dir == '\0') {
+        key_dir = KEY_DIR;
+    }
+    if (key_id && *key_id != '\0') {
+        return write_keys(key_dir, key_id, 1);
+    }
+    if (key_count && strtoul(key_count, NULL, 10) > 0) {
+        return write_keys(key_dir, NULL, strtoul(key_count, NULL, 10));
+    }
+
+    printf("[*] Generating Dilithium keypair...\n");
+    if (crypto_sign_keypair(pk, sk) != 0) {
+        fprintf(stderr, "Key generation failed\n");
+        return 1;
+    }
+
+    if (write_file(CLIENT_SK_PATH, sk, sizeof(sk)) < 0) {
+        fprintf(stderr, "Failed to write %s\n", CLIENT_SK_PATH);
+        return 1;
+    }
+
+    if (write_file(CLIENT_PK_PATH, pk, sizeof(pk)) < 0) {
+        fprintf(stderr, "Failed to write %s\n", CLIENT_PK_PATH);
+        return 1;
+    }
+
+    if (write_file(SERVER_PK_PATH, pk, sizeof(pk)) < 0) {
+        fprintf(stderr, "Failed to write %s\n", SERVER_PK_PATH);
+        return 1;
+    }
+
+    printf("[OK] Wrote %s, %s, %s\n", CLIENT_SK_PATH, CLIENT_PK_PATH, SERVER_PK_PATH);
+    printf("Copy %s to the server machine before running the server.\n", SERVER_PK_PATH);
+    return 0;
+}
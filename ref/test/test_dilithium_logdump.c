@@ -0,0 +1,151 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+
+#include "binlog.h"
+
+/* Convert binlog files written by the demo programs to CSV (default) or
+ * JSON Lines (-j) on stdout. */
+
+static const char *source_name(uint8_t source) {
+    switch (source) {
+        case BINLOG_SRC_SERVER:
+            return "server";
+        case BINLOG_SRC_SERVER_EPOLL:
+            return "server_epoll";
+        case BINLOG_SRC_CLIENT:
+            return "client";
+        case BINLOG_SRC_STRESS:
+            return "stress";
+        default:
+            return "unknown";
+    }
+}
+
+static const char *result_name(uint8_t result) {
+    switch (result) {
+        case BINLOG_RESULT_OK:
+            return "OK";
+        case BINLOG_RESULT_FAIL:
+            return "FAIL";
+        default:
+            return "ERROR";
+    }
+}
+
+/* What stage_us[i] means for each source (NULL: unused) */
+static const char *stage_name(uint8_t source, unsigned int i) {
+    static const char *const server[BINLOG_STAGES] = {"send_us", "recv_us", "verify_us", NULL};
+    static const char *const epoll[BINLOG_STAGES] = {"io_us", "wait_us", "verify_us", NULL};
+    static const char *const client[BINLOG_STAGES] = {"connect_us", "recv_us", "sign_us", "send_us"};
+
+    switch (source) {
+        case BINLOG_SRC_SERVER:
+            return server[i];
+        case BINLOG_SRC_SERVER_EPOLL:
+            return epoll[i];
+        case BINLOG_SRC_CLIENT:
+        case BINLOG_SRC_STRESS:
+            return client[i];
+        default:
+            return NULL;
+    }
+}
+
+static void print_csv(const binlog_rec_t *r) {
+    char peer[INET_ADDRSTRLEN];
+    struct in_addr a;
+
+    a.s_addr = r->peer_addr;
+    inet_ntop(AF_INET, &a, peer, sizeof(peer));
+    printf("%llu.%09llu,%s,%u,%s:%u,%s,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n",
+           (unsigned long long)(r->ts_ns / 1000000000ull),
+           (unsigned long long)(r->ts_ns % 1000000000ull),
+           source_name(r->source), r->pid, peer, (unsigned int)r->peer_port,
+           result_name(r->result), r->rounds,
+           r->stage_us[0], r->stage_us[1], r->stage_us[2], r->stage_us[3], r->total_us,
+           r->challenge_len, r->sig_len, r->cpu_user_us, r->cpu_sys_us, r->maxrss_kb);
+}
+
+static void print_json(const binlog_rec_t *r) {
+    char peer[INET_ADDRSTRLEN];
+    struct in_addr a;
+    unsigned int i;
+
+    a.s_addr = r->peer_addr;
+    inet_ntop(AF_INET, &a, peer, sizeof(peer));
+    printf("{\"time\":%llu.%09llu,\"source\":\"%s\",\"pid\":%u,\"peer\":\"%s:%u\","
+           "\"result\":\"%s\",\"rounds\":%u",
+           (unsigned long long)(r->ts_ns / 1000000000ull),
+           (unsigned long long)(r->ts_ns % 1000000000ull),
+           source_name(r->source), r->pid, peer, (unsigned int)r->peer_port,
+           result_name(r->result), r->rounds);
+    for (i = 0; i < BINLOG_STAGES; ++i) {
+        const char *name = stage_name(r->source, i);
+        if (name) {
+            printf(",\"%s\":%u", name, r->stage_us[i]);
+        }
+    }
+    printf(",\"total_us\":%u,\"challenge\":%u,\"sig\":%u,\"cpu_user_us\":%u,"
+           "\"cpu_sys_us\":%u,\"maxrss_kb\":%u}\n",
+           r->total_us, r->challenge_len, r->sig_len, r->cpu_user_us, r->cpu_sys_us,
+           r->maxrss_kb);
+}
+
+static int dump_file(const char *path, int json) {
+    binlog_file_hdr hdr;
+    binlog_rec_t rec;
+    FILE *f = fopen(path, "rb");
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 || hdr.magic != BINLOG_MAGIC ||
+        hdr.version != BINLOG_VERSION || hdr.rec_size != sizeof(binlog_rec_t)) {
+        fprintf(stderr, "%s: not a version %d binlog written on a host like this one\n",
+                path, BINLOG_VERSION);
+        fclose(f);
+        return -1;
+    }
+    while (fread(&rec, sizeof(rec), 1, f) == 1) {
+        if (json) {
+            print_json(&rec);
+        } else {
+            print_csv(&rec);
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int json = 0;
+    int first = 1;
+    int rc = 0;
+    int i;
+
+    if (argc > 1 && strcmp(argv[1], "-j") == 0) {
+        json = 1;
+        first = 2;
+    }
+    if (first >= argc) {
+        fprintf(stderr, "Usage: %s [-j] file.dlog...\n", argv[0]);
+        return 1;
+    }
+
+    if (!json) {
+        printf("time,source,pid,peer,result,rounds,stage1_us,stage2_us,stage3_us,stage4_us,"
+               "total_us,challenge,sig,cpu_user_us,cpu_sys_us,maxrss_kb\n");
+    }
+    for (i = first; i < argc; ++i) {
+        if (dump_file(argv[i], json) < 0) {
+            rc = 1;
+        }
+    }
+    return rc;
+}
@@ -0,0 +1,970 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+
+/* Platform-specific socket headers - must come before ../sign.h to avoid macro conflicts */
+#ifdef _WIN32
+  #define WIN32_LEAN_AND_MEAN
+  #include <winsock2.h>
+  #include <ws2tcpip.h>
+  #include <windows.h>
+  #define close(sock) closesocket(sock)
+  #define ssize_t int
+  /* Undefine potential macro conflicts that Windows headers define */
+  #undef N
+  #undef D
+  #undef L
+#else
+  #include <sys/types.h>
+  #include <sys/socket.h>
+  #include <netinet/in.h>
+  #include <arpa/inet.h>
+  #include <netinet/tcp.h>
+  #include <unistd.h>
+  #include <sys/resource.h>
+#endif
+
+/* Dilithium headers - included after socket headers to avoid macro conflicts */
+#include "../randombytes.h"
+#include "../sign.h"
+#include "proto.h"
+#include "binlog.h"
+#include "metrics.h"
+#include "keycache.h"
+
+/* Configuration */
+#define SERVER_PORT 5000
+#define CHALLENGE_MAX 8192
+#define CHALLENGE_PATH_PRIMARY "test/input.txt"
+#define CHALLENGE_PATH_FALLBACK "input.txt"
+#define SERVER_PK_PATH "server_pk.bin"
+#define SERVER_LOG_PATH "server.dlog"
+#define SERVER_LOG_RING 4096 /* records the writer may fall behind by */
+#define METRICS_SLOTS 64 /* children pick a slot by pid */
+#define SERVER_KEY_CACHE_MB 16 /* default budget for expanded client keys */
+#define UPLOAD_BUFFERED_MAX (1u << 30) /* largest PROTO_FLAG_BUFFERED message */
+
+/* Per-connection progress output; SERVER_VERBOSE=0 turns it off */
+#define VPRINTF(...) do { if (g_verbose) printf(__VA_ARGS__); } while (0)
+
+enum { STAGE_SEND, STAGE_RECV, STAGE_VERIFY, STAGE_TOTAL, NSTAGES };
+static const char *const stage_names[NSTAGES] = {"send", "recv", "verify", "total"};
+
+/* Forward declarations */
+static uint64_t get_time_us(void);
+static int send_all(int sock, const uint8_t *buf, size_t len);
+static int recv_all(int sock, uint8_t *buf, size_t len);
+static int send_blob(int sock, const uint8_t *data, uint32_t data_len);
+static int recv_blob(int sock, uint8_t *buf, uint32_t buf_size, uint32_t *out_len);
+static int send_challenge(int sock, const uint8_t *challenge, size_t challenge_len);
+static int receive_signature(int sock, uint8_t *signature, size_t *sig_len);
+static int load_file_exact(const char *path, uint8_t *buf, size_t len);
+static int load_public_key(const char *path, uint8_t *pk);
+static void load_challenge(uint8_t *challenge, size_t *challenge_len);
+static void log_result(const struct sockaddr_in *client_addr,
+                       int result,
+                       uint32_t rounds,
+                       const uint32_t stage_us[BINLOG_STAGES],
+                       uint64_t total_us,
+                       size_t challenge_len,
+                       size_t sig_len);
+static int handle_client(int client_sock, const struct sockaddr_in *client_addr);
+
+static uint8_t g_pk[CRYPTO_PUBLICKEYBYTES];
+static verify_ctx g_vctx; /* g_pk expanded once */
+static uint8_t g_mu[CRHBYTES]; /* CRH(tr, pre, g_challenge): every v1 client signs the same */
+static uint8_t g_challenge[CHALLENGE_MAX];
+static size_t g_challenge_len = 0;
+static int g_proto_v2 = 0; /* SERVER_PROTO=2: framed multi-round protocol */
+static volatile sig_atomic_t g_stop = 0;
+static int g_verbose = 1;
+#ifndef _WIN32
+/* Rings shared with the forked children, drained by a writer thread here */
+static binlog_t *g_log = NULL;
+/* Counters in shared memory, updated atomically by the children and read
+ * by the metrics thread here; NULL without SERVER_METRICS */
+static metrics_slot_t *g_metrics = NULL;
+/* Expanded per-client keys shared by all children; NULL without SERVER_KEY_DIR */
+static keycache_t *g_keys = NULL;
+#endif
+
+/* Get current time in microseconds */
+static uint64_t get_time_us(void) {
+#ifdef _WIN32
+  return (uint64_t)GetTickCount64() * 1000;
+#else
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+    return 0;
+  }
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static int send_all(int sock, const uint8_t *buf, size_t len) {
+  size_t total = 0;
+  while (total < len) {
+    ssize_t sent = send(sock, (const char *)buf + total, (int)(len - total), 0);
+    if (sent < 0) {
+#ifndef _WIN32
+      if (errno == EINTR) {
+        continue;
+      }
+#endif
+      return -1;
+    }
+    if (sent == 0) {
+      errno = ECONNRESET;
+      return -1;
+    }
+    total += (size_t)sent;
+  }
+  return 0;
+}
+
+static int recv_all(int sock, uint8_t *buf, size_t len) {
+  size_t total = 0;
+  while (total < len) {
+    ssize_t recvd = recv(sock, (char *)buf + total, (int)(len - total), 0);
+    if (recvd == 0) {
+      errno = ECONNRESET;
+      return -1;
+    }
+    if (recvd < 0) {
+#ifndef _WIN32
+      if (errno == EINTR) {
+        continue;
+      }
+#endif
+      return -1;
+    }
+    total += (size_t)recvd;
+  }
+  return 0;
+}
+
+static int send_blob(int sock, const uint8_t *data, uint32_t data_len) {
+  uint32_t len_net = htonl(data_len);
+  if (send_all(sock, (const uint8_t *)&len_net, sizeof(len_net)) < 0) {
+    return -1;
+  }
+  if (data_len == 0) {
+    return 0;
+  }
+  return send_all(sock, data, data_len);
+}
+
+static int recv_blob(int sock, uint8_t *buf, uint32_t buf_size, uint32_t *out_len) {
+  uint32_t len_net = 0;
+  if (recv_all(sock, (uint8_t *)&len_net, sizeof(len_net)) < 0) {
+    return -1;
+  }
+
+  uint32_t len = ntohl(len_net);
+  if (len > buf_size) {
+    errno = EMSGSIZE;
+    return -1;
+  }
+
+  if (len > 0 && recv_all(sock, buf, len) < 0) {
+    return -1;
+  }
+
+  *out_len = len;
+  return 0;
+}
+
+static int load_file_exact(const char *path, uint8_t *buf, size_t len) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    return -1;
+  }
+
+  size_t n = fread(buf, 1, len, f);
+  fclose(f);
+
+  if (n != len) {
+    return -1;
+  }
+
+  return 0;
+}
+
+static int load_public_key(const char *path, uint8_t *pk) {
+  if (load_file_exact(path, pk, CRYPTO_PUBLICKEYBYTES) < 0) {
+    fprintf(stderr, "Failed to load public key from %s\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+static void load_challenge(uint8_t *challenge, size_t *challenge_len) {
+  FILE *fin = fopen(CHALLENGE_PATH_PRIMARY, "rb");
+  if (!fin) {
+    fin = fopen(CHALLENGE_PATH_FALLBACK, "rb");
+  }
+
+  if (!fin) {
+    const char *default_msg = "This is a test challenge message";
+    size_t default_len = strlen(default_msg);
+    memcpy(challenge, default_msg, default_len);
+    *challenge_len = default_len;
+    printf("[WARNING] Cannot open input file, using default challenge\n");
+    return;
+  }
+
+  *challenge_len = fread(challenge, 1, CHALLENGE_MAX, fin);
+  fclose(fin);
+
+  if (*challenge_len == 0) {
+    const char *default_msg = "This is a test challenge message";
+    size_t default_len = strlen(default_msg);
+    memcpy(challenge, default_msg, default_len);
+    *challenge_len = default_len;
+    printf("[WARNING] Empty input file, using default challenge\n");
+  }
+}
+
+/* Queue one record for the log writer; never blocks on the file */
+static void log_result(const struct sockaddr_in *client_addr,
+                       int result,
+                       uint32_t rounds,
+                       const uint32_t stage_us[BINLOG_STAGES],
+                       uint64_t total_us,
+                       size_t challenge_len,
+                       size_t sig_len) {
+#ifndef _WIN32
+  binlog_rec_t rec;
+  binlog_cpu_t cpu = {0, 0}; /* a forked child starts from zero */
+
+  if (!g_log) {
+    return;
+  }
+  memset(&rec, 0, sizeof(rec));
+  if (client_addr) {
+    rec.peer_addr = client_addr->sin_addr.s_addr;
+    rec.peer_port = ntohs(client_addr->sin_port);
+  }
+  rec.source = BINLOG_SRC_SERVER;
+  rec.result = (uint8_t)result;
+  rec.rounds = rounds;
+  if (stage_us) {
+    memcpy(rec.stage_us, stage_us, sizeof(rec.stage_us));
+  }
+  rec.total_us = (uint32_t)total_us;
+  rec.challenge_len = (uint32_t)challenge_len;
+  rec.sig_len = (uint32_t)sig_len;
+  binlog_stamp(&rec, &cpu);
+  binlog_push(binlog_ring(g_log, 0), &rec);
+#else
+  (void)client_addr;
+  (void)result;
+  (void)rounds;
+  (void)stage_us;
+  (void)total_us;
+  (void)challenge_len;
+  (void)sig_len;
+#endif
+}
+
+/* Metrics: each child updates the slot its pid maps to, atomically, since
+ * several live children can share one */
+static void count_connection(void) {
+#ifndef _WIN32
+  if (g_metrics) {
+    metrics_inc(&g_metrics[(unsigned int)getpid() % METRICS_SLOTS].connections);
+  }
+#endif
+}
+
+static void count_result(int result) {
+#ifndef _WIN32
+  if (g_metrics) {
+    metrics_slot_t *m = &g_metrics[(unsigned int)getpid() % METRICS_SLOTS];
+    metrics_inc(result == BINLOG_RESULT_OK ? &m->valid
+                : result == BINLOG_RESULT_FAIL ? &m->invalid : &m->errors);
+  }
+#else
+  (void)result;
+#endif
+}
+
+static void observe_stage(unsigned int stage, uint64_t us) {
+#ifndef _WIN32
+  if (g_metrics) {
+    hist_add_atomic(&g_metrics[(unsigned int)getpid() % METRICS_SLOTS].stage_ns[stage], us * 1000);
+  }
+#else
+  (void)stage;
+  (void)us;
+#endif
+}
+
+#ifndef _WIN32
+static void collect_metrics(metrics_snapshot_t *snap, void *arg) {
+  keycache_stats_t kst;
+  unsigned int i;
+  (void)arg;
+  metrics_slots_collect(snap, g_metrics, METRICS_SLOTS, NSTAGES);
+  for (i = 0; i < NSTAGES; ++i) {
+    snap->stage_names[i] = stage_names[i];
+  }
+  if (g_keys) {
+    keycache_stats(g_keys, &kst);
+    snap->nextra = 4;
+    snap->extra_names[0] = "key_cache_hits";
+    snap->extra_help[0] = "HELLO key lookups served from the key cache";
+    snap->extra[0] = kst.hits;
+    snap->extra_names[1] = "key_cache_misses";
+    snap->extra_help[1] = "HELLO key lookups that read and expanded the key";
+    snap->extra[1] = kst.misses;
+    snap->extra_names[2] = "key_cache_evictions";
+    snap->extra_help[2] = "Expanded keys evicted to stay within the memory budget";
+    snap->extra[2] = kst.evictions;
+    snap->extra_names[3] = "key_cache_bypass";
+    snap->extra_help[3] = "Misses expanded outside the cache because every slot was in use";
+    snap->extra[3] = kst.bypass;
+  }
+}
+#endif
+
+/* Send challenge message to client */
+static int send_challenge(int sock, const uint8_t *challenge, size_t challenge_len) {
+  VPRINTF("[*] Sending challenge to client (size: %zu bytes)...\n", challenge_len);
+
+  if (challenge_len > UINT32_MAX) {
+    fprintf(stderr, "Challenge too large: %zu bytes\n", challenge_len);
+    return -1;
+  }
+
+  if (send_blob(sock, challenge, (uint32_t)challenge_len) < 0) {
+    perror("send() challenge failed");
+    return -1;
+  }
+
+  VPRINTF("[+] Challenge sent successfully\n\n");
+  return 0;
+}
+
+/* Receive signature from client */
+static int receive_signature(int sock, uint8_t *signature, size_t *sig_len) {
+  VPRINTF("[*] Waiting for signature from client...\n");
+
+  uint32_t size = 0;
+  if (recv_blob(sock, signature, CRYPTO_BYTES, &size) < 0) {
+    perror("recv() signature failed");
+    return -1;
+  }
+
+  *sig_len = (size_t)size;
+  VPRINTF("[+] Signature received successfully (size: %zu bytes)\n\n", *sig_len);
+  return 0;
+}
+
+/* Version 2 round state: the challenge issued for request_id */
+typedef struct {
+  uint32_t id;
+  int busy;
+  uint8_t challenge[PROTO_CHALLENGE_BYTES];
+  uint8_t mu[CRHBYTES]; // hashed while the client is signing
+} round_state;
+
+static int send_frame(int sock, uint8_t *frame, uint8_t type, uint16_t count,
+                      uint32_t request_id, uint32_t payload_len) {
+  proto_hdr h;
+  h.type = type;
+  h.flags = 0;
+  h.count = count;
+  h.request_id = request_id;
+  h.length = payload_len;
+  proto_hdr_pack(frame, &h);
+  return send_all(sock, frame, PROTO_HDR_BYTES + payload_len);
+}
+
+/* HELLO: verify the rest of the connection against the client's own key.
+ * The cache pins the expanded key until the connection ends; *scratch is
+ * only used when every cache slot is pinned. */
+static uint8_t select_key(const uint8_t *id, uint32_t id_len, const verify_ctx **vctx,
+                          verify_ctx **scratch, int *slot) {
+#ifndef _WIN32
+  char key_id[PROTO_MAX_KEY_ID + 1];
+  const verify_ctx *v;
+
+  if (!g_keys || id_len == 0 || id_len > PROTO_MAX_KEY_ID) {
+    return PROTO_STATUS_UNKNOWN_KEY;
+  }
+  memcpy(key_id, id, id_len);
+  key_id[id_len] = '\0';
+  if (!*scratch && !(*scratch = malloc(sizeof(verify_ctx)))) {
+    return PROTO_STATUS_UNKNOWN_KEY;
+  }
+  v = keycache_acquire(g_keys, key_id, *scratch, slot);
+  if (!v) {
+    return PROTO_STATUS_UNKNOWN_KEY;
+  }
+  *vctx = v;
+  return PROTO_STATUS_OK;
+#else
+  (void)id;
+  (void)id_len;
+  (void)vctx;
+  (void)scratch;
+  (void)slot;
+  return PROTO_STATUS_UNKNOWN_KEY;
+#endif
+}
+
+static uint8_t verify_round(round_state *rounds, uint32_t request_id,
+                            const uint8_t *sig, size_t sig_len, const verify_ctx *vctx) {
+  round_state *r = &rounds[request_id % PROTO_MAX_OUTSTANDING];
+
+  if (!r->busy || r->id != request_id) {
+    return PROTO_STATUS_UNKNOWN;
+  }
+  r->busy = 0;
+  uint64_t t0 = get_time_us();
+  int ret = crypto_sign_verify_ctx_mu(sig, sig_len, r->mu, vctx);
+  observe_stage(STAGE_VERIFY, get_time_us() - t0);
+  count_result(ret == 0 ? BINLOG_RESULT_OK : BINLOG_RESULT_FAIL);
+  return ret == 0 ? PROTO_STATUS_OK : PROTO_STATUS_INVALID;
+}
+
+/* UPLOAD: absorb the message into mu chunk by chunk as recv() returns it,
+ * so by the time its last byte is in only the signature and the lattice
+ * checks remain. With PROTO_FLAG_BUFFERED the whole message is received
+ * first and hashed afterwards, for comparison. buf (buf_len bytes) is the
+ * receive buffer. Returns a PROTO_STATUS_*, or -1 when the frame is
+ * malformed or the connection failed. */
+static int verify_upload(int sock, const proto_hdr *h, uint8_t *buf, size_t buf_len,
+                         const verify_ctx *vctx) {
+  uint8_t sig[CRYPTO_BYTES];
+  uint8_t *msg = NULL;
+  uint32_t mlen, sig_len, left;
+  verify_stream st;
+  uint64_t t0, t1, t2;
+  int buffered = (h->flags & PROTO_FLAG_BUFFERED) != 0;
+  int ret;
+
+  if (h->length < 4 || recv_all(sock, buf, 4) < 0) {
+    return -1;
+  }
+  mlen = proto_get32(buf);
+  if (mlen > h->length - 4 || h->length - 4 - mlen > CRYPTO_BYTES) {
+    return -1;
+  }
+  sig_len = h->length - 4 - mlen;
+
+  t0 = get_time_us();
+  if (buffered) {
+    if (mlen > UPLOAD_BUFFERED_MAX || !(msg = malloc(mlen > 0 ? mlen : 1))) {
+      return -1;
+    }
+    if (recv_all(sock, msg, mlen) < 0 || recv_all(sock, sig, sig_len) < 0) {
+      free(msg);
+      return -1;
+    }
+    t1 = get_time_us();
+    ret = crypto_sign_verify_ctx(sig, sig_len, msg, mlen, NULL, 0, vctx);
+    free(msg);
+  } else {
+    crypto_verify_init_ctx(&st, NULL, 0, vctx);
+    for (left = mlen; left > 0;) {
+      ssize_t n = recv(sock, (char *)buf, (int)(left < buf_len ? left : buf_len), 0);
+      if (n < 0) {
+#ifndef _WIN32
+        if (errno == EINTR) {
+          continue;
+        }
+#endif
+        return -1;
+      }
+      if (n == 0) {
+        return -1;
+      }
+      crypto_verify_update(&st, buf, (size_t)n);
+      left -= (uint32_t)n;
+    }
+    if (recv_all(sock, sig, sig_len) < 0) {
+      return -1;
+    }
+    t1 = get_time_us();
+    ret = crypto_verify_final_ctx(&st, sig, sig_len, vctx);
+  }
+  t2 = get_time_us();
+
+  observe_stage(STAGE_RECV, t1 - t0);
+  observe_stage(STAGE_VERIFY, t2 - t1);
+  count_result(ret == 0 ? BINLOG_RESULT_OK : BINLOG_RESULT_FAIL);
+  VPRINTF("[v2] upload of %u bytes%s: received in %llu us, verified %llu us later\n", mlen,
+         buffered ? " (buffered)" : "", (unsigned long long)(t1 - t0), (unsigned long long)(t2 - t1));
+  return ret == 0 ? PROTO_STATUS_OK : PROTO_STATUS_INVALID;
+}
+
+/* Version 2: any number of pipelined rounds over one connection, see proto.h */
+static int handle_client_v2(int client_sock, const struct sockaddr_in *client_addr,
+                            const char *client_ip, uint16_t client_port) {
+  uint64_t total_start = get_time_us();
+  round_state rounds[PROTO_MAX_OUTSTANDING];
+  uint8_t hdr_buf[PROTO_HDR_BYTES];
+  uint8_t out[PROTO_HDR_BYTES + PROTO_MAX_BATCH * PROTO_RESULT_ENTRY_BYTES];
+  size_t in_cap = (size_t)PROTO_MAX_BATCH * PROTO_BATCH_ENTRY_BYTES(CRYPTO_BYTES);
+  uint8_t *in = malloc(in_cap);
+  unsigned int ok = 0, fail = 0, frames = 0;
+  int error = 0;
+  const verify_ctx *vctx = &g_vctx;
+  verify_ctx *scratch = NULL;
+  int key_slot = -1;
+  proto_hdr h;
+
+  if (!in) {
+    return 1;
+  }
+  memset(rounds, 0, sizeof(rounds));
+
+  /* Results are small frames; don't hold them back behind Nagle */
+  int one = 1;
+  setsockopt(client_sock, IPPROTO_TCP, TCP_NODELAY, (char *)&one, sizeof(one));
+
+  proto_put32(hdr_buf, PROTO_MAGIC);
+  if (send_all(client_sock, hdr_buf, 4) < 0) {
+    free(in);
+    return 1;
+  }
+
+  /* The client ends the session by closing the connection */
+  while (!error && recv_all(client_sock, hdr_buf, sizeof(hdr_buf)) == 0) {
+    proto_hdr_unpack(&h, hdr_buf);
+    ++frames;
+    if (h.type == PROTO_UPLOAD) {
+      int status = verify_upload(client_sock, &h, in, in_cap, vctx);
+      if (status < 0) {
+        error = 1;
+        break;
+      }
+      if (status == PROTO_STATUS_OK) {
+        ++ok;
+      } else {
+        ++fail;
+      }
+      out[PROTO_HDR_BYTES] = (uint8_t)status;
+      if (send_frame(client_sock, out, PROTO_RESULT, 0, h.request_id, 1) < 0) {
+        error = 1;
+      }
+      continue;
+    }
+    if (h.length > in_cap || (h.length > 0 && recv_all(client_sock, in, h.length) < 0)) {
+      error = 1;
+      break;
+    }
+
+    switch (h.type) {
+      case PROTO_HELLO: {
+        if (frames > 1) {
+          error = 1; // the key cannot change under outstanding rounds
+          break;
+        }
+        out[PROTO_HDR_BYTES] = select_key(in, h.length, &vctx, &scratch, &key_slot);
+        if (send_frame(client_sock, out, PROTO_RESULT, 0, h.request_id, 1) < 0 ||
+            out[PROTO_HDR_BYTES] != PROTO_STATUS_OK) {
+          error = 1;
+        }
+        break;
+      }
+
+      case PROTO_CHALLENGE_REQ: {
+        round_state *r = &rounds[h.request_id % PROTO_MAX_OUTSTANDING];
+        if (r->busy) {
+          error = 1; // window exceeded
+          break;
+        }
+        r->id = h.request_id;
+        r->busy = 1;
+        randombytes(r->challenge, PROTO_CHALLENGE_BYTES);
+        memcpy(out + PROTO_HDR_BYTES, r->challenge, PROTO_CHALLENGE_BYTES);
+        if (send_frame(client_sock, out, PROTO_CHALLENGE, 0, h.request_id, PROTO_CHALLENGE_BYTES) < 0) {
+          error = 1;
+        }
+        crypto_sign_mu_ctx(r->mu, r->challenge, PROTO_CHALLENGE_BYTES, NULL, 0, vctx);
+        break;
+      }
+
+      case PROTO_SIGNATURE: {
+        uint8_t status = h.length <= CRYPTO_BYTES
+                           ? verify_round(rounds, h.request_id, in, h.length, vctx)
+                           : PROTO_STATUS_INVALID;
+        if (status == PROTO_STATUS_OK) {
+          ++ok;
+        } else {
+          ++fail;
+        }
+        out[PROTO_HDR_BYTES] = status;
+        if (send_frame(client_sock, out, PROTO_RESULT, 0, h.request_id, 1) < 0) {
+          error = 1;
+        }
+        break;
+      }
+
+      case PROTO_SIG_BATCH: {
+        size_t off = 0;
+        unsigned int i;
+        if (h.count > PROTO_MAX_BATCH) {
+          error = 1;
+          break;
+        }
+        for (i = 0; i < h.count; ++i) {
+          uint8_t *e = out + PROTO_HDR_BYTES + i * PROTO_RESULT_ENTRY_BYTES;
+          uint32_t id, len;
+          if (h.length - off < 8) {
+            error = 1;
+            break;
+          }
+          id = proto_get32(in + off);
+          len = proto_get32(in + off + 4);
+          off += 8;
+          if (len > CRYPTO_BYTES || h.length - off < len) {
+            error = 1;
+            break;
+          }
+          proto_put32(e, id);
+          e[4] = verify_round(rounds, id, in + off, len, vctx);
+          if (e[4] == PROTO_STATUS_OK) {
+            ++ok;
+          } else {
+            ++fail;
+          }
+          off += len;
+        }
+        if (!error && send_frame(client_sock, out, PROTO_RESULT_BATCH, h.count, 0,
+                                 h.count * PROTO_RESULT_ENTRY_BYTES) < 0) {
+          error = 1;
+        }
+        break;
+      }
+
+      default:
+        error = 1;
+        break;
+    }
+  }
+
+  if (error) {
+    send_frame(client_sock, out, PROTO_ERROR, 0, h.request_id, 0);
+    count_result(BINLOG_RESULT_ERROR);
+  }
+
+  uint64_t elapsed = get_time_us() - total_start;
+  observe_stage(STAGE_TOTAL, elapsed);
+  VPRINTF("[v2] %s:%u: %u valid, %u invalid in %llu ms%s\n", client_ip, (unsigned int)client_port,
+         ok, fail, (unsigned long long)(elapsed / 1000), error ? " (protocol error)" : "");
+  log_result(client_addr, error ? BINLOG_RESULT_ERROR : fail ? BINLOG_RESULT_FAIL : BINLOG_RESULT_OK,
+             ok + fail, NULL, elapsed, PROTO_CHALLENGE_BYTES, CRYPTO_BYTES);
+#ifndef _WIN32
+  if (g_keys) {
+    keycache_release(g_keys, key_slot);
+  }
+#endif
+  free(scratch);
+  free(in);
+  return (fail || error) ? 1 : 0;
+}
+
+static int handle_client(int client_sock, const struct sockaddr_in *client_addr) {
+  uint64_t total_start = get_time_us();
+
+  uint8_t signature[CRYPTO_BYTES];
+  size_t sig_len = 0;
+
+  char client_ip[INET_ADDRSTRLEN] = "unknown";
+  uint16_t client_port = 0;
+  if (client_addr) {
+    inet_ntop(AF_INET, &client_addr->sin_addr, client_ip, sizeof(client_ip));
+    client_port = ntohs(client_addr->sin_port);
+  }
+
+  count_connection();
+  if (g_proto_v2) {
+    return handle_client_v2(client_sock, client_addr, client_ip, client_port);
+  }
+
+  /* ============ STAGE 1: Send Challenge ============ */
+  VPRINTF("[STAGE 1] Sending challenge to client...\n");
+  VPRINTF("- Challenge size: %zu bytes\n", g_challenge_len);
+
+  uint64_t send_challenge_start = get_time_us();
+  if (send_challenge(client_sock, g_challenge, g_challenge_len) < 0) {
+    fprintf(stderr, "Failed to send challenge\n");
+    count_result(BINLOG_RESULT_ERROR);
+    log_result(client_addr, BINLOG_RESULT_ERROR, 1, NULL, get_time_us() - total_start,
+               g_challenge_len, 0);
+    return 1;
+  }
+  uint64_t send_challenge_end = get_time_us();
+
+  VPRINTF("[+] Send challenge time: %llu ms\n\n",
+    (unsigned long long)((send_challenge_end - send_challenge_start) / 1000));
+
+  /* ============ STAGE 2: Receive Signature ============ */
+  VPRINTF("[STAGE 2] Receiving signature from client...\n");
+
+  uint64_t recv_sig_start = get_time_us();
+  if (receive_signature(client_sock, signature, &sig_len) < 0) {
+    fprintf(stderr, "Failed to receive signature\n");
+    count_result(BINLOG_RESULT_ERROR);
+    log_result(client_addr, BINLOG_RESULT_ERROR, 1, NULL, get_time_us() - total_start,
+               g_challenge_len, 0);
+    return 1;
+  }
+  uint64_t recv_sig_end = get_time_us();
+
+  VPRINTF("- Signature size: %zu bytes\n", sig_len);
+  VPRINTF("[+] Receive signature time: %llu ms\n\n",
+    (unsigned long long)((recv_sig_end - recv_sig_start) / 1000));
+
+  /* ============ STAGE 3: Verify Signature ============ */
+  VPRINTF("[STAGE 3] Verifying signature...\n");
+
+  uint64_t verify_start = get_time_us();
+  /* pk expansion and mu were done once at startup */
+  int verify_result = crypto_sign_verify_ctx_mu(signature, sig_len, g_mu, &g_vctx);
+  uint64_t verify_end = get_time_us();
+
+  VPRINTF("- Verification result: %s\n", verify_result == 0 ? "VALID" : "INVALID");
+  VPRINTF("[+] Verification time: %llu ms\n\n",
+    (unsigned long long)((verify_end - verify_start) / 1000));
+
+  /* ============ TIMING SUMMARY ============ */
+  uint64_t total_end = get_time_us();
+
+  VPRINTF("===================================\n");
+  VPRINTF("[TIMING SUMMARY]\n");
+  VPRINTF("===================================\n");
+  VPRINTF("Send Challenge Time:       %llu ms\n",
+    (unsigned long long)((send_challenge_end - send_challenge_start) / 1000));
+  VPRINTF("Receive Signature Time:    %llu ms\n",
+    (unsigned long long)((recv_sig_end - recv_sig_start) / 1000));
+  VPRINTF("Verification Time:         %llu ms\n",
+    (unsigned long long)((verify_end - verify_start) / 1000));
+  VPRINTF("-----------------------------------\n");
+  VPRINTF("Total Time (from start):   %llu ms\n",
+    (unsigned long long)((total_end - total_start) / 1000));
+  VPRINTF("===================================\n\n");
+
+  VPRINTF("[KEY INFORMATION]\n");
+  VPRINTF("- Signature Size:          %zu bytes\n", sig_len);
+  VPRINTF("- Challenge Size:          %zu bytes\n", g_challenge_len);
+  VPRINTF("===================================\n\n");
+
+  VPRINTF("[+] Signature verification %s.\n", verify_result == 0 ? "OK" : "FAILED");
+
+  observe_stage(STAGE_SEND, send_challenge_end - send_challenge_start);
+  observe_stage(STAGE_RECV, recv_sig_end - recv_sig_start);
+  observe_stage(STAGE_VERIFY, verify_end - verify_start);
+  observe_stage(STAGE_TOTAL, total_end - total_start);
+  count_result(verify_result == 0 ? BINLOG_RESULT_OK : BINLOG_RESULT_FAIL);
+
+  uint32_t stage_us[BINLOG_STAGES] = {
+    (uint32_t)(send_challenge_end - send_challenge_start),
+    (uint32_t)(recv_sig_end - recv_sig_start),
+    (uint32_t)(verify_end - verify_start),
+    0
+  };
+  log_result(client_addr, verify_result == 0 ? BINLOG_RESULT_OK : BINLOG_RESULT_FAIL, 1, stage_us,
+             total_end - total_start, g_challenge_len, sig_len);
+
+  return verify_result == 0 ? 0 : 1;
+}
+
+#ifndef _WIN32
+static void handle_stop(int sig) {
+  (void)sig;
+  g_stop = 1;
+}
+#endif
+
+int main(void) {
+  int listen_sock = -1;
+  const char *proto = getenv("SERVER_PROTO");
+  const char *verbose = getenv("SERVER_VERBOSE");
+  g_proto_v2 = proto && strcmp(proto, "2") == 0;
+  g_verbose = !(verbose && strcmp(verbose, "0") == 0);
+
+  printf("\n========== Dilithium Server ==========\n");
+  printf("Listening on port %d (protocol v%d)\n", SERVER_PORT, g_proto_v2 ? 2 : 1);
+  printf("======================================\n\n");
+
+  /* Windows socket initialization */
+#ifdef _WIN32
+  WSADATA wsa_data;
+  if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+    fprintf(stderr, "WSAStartup failed\n");
+    return 1;
+  }
+#else
+  signal(SIGCHLD, SIG_IGN);
+  signal(SIGPIPE, SIG_IGN);
+
+  /* No SA_RESTART: accept() must return so the log can be flushed */
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = handle_stop;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+#endif
+
+  if (load_public_key(SERVER_PK_PATH, g_pk) < 0) {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return 1;
+  }
+
+  crypto_sign_pk_expand(&g_vctx, g_pk);
+  load_challenge(g_challenge, &g_challenge_len);
+  crypto_sign_mu_ctx(g_mu, g_challenge, g_challenge_len, NULL, 0, &g_vctx);
+
+#ifndef _WIN32
+  g_log = binlog_open(SERVER_LOG_PATH, 1, SERVER_LOG_RING, 1);
+  if (!g_log) {
+    fprintf(stderr, "Cannot open %s, logging disabled\n", SERVER_LOG_PATH);
+  }
+
+  metrics_server_t *metrics = NULL;
+  const char *metrics_on = getenv("SERVER_METRICS");
+  if (metrics_on && *metrics_on != '\0') {
+    g_metrics = metrics_slots_shared(METRICS_SLOTS);
+    metrics = g_metrics ? metrics_start(metrics_on, "dilithium_server", collect_metrics, NULL) : NULL;
+    if (!metrics) {
+      return 1;
+    }
+    printf("Metrics on %s (GET /metrics)\n", metrics_on);
+  }
+
+  const char *key_dir = getenv("SERVER_KEY_DIR");
+  if (key_dir && *key_dir != '\0') {
+    const char *mb = getenv("SERVER_KEY_CACHE_MB");
+    size_t budget = (size_t)(mb && *mb ? strtoul(mb, NULL, 10) : SERVER_KEY_CACHE_MB) << 20;
+    g_keys = keycache_create(key_dir, budget);
+    if (!g_keys) {
+      fprintf(stderr, "Cannot set up the key cache for %s\n", key_dir);
+      return 1;
+    }
+    keycache_stats_t kst;
+    keycache_stats(g_keys, &kst);
+    printf("Client keys from %s/<key_id>.pk, cache of %u expanded keys\n", key_dir, kst.slots);
+  }
+#endif
+
+  /* ============ STAGE 0: Create Socket & Listen ============ */
+  listen_sock = socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_sock < 0) {
+    perror("socket() failed");
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return 1;
+  }
+
+  /* Allow socket address reuse */
+  int reuse = 1;
+  if (setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, (char *)&reuse, sizeof(reuse)) < 0) {
+    perror("setsockopt() failed");
+    close(listen_sock);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return 1;
+  }
+
+  struct sockaddr_in server_addr;
+  memset(&server_addr, 0, sizeof(server_addr));
+  server_addr.sin_family = AF_INET;
+  server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  server_addr.sin_port = htons(SERVER_PORT);
+
+  if (bind(listen_sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+    perror("bind() failed");
+    close(listen_sock);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return 1;
+  }
+
+  if (listen(listen_sock, SOMAXCONN) < 0) {
+    perror("listen() failed");
+    close(listen_sock);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return 1;
+  }
+
+  printf("[*] Waiting for client connections...\n");
+
+  while (!g_stop) {
+    struct sockaddr_in client_addr;
+    socklen_t client_addr_len = sizeof(client_addr);
+    int client_sock = accept(listen_sock, (struct sockaddr *)&client_addr, &client_addr_len);
+    if (client_sock < 0) {
+#ifndef _WIN32
+      if (errno == EINTR) {
+        continue;
+      }
+#endif
+      perror("accept() failed");
+      continue;
+    }
+
+            VPRINTF("[+] Client connected from %s:%d\n\n", inet_ntoa(client_addr.sin_addr),
+              ntohs(client_addr.sin_port));
+
+#ifndef _WIN32
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(listen_sock);
+      handle_client(client_sock, &client_addr);
+      close(client_sock);
+      _exit(0);
+    }
+
+    if (pid < 0) {
+      perror("fork() failed");
+      close(client_sock);
+      continue;
+    }
+
+    close(client_sock);
+#else
+    handle_client(client_sock, &client_addr);
+    close(client_sock);
+#endif
+  }
+
+  close(listen_sock);
+#ifdef _WIN32
+  WSACleanup();
+#else
+  metrics_stop(metrics);
+  if (g_keys) {
+    keycache_stats_t kst;
+    keycache_stats(g_keys, &kst);
+    printf("[KEYS] %llu hits, %llu misses, %llu evictions, %llu bypassed, %u of %u slots used\n",
+           (unsigned long long)kst.hits, (unsigned long long)kst.misses,
+           (unsigned long long)kst.evictions, (unsigned long long)kst.bypass, kst.used, kst.slots);
+    keycache_destroy(g_keys);
+  }
+  uint64_t dropped = binlog_close(g_log);
+  if (dropped > 0) {
+    fprintf(stderr, "[LOG] %llu records dropped\n", (unsigned long long)dropped);
+  }
+#endif
+  return 0;
+}
+
+
@@ -0,0 +1,1217 @@
+#define _GNU_SOURCE
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+
+#include "../randombytes.h"
+#include "../sign.h"
+#include "hist.h"
+#include "lfqueue.h"
+#include "binlog.h"
+#include "metrics.h"
+#ifdef SERVER_IO_URING
+#include <sys/eventfd.h>
+#include "uring.h"
+#endif
+
+/* Event-driven variant of test_dilithium_server: same wire protocol
+ * (challenge blob out, signature blob in), but connections are multiplexed
+ * by non-blocking I/O threads and complete signatures are verified by a
+ * fixed pool of worker threads instead of one fork() per client.
+ *
+ *   I/O threads:  one listening socket each (SO_REUSEPORT lets the kernel
+ *                 shard incoming connections), epoll loop driving the
+ *                 per-connection send/recv state machine.
+ *   Workers:      pinned to CPUs, take finished connections from a
+ *                 lock-free MPMC queue, verify, close.
+ *   Main thread:  prints connections/sec and verify latency percentiles.
+ *
+ * Built with -DSERVER_IO_URING (test_dilithium_server_uring*) the I/O
+ * threads use io_uring instead of epoll: one multishot accept per
+ * listener, one send for the challenge and one multishot recv per
+ * connection into a ring of kernel-provided buffers. When a signature
+ * arrives in a single buffer the workers verify it in place and the I/O
+ * thread recycles the buffer afterwards; only fragmented messages are
+ * assembled in the connection.
+ *
+ * Configuration (environment):
+ *   SERVER_PORT        TCP port (default 5000)
+ *   SERVER_IO_THREADS  I/O threads / listening sockets (default 1)
+ *   SERVER_WORKERS     verification threads (default: online CPUs)
+ *   SERVER_PIN         pin workers to CPUs (default 1)
+ *   SERVER_STATS_SEC   stats interval in seconds, 0 disables (default 5)
+ *   SERVER_BATCH_MAX   signatures a worker takes from the queue at once (default 1)
+ *   SERVER_BATCH_WAIT_US  how long a worker holding a partial batch waits for
+ *                      more signatures (default 0: take what is queued)
+ *   SERVER_LOG         binary per-connection log file (binlog.h), written
+ *                      by a background thread from one ring per worker
+ *                      (default: no log)
+ *   SERVER_METRICS     serve Prometheus metrics on PORT, ADDR:PORT or a Unix
+ *                      socket path (metrics.h; default: off)
+ */
+
+/* Configuration */
+#define SERVER_PORT 5000
+#define CHALLENGE_MAX 8192
+#define CHALLENGE_PATH_PRIMARY "test/input.txt"
+#define CHALLENGE_PATH_FALLBACK "input.txt"
+#define SERVER_PK_PATH "server_pk.bin"
+#define DEFAULT_IO_THREADS 1
+#define DEFAULT_STATS_SEC 5
+#define MAX_BATCH 64
+#define QUEUE_CAPACITY 4096
+#define MAX_EVENTS 256
+#define MAX_THREADS 256
+#define LOG_RING 4096
+#ifdef SERVER_IO_URING
+#define URING_ENTRIES 256
+#define URING_CQ_ENTRIES 4096
+#define URING_BUFS 512
+#define URING_BUF_SIZE 8192 // holds length prefix + largest signature
+#define URING_BGID 0
+#endif
+
+enum {
+  CONN_SEND_CHALLENGE,
+  CONN_RECV_LEN,
+  CONN_RECV_SIG,
+  CONN_DONE
+};
+
+struct io_ctx;
+
+typedef struct conn {
+  int fd;
+  int state;
+  uint32_t events; // currently registered with epoll
+  size_t off;
+  uint8_t len_buf[4];
+  uint32_t sig_len;
+  const uint8_t *sig_ptr; // what the worker verifies: sig or a receive buffer
+  uint64_t t_accept;
+  uint64_t t_sent;   // challenge fully sent, 0 if not seen before queueing
+  uint64_t t_queued; // handed to the workers
+#ifdef SERVER_IO_URING
+  struct io_ctx *io;
+  struct conn *next; // waiting for receive buffers
+  int refs;          // outstanding ring operations + worker
+  int bid;           // receive buffer held for in-place verification, or -1
+  int failed;
+#endif
+  uint8_t sig[CRYPTO_BYTES];
+} conn_t;
+
+/* Written only by the owning thread, read by the stats thread */
+typedef struct {
+  uint64_t accepted;
+  uint64_t errors;
+  uint64_t zerocopy; // signatures verified straight from a receive buffer
+} __attribute__((aligned(64))) io_stats_t;
+
+typedef struct {
+  uint64_t ok;
+  uint64_t fail;
+  uint64_t batches;
+  hist_t send_ns;   // accept to challenge sent
+  hist_t recv_ns;   // challenge sent to signature complete
+  hist_t verify_ns; // verification time per signature (batch time / batch size)
+  hist_t wait_ns;   // queued to verification start: queueing + batching window
+  hist_t total_ns;  // accept to verification done
+} __attribute__((aligned(64))) worker_stats_t;
+
+typedef struct io_ctx {
+  int listen_fd;
+  io_stats_t *stats;
+#ifdef SERVER_IO_URING
+  uring_t ring;
+  uring_bufring_t bufs;
+  lfqueue done;     // verified connections handed back by the workers
+  int efd;          // workers kick it after pushing to done
+  uint64_t efd_val;
+  conn_t *starved;  // multishot recv stopped for lack of buffers
+  int bufs_freed;   // buffers went back to the kernel this round
+#endif
+} io_ctx_t;
+
+typedef struct {
+  int cpu; // -1: not pinned
+  worker_stats_t *stats;
+  binlog_ring_t *log; // NULL: logging disabled
+  binlog_cpu_t cpu_mark;
+} worker_ctx_t;
+
+static uint8_t g_pk[CRYPTO_PUBLICKEYBYTES];
+static verify_ctx g_vctx;      /* g_pk expanded once */
+static uint8_t g_mu[CRHBYTES]; /* CRH(tr, pre, g_challenge), shared by every signature */
+static uint8_t g_challenge[CHALLENGE_MAX];
+static size_t g_challenge_len = 0;
+static uint8_t g_challenge_msg[4 + CHALLENGE_MAX]; // length prefix + challenge
+static size_t g_challenge_msg_len = 0;
+
+static lfqueue g_queue;
+static sem_t g_queue_items;
+static volatile sig_atomic_t g_stop = 0;
+static unsigned int g_batch_max = 1;
+static unsigned int g_batch_wait_us = 0;
+
+static uint64_t get_time_ns(void) {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+    return 0;
+  }
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static unsigned int parse_uint_env(const char *name, unsigned int def_value) {
+  const char *val = getenv(name);
+  if (!val || *val == '\0') {
+    return def_value;
+  }
+
+  char *end = NULL;
+  unsigned long parsed = strtoul(val, &end, 10);
+  if (!end || *end != '\0' || parsed > UINT_MAX) {
+    return def_value;
+  }
+
+  return (unsigned int)parsed;
+}
+
+static int load_file_exact(const char *path, uint8_t *buf, size_t len) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    return -1;
+  }
+
+  size_t n = fread(buf, 1, len, f);
+  fclose(f);
+
+  if (n != len) {
+    return -1;
+  }
+
+  return 0;
+}
+
+static void load_challenge(uint8_t *challenge, size_t *challenge_len) {
+  FILE *fin = fopen(CHALLENGE_PATH_PRIMARY, "rb");
+  if (!fin) {
+    fin = fopen(CHALLENGE_PATH_FALLBACK, "rb");
+  }
+
+  *challenge_len = 0;
+  if (fin) {
+    *challenge_len = fread(challenge, 1, CHALLENGE_MAX, fin);
+    fclose(fin);
+  }
+
+  if (*challenge_len == 0) {
+    const char *default_msg = "This is a test challenge message";
+    *challenge_len = strlen(default_msg);
+    memcpy(challenge, default_msg, *challenge_len);
+    printf("[WARNING] No usable input file, using default challenge\n");
+  }
+}
+
+static void on_signal(int sig) {
+  (void)sig;
+  g_stop = 1;
+}
+
+static int make_listen_socket(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  if (fd < 0) {
+    perror("socket() failed");
+    return -1;
+  }
+
+  int one = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0 ||
+      setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0) {
+    perror("setsockopt() failed");
+    close(fd);
+    return -1;
+  }
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    perror("bind() failed");
+    close(fd);
+    return -1;
+  }
+  if (listen(fd, SOMAXCONN) < 0) {
+    perror("listen() failed");
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static void counter_inc(uint64_t *c) {
+  __atomic_store_n(c, __atomic_load_n(c, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+}
+
+#ifdef SERVER_IO_URING
+static void io_drain_done(io_ctx_t *io);
+#endif
+
+/* Hand a finished connection to the workers */
+static void dispatch_conn(io_ctx_t *io, conn_t *c) {
+  c->t_queued = get_time_ns();
+  while (lfq_push(&g_queue, c) < 0) {
+#ifdef SERVER_IO_URING
+    io_drain_done(io); // workers may be waiting for room in io->done
+#else
+    (void)io;
+#endif
+    sched_yield(); // queue full: back-pressure on this I/O thread
+  }
+  sem_post(&g_queue_items);
+}
+
+/* Called by the worker once it no longer needs c */
+static void conn_finish(conn_t *c) {
+#ifdef SERVER_IO_URING
+  io_ctx_t *io = c->io;
+  uint64_t one = 1;
+
+  while (lfq_push(&io->done, c) < 0) {
+    sched_yield();
+  }
+  if (write(io->efd, &one, sizeof(one)) != sizeof(one)) {
+    /* counter overflow is impossible; the I/O thread drains on any wakeup */
+  }
+#else
+  close(c->fd);
+  free(c);
+#endif
+}
+
+#ifndef SERVER_IO_URING
+static void conn_close(conn_t *c) {
+  close(c->fd);
+  free(c);
+}
+
+/* Advance the connection as far as the socket allows without blocking.
+ * Returns 1 once the whole signature is in, 0 to wait for readiness and
+ * -1 on error or peer close. */
+static int conn_progress(conn_t *c) {
+  ssize_t n;
+
+  if (c->state == CONN_SEND_CHALLENGE) {
+    while (c->off < g_challenge_msg_len) {
+      n = send(c->fd, g_challenge_msg + c->off, g_challenge_msg_len - c->off, MSG_NOSIGNAL);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+      }
+      c->off += (size_t)n;
+    }
+    c->state = CONN_RECV_LEN;
+    c->off = 0;
+    c->t_sent = get_time_ns();
+  }
+
+  if (c->state == CONN_RECV_LEN) {
+    while (c->off < sizeof(c->len_buf)) {
+      n = recv(c->fd, c->len_buf + c->off, sizeof(c->len_buf) - c->off, 0);
+      if (n == 0) {
+        return -1;
+      }
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+      }
+      c->off += (size_t)n;
+    }
+
+    uint32_t len_net;
+    memcpy(&len_net, c->len_buf, sizeof(len_net));
+    c->sig_len = ntohl(len_net);
+    if (c->sig_len > CRYPTO_BYTES) {
+      return -1;
+    }
+    c->state = CONN_RECV_SIG;
+    c->off = 0;
+  }
+
+  while (c->off < c->sig_len) {
+    n = recv(c->fd, c->sig + c->off, c->sig_len - c->off, 0);
+    if (n == 0) {
+      return -1;
+    }
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+    c->off += (size_t)n;
+  }
+  return 1;
+}
+
+static void conn_ready(io_ctx_t *io, int ep, conn_t *c) {
+  int r = conn_progress(c);
+
+  if (r < 0) {
+    epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+    counter_inc(&io->stats->errors);
+    conn_close(c);
+    return;
+  }
+  if (r > 0) {
+    epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+    dispatch_conn(io, c);
+    return;
+  }
+
+  uint32_t want = (c->state == CONN_SEND_CHALLENGE) ? EPOLLOUT : EPOLLIN;
+  if (want != c->events) {
+    struct epoll_event ev;
+    ev.events = want;
+    ev.data.ptr = c;
+    epoll_ctl(ep, EPOLL_CTL_MOD, c->fd, &ev);
+    c->events = want;
+  }
+}
+
+static void accept_ready(io_ctx_t *io, int ep) {
+  for (;;) {
+    int fd = accept4(io->listen_fd, NULL, NULL, SOCK_NONBLOCK);
+    if (fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return; // EAGAIN or a transient error; epoll will report again
+    }
+    counter_inc(&io->stats->accepted);
+
+    conn_t *c = malloc(sizeof(*c));
+    if (!c) {
+      close(fd);
+      counter_inc(&io->stats->errors);
+      continue;
+    }
+    c->fd = fd;
+    c->state = CONN_SEND_CHALLENGE;
+    c->off = 0;
+    c->sig_len = 0;
+    c->t_accept = get_time_ns();
+    c->t_sent = 0;
+    c->t_queued = 0;
+    c->sig_ptr = c->sig;
+
+    /* Usually the whole challenge fits into the socket buffer right away */
+    int r = conn_progress(c);
+    if (r < 0) {
+      counter_inc(&io->stats->errors);
+      conn_close(c);
+      continue;
+    }
+    if (r > 0) {
+      dispatch_conn(io, c);
+      continue;
+    }
+
+    struct epoll_event ev;
+    c->events = (c->state == CONN_SEND_CHALLENGE) ? EPOLLOUT : EPOLLIN;
+    ev.events = c->events;
+    ev.data.ptr = c;
+    if (epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev) < 0) {
+      counter_inc(&io->stats->errors);
+      conn_close(c);
+    }
+  }
+}
+
+static void *io_thread(void *arg) {
+  io_ctx_t *io = arg;
+  struct epoll_event events[MAX_EVENTS];
+  struct epoll_event ev;
+  int ep = epoll_create1(0);
+
+  if (ep < 0) {
+    perror("epoll_create1() failed");
+    g_stop = 1;
+    return NULL;
+  }
+
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL; // NULL marks the listening socket
+  if (epoll_ctl(ep, EPOLL_CTL_ADD, io->listen_fd, &ev) < 0) {
+    perror("epoll_ctl() failed");
+    g_stop = 1;
+    close(ep);
+    return NULL;
+  }
+
+  while (!g_stop) {
+    int n = epoll_wait(ep, events, MAX_EVENTS, 100);
+    for (int i = 0; i < n; ++i) {
+      if (events[i].data.ptr == NULL) {
+        accept_ready(io, ep);
+      } else {
+        conn_ready(io, ep, events[i].data.ptr);
+      }
+    }
+  }
+
+  close(ep);
+  return NULL;
+}
+
+#else /* SERVER_IO_URING */
+
+/* Low bits of user_data say which operation completed; conn_t is at
+ * least 8-byte aligned so the rest is the connection pointer. */
+#define TAG_MASK 3ull
+enum {
+  TAG_ACCEPT,
+  TAG_SEND,
+  TAG_RECV,
+  TAG_EVENT
+};
+
+static struct io_uring_sqe *io_sqe(io_ctx_t *io) {
+  struct io_uring_sqe *sqe = uring_get_sqe(&io->ring);
+  if (!sqe) {
+    perror("io_uring_enter() failed");
+    exit(1);
+  }
+  return sqe;
+}
+
+static void arm_accept(io_ctx_t *io) {
+  struct io_uring_sqe *sqe = io_sqe(io);
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = io->listen_fd;
+  sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+  sqe->user_data = TAG_ACCEPT;
+}
+
+static void arm_event(io_ctx_t *io) {
+  struct io_uring_sqe *sqe = io_sqe(io);
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = io->efd;
+  sqe->addr = (uint64_t)(uintptr_t)&io->efd_val;
+  sqe->len = sizeof(io->efd_val);
+  sqe->user_data = TAG_EVENT;
+}
+
+/* Length prefix and challenge go out in one send */
+static void arm_send(io_ctx_t *io, conn_t *c) {
+  struct io_uring_sqe *sqe = io_sqe(io);
+  sqe->opcode = IORING_OP_SEND;
+  sqe->fd = c->fd;
+  sqe->addr = (uint64_t)(uintptr_t)g_challenge_msg;
+  sqe->len = (uint32_t)g_challenge_msg_len;
+  sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+  sqe->user_data = (uint64_t)(uintptr_t)c | TAG_SEND;
+}
+
+/* Multishot recv: one CQE per segment, each in a buffer the kernel takes
+ * from io->bufs, until EOF, error or the buffers run out */
+static void arm_recv(io_ctx_t *io, conn_t *c) {
+  struct io_uring_sqe *sqe = io_sqe(io);
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = c->fd;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = URING_BGID;
+  sqe->user_data = (uint64_t)(uintptr_t)c | TAG_RECV;
+}
+
+static void conn_put(io_ctx_t *io, conn_t *c) {
+  (void)io;
+  if (--c->refs > 0) {
+    return;
+  }
+  close(c->fd);
+  free(c);
+}
+
+/* Shutting the socket down terminates the pending send/recv, whose final
+ * CQEs then drop the remaining references */
+static void conn_fail(io_ctx_t *io, conn_t *c) {
+  if (!c->failed) {
+    c->failed = 1;
+    counter_inc(&io->stats->errors);
+    shutdown(c->fd, SHUT_RDWR);
+  }
+}
+
+static void conn_dispatch(io_ctx_t *io, conn_t *c) {
+  c->state = CONN_DONE;
+  c->refs++;
+  dispatch_conn(io, c);
+}
+
+/* Append n received bytes to the message assembled in c. Returns 1 when
+ * the signature is complete, 0 if more is needed, -1 on protocol error. */
+static int conn_feed(conn_t *c, const uint8_t *p, size_t n) {
+  size_t take;
+
+  while (n > 0) {
+    if (c->state == CONN_RECV_LEN) {
+      take = sizeof(c->len_buf) - c->off;
+      take = take < n ? take : n;
+      memcpy(c->len_buf + c->off, p, take);
+      c->off += take;
+      if (c->off == sizeof(c->len_buf)) {
+        uint32_t len_net;
+        memcpy(&len_net, c->len_buf, sizeof(len_net));
+        c->sig_len = ntohl(len_net);
+        if (c->sig_len > CRYPTO_BYTES) {
+          return -1;
+        }
+        c->state = CONN_RECV_SIG;
+        c->off = 0;
+      }
+    } else {
+      take = c->sig_len - c->off;
+      if (take == 0) {
+        return -1; // trailing garbage
+      }
+      take = take < n ? take : n;
+      memcpy(c->sig + c->off, p, take);
+      c->off += take;
+    }
+    p += take;
+    n -= take;
+  }
+  return (c->state == CONN_RECV_SIG && c->off == c->sig_len) ? 1 : 0;
+}
+
+static void on_recv_data(io_ctx_t *io, conn_t *c, unsigned int bid, size_t n) {
+  uint8_t *buf = uring_buf(&io->bufs, bid);
+  uint32_t len_net;
+  int r;
+
+  if (c->failed || c->state == CONN_DONE) {
+    uring_bufring_recycle(&io->bufs, bid);
+    io->bufs_freed = 1;
+    return;
+  }
+
+  /* Signature (with or without its length prefix) in one buffer: the
+   * worker verifies it where the kernel put it */
+  if (c->state == CONN_RECV_LEN && c->off == 0 && n >= sizeof(len_net)) {
+    memcpy(&len_net, buf, sizeof(len_net));
+    if (ntohl(len_net) <= CRYPTO_BYTES && n == sizeof(len_net) + ntohl(len_net)) {
+      c->sig_len = ntohl(len_net);
+      c->sig_ptr = buf + sizeof(len_net);
+      c->bid = (int)bid;
+      counter_inc(&io->stats->zerocopy);
+      conn_dispatch(io, c);
+      return;
+    }
+  } else if (c->state == CONN_RECV_SIG && c->off == 0 && n == c->sig_len) {
+    c->sig_ptr = buf;
+    c->bid = (int)bid;
+    counter_inc(&io->stats->zerocopy);
+    conn_dispatch(io, c);
+    return;
+  }
+
+  r = conn_feed(c, buf, n);
+  uring_bufring_recycle(&io->bufs, bid);
+  io->bufs_freed = 1;
+  if (r < 0) {
+    conn_fail(io, c);
+  } else if (r > 0) {
+    c->sig_ptr = c->sig;
+    conn_dispatch(io, c);
+  }
+}
+
+static void on_recv(io_ctx_t *io, conn_t *c, const struct io_uring_cqe *cqe) {
+  int more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+
+  if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+    on_recv_data(io, c, cqe->flags >> IORING_CQE_BUFFER_SHIFT, (size_t)cqe->res);
+  } else if (cqe->res == -ENOBUFS && !more && !c->failed) {
+    /* Keep the reference; re-armed once workers hand buffers back */
+    c->next = io->starved;
+    io->starved = c;
+    return;
+  } else if (c->state != CONN_DONE) {
+    conn_fail(io, c); // EOF or error before the signature was complete
+  }
+
+  if (!more) {
+    conn_put(io, c);
+  }
+}
+
+static void on_accept(io_ctx_t *io, const struct io_uring_cqe *cqe) {
+  if (cqe->res >= 0) {
+    conn_t *c = malloc(sizeof(*c));
+    counter_inc(&io->stats->accepted);
+    if (!c) {
+      close(cqe->res);
+      counter_inc(&io->stats->errors);
+    } else {
+      c->fd = cqe->res;
+      c->state = CONN_RECV_LEN;
+      c->off = 0;
+      c->sig_len = 0;
+      c->sig_ptr = NULL;
+      c->t_accept = get_time_ns();
+      c->t_sent = 0;
+      c->t_queued = 0;
+      c->io = io;
+      c->next = NULL;
+      c->refs = 2; // send + recv
+      c->bid = -1;
+      c->failed = 0;
+      arm_send(io, c);
+      arm_recv(io, c);
+    }
+  }
+  if (!(cqe->flags & IORING_CQE_F_MORE) && !g_stop) {
+    arm_accept(io);
+  }
+}
+
+/* Take back connections the workers are done with */
+static void io_drain_done(io_ctx_t *io) {
+  void *item;
+
+  while (lfq_pop(&io->done, &item) == 0) {
+    conn_t *c = item;
+    if (c->bid >= 0) {
+      uring_bufring_recycle(&io->bufs, (unsigned int)c->bid);
+      c->bid = -1;
+      io->bufs_freed = 1;
+    }
+    shutdown(c->fd, SHUT_RDWR); // ends the multishot recv if the peer lingers
+    conn_put(io, c);
+  }
+}
+
+static void *io_thread(void *arg) {
+  io_ctx_t *io = arg;
+  struct io_uring_cqe *cqe;
+  int ret;
+
+  ret = uring_init(&io->ring, URING_ENTRIES, URING_CQ_ENTRIES);
+  if (ret == 0) {
+    ret = uring_bufring_init(&io->ring, &io->bufs, URING_BGID, URING_BUFS, URING_BUF_SIZE);
+    if (ret < 0) {
+      uring_exit(&io->ring);
+    }
+  }
+  if (ret < 0) {
+    fprintf(stderr, "io_uring setup failed: %s\n", strerror(-ret));
+    g_stop = 1;
+    return NULL;
+  }
+
+  arm_accept(io);
+  arm_event(io);
+  while (!g_stop) {
+    ret = uring_submit(&io->ring, 1);
+    if (ret < 0) {
+      fprintf(stderr, "io_uring_enter() failed: %s\n", strerror(-ret));
+      g_stop = 1;
+      break;
+    }
+
+    while ((cqe = uring_peek_cqe(&io->ring)) != NULL) {
+      struct io_uring_cqe e = *cqe;
+      conn_t *c = (conn_t *)(uintptr_t)(e.user_data & ~TAG_MASK);
+
+      uring_cqe_seen(&io->ring);
+      switch (e.user_data & TAG_MASK) {
+        case TAG_ACCEPT:
+          on_accept(io, &e);
+          break;
+        case TAG_SEND:
+          if (e.res != (int)g_challenge_msg_len) {
+            conn_fail(io, c);
+          } else if (c->t_queued == 0) {
+            c->t_sent = get_time_ns(); // else the worker may already own c
+          }
+          conn_put(io, c);
+          break;
+        case TAG_RECV:
+          on_recv(io, c, &e);
+          break;
+        default:
+          io_drain_done(io);
+          if (!g_stop) {
+            arm_event(io);
+          }
+          break;
+      }
+    }
+
+    if (io->bufs_freed) {
+      io->bufs_freed = 0;
+      while (io->starved) {
+        conn_t *c = io->starved;
+        io->starved = c->next;
+        arm_recv(io, c);
+      }
+    }
+  }
+
+  uring_exit(&io->ring);
+  return NULL;
+}
+#endif /* SERVER_IO_URING */
+
+static void pin_to_cpu(int cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+    fprintf(stderr, "[WARNING] Cannot pin worker to CPU %d\n", cpu);
+  }
+}
+
+/* Wait for the next queued connection; deadline NULL blocks. Returns
+ * NULL on timeout or shutdown. */
+static conn_t *next_conn(const struct timespec *deadline) {
+  void *item;
+  int r;
+
+  do {
+    r = deadline ? sem_timedwait(&g_queue_items, deadline) : sem_wait(&g_queue_items);
+  } while (r < 0 && errno == EINTR);
+  if (r < 0) {
+    return NULL;
+  }
+  if (g_stop) {
+    sem_post(&g_queue_items); // pass the wakeup on to the next worker
+    return NULL;
+  }
+  /* The semaphore guarantees an element; it may just not be published yet */
+  while (lfq_pop(&g_queue, &item) < 0) {
+    sched_yield();
+  }
+  return item;
+}
+
+/* One record per connection of a verified batch; the batch's CPU time is
+ * split evenly. Runs before conn_finish() so the socket is still open. */
+static void log_batch(worker_ctx_t *w, conn_t *const *batch, const int *results,
+                      unsigned int n, uint64_t t0, uint64_t t1) {
+  binlog_rec_t rec;
+  unsigned int i;
+
+  memset(&rec, 0, sizeof(rec));
+  binlog_stamp(&rec, &w->cpu_mark);
+  rec.source = BINLOG_SRC_SERVER_EPOLL;
+  rec.rounds = 1;
+  rec.challenge_len = (uint32_t)g_challenge_len;
+  rec.cpu_user_us /= n;
+  rec.cpu_sys_us /= n;
+  rec.stage_us[2] = (uint32_t)((t1 - t0) / n / 1000);
+  for (i = 0; i < n; ++i) {
+    const conn_t *c = batch[i];
+    struct sockaddr_in peer;
+    socklen_t peer_len = sizeof(peer);
+
+    if (getpeername(c->fd, (struct sockaddr *)&peer, &peer_len) == 0) {
+      rec.peer_addr = peer.sin_addr.s_addr;
+      rec.peer_port = ntohs(peer.sin_port);
+    } else {
+      rec.peer_addr = 0;
+      rec.peer_port = 0;
+    }
+    rec.result = results[i] == 0 ? BINLOG_RESULT_OK : BINLOG_RESULT_FAIL;
+    rec.sig_len = c->sig_len;
+    rec.stage_us[0] = (uint32_t)((c->t_queued - c->t_accept) / 1000);
+    rec.stage_us[1] = (uint32_t)((t0 - c->t_queued) / 1000);
+    rec.total_us = (uint32_t)((t1 - c->t_accept) / 1000);
+    binlog_push(w->log, &rec);
+  }
+}
+
+static void *worker_thread(void *arg) {
+  worker_ctx_t *w = arg;
+  conn_t *batch[MAX_BATCH];
+  const uint8_t *sigs[MAX_BATCH];
+  size_t siglens[MAX_BATCH];
+  int results[MAX_BATCH];
+  unsigned int i, n;
+
+  if (w->cpu >= 0) {
+    pin_to_cpu(w->cpu);
+  }
+
+  for (;;) {
+    batch[0] = next_conn(NULL);
+    if (!batch[0]) {
+      break;
+    }
+
+    /* Batching window: take whatever else is queued already, then wait for
+     * more until the batch is full or the window closes */
+    struct timespec deadline;
+    const struct timespec *until = &deadline;
+    if (g_batch_wait_us > 0) {
+      clock_gettime(CLOCK_REALTIME, &deadline); // sem_timedwait's clock
+      deadline.tv_nsec += (long)(g_batch_wait_us % 1000000) * 1000;
+      deadline.tv_sec += g_batch_wait_us / 1000000 + deadline.tv_nsec / 1000000000;
+      deadline.tv_nsec %= 1000000000;
+    } else {
+      deadline.tv_sec = 0; // already expired: sem_timedwait only takes ready items
+      deadline.tv_nsec = 0;
+    }
+    for (n = 1; n < g_batch_max; ++n) {
+      if (!(batch[n] = next_conn(until))) {
+        break;
+      }
+    }
+
+    /* Every signature is over g_challenge under g_pk: the key expansion and
+     * mu are shared by all of them, only the lattice part is per signature
+     * and the final challenge hashes run four at a time */
+    for (i = 0; i < n; ++i) {
+      sigs[i] = batch[i]->sig_ptr;
+      siglens[i] = batch[i]->sig_len;
+    }
+    uint64_t t0 = get_time_ns();
+    crypto_sign_verify_batch_mu(results, sigs, siglens, g_mu, &g_vctx, n);
+    uint64_t t1 = get_time_ns();
+
+    counter_inc(&w->stats->batches);
+    if (w->log) {
+      log_batch(w, batch, results, n, t0, t1);
+    }
+    for (i = 0; i < n; ++i) {
+      conn_t *c = batch[i];
+      uint64_t t_sent = c->t_sent ? c->t_sent : c->t_accept;
+      hist_add(&w->stats->send_ns, t_sent - c->t_accept);
+      hist_add(&w->stats->recv_ns, c->t_queued - t_sent);
+      hist_add(&w->stats->verify_ns, (t1 - t0) / n);
+      hist_add(&w->stats->wait_ns, t0 - c->t_queued);
+      hist_add(&w->stats->total_ns, t1 - c->t_accept);
+      counter_inc(results[i] == 0 ? &w->stats->ok : &w->stats->fail);
+      conn_finish(c);
+    }
+  }
+
+  return NULL;
+}
+
+typedef struct {
+  uint64_t accepted;
+  uint64_t errors;
+  uint64_t zerocopy;
+  uint64_t ok;
+  uint64_t fail;
+  uint64_t batches;
+  hist_t send_ns;
+  hist_t recv_ns;
+  hist_t verify_ns;
+  hist_t wait_ns;
+  hist_t total_ns;
+} snapshot_t;
+
+static void take_snapshot(snapshot_t *s,
+                          const io_stats_t *io, unsigned int nio,
+                          const worker_stats_t *ws, unsigned int nworkers) {
+  unsigned int i;
+
+  memset(s, 0, sizeof(*s));
+  for (i = 0; i < nio; ++i) {
+    s->accepted += __atomic_load_n(&io[i].accepted, __ATOMIC_RELAXED);
+    s->errors += __atomic_load_n(&io[i].errors, __ATOMIC_RELAXED);
+    s->zerocopy += __atomic_load_n(&io[i].zerocopy, __ATOMIC_RELAXED);
+  }
+  for (i = 0; i < nworkers; ++i) {
+    s->ok += __atomic_load_n(&ws[i].ok, __ATOMIC_RELAXED);
+    s->fail += __atomic_load_n(&ws[i].fail, __ATOMIC_RELAXED);
+    s->batches += __atomic_load_n(&ws[i].batches, __ATOMIC_RELAXED);
+    hist_merge(&s->send_ns, &ws[i].send_ns);
+    hist_merge(&s->recv_ns, &ws[i].recv_ns);
+    hist_merge(&s->verify_ns, &ws[i].verify_ns);
+    hist_merge(&s->wait_ns, &ws[i].wait_ns);
+    hist_merge(&s->total_ns, &ws[i].total_ns);
+  }
+}
+
+/* Interval histogram = cur - prev, bucket by bucket */
+static void hist_delta(hist_t *d, const hist_t *cur, const hist_t *prev) {
+  unsigned int i;
+
+  for (i = 0; i < HIST_BUCKETS; ++i) {
+    d->count[i] = cur->count[i] - prev->count[i];
+  }
+  d->total = cur->total - prev->total;
+  d->sum = cur->sum - prev->sum;
+  d->max = cur->max;
+}
+
+static void print_stats(const char *tag, const snapshot_t *cur, const snapshot_t *prev,
+                        double seconds) {
+  static hist_t verify, wait, total;
+  uint64_t done = (cur->ok + cur->fail) - (prev->ok + prev->fail);
+  uint64_t batches = cur->batches - prev->batches;
+
+  hist_delta(&verify, &cur->verify_ns, &prev->verify_ns);
+  hist_delta(&wait, &cur->wait_ns, &prev->wait_ns);
+  hist_delta(&total, &cur->total_ns, &prev->total_ns);
+
+  printf("[%s] %.1fs conns/s=%.1f verified/s=%.1f ok=%llu fail=%llu errors=%llu "
+         "verify_us p50=%.1f p99=%.1f total_us p50=%.1f p99=%.1f\n",
+         tag, seconds,
+         (double)(cur->accepted - prev->accepted) / seconds,
+         (double)done / seconds,
+         (unsigned long long)(cur->ok - prev->ok),
+         (unsigned long long)(cur->fail - prev->fail),
+         (unsigned long long)(cur->errors - prev->errors),
+         hist_quantile(&verify, 0.50) / 1e3, hist_quantile(&verify, 0.99) / 1e3,
+         hist_quantile(&total, 0.50) / 1e3, hist_quantile(&total, 0.99) / 1e3);
+  /* Batching trades added latency (wait) for cheaper verification */
+  printf("[%s] batch avg=%.2f wait_us p50=%.1f p99=%.1f\n", tag,
+         batches ? (double)done / (double)batches : 0.0,
+         hist_quantile(&wait, 0.50) / 1e3, hist_quantile(&wait, 0.99) / 1e3);
+#ifdef SERVER_IO_URING
+  printf("[%s] verified in place: %llu of %llu\n", tag,
+         (unsigned long long)(cur->zerocopy - prev->zerocopy), (unsigned long long)done);
+#endif
+  fflush(stdout);
+}
+
+/* The metrics thread takes its own snapshot, cumulative since start */
+typedef struct {
+  const io_stats_t *io;
+  unsigned int nio;
+  const worker_stats_t *ws;
+  unsigned int nworkers;
+  snapshot_t snap;
+} metrics_ctx_t;
+
+static void collect_metrics(metrics_snapshot_t *m, void *arg) {
+  static const char *const stage_names[] = {"send", "recv", "wait", "verify", "total"};
+  metrics_ctx_t *ctx = arg;
+  snapshot_t *s = &ctx->snap;
+  unsigned int i;
+
+  take_snapshot(s, ctx->io, ctx->nio, ctx->ws, ctx->nworkers);
+  m->connections = s->accepted;
+  m->valid = s->ok;
+  m->invalid = s->fail;
+  m->errors = s->errors;
+  m->nstages = 5;
+  for (i = 0; i < m->nstages; ++i) {
+    m->stage_names[i] = stage_names[i];
+  }
+  m->stage_ns[0] = s->send_ns;
+  m->stage_ns[1] = s->recv_ns;
+  m->stage_ns[2] = s->wait_ns;
+  m->stage_ns[3] = s->verify_ns;
+  m->stage_ns[4] = s->total_ns;
+  m->extra_names[m->nextra] = "batches";
+  m->extra_help[m->nextra] = "Verification batches taken from the queue";
+  m->extra[m->nextra++] = s->batches;
+#ifdef SERVER_IO_URING
+  m->extra_names[m->nextra] = "zerocopy";
+  m->extra_help[m->nextra] = "signatures verified straight from a receive buffer";
+  m->extra[m->nextra++] = s->zerocopy;
+#endif
+}
+
+int main(void) {
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  unsigned int port = parse_uint_env("SERVER_PORT", SERVER_PORT);
+  unsigned int nio = parse_uint_env("SERVER_IO_THREADS", DEFAULT_IO_THREADS);
+  unsigned int nworkers = parse_uint_env("SERVER_WORKERS", ncpu > 0 ? (unsigned int)ncpu : 1);
+  unsigned int pin = parse_uint_env("SERVER_PIN", 1);
+  unsigned int stats_sec = parse_uint_env("SERVER_STATS_SEC", DEFAULT_STATS_SEC);
+  g_batch_max = parse_uint_env("SERVER_BATCH_MAX", 1);
+  g_batch_wait_us = parse_uint_env("SERVER_BATCH_WAIT_US", 0);
+  const char *log_path = getenv("SERVER_LOG");
+  const char *metrics_on = getenv("SERVER_METRICS");
+  binlog_t *log = NULL;
+  metrics_server_t *metrics = NULL;
+  pthread_t io_tid[MAX_THREADS], worker_tid[MAX_THREADS];
+  io_ctx_t io_ctx[MAX_THREADS];
+  worker_ctx_t worker_ctx[MAX_THREADS];
+  unsigned int i;
+
+  if (nio == 0 || nio > MAX_THREADS || nworkers == 0 || nworkers > MAX_THREADS || port > 65535 ||
+      g_batch_max == 0 || g_batch_max > MAX_BATCH) {
+    fprintf(stderr, "Invalid configuration\n");
+    return 1;
+  }
+
+  if (load_file_exact(SERVER_PK_PATH, g_pk, CRYPTO_PUBLICKEYBYTES) < 0) {
+    fprintf(stderr, "Failed to load public key from %s\n", SERVER_PK_PATH);
+    return 1;
+  }
+  load_challenge(g_challenge, &g_challenge_len);
+  crypto_sign_pk_expand(&g_vctx, g_pk);
+  crypto_sign_mu_ctx(g_mu, g_challenge, g_challenge_len, NULL, 0, &g_vctx);
+  uint32_t len_net = htonl((uint32_t)g_challenge_len);
+  memcpy(g_challenge_msg, &len_net, sizeof(len_net));
+  memcpy(g_challenge_msg + sizeof(len_net), g_challenge, g_challenge_len);
+  g_challenge_msg_len = sizeof(len_net) + g_challenge_len;
+
+  io_stats_t *io_stats = calloc(nio, sizeof(io_stats_t));
+  worker_stats_t *worker_stats = calloc(nworkers, sizeof(worker_stats_t));
+  snapshot_t *first = calloc(1, sizeof(snapshot_t));
+  snapshot_t *prev = calloc(1, sizeof(snapshot_t));
+  snapshot_t *cur = calloc(1, sizeof(snapshot_t));
+  metrics_ctx_t *metrics_ctx = calloc(1, sizeof(metrics_ctx_t));
+  if (!io_stats || !worker_stats || !first || !prev || !cur || !metrics_ctx ||
+      lfq_init(&g_queue, QUEUE_CAPACITY) < 0 || sem_init(&g_queue_items, 0, 0) < 0) {
+    fprintf(stderr, "Out of memory\n");
+    return 1;
+  }
+
+  if (log_path && *log_path != '\0') {
+    log = binlog_open(log_path, nworkers, LOG_RING, 0);
+    if (!log) {
+      fprintf(stderr, "Cannot open %s\n", log_path);
+      return 1;
+    }
+  }
+
+  if (metrics_on && *metrics_on != '\0') {
+    metrics_ctx->io = io_stats;
+    metrics_ctx->nio = nio;
+    metrics_ctx->ws = worker_stats;
+    metrics_ctx->nworkers = nworkers;
+    metrics = metrics_start(metrics_on, "dilithium_server", collect_metrics, metrics_ctx);
+    if (!metrics) {
+      return 1;
+    }
+  }
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_signal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  for (i = 0; i < nio; ++i) {
+    io_ctx[i].listen_fd = make_listen_socket((uint16_t)port);
+    if (io_ctx[i].listen_fd < 0) {
+      return 1;
+    }
+    io_ctx[i].stats = &io_stats[i];
+#ifdef SERVER_IO_URING
+    io_ctx[i].starved = NULL;
+    io_ctx[i].bufs_freed = 0;
+    io_ctx[i].efd = eventfd(0, EFD_CLOEXEC);
+    if (io_ctx[i].efd < 0 || lfq_init(&io_ctx[i].done, QUEUE_CAPACITY) < 0) {
+      fprintf(stderr, "Out of memory\n");
+      return 1;
+    }
+#endif
+  }
+
+#ifdef SERVER_IO_URING
+  printf("\n========= Dilithium Server (io_uring) =========\n");
+#else
+  printf("\n========== Dilithium Server (epoll) ==========\n");
+#endif
+  printf("Port %u, %u I/O thread(s), %u worker(s)%s, challenge %zu bytes\n",
+         port, nio, nworkers, pin ? " pinned" : "", g_challenge_len);
+  printf("Verify batches of up to %u, waiting up to %u us\n", g_batch_max, g_batch_wait_us);
+  if (log) {
+    printf("Logging to %s\n", log_path);
+  }
+  if (metrics) {
+    printf("Metrics on %s (GET /metrics)\n", metrics_on);
+  }
+  printf("==============================================\n\n");
+
+  for (i = 0; i < nworkers; ++i) {
+    worker_ctx[i].cpu = (pin && ncpu > 0) ? (int)(i % (unsigned int)ncpu) : -1;
+    worker_ctx[i].stats = &worker_stats[i];
+    worker_ctx[i].log = log ? binlog_ring(log, i) : NULL;
+    memset(&worker_ctx[i].cpu_mark, 0, sizeof(worker_ctx[i].cpu_mark));
+    pthread_create(&worker_tid[i], NULL, worker_thread, &worker_ctx[i]);
+  }
+  for (i = 0; i < nio; ++i) {
+    pthread_create(&io_tid[i], NULL, io_thread, &io_ctx[i]);
+  }
+
+  uint64_t t_start = get_time_ns(), t_prev = t_start;
+  while (!g_stop) {
+    struct timespec ts = {1, 0};
+    nanosleep(&ts, NULL);
+    uint64_t t_now = get_time_ns();
+    if (stats_sec > 0 && t_now - t_prev >= (uint64_t)stats_sec * 1000000000ull) {
+      take_snapshot(cur, io_stats, nio, worker_stats, nworkers);
+      print_stats("STATS", cur, prev, (double)(t_now - t_prev) / 1e9);
+      snapshot_t *tmp = prev;
+      prev = cur;
+      cur = tmp;
+      t_prev = t_now;
+    }
+  }
+
+#ifdef SERVER_IO_URING
+  for (i = 0; i < nio; ++i) {
+    uint64_t one = 1;
+    if (write(io_ctx[i].efd, &one, sizeof(one)) != sizeof(one)) {
+      perror("write() failed");
+    }
+  }
+#endif
+  for (i = 0; i < nio; ++i) {
+    pthread_join(io_tid[i], NULL);
+    close(io_ctx[i].listen_fd);
+  }
+  for (i = 0; i < nworkers; ++i) {
+    sem_post(&g_queue_items);
+  }
+  for (i = 0; i < nworkers; ++i) {
+    pthread_join(worker_tid[i], NULL);
+  }
+
+  metrics_stop(metrics);
+  take_snapshot(cur, io_stats, nio, worker_stats, nworkers);
+  print_stats("TOTAL", cur, first, (double)(get_time_ns() - t_start) / 1e9);
+  if (log) {
+    uint64_t dropped = binlog_close(log);
+    if (dropped > 0) {
+      printf("[LOG] %llu records dropped\n", (unsigned long long)dropped);
+    }
+  }
+
+  lfq_free(&g_queue);
+  sem_destroy(&g_queue_items);
+  free(io_stats);
+  free(worker_stats);
+  free(first);
+  free(prev);
+  free(cur);
+  free(metrics_ctx);
+  return 0;
+}
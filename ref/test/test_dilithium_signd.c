@@ -0,0 +1,852 @@
+#define _GNU_SOURCE
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <poll.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+
+#include "../randombytes.h"
+#include "../sign.h"
+#include "hist.h"
+#include "lfqueue.h"
+#include "signd.h"
+#include "team.h"
+
+/* Local signing daemon (signd.h). The secret key is read and expanded
+ * once at startup; a pool of pinned worker threads then signs for any
+ * process that can reach the Unix socket (created mode 0600) or, with
+ * SIGND_SHM, the shared memory table.
+ *
+ *   I/O thread:   epoll loop over the socket connections, splits the byte
+ *                 stream into requests and queues them.
+ *   Shm thread:   polls the shared memory table for requested slots and
+ *                 queues them; sleeps on the doorbell futex when idle.
+ *   Workers:      take up to SIGND_BATCH_MAX queued requests at once, draw
+ *                 the signing randomness for all of them with one
+ *                 randombytes() call, sign them with the shared expanded
+ *                 key and answer each connection with one send().
+ *   Pool filler:  with SIGND_POOL, precomputes single-use commitments
+ *                 (crypto_sign_commit) at SCHED_IDLE priority, so it only
+ *                 runs on otherwise idle CPU time. Workers then sign with
+ *                 crypto_sign_signature_commit, which leaves only the
+ *                 message-dependent part of each attempt, and fall back to
+ *                 ordinary signing when the pool runs dry. This is NOT the
+ *                 FIPS 204 signing algorithm (see sign.h) and is off by
+ *                 default.
+ *   Spec helpers: with SIGND_SPEC, each worker owns a team of that many
+ *                 threads (itself included) that try several rejection
+ *                 loop attempts of one signature at once
+ *                 (crypto_sign_signature_mu_spec); the signatures are the
+ *                 same as without.
+ *   Row helpers:  with SIGND_ROWS instead, the worker's team splits the
+ *                 rows of matrix A within each attempt
+ *                 (crypto_sign_set_team); also the same signatures.
+ *
+ * Configuration (environment):
+ *   SIGND_SOCKET     Unix socket path (default signd.sock)
+ *   SIGND_KEY        secret key file (default client_sk.bin)
+ *   SIGND_WORKERS    signing threads (default: online CPUs)
+ *   SIGND_PIN        pin workers to CPUs (default 1)
+ *   SIGND_BATCH_MAX  requests a worker takes from the queue at once (default 16)
+ *   SIGND_SHM        also serve the shared memory table of this name, e.g.
+ *                    /dilithium-signd (default: socket only)
+ *   SIGND_SHM_SLOTS  slots in that table (default 64)
+ *   SIGND_SPIN_US    how long the shm thread polls before sleeping (default 50,
+ *                    0 on a single CPU)
+ *   SIGND_POOL       precomputed commitments to keep (default 0: off)
+ *   SIGND_SPEC       signing attempts each worker runs at once (default 1,
+ *                    at most 8); meant for few workers on many cores
+ *   SIGND_ROWS       threads each worker splits the rows of A over (default
+ *                    1, at most K); not together with SIGND_SPEC
+ */
+
+#define SIGND_KEY_PATH "client_sk.bin"
+#define DEFAULT_BATCH_MAX 16
+#define DEFAULT_SPIN_US 50
+#define MAX_BATCH 64
+#define MAX_POOL 65536
+#define QUEUE_CAPACITY 4096
+#define MAX_EVENTS 256
+#define MAX_THREADS 256
+#define SEND_TIMEOUT_MS 1000 /* a client that stops reading loses its connection */
+
+typedef struct client {
+  int fd;
+  int refs; // I/O thread while connected, plus one per queued request
+  pthread_mutex_t send_lock;
+  size_t have;
+  uint8_t buf[PROTO_HDR_BYTES + SIGND_MAX_MSG];
+} client_t;
+
+/* One signing request: from a connection, or a shared memory slot */
+typedef struct {
+  client_t *cl;     // NULL for a slot
+  signd_slot *slot; // NULL for a connection
+  uint32_t request_id;
+  uint32_t mlen;
+  const uint8_t *msg;
+  uint64_t t_queued;
+} job_t;
+
+/* Written only by the owning worker, read at exit */
+typedef struct {
+  uint64_t socket;
+  uint64_t shm;
+  uint64_t batches;
+  uint64_t pooled;   // signed from the commitment pool alone
+  uint64_t unpooled; // pool ran dry during the signature
+  hist_t sign_ns; // per request (batch time / batch size)
+  hist_t wait_ns; // queued to batch start
+} __attribute__((aligned(64))) worker_stats_t;
+
+typedef struct {
+  int cpu;
+  worker_stats_t *stats;
+} worker_ctx_t;
+
+static sign_ctx g_sctx;
+static lfqueue g_queue;
+static sem_t g_queue_items;
+static volatile sig_atomic_t g_stop = 0;
+static unsigned int g_batch_max = DEFAULT_BATCH_MAX;
+static unsigned int g_spec = 1;
+static unsigned int g_rows = 1;
+static signd_shm *g_shm = NULL;
+static job_t *g_shm_jobs = NULL; // one per slot
+
+/* Commitment pool (SIGND_POOL): every entry is either on g_pool_ready,
+ * on g_pool_free or in the hands of one thread, so none is used twice */
+static sign_commitment *g_pool = NULL;
+static lfqueue g_pool_ready;
+static lfqueue g_pool_free;
+static sem_t g_pool_free_items;
+
+static uint64_t get_time_ns(void) {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+    return 0;
+  }
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static unsigned int parse_uint_env(const char *name, unsigned int def_value) {
+  const char *val = getenv(name);
+  if (!val || *val == '\0') {
+    return def_value;
+  }
+
+  char *end = NULL;
+  unsigned long parsed = strtoul(val, &end, 10);
+  if (!end || *end != '\0' || parsed > UINT_MAX) {
+    return def_value;
+  }
+  return (unsigned int)parsed;
+}
+
+static int load_file_exact(const char *path, uint8_t *buf, size_t len) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    return -1;
+  }
+
+  size_t n = fread(buf, 1, len, f);
+  fclose(f);
+
+  if (n != len) {
+    return -1;
+  }
+
+  return 0;
+}
+
+static void on_signal(int sig) {
+  (void)sig;
+  g_stop = 1;
+}
+
+static long futex(uint32_t *addr, int op, uint32_t val, const struct timespec *timeout) {
+  return syscall(SYS_futex, addr, op, val, timeout, NULL, 0);
+}
+
+static void counter_inc(uint64_t *c) {
+  __atomic_store_n(c, __atomic_load_n(c, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+}
+
+static void queue_job(job_t *j) {
+  j->t_queued = get_time_ns();
+  while (lfq_push(&g_queue, j) < 0) {
+    sched_yield(); // queue full: back-pressure on the caller
+  }
+  sem_post(&g_queue_items);
+}
+
+static void client_put(client_t *cl) {
+  if (__atomic_sub_fetch(&cl->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+    close(cl->fd);
+    pthread_mutex_destroy(&cl->send_lock);
+    free(cl);
+  }
+}
+
+/* The socket is non-blocking for the I/O thread; workers wait for room */
+static int client_send(client_t *cl, const uint8_t *buf, size_t len) {
+  struct pollfd pfd;
+  size_t off = 0;
+
+  while (off < len) {
+    ssize_t n = send(cl->fd, buf + off, len - off, MSG_NOSIGNAL);
+    if (n >= 0) {
+      off += (size_t)n;
+      continue;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      return -1;
+    }
+    pfd.fd = cl->fd;
+    pfd.events = POLLOUT;
+    if (poll(&pfd, 1, SEND_TIMEOUT_MS) <= 0) {
+      shutdown(cl->fd, SHUT_RDWR); // the I/O thread sees EOF and lets go
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static void send_error(client_t *cl, uint32_t request_id) {
+  uint8_t hdr[PROTO_HDR_BYTES];
+  proto_hdr h = {SIGND_ERROR, 0, 0, request_id, 0};
+
+  proto_hdr_pack(hdr, &h);
+  pthread_mutex_lock(&cl->send_lock);
+  client_send(cl, hdr, sizeof(hdr));
+  pthread_mutex_unlock(&cl->send_lock);
+}
+
+/* Queue every complete request in cl->buf. Returns -1 to drop the client. */
+static int client_parse(client_t *cl) {
+  size_t off = 0;
+  proto_hdr h;
+
+  while (cl->have - off >= PROTO_HDR_BYTES) {
+    proto_hdr_unpack(&h, cl->buf + off);
+    if (h.type != SIGND_SIGN || h.length > SIGND_MAX_MSG) {
+      send_error(cl, h.request_id);
+      return -1;
+    }
+    if (cl->have - off < PROTO_HDR_BYTES + h.length) {
+      break;
+    }
+
+    job_t *j = malloc(sizeof(*j) + h.length);
+    if (!j) {
+      return -1;
+    }
+    j->cl = cl;
+    j->slot = NULL;
+    j->request_id = h.request_id;
+    j->mlen = h.length;
+    j->msg = (const uint8_t *)(j + 1);
+    memcpy(j + 1, cl->buf + off + PROTO_HDR_BYTES, h.length);
+    __atomic_add_fetch(&cl->refs, 1, __ATOMIC_RELAXED);
+    queue_job(j);
+    off += PROTO_HDR_BYTES + h.length;
+  }
+  memmove(cl->buf, cl->buf + off, cl->have - off);
+  cl->have -= off;
+  return 0;
+}
+
+static int client_ready(client_t *cl) {
+  for (;;) {
+    ssize_t n = recv(cl->fd, cl->buf + cl->have, sizeof(cl->buf) - cl->have, 0);
+    if (n == 0) {
+      return -1;
+    }
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+    cl->have += (size_t)n;
+    if (client_parse(cl) < 0) {
+      return -1;
+    }
+  }
+}
+
+static void accept_ready(int listen_fd, int ep) {
+  for (;;) {
+    int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+
+    client_t *cl = malloc(sizeof(*cl));
+    if (!cl) {
+      close(fd);
+      continue;
+    }
+    cl->fd = fd;
+    cl->refs = 1;
+    cl->have = 0;
+    pthread_mutex_init(&cl->send_lock, NULL);
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = cl;
+    if (epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev) < 0) {
+      client_put(cl);
+    }
+  }
+}
+
+static void *io_thread(void *arg) {
+  int listen_fd = *(const int *)arg;
+  struct epoll_event events[MAX_EVENTS];
+  struct epoll_event ev;
+  int ep = epoll_create1(0);
+
+  if (ep < 0) {
+    perror("epoll_create1() failed");
+    g_stop = 1;
+    return NULL;
+  }
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL; // NULL marks the listening socket
+  if (epoll_ctl(ep, EPOLL_CTL_ADD, listen_fd, &ev) < 0) {
+    perror("epoll_ctl() failed");
+    g_stop = 1;
+    close(ep);
+    return NULL;
+  }
+
+  while (!g_stop) {
+    int n = epoll_wait(ep, events, MAX_EVENTS, 100);
+    for (int i = 0; i < n; ++i) {
+      client_t *cl = events[i].data.ptr;
+      if (!cl) {
+        accept_ready(listen_fd, ep);
+      } else if (client_ready(cl) < 0) {
+        epoll_ctl(ep, EPOLL_CTL_DEL, cl->fd, NULL);
+        client_put(cl);
+      }
+    }
+  }
+
+  close(ep);
+  return NULL;
+}
+
+/* Queue every requested slot; returns how many were found */
+static unsigned int shm_scan(void) {
+  unsigned int i, found = 0;
+
+  for (i = 0; i < g_shm->nslots; ++i) {
+    signd_slot *slot = &g_shm->slots[i];
+    uint32_t expect = SIGND_SLOT_REQUEST;
+    if (__atomic_load_n(&slot->state, __ATOMIC_RELAXED) == SIGND_SLOT_REQUEST &&
+        __atomic_compare_exchange_n(&slot->state, &expect, SIGND_SLOT_BUSY, 0,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      job_t *j = &g_shm_jobs[i];
+      j->mlen = slot->mlen <= SIGND_SHM_MSG_MAX ? slot->mlen : SIGND_SHM_MSG_MAX + 1;
+      queue_job(j);
+      ++found;
+    }
+  }
+  return found;
+}
+
+static void *shm_thread(void *arg) {
+  uint64_t spin_ns = (uint64_t)*(const unsigned int *)arg * 1000;
+  uint64_t idle_since = get_time_ns();
+  const struct timespec tick = {0, 100000000}; // notice g_stop while idle
+
+  while (!g_stop) {
+    /* A request rung in after this load makes the futex wait return at once */
+    uint32_t seen = __atomic_load_n(&g_shm->doorbell, __ATOMIC_SEQ_CST);
+    if (shm_scan() > 0) {
+      idle_since = get_time_ns();
+      continue;
+    }
+    if (get_time_ns() - idle_since < spin_ns) {
+      signd_relax();
+      continue;
+    }
+    __atomic_store_n(&g_shm->sleeping, 1, __ATOMIC_SEQ_CST);
+    futex(&g_shm->doorbell, FUTEX_WAIT, seen, &tick);
+    __atomic_store_n(&g_shm->sleeping, 0, __ATOMIC_RELAXED);
+    idle_since = get_time_ns();
+  }
+  return NULL;
+}
+
+static void pin_to_cpu(int cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+    fprintf(stderr, "[WARNING] Cannot pin worker to CPU %d\n", cpu);
+  }
+}
+
+/* Next queued request; blocks unless wait is 0. NULL when there is none
+ * (wait == 0) or on shutdown. */
+static job_t *next_job(int wait) {
+  void *item;
+  int r;
+
+  do {
+    r = wait ? sem_wait(&g_queue_items) : sem_trywait(&g_queue_items);
+  } while (r < 0 && errno == EINTR);
+  if (r < 0) {
+    return NULL;
+  }
+  if (g_stop) {
+    sem_post(&g_queue_items); // pass the wakeup on to the next worker
+    return NULL;
+  }
+  /* The semaphore guarantees an element; it may just not be published yet */
+  while (lfq_pop(&g_queue, &item) < 0) {
+    sched_yield();
+  }
+  return item;
+}
+
+static void finish_slot(signd_slot *slot, const uint8_t *sig, size_t siglen) {
+  if (siglen > 0) {
+    memcpy(slot->sig, sig, siglen);
+  }
+  slot->siglen = (uint32_t)siglen;
+  __atomic_store_n(&slot->state, SIGND_SLOT_DONE, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&slot->waiting, __ATOMIC_SEQ_CST)) {
+    futex(&slot->state, FUTEX_WAKE, 1, NULL);
+  }
+}
+
+static void *pool_thread(void *arg) {
+  struct sched_param sp = {0};
+  uint64_t *made = arg;
+  void *item;
+
+  if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &sp) != 0) {
+    fprintf(stderr, "[WARNING] Cannot lower the pool filler to SCHED_IDLE\n");
+  }
+  for (;;) {
+    while (sem_wait(&g_pool_free_items) < 0 && errno == EINTR) {
+    }
+    if (g_stop) {
+      break;
+    }
+    while (lfq_pop(&g_pool_free, &item) < 0) {
+      sched_yield();
+    }
+    crypto_sign_commit(item, &g_sctx);
+    lfq_push(&g_pool_ready, item); // cannot be full: it holds at most the whole pool
+    counter_inc(made);
+  }
+  return NULL;
+}
+
+/* Sign with precomputed commitments while the pool lasts, then the
+ * ordinary way; returns 1 if the pool covered the whole signature */
+static int sign_pooled(uint8_t *sig, size_t *siglen, const uint8_t mu[CRHBYTES],
+                       const uint8_t rnd[RNDBYTES], const sign_team *team) {
+  void *item;
+
+  while (lfq_pop(&g_pool_ready, &item) == 0) {
+    int rc = crypto_sign_signature_commit(sig, siglen, mu, item, &g_sctx);
+    lfq_push(&g_pool_free, item);
+    sem_post(&g_pool_free_items);
+    if (rc == 0) {
+      return 1;
+    }
+  }
+  crypto_sign_signature_mu_spec(sig, siglen, mu, rnd, &g_sctx, team);
+  return 0;
+}
+
+static void *worker_thread(void *arg) {
+  worker_ctx_t *w = arg;
+  job_t *batch[MAX_BATCH];
+  static __thread uint8_t sigs[MAX_BATCH][CRYPTO_BYTES];
+  static __thread uint8_t out[MAX_BATCH * (PROTO_HDR_BYTES + CRYPTO_BYTES)];
+  size_t siglens[MAX_BATCH];
+  uint8_t rnd[MAX_BATCH][RNDBYTES];
+  uint8_t mu[CRHBYTES];
+  const uint8_t pre[2] = {0, 0}; // empty context string
+  const sign_team *team = NULL;
+  team_t helpers;
+  unsigned int i, j, n;
+
+  if (w->cpu >= 0) {
+    pin_to_cpu(w->cpu);
+  }
+  if (g_spec > 1 || g_rows > 1) {
+    if (team_init(&helpers, g_spec > 1 ? g_spec : g_rows) < 0) {
+      fprintf(stderr, "[WARNING] Cannot start signing helpers\n");
+    }
+    if (g_spec > 1) {
+      team = &helpers.team;
+    } else {
+      crypto_sign_set_team(&helpers.team);
+    }
+  }
+
+  for (;;) {
+    if (!(batch[0] = next_job(1))) {
+      break;
+    }
+    for (n = 1; n < g_batch_max; ++n) {
+      if (!(batch[n] = next_job(0))) {
+        break;
+      }
+    }
+
+    uint64_t t0 = get_time_ns();
+#ifdef DILITHIUM_RANDOMIZED_SIGNING
+    randombytes(rnd[0], (size_t)n * RNDBYTES); // one getrandom() per batch
+#else
+    memset(rnd, 0, sizeof(rnd));
+#endif
+    for (i = 0; i < n; ++i) {
+      siglens[i] = 0;
+      if (batch[i]->mlen > (batch[i]->slot ? SIGND_SHM_MSG_MAX : SIGND_MAX_MSG)) {
+        continue;
+      }
+      crypto_sign_mu_internal(mu, batch[i]->msg, batch[i]->mlen, pre, sizeof(pre), &g_sctx);
+      if (g_pool) {
+        counter_inc(sign_pooled(sigs[i], &siglens[i], mu, rnd[i], team) ? &w->stats->pooled
+                                                                        : &w->stats->unpooled);
+      } else {
+        crypto_sign_signature_mu_spec(sigs[i], &siglens[i], mu, rnd[i], &g_sctx, team);
+      }
+    }
+    uint64_t t1 = get_time_ns();
+
+    counter_inc(&w->stats->batches);
+    for (i = 0; i < n; ++i) {
+      hist_add(&w->stats->sign_ns, (t1 - t0) / n);
+      hist_add(&w->stats->wait_ns, t0 - batch[i]->t_queued);
+      if (batch[i]->slot) {
+        counter_inc(&w->stats->shm);
+        finish_slot(batch[i]->slot, sigs[i], siglens[i]);
+        batch[i] = NULL;
+      }
+    }
+
+    /* One send per connection for all of its answers in the batch */
+    for (i = 0; i < n; ++i) {
+      client_t *cl;
+      size_t len = 0;
+
+      if (!batch[i]) {
+        continue;
+      }
+      cl = batch[i]->cl;
+      for (j = i; j < n; ++j) {
+        if (!batch[j] || batch[j]->cl != cl) {
+          continue;
+        }
+        proto_hdr h = {SIGND_SIGNATURE, 0, 0, batch[j]->request_id, (uint32_t)siglens[j]};
+        proto_hdr_pack(out + len, &h);
+        memcpy(out + len + PROTO_HDR_BYTES, sigs[j], siglens[j]);
+        len += PROTO_HDR_BYTES + siglens[j];
+        counter_inc(&w->stats->socket);
+        if (j > i) {
+          free(batch[j]);
+          batch[j] = NULL;
+          client_put(cl);
+        }
+      }
+      pthread_mutex_lock(&cl->send_lock);
+      client_send(cl, out, len);
+      pthread_mutex_unlock(&cl->send_lock);
+      free(batch[i]);
+      batch[i] = NULL;
+      client_put(cl);
+    }
+  }
+
+  if (g_spec > 1 || g_rows > 1) {
+    crypto_sign_set_team(NULL);
+    team_destroy(&helpers);
+  }
+  return NULL;
+}
+
+static int make_listen_socket(const char *path) {
+  struct sockaddr_un addr;
+  int fd;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "Socket path too long: %s\n", path);
+    return -1;
+  }
+  strcpy(addr.sun_path, path);
+  unlink(path);
+
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    perror("socket() failed");
+    return -1;
+  }
+  mode_t old_mask = umask(077); // whoever can connect can sign
+  int r = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+  umask(old_mask);
+  if (r < 0 || listen(fd, SOMAXCONN) < 0) {
+    perror("bind()/listen() failed");
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static signd_shm *make_shm(const char *name, unsigned int nslots) {
+  size_t len = signd_shm_size(nslots);
+  signd_shm *s;
+  int fd;
+
+  shm_unlink(name);
+  fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    fprintf(stderr, "Cannot create shared memory %s: %s\n", name, strerror(errno));
+    return NULL;
+  }
+  if (ftruncate(fd, (off_t)len) < 0) {
+    perror("ftruncate() failed");
+    close(fd);
+    shm_unlink(name);
+    return NULL;
+  }
+  s = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (s == MAP_FAILED) {
+    perror("mmap() failed");
+    shm_unlink(name);
+    return NULL;
+  }
+  s->nslots = nslots;
+  s->sig_bytes = CRYPTO_BYTES;
+  __atomic_store_n(&s->magic, SIGND_SHM_MAGIC, __ATOMIC_RELEASE); // callers check it last
+  return s;
+}
+
+int main(void) {
+  long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  unsigned int nworkers = parse_uint_env("SIGND_WORKERS", ncpu > 0 ? (unsigned int)ncpu : 1);
+  unsigned int pin = parse_uint_env("SIGND_PIN", 1);
+  unsigned int nslots = parse_uint_env("SIGND_SHM_SLOTS", SIGND_SHM_SLOTS);
+  unsigned int spin_us = parse_uint_env("SIGND_SPIN_US", ncpu > 1 ? DEFAULT_SPIN_US : 0);
+  const char *sock_path = getenv("SIGND_SOCKET");
+  const char *key_path = getenv("SIGND_KEY");
+  const char *shm_name = getenv("SIGND_SHM");
+  unsigned int npool = parse_uint_env("SIGND_POOL", 0);
+  static uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint64_t pool_made = 0;
+  pthread_t io_tid, shm_tid, pool_tid, worker_tid[MAX_THREADS];
+  worker_ctx_t worker_ctx[MAX_THREADS];
+  int listen_fd;
+  unsigned int i;
+
+  g_batch_max = parse_uint_env("SIGND_BATCH_MAX", DEFAULT_BATCH_MAX);
+  g_spec = parse_uint_env("SIGND_SPEC", 1);
+  g_rows = parse_uint_env("SIGND_ROWS", 1);
+  if (!sock_path || *sock_path == '\0') {
+    sock_path = SIGND_SOCKET;
+  }
+  if (!key_path || *key_path == '\0') {
+    key_path = SIGND_KEY_PATH;
+  }
+  if (shm_name && *shm_name == '\0') {
+    shm_name = NULL;
+  }
+  if (nworkers == 0 || nworkers > MAX_THREADS || g_batch_max == 0 || g_batch_max > MAX_BATCH ||
+      nslots == 0 || nslots > QUEUE_CAPACITY || npool > MAX_POOL || g_spec == 0 ||
+      g_spec > SIGN_SPEC_MAX_WIDTH || g_rows == 0 || g_rows > K ||
+      (g_spec > 1 && g_rows > 1)) {
+    fprintf(stderr, "Invalid configuration\n");
+    return 1;
+  }
+
+  if (load_file_exact(key_path, sk, sizeof(sk)) < 0) {
+    fprintf(stderr, "Missing %s. Run test_dilithium_keygen first.\n", key_path);
+    return 1;
+  }
+  crypto_sign_key_expand(&g_sctx, sk);
+  memset(sk, 0, sizeof(sk));
+
+  worker_stats_t *stats = calloc(nworkers, sizeof(worker_stats_t));
+  if (!stats || lfq_init(&g_queue, QUEUE_CAPACITY) < 0 || sem_init(&g_queue_items, 0, 0) < 0) {
+    fprintf(stderr, "Out of memory\n");
+    return 1;
+  }
+  if (shm_name) {
+    g_shm = make_shm(shm_name, nslots);
+    g_shm_jobs = calloc(nslots, sizeof(job_t));
+    if (!g_shm || !g_shm_jobs) {
+      return 1;
+    }
+    for (i = 0; i < nslots; ++i) {
+      g_shm_jobs[i].slot = &g_shm->slots[i];
+      g_shm_jobs[i].msg = g_shm->slots[i].msg;
+    }
+  }
+  if (npool > 0) {
+    size_t cap = 2;
+    while (cap < npool) {
+      cap *= 2;
+    }
+    g_pool = aligned_alloc(64, (size_t)npool * sizeof(sign_commitment));
+    if (!g_pool || lfq_init(&g_pool_ready, cap) < 0 || lfq_init(&g_pool_free, cap) < 0 ||
+        sem_init(&g_pool_free_items, 0, npool) < 0) {
+      fprintf(stderr, "Out of memory\n");
+      return 1;
+    }
+    for (i = 0; i < npool; ++i) {
+      lfq_push(&g_pool_free, &g_pool[i]);
+    }
+  }
+  listen_fd = make_listen_socket(sock_path);
+  if (listen_fd < 0) {
+    return 1;
+  }
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_signal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  printf("\n========== Dilithium Signing Daemon ==========\n");
+  printf("Key %s, socket %s, %u worker(s)%s, batches of up to %u\n",
+         key_path, sock_path, nworkers, pin ? " pinned" : "", g_batch_max);
+  if (g_shm) {
+    printf("Shared memory %s: %u slots, polling %u us before sleeping\n", shm_name, nslots, spin_us);
+  }
+  if (g_spec > 1) {
+    printf("Speculative signing: %u attempts at once per worker\n", g_spec);
+  }
+  if (g_rows > 1) {
+    printf("Row-parallel signing: %u threads per worker\n", g_rows);
+  }
+  if (g_pool) {
+    printf("Offline/online signing (not FIPS 204): pool of %u commitments (%zu KB)\n",
+           npool, (size_t)npool * sizeof(sign_commitment) / 1024);
+  }
+  printf("==============================================\n\n");
+  fflush(stdout);
+
+  for (i = 0; i < nworkers; ++i) {
+    worker_ctx[i].cpu = (pin && ncpu > 0) ? (int)(i % (unsigned int)ncpu) : -1;
+    worker_ctx[i].stats = &stats[i];
+    pthread_create(&worker_tid[i], NULL, worker_thread, &worker_ctx[i]);
+  }
+  pthread_create(&io_tid, NULL, io_thread, &listen_fd);
+  if (g_shm) {
+    pthread_create(&shm_tid, NULL, shm_thread, &spin_us);
+  }
+  if (g_pool) {
+    pthread_create(&pool_tid, NULL, pool_thread, &pool_made);
+  }
+
+  uint64_t t_start = get_time_ns();
+  while (!g_stop) {
+    struct timespec ts = {0, 100000000};
+    nanosleep(&ts, NULL);
+  }
+
+  pthread_join(io_tid, NULL);
+  if (g_shm) {
+    pthread_join(shm_tid, NULL);
+  }
+  for (i = 0; i < nworkers; ++i) {
+    sem_post(&g_queue_items);
+  }
+  for (i = 0; i < nworkers; ++i) {
+    pthread_join(worker_tid[i], NULL);
+  }
+  if (g_pool) {
+    sem_post(&g_pool_free_items);
+    pthread_join(pool_tid, NULL);
+  }
+  close(listen_fd);
+  unlink(sock_path);
+  if (g_shm) {
+    munmap(g_shm, signd_shm_size(nslots));
+    shm_unlink(shm_name);
+  }
+
+  /* Merge per-worker counters */
+  uint64_t n_socket = 0, n_shm = 0, batches = 0, pooled = 0, unpooled = 0;
+  hist_t *sign_ns = calloc(1, sizeof(hist_t));
+  hist_t *wait_ns = calloc(1, sizeof(hist_t));
+  if (sign_ns && wait_ns) {
+    for (i = 0; i < nworkers; ++i) {
+      n_socket += stats[i].socket;
+      n_shm += stats[i].shm;
+      batches += stats[i].batches;
+      pooled += stats[i].pooled;
+      unpooled += stats[i].unpooled;
+      hist_merge(sign_ns, &stats[i].sign_ns);
+      hist_merge(wait_ns, &stats[i].wait_ns);
+    }
+    double secs = (double)(get_time_ns() - t_start) / 1e9;
+    printf("[TOTAL] %.1fs signed=%llu (socket %llu, shm %llu) signed/s=%.1f avg_batch=%.2f "
+           "sign_us p50=%.1f p99=%.1f wait_us p50=%.1f p99=%.1f\n",
+           secs, (unsigned long long)(n_socket + n_shm), (unsigned long long)n_socket,
+           (unsigned long long)n_shm, secs > 0 ? (double)(n_socket + n_shm) / secs : 0.0,
+           batches ? (double)(n_socket + n_shm) / (double)batches : 0.0,
+           hist_quantile(sign_ns, 0.50) / 1e3, hist_quantile(sign_ns, 0.99) / 1e3,
+           hist_quantile(wait_ns, 0.50) / 1e3, hist_quantile(wait_ns, 0.99) / 1e3);
+    if (g_pool) {
+      printf("[POOL] commitments made=%llu signatures from the pool=%llu, pool ran dry=%llu\n",
+             (unsigned long long)pool_made, (unsigned long long)pooled,
+             (unsigned long long)unpooled);
+    }
+  }
+
+  memset(&g_sctx, 0, sizeof(g_sctx));
+  if (g_pool) {
+    memset(g_pool, 0, (size_t)npool * sizeof(sign_commitment));
+    free(g_pool);
+    lfq_free(&g_pool_ready);
+    lfq_free(&g_pool_free);
+    sem_destroy(&g_pool_free_items);
+  }
+  free(sign_ns);
+  free(wait_ns);
+  free(g_shm_jobs);
+  free(stats);
+  lfq_free(&g_queue);
+  sem_destroy(&g_queue_items);
+  return 0;
+}
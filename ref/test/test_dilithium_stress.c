@@ -0,0 +1,494 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "../sign.h"
+#include "hist.h"
+#include "proto.h"
+#include "proto_client.h"
+#include "binlog.h"
+
+/* Open-loop load generator. Sessions start on a fixed schedule (RATE per
+ * second, interleaved over THREADS threads) whether or not earlier ones
+ * have finished, and total latency is measured from the scheduled start,
+ * so a server that falls behind shows up as growing latency instead of
+ * quietly lowering the offered load. Every thread records into its own
+ * histograms; they are merged once all threads are done.
+ *
+ * With KEY_COUNT=N every session signs with one of keys/key0 .. key<N-1>
+ * (test_dilithium_keygen KEY_COUNT=N), picked at random, and names it in
+ * a HELLO frame, which exercises a version 2 server's key cache.
+ *
+ * With SIGND set (a socket path, or shm:NAME) every thread signs through
+ * the signing daemon (test_dilithium_signd) instead of with its own copy
+ * of client_sk.bin. */
+
+#define SERVER_PORT 5000
+#define BUFFER_SIZE 8192
+#define DEFAULT_TARGET_IP "192.168.4.85"
+#define DEFAULT_RATE 100
+#define DEFAULT_THREADS 4
+#define DEFAULT_DURATION_SEC 10
+#define MAX_THREADS 256
+#define CLIENT_SK_PATH "client_sk.bin"
+#define STRESS_LOG_RING 4096
+#define KEY_DIR "keys"
+#define KEY_ID_MAX 16 /* "key" + decimal index */
+
+enum {
+    PHASE_CONNECT,
+    PHASE_RECV,  /* connected until the challenge (or PROTO_MAGIC) is in */
+    PHASE_SIGN,
+    PHASE_SEND,
+    PHASE_TOTAL, /* scheduled start until the session is done */
+    PHASE_ROUND, /* version 2 only: CHALLENGE_REQ until its result */
+    NPHASES
+};
+
+static const char *const phase_names[NPHASES] = {
+    "connect", "recv", "sign", "send", "total", "round"
+};
+
+typedef struct {
+    hist_t phase[NPHASES];
+    uint64_t ok;
+    uint64_t fail;
+    uint64_t late; /* sessions that could not start on schedule */
+} thread_stats_t;
+
+typedef struct {
+    unsigned int index;
+    thread_stats_t *stats;
+    binlog_ring_t *log; /* this thread's ring, NULL without STRESS_LOG */
+    binlog_cpu_t cpu;
+    uint32_t rng; /* key choice with KEY_COUNT */
+    signd_client *signd; /* this thread's daemon connection, NULL without SIGND */
+} thread_ctx_t;
+
+static struct sockaddr_in g_addr;
+static uint8_t g_sk[CRYPTO_SECRETKEYBYTES];
+static proto_client_cfg g_cfg;
+static unsigned int g_nkeys;                   /* KEY_COUNT, 0: g_sk only */
+static uint8_t (*g_key_sk)[CRYPTO_SECRETKEYBYTES];
+static const char *g_signd; /* SIGND, NULL: sign locally */
+static char (*g_key_ids)[KEY_ID_MAX];
+static unsigned int g_threads;
+static uint64_t g_interval_ns; /* between consecutive sessions of all threads */
+static uint64_t g_start_ns;
+static uint64_t g_end_ns;
+
+static uint64_t get_time_ns(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t t) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(t / 1000000000ull);
+    ts.tv_nsec = (long)(t % 1000000000ull);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+static unsigned int parse_uint_env(const char *name, unsigned int def_value) {
+    const char *val = getenv(name);
+    if (!val || *val == '\0') {
+        return def_value;
+    }
+
+    char *end = NULL;
+    unsigned long parsed = strtoul(val, &end, 10);
+    if (!end || *end != '\0' || parsed > UINT_MAX) {
+        return def_value;
+    }
+
+    return (unsigned int)parsed;
+}
+
+static const char *get_env_or_default(const char *name, const char *def_value) {
+    const char *val = getenv(name);
+    if (!val || *val == '\0') {
+        return def_value;
+    }
+    return val;
+}
+
+static int load_file_exact(const char *path, uint8_t *buf, size_t len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return -1;
+    }
+
+    size_t n = fread(buf, 1, len, f);
+    fclose(f);
+
+    if (n != len) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int send_all(int sock, const uint8_t *buf, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+        ssize_t sent = send(sock, (const char *)buf + total, len - total, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (sent == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        total += (size_t)sent;
+    }
+    return 0;
+}
+
+static int recv_all(int sock, uint8_t *buf, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+        ssize_t recvd = recv(sock, (char *)buf + total, len - total, 0);
+        if (recvd == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        if (recvd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        total += (size_t)recvd;
+    }
+    return 0;
+}
+
+static int load_keys(const char *dir) {
+    char path[PATH_MAX];
+    unsigned int i;
+
+    g_key_sk = malloc((size_t)g_nkeys * sizeof(*g_key_sk));
+    g_key_ids = malloc((size_t)g_nkeys * sizeof(*g_key_ids));
+    if (!g_key_sk || !g_key_ids) {
+        fprintf(stderr, "Out of memory\n");
+        return -1;
+    }
+    for (i = 0; i < g_nkeys; ++i) {
+        snprintf(g_key_ids[i], KEY_ID_MAX, "key%u", i);
+        snprintf(path, sizeof(path), "%s/%s.sk", dir, g_key_ids[i]);
+        if (load_file_exact(path, g_key_sk[i], CRYPTO_SECRETKEYBYTES) < 0) {
+            fprintf(stderr, "Missing %s. Run test_dilithium_keygen with KEY_COUNT=%u first.\n",
+                    path, g_nkeys);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* One session scheduled for t_sched with key number key (ignored without
+ * KEY_COUNT), signed by signd if it is not NULL; returns 0 on success.
+ * Stage timings and sizes go to rec as well when it is not NULL. */
+static int run_session(thread_stats_t *st, uint64_t t_sched, unsigned int key,
+                       signd_client *signd, binlog_rec_t *rec) {
+    const uint8_t *sk = g_nkeys > 0 ? g_key_sk[key] : g_sk;
+    uint8_t challenge[BUFFER_SIZE];
+    uint8_t msg[4 + CRYPTO_BYTES]; /* length prefix + signature, one send */
+    uint8_t first[4];
+    size_t sig_len = 0;
+    uint64_t t0, t1, t2, t3, t4;
+    int rc = 1;
+
+    t0 = get_time_ns();
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        return 1;
+    }
+    if (connect(sock, (const struct sockaddr *)&g_addr, sizeof(g_addr)) < 0) {
+        goto out;
+    }
+    t1 = get_time_ns();
+    hist_add(&st->phase[PHASE_CONNECT], t1 - t0);
+    if (rec) {
+        rec->stage_us[0] = (uint32_t)((t1 - t0) / 1000);
+    }
+
+    if (recv_all(sock, first, sizeof(first)) < 0) {
+        goto out;
+    }
+
+    /* Version 2 server: all cfg.rounds rounds make up this one session */
+    if (proto_get32(first) == PROTO_MAGIC) {
+        proto_client_stats ps;
+        memset(&ps, 0, sizeof(ps));
+        ps.sign_ns = &st->phase[PHASE_SIGN];
+        ps.round_ns = &st->phase[PHASE_ROUND];
+        hist_add(&st->phase[PHASE_RECV], get_time_ns() - t1);
+        if (rec) {
+            rec->stage_us[1] = (uint32_t)((get_time_ns() - t1) / 1000);
+        }
+        proto_client_cfg cfg = g_cfg;
+        if (g_nkeys > 0) {
+            cfg.key_id = g_key_ids[key];
+        }
+        cfg.signd = signd;
+        if (proto_client_run(sock, sk, &cfg, &ps) == 0 && ps.fail == 0) {
+            hist_add(&st->phase[PHASE_TOTAL], get_time_ns() - t_sched);
+            rc = 0;
+        }
+        if (rec) {
+            rec->rounds = ps.ok + ps.fail;
+            rec->challenge_len = PROTO_CHALLENGE_BYTES;
+            rec->sig_len = CRYPTO_BYTES;
+        }
+        goto out;
+    }
+
+    uint32_t challenge_len = proto_get32(first);
+    if (challenge_len > BUFFER_SIZE ||
+        (challenge_len > 0 && recv_all(sock, challenge, challenge_len) < 0)) {
+        goto out;
+    }
+    t2 = get_time_ns();
+    hist_add(&st->phase[PHASE_RECV], t2 - t1);
+
+    if ((signd ? signd_sign(signd, msg + 4, &sig_len, challenge, challenge_len)
+               : crypto_sign_signature(msg + 4, &sig_len, challenge, challenge_len, NULL, 0, sk)) != 0) {
+        goto out;
+    }
+    t3 = get_time_ns();
+    hist_add(&st->phase[PHASE_SIGN], t3 - t2);
+
+    proto_put32(msg, (uint32_t)sig_len);
+    if (send_all(sock, msg, 4 + sig_len) < 0) {
+        goto out;
+    }
+    t4 = get_time_ns();
+    hist_add(&st->phase[PHASE_SEND], t4 - t3);
+    hist_add(&st->phase[PHASE_TOTAL], t4 - t_sched);
+    if (rec) {
+        rec->stage_us[1] = (uint32_t)((t2 - t1) / 1000);
+        rec->stage_us[2] = (uint32_t)((t3 - t2) / 1000);
+        rec->stage_us[3] = (uint32_t)((t4 - t3) / 1000);
+        rec->challenge_len = challenge_len;
+        rec->sig_len = (uint32_t)sig_len;
+    }
+    rc = 0;
+
+out:
+    close(sock);
+    return rc;
+}
+
+static void *load_thread(void *arg) {
+    thread_ctx_t *ctx = arg;
+    thread_stats_t *st = ctx->stats;
+    uint64_t k;
+
+    /* Thread i owns slots i, i + T, i + 2T, ... of the global schedule */
+    for (k = ctx->index;; k += g_threads) {
+        uint64_t t_sched = g_start_ns + k * g_interval_ns;
+        if (t_sched >= g_end_ns) {
+            break;
+        }
+        if (get_time_ns() < t_sched) {
+            sleep_until_ns(t_sched);
+        } else {
+            st->late++;
+        }
+
+        unsigned int key = 0;
+        if (g_nkeys > 0) {
+            ctx->rng ^= ctx->rng << 13; /* xorshift32 */
+            ctx->rng ^= ctx->rng >> 17;
+            ctx->rng ^= ctx->rng << 5;
+            key = ctx->rng % g_nkeys;
+        }
+
+        if (!ctx->log) {
+            if (run_session(st, t_sched, key, ctx->signd, NULL) == 0) {
+                st->ok++;
+            } else {
+                st->fail++;
+            }
+            continue;
+        }
+
+        binlog_rec_t rec;
+        memset(&rec, 0, sizeof(rec));
+        rec.source = BINLOG_SRC_STRESS;
+        rec.peer_addr = g_addr.sin_addr.s_addr;
+        rec.peer_port = SERVER_PORT;
+        rec.rounds = 1;
+        if (run_session(st, t_sched, key, ctx->signd, &rec) == 0) {
+            st->ok++;
+            rec.result = BINLOG_RESULT_OK;
+        } else {
+            st->fail++;
+            rec.result = BINLOG_RESULT_ERROR;
+        }
+        rec.total_us = (uint32_t)((get_time_ns() - t_sched) / 1000);
+        binlog_stamp(&rec, &ctx->cpu);
+        binlog_push(ctx->log, &rec);
+    }
+    return NULL;
+}
+
+static void print_phase(const char *name, const hist_t *h) {
+    printf("%-8s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", name,
+           hist_quantile(h, 0.50) / 1e3, hist_quantile(h, 0.90) / 1e3,
+           hist_quantile(h, 0.99) / 1e3, hist_quantile(h, 0.999) / 1e3,
+           (double)h->max / 1e3, hist_mean(h) / 1e3);
+}
+
+int main(void) {
+    const char *ip = get_env_or_default("TARGET_IP", DEFAULT_TARGET_IP);
+    unsigned int rate = parse_uint_env("RATE", DEFAULT_RATE);
+    unsigned int duration = parse_uint_env("DURATION_SEC", DEFAULT_DURATION_SEC);
+    pthread_t tid[MAX_THREADS];
+    thread_ctx_t ctx[MAX_THREADS];
+    unsigned int i, p;
+
+    g_threads = parse_uint_env("THREADS", DEFAULT_THREADS);
+    if (g_threads == 0) {
+        g_threads = 1;
+    }
+    if (g_threads > MAX_THREADS) {
+        g_threads = MAX_THREADS;
+    }
+    if (rate == 0) {
+        rate = 1;
+    }
+
+    g_nkeys = parse_uint_env("KEY_COUNT", 0);
+    g_signd = getenv("SIGND");
+    if (g_signd && *g_signd == '\0') {
+        g_signd = NULL;
+    }
+    if (g_signd) {
+        if (g_nkeys > 0) {
+            fprintf(stderr, "SIGND signs with the daemon's key; it cannot be combined with KEY_COUNT\n");
+            return 1;
+        }
+    } else if (g_nkeys > 0) {
+        if (load_keys(get_env_or_default("KEY_DIR", KEY_DIR)) < 0) {
+            return 1;
+        }
+    } else if (load_file_exact(CLIENT_SK_PATH, g_sk, sizeof(g_sk)) < 0) {
+        fprintf(stderr, "Missing %s. Run test_dilithium_keygen first.\n", CLIENT_SK_PATH);
+        return 1;
+    }
+
+    memset(&g_addr, 0, sizeof(g_addr));
+    g_addr.sin_family = AF_INET;
+    g_addr.sin_port = htons(SERVER_PORT);
+    if (inet_pton(AF_INET, ip, &g_addr.sin_addr) != 1) {
+        fprintf(stderr, "Invalid server IP: %s\n", ip);
+        return 1;
+    }
+
+    proto_client_config(&g_cfg);
+
+    const char *log_path = getenv("STRESS_LOG");
+    binlog_t *log = NULL;
+    if (log_path && *log_path != '\0') {
+        log = binlog_open(log_path, g_threads, STRESS_LOG_RING, 0);
+        if (!log) {
+            fprintf(stderr, "Cannot open %s\n", log_path);
+            return 1;
+        }
+    }
+
+    /* Histograms are large; keep them off the thread stacks */
+    thread_stats_t *stats = calloc(g_threads + 1, sizeof(thread_stats_t));
+    if (!stats) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    thread_stats_t *total = &stats[g_threads];
+
+    printf("[STRESS] target=%s rate=%u/s threads=%u duration=%us\n", ip, rate, g_threads, duration);
+    printf("[STRESS] framed protocol (if the server speaks it): rounds=%u pipeline=%u batch_sigs=%u\n",
+           g_cfg.rounds, g_cfg.pipeline, g_cfg.batch);
+    if (g_nkeys > 0) {
+        printf("[STRESS] %u client keys, announced with HELLO\n", g_nkeys);
+    }
+    if (g_signd) {
+        printf("[STRESS] signing through the daemon at %s\n", g_signd);
+    }
+
+    g_interval_ns = 1000000000ull / rate;
+    g_start_ns = get_time_ns() + 10000000ull; // give every thread time to start
+    g_end_ns = g_start_ns + (uint64_t)duration * 1000000000ull;
+    for (i = 0; i < g_threads; ++i) {
+        ctx[i].index = i;
+        ctx[i].stats = &stats[i];
+        ctx[i].log = log ? binlog_ring(log, i) : NULL;
+        memset(&ctx[i].cpu, 0, sizeof(ctx[i].cpu));
+        ctx[i].rng = 2463534242u + i * 2654435761u;
+        ctx[i].signd = NULL;
+        if (g_signd && !(ctx[i].signd = signd_open(g_signd))) {
+            return 1;
+        }
+        if (pthread_create(&tid[i], NULL, load_thread, &ctx[i]) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            return 1;
+        }
+    }
+    for (i = 0; i < g_threads; ++i) {
+        pthread_join(tid[i], NULL);
+        signd_close(ctx[i].signd);
+    }
+    double elapsed = (double)(get_time_ns() - g_start_ns) / 1e9;
+    if (log) {
+        uint64_t dropped = binlog_close(log);
+        printf("[STRESS] log written to %s (%llu records dropped)\n", log_path,
+               (unsigned long long)dropped);
+    }
+
+    for (i = 0; i < g_threads; ++i) {
+        total->ok += stats[i].ok;
+        total->fail += stats[i].fail;
+        total->late += stats[i].late;
+        for (p = 0; p < NPHASES; ++p) {
+            hist_merge(&total->phase[p], &stats[i].phase[p]);
+        }
+    }
+
+    printf("[STRESS] sessions ok=%llu fail=%llu late=%llu in %.2f s: %.1f/s (offered %u/s)\n",
+           (unsigned long long)total->ok, (unsigned long long)total->fail,
+           (unsigned long long)total->late, elapsed, (double)total->ok / elapsed, rate);
+    if (g_cfg.rounds > 1) {
+        printf("[STRESS] %.0f rounds/s\n", (double)total->ok * g_cfg.rounds / elapsed);
+    }
+    printf("%-8s %10s %10s %10s %10s %10s %10s\n", "[us]", "p50", "p90", "p99", "p99.9", "max", "mean");
+    for (p = 0; p < NPHASES; ++p) {
+        if (total->phase[p].total > 0) {
+            print_phase(phase_names[p], &total->phase[p]);
+        }
+    }
+
+    int rc = total->fail == 0 ? 0 : 1;
+    free(stats);
+    free(g_key_sk);
+    free(g_key_ids);
+    return rc;
+}
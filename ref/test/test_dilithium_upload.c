@@ -0,0 +1,274 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include "../randombytes.h"
+#include "../sign.h"
+#include "proto.h"
+
+/* Upload benchmark for the version 2 server's UPLOAD frame (proto.h).
+ *
+ * For every message size from UPLOAD_MIN_MB to UPLOAD_MAX_MB (x4 each
+ * step) the message is signed once, then uploaded UPLOAD_REPS times as a
+ * streamed frame and as many times with PROTO_FLAG_BUFFERED, alternating,
+ * over one connection. Reported per mode are the medians of
+ *   total  first byte sent until the RESULT is in
+ *   tail   last byte sent until the RESULT is in
+ * The tail is what the server still has to do once the upload is over:
+ * for a buffered upload the whole message hash, for a streamed one only
+ * what was left in the socket buffers plus the lattice checks.
+ *
+ * The message is one MB of random bytes repeated, so neither side needs
+ * the whole message in memory (the server does in buffered mode, up to
+ * 1 GB). Start the server with SERVER_PROTO=2 and SERVER_VERBOSE=0. */
+
+#define SERVER_PORT 5000
+#define DEFAULT_TARGET_IP "127.0.0.1"
+#define CLIENT_SK_PATH "client_sk.bin"
+#define CHUNK_BYTES (1u << 20)
+#define DEFAULT_MIN_MB 1
+#define DEFAULT_MAX_MB 1024
+#define DEFAULT_REPS 3
+#define MAX_REPS 32
+
+static uint64_t get_time_ns(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static unsigned long env_ulong(const char *name, unsigned long def) {
+    const char *v = getenv(name);
+    if (!v || *v == '\0') {
+        return def;
+    }
+    return strtoul(v, NULL, 10);
+}
+
+static int load_file_exact(const char *path, uint8_t *buf, size_t len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return -1;
+    }
+
+    size_t n = fread(buf, 1, len, f);
+    fclose(f);
+
+    if (n != len) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int send_all(int sock, const uint8_t *buf, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+        ssize_t sent = send(sock, (const char *)buf + total, len - total, 0);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (sent == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        total += (size_t)sent;
+    }
+    return 0;
+}
+
+static int recv_all(int sock, uint8_t *buf, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+        ssize_t recvd = recv(sock, (char *)buf + total, len - total, 0);
+        if (recvd == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        if (recvd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        total += (size_t)recvd;
+    }
+    return 0;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static double median_ms(uint64_t *ns, unsigned int n) {
+    qsort(ns, n, sizeof(*ns), cmp_u64);
+    return (n % 2 ? ns[n / 2] : (ns[n / 2 - 1] + ns[n / 2]) / 2) / 1e6;
+}
+
+/* One UPLOAD of chunks x chunk plus sig; returns the RESULT status or -1 */
+static int upload(int sock, uint32_t request_id, uint8_t flags, const uint8_t *chunk,
+                  unsigned int chunks, const uint8_t *sig, size_t sig_len,
+                  uint64_t *total_ns, uint64_t *tail_ns) {
+    uint8_t hdr[PROTO_HDR_BYTES + 4];
+    uint32_t mlen = chunks * CHUNK_BYTES;
+    proto_hdr h;
+    uint64_t t0, t1;
+    unsigned int i;
+
+    h.type = PROTO_UPLOAD;
+    h.flags = flags;
+    h.count = 0;
+    h.request_id = request_id;
+    h.length = 4 + mlen + (uint32_t)sig_len;
+    proto_hdr_pack(hdr, &h);
+    proto_put32(hdr + PROTO_HDR_BYTES, mlen);
+
+    t0 = get_time_ns();
+    if (send_all(sock, hdr, sizeof(hdr)) < 0) {
+        return -1;
+    }
+    for (i = 0; i < chunks; ++i) {
+        if (send_all(sock, chunk, CHUNK_BYTES) < 0) {
+            return -1;
+        }
+    }
+    if (send_all(sock, sig, sig_len) < 0) {
+        return -1;
+    }
+    t1 = get_time_ns();
+
+    if (recv_all(sock, hdr, PROTO_HDR_BYTES + 1) < 0) {
+        return -1;
+    }
+    proto_hdr_unpack(&h, hdr);
+    if (h.type != PROTO_RESULT || h.request_id != request_id || h.length != 1) {
+        errno = EPROTO;
+        return -1;
+    }
+    *total_ns = get_time_ns() - t0;
+    *tail_ns = get_time_ns() - t1;
+    return hdr[PROTO_HDR_BYTES];
+}
+
+int main(int argc, char *argv[]) {
+    static uint8_t sk[CRYPTO_SECRETKEYBYTES];
+    uint8_t sig[CRYPTO_BYTES];
+    uint8_t magic[4];
+    uint64_t total[2][MAX_REPS], tail[2][MAX_REPS];
+    struct sockaddr_in server_addr;
+    sign_stream st;
+    size_t sig_len = 0;
+    uint32_t request_id = 0;
+    unsigned int mb, i, rep, mode;
+    int sock, one = 1, rc = 0;
+
+    const char *ip = argc > 1 ? argv[1] : getenv("TARGET_IP");
+    if (!ip || *ip == '\0') {
+        ip = DEFAULT_TARGET_IP;
+    }
+    unsigned long min_mb = env_ulong("UPLOAD_MIN_MB", DEFAULT_MIN_MB);
+    unsigned long max_mb = env_ulong("UPLOAD_MAX_MB", DEFAULT_MAX_MB);
+    unsigned long reps = env_ulong("UPLOAD_REPS", DEFAULT_REPS);
+    if (min_mb < 1) {
+        min_mb = 1;
+    }
+    if (max_mb > 4095) {
+        max_mb = 4095; /* the frame length is 32 bits */
+    }
+    if (reps < 1 || reps > MAX_REPS) {
+        reps = reps < 1 ? 1 : MAX_REPS;
+    }
+
+    if (load_file_exact(CLIENT_SK_PATH, sk, sizeof(sk)) < 0) {
+        fprintf(stderr, "Missing %s. Run test_dilithium_keygen first.\n", CLIENT_SK_PATH);
+        return 1;
+    }
+    uint8_t *chunk = malloc(CHUNK_BYTES);
+    if (!chunk) {
+        return 1;
+    }
+    randombytes(chunk, CHUNK_BYTES);
+
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(SERVER_PORT);
+    if (inet_pton(AF_INET, ip, &server_addr.sin_addr) != 1) {
+        fprintf(stderr, "Invalid server IP: %s\n", ip);
+        free(chunk);
+        return 1;
+    }
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0 || connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        perror("connect failed");
+        free(chunk);
+        return 1;
+    }
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char *)&one, sizeof(one));
+    if (recv_all(sock, magic, sizeof(magic)) < 0 || proto_get32(magic) != PROTO_MAGIC) {
+        fprintf(stderr, "%s does not speak the framed protocol; start it with SERVER_PROTO=2\n", ip);
+        close(sock);
+        free(chunk);
+        return 1;
+    }
+
+    printf("[UPLOAD] %s: %lu upload(s) per size and mode, medians in ms\n", ip, reps);
+    printf("%9s %12s %10s %12s %10s %9s\n",
+           "size", "streamed", "tail", "buffered", "tail", "saved");
+
+    for (mb = (unsigned int)min_mb; mb <= max_mb; mb *= 4) {
+        crypto_sign_init(&st, NULL, 0, sk);
+        for (i = 0; i < mb; ++i) {
+            crypto_sign_update(&st, chunk, CHUNK_BYTES);
+        }
+        crypto_sign_final(&st, sig, &sig_len, sk);
+
+        for (rep = 0; rep < reps && rc == 0; ++rep) {
+            for (mode = 0; mode < 2; ++mode) {
+                int status = upload(sock, request_id++, mode ? PROTO_FLAG_BUFFERED : 0, chunk, mb,
+                                    sig, sig_len, &total[mode][rep], &tail[mode][rep]);
+                if (status != PROTO_STATUS_OK) {
+                    if (status < 0) {
+                        perror("upload failed");
+                    } else {
+                        fprintf(stderr, "%u MB upload rejected (status %d)\n", mb, status);
+                    }
+                    rc = 1;
+                    break;
+                }
+            }
+        }
+        if (rc != 0) {
+            break;
+        }
+
+        double s_total = median_ms(total[0], (unsigned int)reps);
+        double s_tail = median_ms(tail[0], (unsigned int)reps);
+        double b_total = median_ms(total[1], (unsigned int)reps);
+        double b_tail = median_ms(tail[1], (unsigned int)reps);
+        printf("%6u MB %12.2f %10.2f %12.2f %10.2f %8.1f%%\n",
+               mb, s_total, s_tail, b_total, b_tail,
+               b_tail > 0 ? 100.0 * (b_tail - s_tail) / b_tail : 0.0);
+        fflush(stdout);
+    }
+
+    close(sock);
+    free(chunk);
+    return rc;
+}
@@ -0,0 +1,87 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../fips202.h"
+#include "../randombytes.h"
+#include "cpucycles.h"
+
+#define MINLEN 64
+#define MAXLEN (64*1024*1024)
+#define CHUNKLEN 1000 // update size for the streaming column, not rate aligned
+#define NREPS 31
+
+static int cmp_uint64(const void *a, const void *b) {
+  if(*(uint64_t *)a < *(uint64_t *)b) return -1;
+  if(*(uint64_t *)a > *(uint64_t *)b) return 1;
+  return 0;
+}
+
+static void shake_absorb(unsigned int rate, const uint8_t *in, size_t inlen, size_t chunk) {
+  uint8_t out[32];
+  size_t len;
+  keccak_state state;
+
+  if(rate == SHAKE128_RATE) {
+    shake128_init(&state);
+    for(; inlen > 0; inlen -= len, in += len) {
+      len = (inlen < chunk) ? inlen : chunk;
+      shake128_absorb(&state, in, len);
+    }
+    shake128_finalize(&state);
+    shake128_squeeze(out, sizeof(out), &state);
+  }
+  else {
+    shake256_init(&state);
+    for(; inlen > 0; inlen -= len, in += len) {
+      len = (inlen < chunk) ? inlen : chunk;
+      shake256_absorb(&state, in, len);
+    }
+    shake256_finalize(&state);
+    shake256_squeeze(out, sizeof(out), &state);
+  }
+
+  /* Keep the compiler from dropping the call */
+  __asm__ volatile ("" : : "r" (out) : "memory");
+}
+
+/* Median cycles per byte over NREPS runs (fewer for large inputs) */
+static double cycles_per_byte(unsigned int rate, const uint8_t *in, size_t inlen, size_t chunk) {
+  unsigned int i, reps;
+  uint64_t t[NREPS], t0;
+
+  reps = (inlen >= MAXLEN/16) ? 5 : NREPS;
+  for(i = 0; i < reps; ++i) {
+    t0 = cpucycles();
+    shake_absorb(rate, in, inlen, chunk);
+    t[i] = cpucycles() - t0;
+  }
+  qsort(t, reps, sizeof(uint64_t), cmp_uint64);
+
+  return (double)t[reps/2] / inlen;
+}
+
+int main(void) {
+  size_t inlen;
+  uint8_t *in;
+
+  in = malloc(MAXLEN);
+  if(!in) {
+    printf("Out of memory\n");
+    return 1;
+  }
+  randombytes(in, MAXLEN);
+
+  printf("%10s  %12s  %12s  %12s  %12s\n", "bytes",
+         "SHAKE128", "SHAKE128/1k", "SHAKE256", "SHAKE256/1k");
+  for(inlen = MINLEN; inlen <= MAXLEN; inlen *= 4) {
+    printf("%10zu  %12.2f  %12.2f  %12.2f  %12.2f\n", inlen,
+           cycles_per_byte(SHAKE128_RATE, in, inlen, inlen),
+           cycles_per_byte(SHAKE128_RATE, in, inlen, CHUNKLEN),
+           cycles_per_byte(SHAKE256_RATE, in, inlen, inlen),
+           cycles_per_byte(SHAKE256_RATE, in, inlen, CHUNKLEN));
+  }
+  printf("\n(cycles/byte, median; '/1k' absorbs in %d-byte updates)\n", CHUNKLEN);
+
+  free(in);
+  return 0;
+}
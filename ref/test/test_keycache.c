@@ -0,0 +1,148 @@
+/* Recovery of the key cache from connections that die while loading or
+ * pinning a key, and the bypass past KC_PINNERS pins. Includes
+ * keycache.c to reach the slots, which is how a dead loader is
+ * simulated. */
+#include "keycache.c"
+
+#include <sys/wait.h>
+
+static char g_dir[] = "/tmp/test_keycacheXXXXXX";
+static uint8_t g_pk[CRYPTO_PUBLICKEYBYTES];
+static verify_ctx g_ref;
+
+static int check(int cond, const char *what) {
+  if (!cond) {
+    printf("ERROR: %s\n", what);
+  }
+  return !cond;
+}
+
+static int write_key(const char *id) {
+  char path[sizeof(g_dir) + KEYCACHE_MAX_ID + 8];
+  FILE *f;
+  size_t n;
+
+  snprintf(path, sizeof(path), "%s/%s.pk", g_dir, id);
+  f = fopen(path, "wb");
+  if (!f) {
+    return -1;
+  }
+  n = fwrite(g_pk, 1, sizeof(g_pk), f);
+  fclose(f);
+  return n == sizeof(g_pk) ? 0 : -1;
+}
+
+static void remove_key(const char *id) {
+  char path[sizeof(g_dir) + KEYCACHE_MAX_ID + 8];
+
+  snprintf(path, sizeof(path), "%s/%s.pk", g_dir, id);
+  unlink(path);
+}
+
+/* The expansion handed out matches a fresh one */
+static int same_key(const verify_ctx *v) {
+  return v != NULL && memcmp(v, &g_ref, sizeof(g_ref)) == 0;
+}
+
+/* A child that pins key_id and exits without releasing it; returns its
+ * pid once reaped, so it is certainly gone */
+static pid_t die_pinned(keycache_t *kc, const char *key_id) {
+  static verify_ctx scratch;
+  int slot;
+  pid_t pid = fork();
+
+  if (pid == 0) {
+    _exit(keycache_acquire(kc, key_id, &scratch, &slot) == NULL || slot < 0);
+  }
+  waitpid(pid, NULL, 0);
+  return pid;
+}
+
+int main(void) {
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  static verify_ctx scratch;
+  static int slots[KC_PINNERS];
+  const verify_ctx *v;
+  keycache_t *kc;
+  keycache_stats_t st;
+  pid_t pid;
+  int slot, idx, i, err = 0;
+
+  if (!mkdtemp(g_dir)) {
+    printf("ERROR: mkdtemp\n");
+    return 1;
+  }
+  crypto_sign_keypair(g_pk, sk);
+  crypto_sign_pk_expand(&g_ref, g_pk);
+  if (write_key("a") || write_key("b")) {
+    printf("ERROR: cannot write keys to %s\n", g_dir);
+    return 1;
+  }
+
+  /* One slot: a dead connection's pin must not keep it from "b" */
+  kc = keycache_create(g_dir, 1);
+  if (!kc) {
+    printf("ERROR: keycache_create\n");
+    return 1;
+  }
+  die_pinned(kc, "a");
+  v = keycache_acquire(kc, "b", &scratch, &slot);
+  keycache_stats(kc, &st);
+  err |= check(same_key(v) && slot == 0, "slot pinned by a dead connection not reused");
+  err |= check(st.evictions == 1 && st.bypass == 0, "dead pin: wrong eviction/bypass counts");
+  keycache_release(kc, slot);
+
+  /* A connection died half way through loading "a": the next one
+   * drops the slot and loads the key again */
+  pid = die_pinned(kc, "a");
+  idx = kc_find(kc, "a", kc_hash("a") & (kc->hdr->nbuckets - 1));
+  if (check(idx == 0, "key not cached")) {
+    return 1;
+  }
+  kc->slots[idx].state = SLOT_LOADING;
+  kc->slots[idx].loader = pid;
+  memset(&kc->slots[idx].vctx, 0, sizeof(verify_ctx));
+  v = keycache_acquire(kc, "a", &scratch, &slot);
+  keycache_stats(kc, &st);
+  err |= check(same_key(v) && slot == 0, "slot loading for a dead connection not reloaded");
+  err |= check(st.bypass == 0, "dead loader: bypassed");
+  keycache_release(kc, slot);
+
+  /* A live loader that takes too long is not waited for forever */
+  kc->slots[idx].state = SLOT_LOADING;
+  kc->slots[idx].loader = getpid();
+  v = keycache_acquire(kc, "a", &scratch, &slot);
+  keycache_stats(kc, &st);
+  err |= check(same_key(v) && slot == -1 && st.bypass == 1, "stuck loader not bypassed");
+  keycache_destroy(kc);
+
+  /* KC_PINNERS connections share the cached key, the next one bypasses */
+  kc = keycache_create(g_dir, 1);
+  if (!kc) {
+    printf("ERROR: keycache_create\n");
+    return 1;
+  }
+  for (i = 0; i < KC_PINNERS; ++i) {
+    v = keycache_acquire(kc, "a", &scratch, &slots[i]);
+    err |= check(same_key(v) && slots[i] == 0, "pin of a cached key refused");
+  }
+  v = keycache_acquire(kc, "a", &scratch, &slot);
+  keycache_stats(kc, &st);
+  err |= check(same_key(v) && v == &scratch && slot == -1 && st.bypass == 1,
+               "pin beyond KC_PINNERS not bypassed");
+  for (i = 0; i < KC_PINNERS; ++i) {
+    keycache_release(kc, slots[i]);
+  }
+  v = keycache_acquire(kc, "a", &scratch, &slot);
+  err |= check(same_key(v) && slot == 0, "released pins not reusable");
+  keycache_release(kc, slot);
+  keycache_destroy(kc);
+
+  remove_key("a");
+  remove_key("b");
+  rmdir(g_dir);
+  if (!err) {
+    printf("keycache recovery OK\n");
+  }
+  return err;
+}
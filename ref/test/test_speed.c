@@ -0,0 +1,164 @@
+#include <stdint.h>
+#include "../sign.h"
+#include "../poly.h"
+#include "../polyvec.h"
+#include "../params.h"
+#include "cpucycles.h"
+#include "speed_print.h"
+
+#define NTESTS 1000
+
+uint64_t t[NTESTS];
+
+int main(void)
+{
+  unsigned int i;
+  size_t siglen;
+  uint8_t pk[CRYPTO_PUBLICKEYBYTES];
+  uint8_t sk[CRYPTO_SECRETKEYBYTES];
+  uint8_t sig[CRYPTO_BYTES];
+  uint8_t seed[CRHBYTES] = {0};
+  static sign_ctx sctx;
+  static verify_ctx vctx;
+  static sign_commitment cm;
+  const uint8_t *sigs[4] = {sig, sig, sig, sig};
+  const uint8_t *msgs[4] = {sig, sig, sig, sig};
+  const uint8_t *pks[4] = {pk, pk, pk, pk};
+  const size_t siglens[4] = {CRYPTO_BYTES, CRYPTO_BYTES, CRYPTO_BYTES, CRYPTO_BYTES};
+  const size_t mlens[4] = {CRHBYTES, CRHBYTES, CRHBYTES, CRHBYTES};
+  int results[4];
+  polyvecl mat[K];
+  poly *a = &mat[0].vec[0];
+  poly *b = &mat[0].vec[1];
+  poly *c = &mat[0].vec[2];
+  poly_sparse cs;
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    polyvec_matrix_expand(mat, seed);
+  }
+  print_results("polyvec_matrix_expand:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    poly_uniform_eta(a, seed, 0);
+  }
+  print_results("poly_uniform_eta:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    poly_uniform_gamma1(a, seed, 0);
+  }
+  print_results("poly_uniform_gamma1:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    poly_ntt(a);
+  }
+  print_results("poly_ntt:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    poly_invntt_tomont(a);
+  }
+  print_results("poly_invntt_tomont:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    poly_pointwise_montgomery(c, a, b);
+  }
+  print_results("poly_pointwise_montgomery:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    poly_challenge(c, seed);
+  }
+  print_results("poly_challenge:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    poly_challenge_sparse(&cs, c);
+  }
+  print_results("poly_challenge_sparse:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    poly_sparse_mul_eta(a, &cs, b);
+  }
+  print_results("poly_sparse_mul_eta:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    poly_sparse_mul(a, &cs, b);
+  }
+  print_results("poly_sparse_mul:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_keypair(pk, sk);
+  }
+  print_results("Keypair:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_signature(sig, &siglen, sig, CRHBYTES, NULL, 0, sk);
+  }
+  print_results("Sign:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_key_expand(&sctx, sk);
+  }
+  print_results("Key expand:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_signature_ctx(sig, &siglen, sig, CRHBYTES, NULL, 0, &sctx);
+  }
+  print_results("Sign (expanded key):", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_commit(&cm, &sctx);
+  }
+  print_results("Commit (offline):", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_commit(&cm, &sctx);
+    crypto_sign_signature_commit(sig, &siglen, seed, &cm, &sctx);
+  }
+  print_results("Commit + online attempt:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_verify(sig, CRYPTO_BYTES, sig, CRHBYTES, NULL, 0, pk);
+  }
+  print_results("Verify:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_pk_expand(&vctx, pk);
+  }
+  print_results("Public key expand:", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_verify_ctx(sig, CRYPTO_BYTES, sig, CRHBYTES, NULL, 0, &vctx);
+  }
+  print_results("Verify (expanded key):", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_verify_ctx_mu(sig, CRYPTO_BYTES, seed, &vctx);
+  }
+  print_results("Verify (memoised mu):", t, NTESTS);
+
+  for(i = 0; i < NTESTS; ++i) {
+    t[i] = cpucycles();
+    crypto_sign_verify_batch(results, sigs, siglens, msgs, mlens, NULL, 0, pks, 4);
+  }
+  print_results("Verify batch (4 signatures):", t, NTESTS);
+
+  return 0;
+}
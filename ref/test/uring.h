@@ -0,0 +1,227 @@
+#ifndef URING_H
+#define URING_H
+
+/* Minimal io_uring wrapper on top of the raw syscalls (no liburing): one
+ * submission/completion ring pair plus a provided-buffer ring from which
+ * the kernel picks receive buffers itself. Only what the demo server
+ * needs; every function is meant to be called from a single thread. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+typedef struct {
+  int fd;
+  unsigned int *sq_head;
+  unsigned int *sq_tail;
+  unsigned int sq_mask;
+  unsigned int sq_entries;
+  unsigned int sqe_tail;      // next SQE to hand out
+  unsigned int sqe_submitted; // SQEs already passed to the kernel
+  struct io_uring_sqe *sqes;
+  unsigned int *cq_head;
+  unsigned int *cq_tail;
+  unsigned int cq_mask;
+  struct io_uring_cqe *cqes;
+  void *ring_map;
+  size_t ring_map_len;
+  size_t sqes_len;
+} uring_t;
+
+typedef struct {
+  struct io_uring_buf_ring *br;
+  uint8_t *base;
+  size_t buf_size;
+  unsigned int entries;
+  uint16_t bgid;
+  uint16_t tail;
+} uring_bufring_t;
+
+static inline int uring_setup_params(unsigned int entries, struct io_uring_params *p) {
+  return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+/* Returns 0 on success, -errno on failure */
+static inline int uring_init(uring_t *r, unsigned int entries, unsigned int cq_entries) {
+  struct io_uring_params p;
+  unsigned int *array;
+  unsigned int i;
+  size_t sq_len, cq_len;
+  uint8_t *map;
+
+  memset(r, 0, sizeof(*r));
+  memset(&p, 0, sizeof(p));
+  p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+  p.cq_entries = cq_entries;
+  r->fd = uring_setup_params(entries, &p);
+  if (r->fd < 0 && errno == EINVAL) { // older kernel: plain ring
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = cq_entries;
+    r->fd = uring_setup_params(entries, &p);
+  }
+  if (r->fd < 0) {
+    return -errno;
+  }
+  if (!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+    close(r->fd);
+    return -ENOSYS;
+  }
+
+  sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+  cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  r->ring_map_len = sq_len > cq_len ? sq_len : cq_len;
+  r->ring_map = mmap(NULL, r->ring_map_len, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+  if (r->ring_map == MAP_FAILED) {
+    close(r->fd);
+    return -errno;
+  }
+  r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+  r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+  if (r->sqes == MAP_FAILED) {
+    munmap(r->ring_map, r->ring_map_len);
+    close(r->fd);
+    return -errno;
+  }
+
+  map = r->ring_map;
+  r->sq_head = (unsigned int *)(map + p.sq_off.head);
+  r->sq_tail = (unsigned int *)(map + p.sq_off.tail);
+  r->sq_mask = *(unsigned int *)(map + p.sq_off.ring_mask);
+  r->sq_entries = p.sq_entries;
+  r->cq_head = (unsigned int *)(map + p.cq_off.head);
+  r->cq_tail = (unsigned int *)(map + p.cq_off.tail);
+  r->cq_mask = *(unsigned int *)(map + p.cq_off.ring_mask);
+  r->cqes = (struct io_uring_cqe *)(map + p.cq_off.cqes);
+
+  /* SQ index array is the identity; SQEs are used in ring order */
+  array = (unsigned int *)(map + p.sq_off.array);
+  for (i = 0; i < p.sq_entries; ++i) {
+    array[i] = i;
+  }
+  r->sqe_tail = r->sqe_submitted = *r->sq_tail;
+  return 0;
+}
+
+static inline void uring_exit(uring_t *r) {
+  munmap(r->sqes, r->sqes_len);
+  munmap(r->ring_map, r->ring_map_len);
+  close(r->fd);
+}
+
+/* Publish pending SQEs and optionally wait for wait_nr completions.
+ * Returns the number of SQEs consumed or -errno. */
+static inline int uring_submit(uring_t *r, unsigned int wait_nr) {
+  unsigned int n = r->sqe_tail - r->sqe_submitted;
+  int ret;
+
+  __atomic_store_n(r->sq_tail, r->sqe_tail, __ATOMIC_RELEASE);
+  do {
+    ret = (int)syscall(__NR_io_uring_enter, r->fd, n, wait_nr,
+                       wait_nr ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+  } while (ret < 0 && errno == EINTR);
+  if (ret < 0) {
+    return -errno;
+  }
+  r->sqe_submitted += (unsigned int)ret;
+  return ret;
+}
+
+/* Next free SQE, zeroed; submits first if the ring is full */
+static inline struct io_uring_sqe *uring_get_sqe(uring_t *r) {
+  struct io_uring_sqe *sqe;
+
+  while (r->sqe_tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) >= r->sq_entries) {
+    if (uring_submit(r, 0) < 0) {
+      return NULL;
+    }
+  }
+  sqe = &r->sqes[r->sqe_tail & r->sq_mask];
+  memset(sqe, 0, sizeof(*sqe));
+  r->sqe_tail++;
+  return sqe;
+}
+
+/* Oldest unconsumed CQE or NULL; release it with uring_cqe_seen() */
+static inline struct io_uring_cqe *uring_peek_cqe(uring_t *r) {
+  unsigned int head = *r->cq_head;
+
+  if (head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) {
+    return NULL;
+  }
+  return &r->cqes[head & r->cq_mask];
+}
+
+static inline void uring_cqe_seen(uring_t *r) {
+  __atomic_store_n(r->cq_head, *r->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+/* Register entries buffers of buf_size bytes as buffer group bgid and
+ * hand all of them to the kernel. entries must be a power of two. */
+static inline int uring_bufring_init(uring_t *r, uring_bufring_t *b, uint16_t bgid,
+                                     unsigned int entries, size_t buf_size) {
+  struct io_uring_buf_reg reg;
+  void *ring;
+  unsigned int i;
+
+  memset(b, 0, sizeof(*b));
+  if (posix_memalign(&ring, (size_t)sysconf(_SC_PAGESIZE),
+                     entries * sizeof(struct io_uring_buf)) != 0) {
+    return -ENOMEM;
+  }
+  memset(ring, 0, entries * sizeof(struct io_uring_buf));
+  b->br = ring;
+  b->base = malloc(entries * buf_size);
+  if (!b->base) {
+    free(ring);
+    return -ENOMEM;
+  }
+  b->buf_size = buf_size;
+  b->entries = entries;
+  b->bgid = bgid;
+
+  memset(&reg, 0, sizeof(reg));
+  reg.ring_addr = (uint64_t)(uintptr_t)ring;
+  reg.ring_entries = entries;
+  reg.bgid = bgid;
+  if (syscall(__NR_io_uring_register, r->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+    int err = errno;
+    free(b->base);
+    free(ring);
+    return -err;
+  }
+
+  for (i = 0; i < entries; ++i) {
+    struct io_uring_buf *buf = &b->br->bufs[b->tail++ & (entries - 1)];
+    buf->addr = (uint64_t)(uintptr_t)(b->base + i * buf_size);
+    buf->len = (uint32_t)buf_size;
+    buf->bid = (uint16_t)i;
+  }
+  __atomic_store_n(&b->br->tail, b->tail, __ATOMIC_RELEASE);
+  return 0;
+}
+
+static inline uint8_t *uring_buf(const uring_bufring_t *b, unsigned int bid) {
+  return b->base + (size_t)bid * b->buf_size;
+}
+
+/* Give buffer bid back to the kernel */
+static inline void uring_bufring_recycle(uring_bufring_t *b, unsigned int bid) {
+  struct io_uring_buf *buf = &b->br->bufs[b->tail & (b->entries - 1)];
+
+  buf->addr = (uint64_t)(uintptr_t)uring_buf(b, bid);
+  buf->len = (uint32_t)b->buf_size;
+  buf->bid = (uint16_t)bid;
+  b->tail++;
+  __atomic_store_n(&b->br->tail, b->tail, __ATOMIC_RELEASE);
+}
+
+#endif
@@ -18,6 +18,7 @@ fi
 for dir in $DIRS; do
   make -j$(nproc) -C $dir clean
   make -j$(nproc) -C $dir
+  make -j$(nproc) -C $dir deterministic
   for alg in 2 3 5; do
     #valgrind --vex-guest-max-insns=25 ./$dir/test/test_dilithium$alg
     ./$dir/test/test_dilithium$alg &
@@ -26,6 +27,7 @@ for dir in $DIRS; do
     ./$dir/test/test_vectors$alg > tvecs$alg &
     PID2=$!
     wait $PID1 $PID2
+    ./$dir/test/test_dilithium${alg}_det
   done
   shasum -a256 -c SHA256SUMS
 done
@@ -0,0 +1 @@
+../ref/fips202.c
\ No newline at end of file
@@ -0,0 +1 @@
+../ref/fips202.h
\ No newline at end of file
@@ -0,0 +1 @@
+../ref/fips202x4.c
\ No newline at end of file
@@ -0,0 +1 @@
+../ref/fips202x4.h
\ No newline at end of file
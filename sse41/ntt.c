@@ -0,0 +1,168 @@
+#include <stdint.h>
+#include <smmintrin.h>
+#include "params.h"
+#include "ntt.h"
+#include "reduce.h"
+
+static const int32_t zetas[N] = {
+         0,    25847, -2608894,  -518909,   237124,  -777960,  -876248,   466468,
+   1826347,  2353451,  -359251, -2091905,  3119733, -2884855,  3111497,  2680103,
+   2725464,  1024112, -1079900,  3585928,  -549488, -1119584,  2619752, -2108549,
+  -2118186, -3859737, -1399561, -3277672,  1757237,   -19422,  4010497,   280005,
+   2706023,    95776,  3077325,  3530437, -1661693, -3592148, -2537516,  3915439,
+  -3861115, -3043716,  3574422, -2867647,  3539968,  -300467,  2348700,  -539299,
+  -1699267, -1643818,  3505694, -3821735,  3507263, -2140649, -1600420,  3699596,
+    811944,   531354,   954230,  3881043,  3900724, -2556880,  2071892, -2797779,
+  -3930395, -1528703, -3677745, -3041255, -1452451,  3475950,  2176455, -1585221,
+  -1257611,  1939314, -4083598, -1000202, -3190144, -3157330, -3632928,   126922,
+   3412210,  -983419,  2147896,  2715295, -2967645, -3693493,  -411027, -2477047,
+   -671102, -1228525,   -22981, -1308169,  -381987,  1349076,  1852771, -1430430,
+  -3343383,   264944,   508951,  3097992,    44288, -1100098,   904516,  3958618,
+  -3724342,    -8578,  1653064, -3249728,  2389356,  -210977,   759969, -1316856,
+    189548, -3553272,  3159746, -1851402, -2409325,  -177440,  1315589,  1341330,
+   1285669, -1584928,  -812732, -1439742, -3019102, -3881060, -3628969,  3839961,
+   2091667,  3407706,  2316500,  3817976, -3342478,  2244091, -2446433, -3562462,
+    266997,  2434439, -1235728,  3513181, -3520352, -3759364, -1197226, -3193378,
+    900702,  1859098,   909542,   819034,   495491, -1613174,   -43260,  -522500,
+   -655327, -3122442,  2031748,  3207046, -3556995,  -525098,  -768622, -3595838,
+    342297,   286988, -2437823,  4108315,  3437287, -3342277,  1735879,   203044,
+   2842341,  2691481, -2590150,  1265009,  4055324,  1247620,  2486353,  1595974,
+  -3767016,  1250494,  2635921, -3548272, -2994039,  1869119,  1903435, -1050970,
+  -1333058,  1237275, -3318210, -1430225,  -451100,  1312455,  3306115, -1962642,
+  -1279661,  1917081, -2546312, -1374803,  1500165,   777191,  2235880,  3406031,
+   -542412, -2831860, -1671176, -1846953, -2584293, -3724270,   594136, -3776993,
+  -2013608,  2432395,  2454455,  -164721,  1957272,  3369112,   185531, -1207385,
+  -3183426,   162844,  1616392,  3014001,   810149,  1652634, -3694233, -1799107,
+  -3038916,  3523897,  3866901,   269760,  2213111,  -975884,  1717735,   472078,
+   -426683,  1723600, -1803090,  1910376, -1667432, -1104333,  -260646, -3833893,
+  -2939036, -2235985,  -420899, -2286327,   183443,  -976891,  1612842, -3545687,
+   -554416,  3919660,   -48306, -1362209,  3937738,  1400424,  -846154,  1976782
+};
+
+/*************************************************
+* Name:        ntt
+*
+* Description: Forward NTT, in-place. No modular reduction is performed after
+*              additions or subtractions. Output vector is in bitreversed order.
+*              Same coefficient order and results as ref/ntt.c: levels with
+*              len >= 4 run four butterflies per vector with a broadcast zeta,
+*              the last two levels are done together on blocks of eight
+*              coefficients after transposing them into butterfly pairs.
+*
+* Arguments:   - uint32_t p[N]: input/output coefficient array
+**************************************************/
+void ntt(int32_t a[N]) {
+  unsigned int len, start, j, k;
+  __m128i zeta, x, y, lo, hi, t;
+
+  k = 0;
+  for(len = 128; len >= 4; len >>= 1) {
+    for(start = 0; start < N; start += 2*len) {
+      zeta = _mm_set1_epi32(zetas[++k]);
+      for(j = start; j < start + len; j += 4) {
+        x = _mm_loadu_si128((__m128i *)&a[j]);
+        y = _mm_loadu_si128((__m128i *)&a[j + len]);
+        t = montgomery_mul_sse(zeta, y);
+        _mm_storeu_si128((__m128i *)&a[j + len], _mm_sub_epi32(x, t));
+        _mm_storeu_si128((__m128i *)&a[j], _mm_add_epi32(x, t));
+      }
+    }
+  }
+
+  for(j = 0; j < N; j += 8) {
+    x = _mm_loadu_si128((__m128i *)&a[j]);
+    y = _mm_loadu_si128((__m128i *)&a[j + 4]);
+
+    /* len = 2: pairs (0,2), (1,3) of each group of four */
+    zeta = _mm_set_epi32(zetas[65 + j/4], zetas[65 + j/4],
+                         zetas[64 + j/4], zetas[64 + j/4]);
+    lo = _mm_unpacklo_epi64(x, y);
+    hi = _mm_unpackhi_epi64(x, y);
+    t = montgomery_mul_sse(zeta, hi);
+    hi = _mm_sub_epi32(lo, t);
+    lo = _mm_add_epi32(lo, t);
+    x = _mm_unpacklo_epi64(lo, hi);
+    y = _mm_unpackhi_epi64(lo, hi);
+
+    /* len = 1: pairs (0,1), (2,3), ... */
+    zeta = _mm_loadu_si128((__m128i *)&zetas[128 + j/2]);
+    x = _mm_shuffle_epi32(x, _MM_SHUFFLE(3,1,2,0));
+    y = _mm_shuffle_epi32(y, _MM_SHUFFLE(3,1,2,0));
+    lo = _mm_unpacklo_epi64(x, y);
+    hi = _mm_unpackhi_epi64(x, y);
+    t = montgomery_mul_sse(zeta, hi);
+    hi = _mm_sub_epi32(lo, t);
+    lo = _mm_add_epi32(lo, t);
+    _mm_storeu_si128((__m128i *)&a[j], _mm_unpacklo_epi32(lo, hi));
+    _mm_storeu_si128((__m128i *)&a[j + 4], _mm_unpackhi_epi32(lo, hi));
+  }
+}
+
+/*************************************************
+* Name:        invntt_tomont
+*
+* Description: Inverse NTT and multiplication by Montgomery factor 2^32.
+*              In-place. No modular reductions after additions or
+*              subtractions; input coefficients need to be smaller than
+*              Q in absolute value. Output coefficient are smaller than Q in
+*              absolute value. Mirror image of ntt() above.
+*
+* Arguments:   - uint32_t p[N]: input/output coefficient array
+**************************************************/
+void invntt_tomont(int32_t a[N]) {
+  unsigned int start, len, j, k;
+  __m128i zeta, x, y, lo, hi, t;
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i f = _mm_set1_epi32(41978); // mont^2/256
+
+  for(j = 0; j < N; j += 8) {
+    x = _mm_loadu_si128((__m128i *)&a[j]);
+    y = _mm_loadu_si128((__m128i *)&a[j + 4]);
+
+    /* len = 1 */
+    zeta = _mm_loadu_si128((__m128i *)&zetas[252 - j/2]);
+    zeta = _mm_shuffle_epi32(zeta, _MM_SHUFFLE(0,1,2,3));
+    zeta = _mm_sub_epi32(zero, zeta);
+    x = _mm_shuffle_epi32(x, _MM_SHUFFLE(3,1,2,0));
+    y = _mm_shuffle_epi32(y, _MM_SHUFFLE(3,1,2,0));
+    lo = _mm_unpacklo_epi64(x, y);
+    hi = _mm_unpackhi_epi64(x, y);
+    t = lo;
+    lo = _mm_add_epi32(t, hi);
+    hi = _mm_sub_epi32(t, hi);
+    hi = montgomery_mul_sse(zeta, hi);
+    x = _mm_unpacklo_epi32(lo, hi);
+    y = _mm_unpackhi_epi32(lo, hi);
+
+    /* len = 2 */
+    zeta = _mm_set_epi32(-zetas[126 - j/4], -zetas[126 - j/4],
+                         -zetas[127 - j/4], -zetas[127 - j/4]);
+    lo = _mm_unpacklo_epi64(x, y);
+    hi = _mm_unpackhi_epi64(x, y);
+    t = lo;
+    lo = _mm_add_epi32(t, hi);
+    hi = _mm_sub_epi32(t, hi);
+    hi = montgomery_mul_sse(zeta, hi);
+    _mm_storeu_si128((__m128i *)&a[j], _mm_unpacklo_epi64(lo, hi));
+    _mm_storeu_si128((__m128i *)&a[j + 4], _mm_unpackhi_epi64(lo, hi));
+  }
+
+  k = 64;
+  for(len = 4; len < N; len <<= 1) {
+    for(start = 0; start < N; start += 2*len) {
+      zeta = _mm_set1_epi32(-zetas[--k]);
+      for(j = start; j < start + len; j += 4) {
+        x = _mm_loadu_si128((__m128i *)&a[j]);
+        y = _mm_loadu_si128((__m128i *)&a[j + len]);
+        _mm_storeu_si128((__m128i *)&a[j], _mm_add_epi32(x, y));
+        t = montgomery_mul_sse(zeta, _mm_sub_epi32(x, y));
+        _mm_storeu_si128((__m128i *)&a[j + len], t);
+      }
+    }
+  }
+
+  for(j = 0; j < N; j += 4) {
+    x = _mm_loadu_si128((__m128i *)&a[j]);
+    _mm_storeu_si128((__m128i *)&a[j], montgomery_mul_sse(f, x));
+  }
+}
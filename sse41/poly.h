@@ -0,0 +1 @@
+../ref/poly.h
\ No newline at end of file
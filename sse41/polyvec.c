@@ -0,0 +1 @@
+../ref/polyvec.c
\ No newline at end of file
@@ -0,0 +1 @@
+../ref/polyvec.h
\ No newline at end of file
@@ -0,0 +1 @@
+../ref/randombytes.c
\ No newline at end of file
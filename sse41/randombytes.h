@@ -0,0 +1 @@
+../ref/randombytes.h
\ No newline at end of file
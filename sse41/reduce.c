@@ -0,0 +1 @@
+../ref/reduce.c
\ No newline at end of file
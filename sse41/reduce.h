@@ -0,0 +1,75 @@
+#ifndef REDUCE_H
+#define REDUCE_H
+
+#include <stdint.h>
+#include <smmintrin.h>
+#include "params.h"
+
+#define MONT -4186625 // 2^32 % Q
+#define QINV 58728449 // q^(-1) mod 2^32
+
+#define montgomery_reduce DILITHIUM_NAMESPACE(montgomery_reduce)
+int32_t montgomery_reduce(int64_t a);
+
+#define reduce32 DILITHIUM_NAMESPACE(reduce32)
+int32_t reduce32(int32_t a);
+
+#define caddq DILITHIUM_NAMESPACE(caddq)
+int32_t caddq(int32_t a);
+
+#define freeze DILITHIUM_NAMESPACE(freeze)
+int32_t freeze(int32_t a);
+
+/*************************************************
+* Name:        montgomery_mul_sse
+*
+* Description: Four-lane montgomery_reduce(a*b). The 64-bit products of the
+*              even and odd lanes are formed separately with _mm_mul_epi32;
+*              after subtracting t*Q their low halves vanish and the high
+*              halves are the results. Bit-identical to the scalar code.
+*
+* Arguments:   - __m128i a: first factors
+*              - __m128i b: second factors
+*
+* Returns a*b*2^{-32} mod Q with -Q < r < Q in every lane.
+**************************************************/
+static inline __m128i montgomery_mul_sse(__m128i a, __m128i b) {
+  const __m128i q = _mm_set1_epi32(Q);
+  const __m128i qinv = _mm_set1_epi32(QINV);
+  __m128i lo, hi, t;
+
+  lo = _mm_mul_epi32(a, b);
+  hi = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+  t = _mm_mul_epi32(lo, qinv);
+  t = _mm_mul_epi32(t, q);
+  lo = _mm_sub_epi32(lo, t);
+
+  t = _mm_mul_epi32(hi, qinv);
+  t = _mm_mul_epi32(t, q);
+  hi = _mm_sub_epi32(hi, t);
+
+  lo = _mm_srli_epi64(lo, 32);
+  return _mm_blend_epi16(lo, hi, 0xCC);
+}
+
+/* Four-lane reduce32() */
+static inline __m128i reduce32_sse(__m128i a) {
+  __m128i t;
+
+  t = _mm_add_epi32(a, _mm_set1_epi32(1 << 22));
+  t = _mm_srai_epi32(t, 23);
+  t = _mm_mullo_epi32(t, _mm_set1_epi32(Q));
+  return _mm_sub_epi32(a, t);
+}
+
+/* Four-lane caddq() */
+static inline __m128i caddq_sse(__m128i a) {
+  __m128i t;
+
+  t = _mm_srai_epi32(a, 31);
+  t = _mm_and_si128(t, _mm_set1_epi32(Q));
+  return _mm_add_epi32(a, t);
+}
+
+#endif
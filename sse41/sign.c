@@ -0,0 +1 @@
+../ref/sign.c
\ No newline at end of file
@@ -0,0 +1 @@
+../ref/symmetric-shake.c
\ No newline at end of file
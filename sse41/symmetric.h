@@ -0,0 +1 @@
+../ref/symmetric.h
\ No newline at end of file
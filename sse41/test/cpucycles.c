@@ -0,0 +1 @@
+../../ref/test/cpucycles.c
\ No newline at end of file
@@ -0,0 +1 @@
+../../ref/test/cpucycles.h
\ No newline at end of file
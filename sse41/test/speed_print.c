@@ -0,0 +1 @@
+../../ref/test/speed_print.c
\ No newline at end of file
@@ -0,0 +1 @@
+../../ref/test/test_dilithium.c
\ No newline at end of file
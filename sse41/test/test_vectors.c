@@ -0,0 +1 @@
+../../ref/test/test_vectors.c
\ No newline at end of file